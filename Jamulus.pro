@@ -22,7 +22,8 @@ CONFIG += qt \
     release
 
 QT += network \
-    xml
+    xml \
+    concurrent
 
 contains(CONFIG, "headless") {
     message(Headless mode activated.)
@@ -352,19 +353,26 @@ HEADERS += src/buffer.h \
     src/channel.h \
     src/client.h \
     src/global.h \
+    src/mixstream.h \
+    src/packetcapture.h \
+    src/netimpairment.h \
     src/multicolorled.h \
     src/protocol.h \
+    src/resample.h \
     src/server.h \
+    src/serveradmin.h \
     src/serverlist.h \
     src/serverlogging.h \
     src/settings.h \
     src/socket.h \
+    src/statusfilewriter.h \
     src/soundbase.h \
     src/testbench.h \
     src/util.h \
     src/recorder/jamrecorder.h \
     src/recorder/creaperproject.h \
     src/recorder/cwavestream.h \
+    src/recorder/cmixdown.h \
     src/historygraph.h \
     src/signalhandler.h
 
@@ -452,18 +460,25 @@ SOURCES += src/buffer.cpp \
     src/channel.cpp \
     src/client.cpp \
     src/main.cpp \
+    src/mixstream.cpp \
+    src/packetcapture.cpp \
+    src/netimpairment.cpp \
     src/protocol.cpp \
+    src/resample.cpp \
     src/server.cpp \
+    src/serveradmin.cpp \
     src/serverlist.cpp \
     src/serverlogging.cpp \
     src/settings.cpp \
     src/signalhandler.cpp \
     src/socket.cpp \
     src/soundbase.cpp \
+    src/statusfilewriter.cpp \
     src/util.cpp \
     src/recorder/jamrecorder.cpp \
     src/recorder/creaperproject.cpp \
     src/recorder/cwavestream.cpp \
+    src/recorder/cmixdown.cpp \
     src/historygraph.cpp
 
 SOURCES_GUI = src/audiomixerboard.cpp \
@@ -1012,6 +1027,30 @@ contains(CONFIG, "headless") {
     FORMS += $$FORMS_GUI
 }
 
+# load generator for server capacity tests (virtual clients without sound card)
+contains(CONFIG, "loadgenerator") {
+    message(The load generator is enabled.)
+    DEFINES += LOAD_GENERATOR
+    HEADERS += src/loadgenerator.h
+    SOURCES += src/loadgenerator.cpp
+}
+
+# benchmark of the audio and network hot paths
+contains(CONFIG, "benchmark") {
+    message(The benchmark is enabled.)
+    DEFINES += BENCHMARK
+    HEADERS += src/benchmark.h
+    SOURCES += src/benchmark.cpp
+}
+
+# offline server simulation
+contains(CONFIG, "simulation") {
+    message(The offline simulation is enabled.)
+    DEFINES += SIMULATION
+    HEADERS += src/simulation.h
+    SOURCES += src/simulation.cpp
+}
+
 # use external OPUS library if requested
 contains(CONFIG, "opus_shared_lib") {
     message(OPUS codec is used from a shared library.)
@@ -867,8 +867,10 @@ void CAudioMixerBoard::ApplyNewConClientList ( CVector<CChannelInfo>& vecChanInf
             // check if current fader is used
             if ( vecChanInfo[j].iChanID == i )
             {
+                const bool bFaderWasVisible = vecpChanFader[i]->IsVisible();
+
                 // check if fader was already in use -> preserve gain value
-                if ( !vecpChanFader[i]->IsVisible() )
+                if ( !bFaderWasVisible )
                 {
                     // the fader was not in use, reset everything for new client
                     vecpChanFader[i]->Reset();
@@ -922,8 +924,12 @@ void CAudioMixerBoard::ApplyNewConClientList ( CVector<CChannelInfo>& vecChanInf
                     }
                 }
 
-                // set the channel infos
-                vecpChanFader[i]->SetChannelInfos ( vecChanInfo[j] );
+                // set the channel infos (only if they have changed since the
+                // label, pictures and tool tip are rebuilt on each call)
+                if ( !bFaderWasVisible || ( vecpChanFader[i]->GetReceivedChanInfo() != vecChanInfo[j] ) )
+                {
+                    vecpChanFader[i]->SetChannelInfos ( vecChanInfo[j] );
+                }
 
                 bFaderIsUsed = true;
             }
@@ -51,6 +51,7 @@ public:
 
     QString GetReceivedName() { return cReceivedChanInfo.strName; }
     int GetReceivedInstrument() { return cReceivedChanInfo.iInstrument; }
+    const CChannelInfo& GetReceivedChanInfo() const { return cReceivedChanInfo; }
     void SetChannelInfos ( const CChannelInfo& cChanInfo );
     void Show() { pFrame->show(); }
     void Hide() { pFrame->hide(); }
@@ -0,0 +1,413 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#include "benchmark.h"
+#include <QFile>
+
+
+/* Implementation *************************************************************/
+void CBenchmark::Run ( const QString& strBaselineFileName )
+{
+    // use the same pseudo random input data in each run
+    srand ( 1 );
+
+    vecResults.clear();
+
+    BenchmarkProcessData();
+    BenchmarkOpus();
+    BenchmarkBuffers();
+    BenchmarkProtocol();
+    BenchmarkReverb();
+
+    if ( strBaselineFileName.isEmpty() )
+    {
+        return;
+    }
+
+    // compare with an existing baseline or store a new one
+    if ( LoadBaseline ( strBaselineFileName ) )
+    {
+        tsConsole << endl << "Comparison of the median with the baseline " <<
+            strBaselineFileName << ":" << endl;
+
+        for ( const CResult& Result : vecResults )
+        {
+            for ( const CResult& Baseline : vecBaseline )
+            {
+                if ( ( Baseline.strName == Result.strName ) && ( Baseline.dMedianNs > 0 ) )
+                {
+                    const double dChange = Result.dMedianNs / Baseline.dMedianNs - 1.0;
+
+                    tsConsole << QString ( "  %1 %2 ns -> %3 ns (%4%5 %)%6" ).
+                        arg ( Result.strName, -40 ).
+                        arg ( Baseline.dMedianNs, 10, 'f', 1 ).
+                        arg ( Result.dMedianNs, 10, 'f', 1 ).
+                        arg ( dChange >= 0 ? "+" : "" ).
+                        arg ( 100.0 * dChange, 0, 'f', 1 ).
+                        arg ( fabs ( dChange ) > BENCHMARK_SIGNIFICANT_CHANGE ? " *" : "" ) << endl;
+                }
+            }
+        }
+    }
+    else
+    {
+        SaveBaseline ( strBaselineFileName );
+
+        tsConsole << endl << "Results stored as new baseline in " <<
+            strBaselineFileName << endl;
+    }
+}
+
+template<typename TFunc>
+void CBenchmark::Measure ( const QString& strName,
+                           const int      iNumOpsPerBatch,
+                           TFunc          Function )
+{
+    QElapsedTimer       Timer;
+    std::vector<double> vecdNsPerOp ( BENCHMARK_NUM_BATCHES );
+
+    // warm up caches and branch predictors
+    for ( int i = 0; i < iNumOpsPerBatch; i++ )
+    {
+        Function();
+    }
+
+    for ( int iBatch = 0; iBatch < BENCHMARK_NUM_BATCHES; iBatch++ )
+    {
+        Timer.start();
+
+        for ( int i = 0; i < iNumOpsPerBatch; i++ )
+        {
+            Function();
+        }
+
+        vecdNsPerOp[iBatch] = static_cast<double> ( Timer.nsecsElapsed() ) / iNumOpsPerBatch;
+    }
+
+    std::sort ( vecdNsPerOp.begin(), vecdNsPerOp.end() );
+
+    CResult Result;
+    Result.strName   = strName;
+    Result.dMedianNs = vecdNsPerOp[BENCHMARK_NUM_BATCHES / 2];
+    Result.dP90Ns    = vecdNsPerOp[BENCHMARK_NUM_BATCHES * 90 / 100];
+    Result.dP99Ns    = vecdNsPerOp[BENCHMARK_NUM_BATCHES * 99 / 100];
+
+    vecResults.push_back ( Result );
+
+    tsConsole << QString ( "%1 median %2 ns/op, p90 %3 ns/op, p99 %4 ns/op" ).
+        arg ( strName, -40 ).
+        arg ( Result.dMedianNs, 10, 'f', 1 ).
+        arg ( Result.dP90Ns, 10, 'f', 1 ).
+        arg ( Result.dP99Ns, 10, 'f', 1 ) << endl;
+}
+
+void CBenchmark::BenchmarkProcessData()
+{
+    CBenchServer Server;
+
+    const int iMaxBlockSize = 2 /* stereo */ * DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES;
+
+    CVector<CVector<int16_t> > vecvecsData ( MAX_NUM_CHANNELS );
+    CVector<double>            vecdGains ( MAX_NUM_CHANNELS );
+    CVector<double>            vecdPannings ( MAX_NUM_CHANNELS );
+    CVector<int>               vecNumAudioChannels ( MAX_NUM_CHANNELS );
+    CVector<int16_t>           vecsOutData ( iMaxBlockSize );
+
+    for ( int i = 0; i < MAX_NUM_CHANNELS; i++ )
+    {
+        vecvecsData[i].Init ( iMaxBlockSize );
+
+        for ( int j = 0; j < iMaxBlockSize; j++ )
+        {
+            vecvecsData[i][j] = static_cast<int16_t> ( rand() - RAND_MAX / 2 );
+        }
+
+        // use gains different from one so that the gain multiplication is
+        // included in the measurement
+        vecdGains[i]    = 0.8;
+        vecdPannings[i] = 0.3;
+    }
+
+    const int veciNumClients[] = { 1, 10, 25, MAX_NUM_CHANNELS };
+
+    for ( const int iNumClients : veciNumClients )
+    {
+        // mono clients mixed to a mono output, stereo clients mixed to a
+        // stereo output and alternating mono and stereo clients mixed to a
+        // stereo output (as in a real session, this includes the mono to
+        // stereo conversion with panning)
+        for ( int iConfig = 0; iConfig < 3; iConfig++ )
+        {
+            const bool bIsMixed    = ( iConfig == 2 );
+            const int  iNumAudChan = bIsMixed ? 2 : iConfig + 1;
+
+            for ( int i = 0; i < MAX_NUM_CHANNELS; i++ )
+            {
+                vecNumAudioChannels[i] = bIsMixed ? ( i % 2 ) + 1 : iNumAudChan;
+            }
+
+            Measure ( QString ( "ProcessData %1 clients %2" ).
+                      arg ( iNumClients ).
+                      arg ( bIsMixed ? "mixed" : iNumAudChan == 1 ? "mono" : "stereo" ),
+                      100,
+                      [&]()
+                      {
+                          Server.ProcessData ( vecvecsData,
+                                               vecdGains,
+                                               vecdPannings,
+                                               vecNumAudioChannels,
+                                               vecsOutData,
+                                               iNumAudChan,
+                                               iNumClients );
+
+                          iSink += vecsOutData[0];
+                      } );
+        }
+    }
+}
+
+void CBenchmark::BenchmarkOpus()
+{
+    const int veciFrameSizes[] = { SYSTEM_FRAME_SIZE_SAMPLES, DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES };
+
+    for ( const int iFrameSize : veciFrameSizes )
+    {
+        int iOpusError;
+
+        OpusCustomMode*    OpusMode    = opus_custom_mode_create ( SYSTEM_SAMPLE_RATE_HZ,
+                                                                   iFrameSize,
+                                                                   &iOpusError );
+        OpusCustomEncoder* OpusEncoder = opus_custom_encoder_create ( OpusMode, 2, &iOpusError );
+        OpusCustomDecoder* OpusDecoder = opus_custom_decoder_create ( OpusMode, 2, &iOpusError );
+
+        // same encoder settings as used in the server
+        opus_custom_encoder_ctl ( OpusEncoder, OPUS_SET_VBR ( 0 ) );
+
+        if ( iFrameSize == SYSTEM_FRAME_SIZE_SAMPLES )
+        {
+            opus_custom_encoder_ctl ( OpusEncoder, OPUS_SET_APPLICATION ( OPUS_APPLICATION_RESTRICTED_LOWDELAY ) );
+        }
+        else
+        {
+            opus_custom_encoder_ctl ( OpusEncoder, OPUS_SET_COMPLEXITY ( 1 ) );
+        }
+
+        // stereo normal quality (the number of coded bytes scales with the
+        // frame size)
+        const int iNumCodedBytes = iFrameSize == SYSTEM_FRAME_SIZE_SAMPLES ?
+            35 : 71;
+
+        CVector<int16_t> vecsAudio ( 2 * iFrameSize );
+        CVector<uint8_t> vecbyCoded ( iNumCodedBytes );
+
+        for ( int i = 0; i < vecsAudio.Size(); i++ )
+        {
+            vecsAudio[i] = static_cast<int16_t> ( ( rand() - RAND_MAX / 2 ) / 4 );
+        }
+
+        Measure ( QString ( "opus_custom_encode stereo %1" ).arg ( iFrameSize ),
+                  100,
+                  [&]()
+                  {
+                      iSink += opus_custom_encode ( OpusEncoder,
+                                                    &vecsAudio[0],
+                                                    iFrameSize,
+                                                    &vecbyCoded[0],
+                                                    iNumCodedBytes );
+                  } );
+
+        Measure ( QString ( "opus_custom_decode stereo %1" ).arg ( iFrameSize ),
+                  100,
+                  [&]()
+                  {
+                      iSink += opus_custom_decode ( OpusDecoder,
+                                                    &vecbyCoded[0],
+                                                    iNumCodedBytes,
+                                                    &vecsAudio[0],
+                                                    iFrameSize );
+                  } );
+
+        opus_custom_encoder_destroy ( OpusEncoder );
+        opus_custom_decoder_destroy ( OpusDecoder );
+        opus_custom_mode_destroy ( OpusMode );
+    }
+}
+
+void CBenchmark::BenchmarkBuffers()
+{
+    // jitter buffer with a typical packet size and buffer size
+    const int        iBlockSize = 71;
+    CNetBufWithStats NetBuf;
+    CVector<uint8_t> vecbyData ( iBlockSize, 0 );
+
+    NetBuf.SetUseDoubleSystemFrameSize ( true );
+    NetBuf.Init ( iBlockSize, 6 );
+
+    Measure ( "CNetBufWithStats Put/Get",
+              1000,
+              [&]()
+              {
+                  NetBuf.Put ( vecbyData, iBlockSize );
+                  iSink += NetBuf.Get ( vecbyData, iBlockSize );
+              } );
+
+    // conversion buffer combining two network frames
+    CConvBuf<uint8_t> ConvBuf;
+    ConvBuf.Init ( 2 * iBlockSize );
+
+    Measure ( "CConvBuf Put/GetAll",
+              1000,
+              [&]()
+              {
+                  if ( ConvBuf.Put ( vecbyData, iBlockSize ) )
+                  {
+                      iSink += ConvBuf.GetAll()[0];
+                  }
+              } );
+
+    // CRC over a typical protocol message
+    CCRC CRC;
+
+    Measure ( "CCRC 100 bytes",
+              1000,
+              [&]()
+              {
+                  CRC.Reset();
+
+                  for ( int i = 0; i < 100; i++ )
+                  {
+                      CRC.AddByte ( static_cast<uint8_t> ( i ) );
+                  }
+
+                  iSink += CRC.GetCRC();
+              } );
+}
+
+void CBenchmark::BenchmarkProtocol()
+{
+    CBenchProtocol   Protocol;
+    CVector<uint8_t> vecbyMesBody ( 100, 0 );
+    CVector<uint8_t> vecbyFrame;
+    CVector<uint8_t> vecbyParsedBody;
+    int              iCnt;
+    int              iID;
+
+    Protocol.GenMessageFrame ( vecbyFrame, 0, PROTMESSID_CHAT_TEXT, vecbyMesBody );
+
+    Measure ( "CProtocol::GenMessageFrame 100 bytes",
+              1000,
+              [&]()
+              {
+                  Protocol.GenMessageFrame ( vecbyFrame, 0, PROTMESSID_CHAT_TEXT, vecbyMesBody );
+                  iSink += vecbyFrame[0];
+              } );
+
+    Measure ( "CProtocol::ParseMessageFrame 100 bytes",
+              1000,
+              [&]()
+              {
+                  iSink += CProtocol::ParseMessageFrame ( vecbyFrame,
+                                                          vecbyFrame.Size(),
+                                                          vecbyParsedBody,
+                                                          iCnt,
+                                                          iID );
+              } );
+}
+
+void CBenchmark::BenchmarkReverb()
+{
+    const int veciFrameSizes[] = { SYSTEM_FRAME_SIZE_SAMPLES, DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES };
+
+    for ( const int iFrameSize : veciFrameSizes )
+    {
+        CAudioReverb     AudioReverb;
+        CVector<int16_t> vecsStereo ( 2 * iFrameSize );
+
+        for ( int i = 0; i < vecsStereo.Size(); i++ )
+        {
+            vecsStereo[i] = static_cast<int16_t> ( ( rand() - RAND_MAX / 2 ) / 4 );
+        }
+
+        AudioReverb.Init ( CC_STEREO, 2 * iFrameSize, SYSTEM_SAMPLE_RATE_HZ );
+
+        Measure ( QString ( "CAudioReverb::Process stereo %1" ).arg ( iFrameSize ),
+                  100,
+                  [&]()
+                  {
+                      AudioReverb.Process ( vecsStereo, false, 0.5 );
+                      iSink += vecsStereo[0];
+                  } );
+    }
+}
+
+bool CBenchmark::LoadBaseline ( const QString& strFileName )
+{
+    QFile BaselineFile ( strFileName );
+
+    if ( !BaselineFile.open ( QIODevice::ReadOnly | QIODevice::Text ) )
+    {
+        return false;
+    }
+
+    QTextStream tsBaseline ( &BaselineFile );
+
+    vecBaseline.clear();
+
+    // one line per benchmark: name;median;p90;p99
+    while ( !tsBaseline.atEnd() )
+    {
+        const QStringList slFields = tsBaseline.readLine().split ( ";" );
+
+        if ( slFields.size() == 4 )
+        {
+            CResult Result;
+            Result.strName   = slFields[0];
+            Result.dMedianNs = slFields[1].toDouble();
+            Result.dP90Ns    = slFields[2].toDouble();
+            Result.dP99Ns    = slFields[3].toDouble();
+
+            vecBaseline.push_back ( Result );
+        }
+    }
+
+    return true;
+}
+
+void CBenchmark::SaveBaseline ( const QString& strFileName )
+{
+    QFile BaselineFile ( strFileName );
+
+    if ( !BaselineFile.open ( QIODevice::WriteOnly | QIODevice::Text ) )
+    {
+        throw CGenErr ( "The benchmark baseline file could not be written." );
+    }
+
+    QTextStream tsBaseline ( &BaselineFile );
+
+    for ( const CResult& Result : vecResults )
+    {
+        tsBaseline << Result.strName << ";" << Result.dMedianNs << ";" <<
+            Result.dP90Ns << ";" << Result.dP99Ns << endl;
+    }
+}
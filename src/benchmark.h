@@ -0,0 +1,117 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#pragma once
+
+#include <QTextStream>
+#include <QElapsedTimer>
+#include <QString>
+#include <vector>
+#include <algorithm>
+#ifdef USE_OPUS_SHARED_LIB
+# include "opus/opus_custom.h"
+#else
+# include "opus_custom.h"
+#endif
+#include "global.h"
+#include "buffer.h"
+#include "protocol.h"
+#include "server.h"
+#include "util.h"
+
+
+/* Definitions ****************************************************************/
+// number of measured batches per benchmark (the percentiles are calculated
+// over the batches)
+#define BENCHMARK_NUM_BATCHES               200
+
+// relative change of the median compared to the baseline which is reported
+// as a significant difference
+#define BENCHMARK_SIGNIFICANT_CHANGE        0.05
+
+
+/* Classes ********************************************************************/
+// Benchmark of the audio and network hot paths --------------------------------
+// Each benchmark is run in batches of a fixed number of operations. The time
+// per operation of each batch is measured and the median and the 90 % and
+// 99 % percentiles over all batches are reported. The results can be stored
+// in a baseline file and compared against it in a later run.
+class CBenchmark
+{
+public:
+    CBenchmark ( QTextStream& tsNConsole ) : tsConsole ( tsNConsole ), iSink ( 0 ) {}
+
+    void Run ( const QString& strBaselineFileName );
+
+protected:
+    class CResult
+    {
+    public:
+        CResult() : dMedianNs ( 0 ), dP90Ns ( 0 ), dP99Ns ( 0 ) {}
+
+        QString strName;
+        double  dMedianNs;
+        double  dP90Ns;
+        double  dP99Ns;
+    };
+
+    // derived classes to get access to the protected functions under test
+    class CBenchServer : public CServer
+    {
+    public:
+        CBenchServer() : CServer ( MAX_NUM_CHANNELS, 0, "", 0 /* random port */,
+                                   "", "", "", "", "", "", "", "", false, false,
+                                   false, true, LT_NO_LICENCE ) {}
+
+        using CServer::ProcessData;
+    };
+
+    class CBenchProtocol : public CProtocol
+    {
+    public:
+        using CProtocol::GenMessageFrame;
+    };
+
+    template<typename TFunc>
+    void Measure ( const QString& strName,
+                   const int      iNumOpsPerBatch,
+                   TFunc          Function );
+
+    void BenchmarkProcessData();
+    void BenchmarkOpus();
+    void BenchmarkBuffers();
+    void BenchmarkProtocol();
+    void BenchmarkReverb();
+
+    bool LoadBaseline ( const QString& strFileName );
+    void SaveBaseline ( const QString& strFileName );
+
+    QTextStream&         tsConsole;
+    std::vector<CResult> vecResults;
+    std::vector<CResult> vecBaseline;
+
+    // results of the functions under test are accumulated here so that the
+    // compiler cannot remove the calls
+    uint32_t             iSink;
+};
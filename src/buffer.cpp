@@ -99,7 +99,11 @@ CNetBufWithStats::CNetBufWithStats() :
     dAutoFilt_WightUpFast     ( IIR_WEIGTH_UP_FAST ),
     dAutoFilt_WightDownFast   ( IIR_WEIGTH_DOWN_FAST ),
     dErrorRateBound           ( ERROR_RATE_BOUND ),
-    dUpMaxErrorBound          ( UP_MAX_ERROR_BOUND )
+    dUpMaxErrorBound          ( UP_MAX_ERROR_BOUND ),
+    bUseDriftEstimation       ( false ),
+    dFillLevelIIR             ( 0.0 ),
+    dDriftIntegrator          ( 0.0 ),
+    dDriftCorrection          ( 0.0 )
 {
     // Define the sizes of the simulation buffers,
     // must be NUM_STAT_SIMULATION_BUFFERS elements!
@@ -191,6 +195,11 @@ void CNetBufWithStats::Init ( const int  iNewBlockSize,
         iCurAutoBufferSizeSetting = 6;
         dCurIIRFilterResult       = iCurAutoBufferSizeSetting;
         iCurDecidedResult         = iCurAutoBufferSizeSetting;
+
+        // reset the drift estimation, start with a centered buffer
+        dFillLevelIIR    = 0.5 * iNewNumBlocks;
+        dDriftIntegrator = 0.0;
+        dDriftCorrection = 0.0;
     }
 }
 
@@ -235,9 +244,50 @@ bool CNetBufWithStats::Get ( CVector<uint8_t>& vecbyData,
     // update auto setting
     UpdateAutoSetting();
 
+    // update clock drift estimation
+    if ( bUseDriftEstimation )
+    {
+        UpdateDriftEstimation();
+    }
+
     return bGetOK;
 }
 
+void CNetBufWithStats::UpdateDriftEstimation()
+{
+    // If the sound card clock of the remote side is faster than our clock,
+    // the jitter buffer fill level increases over time and vice versa. The
+    // fill level is very noisy because of the network jitter, therefore we
+    // low pass filter it and use the deviation from the buffer center as the
+    // control error. A positive correction means that the buffer is too full
+    // and we have to consume more samples than we produce.
+    const double dFillLevel = static_cast<double> ( GetAvailData() ) / iBlockSize;
+
+    dFillLevelIIR = DRIFT_EST_FILL_IIR_WEIGHT * dFillLevelIIR +
+        ( 1.0 - DRIFT_EST_FILL_IIR_WEIGHT ) * dFillLevel;
+
+    const double dError = dFillLevelIIR - 0.5 * GetSize();
+
+    // integrate the error and limit the integrator to avoid a wind-up (e.g.
+    // if the correction is not applied at all)
+    dDriftIntegrator += dError;
+
+    const double dMaxIntegrator = DRIFT_EST_MAX_CORRECTION / DRIFT_EST_INT_GAIN;
+
+    if ( dDriftIntegrator > dMaxIntegrator )
+    {
+        dDriftIntegrator = dMaxIntegrator;
+    }
+    else if ( dDriftIntegrator < -dMaxIntegrator )
+    {
+        dDriftIntegrator = -dMaxIntegrator;
+    }
+
+    dDriftCorrection = std::max ( -DRIFT_EST_MAX_CORRECTION,
+                       std::min (  DRIFT_EST_MAX_CORRECTION,
+                                   DRIFT_EST_PROP_GAIN * dError + DRIFT_EST_INT_GAIN * dDriftIntegrator ) );
+}
+
 void CNetBufWithStats::UpdateAutoSetting()
 {
     int  iCurDecision      = 0; // dummy initialization
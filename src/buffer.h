@@ -69,6 +69,18 @@
 #define IIR_WEIGTH_UP_FAST                          0.9997499687422
 #define IIR_WEIGTH_DOWN_FAST                        0.999499875
 
+// Clock drift estimation: the jitter buffer fill level is smoothed with an IIR
+// filter and controlled to the center of the buffer by a PI controller. The
+// controller output is the relative sample rate correction. The integral gain
+// is chosen for critical damping (Ki = Kp^2 / 4), the time constant of the
+// loop is approx. 1 / Kp blocks.
+#define DRIFT_EST_FILL_IIR_WEIGHT                   0.999
+#define DRIFT_EST_PROP_GAIN                         0.00005
+#define DRIFT_EST_INT_GAIN                          ( DRIFT_EST_PROP_GAIN * DRIFT_EST_PROP_GAIN / 4 )
+
+// maximum sample rate correction (sound card clocks are usually much better)
+#define DRIFT_EST_MAX_CORRECTION                    0.001
+
 
 /* Classes ********************************************************************/
 // Buffer base class -----------------------------------------------------------
@@ -432,16 +444,21 @@ public:
 
     void SetUseDoubleSystemFrameSize ( const bool bNDSFSize ) { bUseDoubleSystemFrameSize = bNDSFSize; }
 
+    // the clock drift is only estimated if the compensation is used
+    void SetUseDriftEstimation ( const bool bNUDE ) { bUseDriftEstimation = bNUDE; }
+
     virtual bool Put ( const CVector<uint8_t>& vecbyData, const int iInSize );
     virtual bool Get ( CVector<uint8_t>& vecbyData, const int iOutSize );
 
     int GetAutoSetting() { return iCurAutoBufferSizeSetting; }
+    double GetDriftCorrection() const { return dDriftCorrection; }
     void GetErrorRates ( CVector<double>& vecErrRates,
                          double&          dLimit,
                          double&          dMaxUpLimit );
 
 protected:
     void UpdateAutoSetting();
+    void UpdateDriftEstimation();
     void ResetInitCounter();
 
     // statistic (do not use the vector class since the classes do not have
@@ -463,6 +480,12 @@ protected:
     double     dAutoFilt_WightDownFast;
     double     dErrorRateBound;
     double     dUpMaxErrorBound;
+
+    // clock drift estimation
+    bool       bUseDriftEstimation;
+    double     dFillLevelIIR;
+    double     dDriftIntegrator;
+    double     dDriftCorrection;
 };
 
 
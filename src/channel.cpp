@@ -30,6 +30,11 @@ CChannel::CChannel ( const bool bNIsServer ) :
     vecdGains              ( MAX_NUM_CHANNELS, 1.0 ),
     vecdPannings           ( MAX_NUM_CHANNELS, 0.5 ),
     bDoAutoSockBufSize     ( true ),
+    bRedundancyRequested   ( false ),
+    bUseRedundancy         ( false ),
+    bPrevPacketValid       ( false ),
+    iSendSeqNum            ( 0 ),
+    iLastRecSeqNum         ( INVALID_INDEX ),
     iFadeInCnt             ( 0 ),
     iFadeInCntMax          ( FADE_IN_NUM_FRAMES_DBLE_FRAMESIZE ),
     bIsEnabled             ( false ),
@@ -59,6 +64,7 @@ CChannel::CChannel ( const bool bNIsServer ) :
 // TODO if we later do not fire vectors in the emits, we can remove this again
 qRegisterMetaType<CVector<uint8_t> > ( "CVector<uint8_t>" );
 qRegisterMetaType<CHostAddress> ( "CHostAddress" );
+qRegisterMetaType<CVector<CChannelListDeltaEntry> > ( "CVector<CChannelListDeltaEntry>" );
 
     QObject::connect ( &Protocol, &CProtocol::MessReadyForSending,
         this, &CChannel::OnSendProtMessage );
@@ -69,6 +75,9 @@ qRegisterMetaType<CHostAddress> ( "CHostAddress" );
     QObject::connect ( &Protocol, &CProtocol::ReqJittBufSize,
         this, &CChannel::ReqJittBufSize );
 
+    QObject::connect ( &Protocol, &CProtocol::RecGapTimeout,
+        this, &CChannel::OnProtRecGapTimeout );
+
     QObject::connect ( &Protocol, &CProtocol::ReqChanInfo,
         this, &CChannel::ReqChanInfo );
 
@@ -78,6 +87,12 @@ qRegisterMetaType<CHostAddress> ( "CHostAddress" );
     QObject::connect ( &Protocol, &CProtocol::ConClientListMesReceived,
         this, &CChannel::ConClientListMesReceived );
 
+    QObject::connect ( &Protocol, &CProtocol::ReqConClientListDelta,
+        this, &CChannel::OnReqConClientListDelta );
+
+    QObject::connect ( &Protocol, &CProtocol::ConClientListDeltaMesReceived,
+        this, &CChannel::ConClientListDeltaMesReceived );
+
     QObject::connect ( &Protocol, &CProtocol::ChangeChanGain,
         this, &CChannel::OnChangeChanGain );
 
@@ -113,6 +128,9 @@ qRegisterMetaType<CHostAddress> ( "CHostAddress" );
 
     QObject::connect ( &Protocol, &CProtocol::ReqChannelLevelList,
         this, &CChannel::OnReqChannelLevelList );
+
+    QObject::connect ( &Protocol, &CProtocol::ReqChannelLevelListDelta,
+        this, &CChannel::OnReqChannelLevelListDelta );
 }
 
 bool CChannel::ProtocolIsEnabled()
@@ -179,6 +197,10 @@ void CChannel::SetAudioStreamProperties ( const EAudComprType eNewAudComprType,
             // init socket buffer
             SockBuf.SetUseDoubleSystemFrameSize ( eAudioCompressionType == CT_OPUS ); // NOTE must be set BEFORE the init()
             SockBuf.Init ( iNetwFrameSize, iCurSockBufNumFrames );
+
+            // init buffer for restoring lost packets
+            vecbyRecoveredPacket.Init ( iNetwFrameSize * iNetwFrameSizeFact );
+            iLastRecSeqNum = INVALID_INDEX;
         }
         MutexSocketBuf.unlock();
 
@@ -186,6 +208,11 @@ void CChannel::SetAudioStreamProperties ( const EAudComprType eNewAudComprType,
         {
             // init conversion buffer
             ConvBuf.Init ( iNetwFrameSize * iNetwFrameSizeFact );
+
+            // we only send redundant packets after the server has confirmed
+            // that it supports them
+            bUseRedundancy = false;
+            InitRedundancyBuffers();
         }
         MutexConvBuf.unlock();
 
@@ -371,6 +398,20 @@ void CChannel::OnJittBufSizeChange ( int iNewJitBufSize )
     }
 }
 
+void CChannel::OnProtRecGapTimeout()
+{
+    // for server the stored messages must be processed under the lock of the
+    // server as the received messages, for client process them directly
+    if ( bIsServer )
+    {
+        emit ProtRecGapTimeout();
+    }
+    else
+    {
+        Protocol.FlushStoredMessages();
+    }
+}
+
 void CChannel::OnChangeChanGain ( int    iChanID,
                                   double dNewGain )
 {
@@ -448,6 +489,10 @@ void CChannel::OnNetTranspPropsReceived ( CNetworkTransportProps NetworkTranspor
                 // minimum network frame size)
                 SockBuf.SetUseDoubleSystemFrameSize ( eAudioCompressionType == CT_OPUS ); // NOTE must be set BEFORE the init()
                 SockBuf.Init ( iNetwFrameSize, iCurSockBufNumFrames );
+
+                // init buffer for restoring lost packets
+                vecbyRecoveredPacket.Init ( iNetwFrameSize * iNetwFrameSizeFact );
+                iLastRecSeqNum = INVALID_INDEX;
             }
             MutexSocketBuf.unlock();
 
@@ -455,13 +500,55 @@ void CChannel::OnNetTranspPropsReceived ( CNetworkTransportProps NetworkTranspor
             {
                 // init conversion buffer
                 ConvBuf.Init ( iNetwFrameSize * iNetwFrameSizeFact );
+
+                // the client requests redundancy only if it supports it
+                bUseRedundancy = ( NetworkTransportProps.iFlags & NF_WITH_REDUNDANCY ) != 0;
+                InitRedundancyBuffers();
             }
             MutexConvBuf.unlock();
         }
         Mutex.unlock();
+
+        // confirm the redundancy to the client (older clients never request
+        // it and therefore never get this message)
+        if ( bUseRedundancy )
+        {
+            Protocol.CreateNetwTranspPropsMes ( GetNetworkTransportPropsFromCurrentSettings() );
+        }
+    }
+    else
+    {
+        // the server confirmed our redundancy request, from now on we send
+        // redundant packets
+        if ( bRedundancyRequested && ( NetworkTransportProps.iFlags & NF_WITH_REDUNDANCY ) )
+        {
+            QMutexLocker locker ( &MutexConvBuf );
+
+            // the copy of the previous packet may be left from an earlier
+            // connection
+            if ( !bUseRedundancy )
+            {
+                InitRedundancyBuffers();
+            }
+
+            bUseRedundancy = true;
+        }
     }
 }
 
+void CChannel::InitRedundancyBuffers()
+{
+    // note that the conversion buffer mutex must be locked by the caller
+    const int iPacketSize = iNetwFrameSize * iNetwFrameSizeFact;
+
+    vecbyPrevPacket.Init ( iPacketSize, 0 );
+    vecbyRedPacket.Init  ( 2 * iPacketSize + 1 /* sequence number */ );
+
+    // the receiver must not restore a packet from the zero filled copy
+    bPrevPacketValid = false;
+    iSendSeqNum      = 0;
+}
+
 void CChannel::OnReqNetTranspProps()
 {
     // fill network transport properties struct from current settings and send it
@@ -477,7 +564,7 @@ CNetworkTransportProps CChannel::GetNetworkTransportPropsFromCurrentSettings()
                                     static_cast<uint32_t> ( iNumAudioChannels ),
                                     SYSTEM_SAMPLE_RATE_HZ,
                                     eAudioCompressionType,
-                                    0, // version of the codec
+                                    ( bIsServer ? bUseRedundancy : bRedundancyRequested ) ? NF_WITH_REDUNDANCY : NF_NONE,
                                     0 );
 }
 
@@ -526,17 +613,67 @@ EPutDataStat CChannel::PutAudioData ( const CVector<uint8_t>& vecbyData,
     {
         MutexSocketBuf.lock();
         {
-            // only process audio if packet has correct size
-            if ( iNumBytes == ( iNetwFrameSize * iNetwFrameSizeFact ) )
+            const int iPacketSize = iNetwFrameSize * iNetwFrameSizeFact;
+
+            // only process audio if packet has correct size (the packet
+            // may carry a redundant copy of the previous packet)
+            if ( ( iNumBytes == iPacketSize ) ||
+                 ( iNumBytes == 2 * iPacketSize + 1 ) )
             {
+                bool bPutPacket = true;
+
+                if ( iNumBytes != iPacketSize )
+                {
+                    const int  iSeqNum    = vecbyData[2 * iPacketSize] & REDUNDANCY_SEQ_NUM_MASK;
+                    const bool bPrevValid = ( vecbyData[2 * iPacketSize] & REDUNDANCY_PREV_VALID_FLAG ) != 0;
+
+                    // the first packet after the sender was initialized starts
+                    // a new sequence, there is nothing to restore
+                    if ( ( iLastRecSeqNum != INVALID_INDEX ) && bPrevValid )
+                    {
+                        // sequence number difference with wrap around
+                        const int iSeqDiff = ( iSeqNum - iLastRecSeqNum ) & REDUNDANCY_SEQ_NUM_MASK;
+
+                        if ( ( iSeqDiff == 0 ) ||
+                             ( iSeqDiff > REDUNDANCY_SEQ_NUM_MASK - REDUNDANCY_MAX_SEQ_GAP ) )
+                        {
+                            // duplicate or late packet which was already
+                            // restored from the redundant copy
+                            bPutPacket = false;
+                        }
+                        else if ( ( iSeqDiff > 1 ) && ( iSeqDiff <= REDUNDANCY_MAX_SEQ_GAP ) )
+                        {
+                            // at least one packet was lost, restore the
+                            // previous one from the redundant copy
+                            std::copy ( vecbyData.begin() + iPacketSize,
+                                        vecbyData.begin() + 2 * iPacketSize,
+                                        vecbyRecoveredPacket.begin() );
+
+                            SockBuf.Put ( vecbyRecoveredPacket, iPacketSize );
+                            IncCounter ( CC_RECOVERED_PACKETS );
+                        }
+
+                        // on a larger jump of the sequence number the sequence
+                        // is taken over without restoring a packet
+                    }
+
+                    if ( bPutPacket )
+                    {
+                        iLastRecSeqNum = iSeqNum;
+                    }
+                }
+
+                IncCounter ( CC_REC_PACKETS );
+
                 // store new packet in jitter buffer
-                if ( SockBuf.Put ( vecbyData, iNumBytes ) )
+                if ( !bPutPacket || SockBuf.Put ( vecbyData, iPacketSize ) )
                 {
                     eRet = PS_AUDIO_OK;
                 }
                 else
                 {
                     eRet = PS_AUDIO_ERR;
+                    IncCounter ( CC_BUF_OVERRUNS );
                 }
 
                 // manage audio fade-in counter
@@ -622,6 +759,7 @@ EGetDataStat CChannel::GetData ( CVector<uint8_t>& vecbyData,
                 {
                     // channel is not yet disconnected but no data in buffer
                     eGetStatus = GS_BUFFER_UNDERRUN;
+                    IncCounter ( CC_BUF_UNDERRUNS );
                 }
             }
         }
@@ -653,7 +791,40 @@ void CChannel::PrepAndSendPacket ( CHighPrioSocket*        pSocket,
     // block size
     if ( ConvBuf.Put ( vecbyNPacket, iNPacketLen ) )
     {
-        pSocket->SendPacket ( ConvBuf.GetAll(), GetAddress() );
+        if ( bUseRedundancy )
+        {
+            const int               iPacketSize = vecbyPrevPacket.Size();
+            const CVector<uint8_t>& vecbyPacket = ConvBuf.GetAll();
+
+            // [current packet][previous packet][sequence number]
+            std::copy ( vecbyPacket.begin(),
+                        vecbyPacket.begin() + iPacketSize,
+                        vecbyRedPacket.begin() );
+
+            std::copy ( vecbyPrevPacket.begin(),
+                        vecbyPrevPacket.end(),
+                        vecbyRedPacket.begin() + iPacketSize );
+
+            vecbyRedPacket[2 * iPacketSize] = ( iSendSeqNum & REDUNDANCY_SEQ_NUM_MASK ) |
+                ( bPrevPacketValid ? REDUNDANCY_PREV_VALID_FLAG : 0 );
+
+            iSendSeqNum++;
+
+            // store current packet for the next redundant copy
+            std::copy ( vecbyPacket.begin(),
+                        vecbyPacket.begin() + iPacketSize,
+                        vecbyPrevPacket.begin() );
+
+            bPrevPacketValid = true;
+
+            pSocket->SendAudioPacket ( vecbyRedPacket, GetAddress() );
+        }
+        else
+        {
+            pSocket->SendAudioPacket ( ConvBuf.GetAll(), GetAddress() );
+        }
+
+        IncCounter ( CC_SENT_PACKETS );
     }
 }
 
@@ -667,11 +838,24 @@ int CChannel::GetUploadRateKbps()
     // 8 (UDP) + 20 (IP without optional fields) = 28 bytes
     // 2 (PPP) + 6 (PPPoE) + 18 (MAC)            = 26 bytes
     // 5 (RFC1483B) + 8 (AAL) + 10 (ATM)         = 23 bytes
-    return ( iNetwFrameSize * iNetwFrameSizeFact + 28 + 26 + 23 /* header */ ) *
+    // with redundancy, the previous packet and a sequence number are appended
+    const int iPacketSize = bUseRedundancy ? 2 * iNetwFrameSize * iNetwFrameSizeFact + 1 :
+                                             iNetwFrameSize * iNetwFrameSizeFact;
+
+    return ( iPacketSize + 28 + 26 + 23 /* header */ ) *
         8 /* bits per byte */ *
         SYSTEM_SAMPLE_RATE_HZ / iAudioSizeOut / 1000;
 }
 
+void CChannel::GetBufErrorRates ( CVector<double>& vecErrRates,
+                                  double&          dLimit,
+                                  double&          dMaxUpLimit )
+{
+    QMutexLocker locker ( &MutexSocketBuf );
+
+    SockBuf.GetErrorRates ( vecErrRates, dLimit, dMaxUpLimit );
+}
+
 void CChannel::UpdateSocketBufferSize()
 {
     // just update the socket buffer size if auto setting is enabled, otherwise
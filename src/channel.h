@@ -45,6 +45,16 @@
 #define FADE_IN_NUM_FRAMES                   2250
 #define FADE_IN_NUM_FRAMES_DBLE_FRAMESIZE    1125
 
+// the last byte of a redundant audio packet holds a 7 bit sequence number and
+// a flag which is set if the appended copy of the previous packet is valid
+// (it is not valid for the first packet after the sender was initialized)
+#define REDUNDANCY_SEQ_NUM_MASK              0x7F
+#define REDUNDANCY_PREV_VALID_FLAG           0x80
+
+// maximum jump of the sequence number which is treated as lost or late packets,
+// larger jumps are a discontinuity of the sequence
+#define REDUNDANCY_MAX_SEQ_GAP               8
+
 
 enum EPutDataStat
 {
@@ -58,6 +68,17 @@ enum EPutDataStat
     PS_NEW_CONNECTION
 };
 
+// statistic counters of the audio packets of a connection
+enum EChanCounter
+{
+    CC_REC_PACKETS       = 0, // received audio packets
+    CC_RECOVERED_PACKETS = 1, // lost packets restored from the redundant copy
+    CC_SENT_PACKETS      = 2, // sent audio packets
+    CC_BUF_UNDERRUNS     = 3, // jitter buffer was empty when audio was needed
+    CC_BUF_OVERRUNS      = 4, // jitter buffer was full when a packet arrived
+    CC_NUM_COUNTERS
+};
+
 
 /* Classes ********************************************************************/
 class CChannel : public QObject
@@ -106,6 +127,7 @@ public:
 
     void CreateReqChanInfoMes() { Protocol.CreateReqChanInfoMes(); }
     void CreateVersionAndOSMes() { Protocol.CreateVersionAndOSMes(); }
+    void CreateMessWindowSizeMes() { Protocol.CreateMessWindowSizeMes(); }
     void CreateMuteStateHasChangedMes ( const int iChanID, const bool bIsMuted ) { Protocol.CreateMuteStateHasChangedMes ( iChanID, bIsMuted ); }
 
     void SetGain ( const int iChanID, const double dNewGain );
@@ -140,15 +162,30 @@ public:
 
     bool GetDoAutoSockBufSize() const { return bDoAutoSockBufSize; }
 
+    // packet redundancy (client only, the server follows the client request)
+    void SetRedundancyRequested ( const bool bValue ) { bRedundancyRequested = bValue; }
+    bool GetRedundancyRequested() const { return bRedundancyRequested; }
+    bool GetUseRedundancy() const { return bUseRedundancy; }
+
     int GetNetwFrameSizeFact() const { return iNetwFrameSizeFact; }
     int GetNetwFrameSize() const { return iNetwFrameSize; }
 
-    void GetBufErrorRates ( CVector<double>& vecErrRates, double& dLimit, double& dMaxUpLimit )
-        { SockBuf.GetErrorRates ( vecErrRates, dLimit, dMaxUpLimit ); }
+    // returns a copy of the statistics which may be re-initialized by the
+    // thread of the audio processing at any time
+    void GetBufErrorRates ( CVector<double>& vecErrRates, double& dLimit, double& dMaxUpLimit );
+
+    // relative sample rate correction estimated from the jitter buffer fill
+    // level (zero if the estimation is not used)
+    void SetUseDriftEstimation ( const bool bNUDE ) { SockBuf.SetUseDriftEstimation ( bNUDE ); }
+    double GetDriftCorrection() const { return SockBuf.GetDriftCorrection(); }
 
     EAudComprType GetAudioCompressionType() { return eAudioCompressionType; }
     int GetNumAudioChannels() const { return iNumAudioChannels; }
 
+    // the counters are atomic so that they can be read from any thread
+    uint32_t GetCounter ( const EChanCounter eCounter ) const
+        { return Counters[eCounter].load ( std::memory_order_relaxed ); }
+
     // network protocol interface
     void CreateJitBufMes ( const int iJitBufSize )
     { 
@@ -158,9 +195,12 @@ public:
         }
     }
     void CreateClientIDMes ( const int iChanID )             { Protocol.CreateClientIDMes ( iChanID ); }
+    void FlushStoredProtMessages()                           { Protocol.FlushStoredMessages(); }
     void CreateReqNetwTranspPropsMes()                       { Protocol.CreateReqNetwTranspPropsMes(); }
     void CreateReqJitBufMes()                                { Protocol.CreateReqJitBufMes(); }
     void CreateReqConnClientsList()                          { Protocol.CreateReqConnClientsList(); }
+    void CreateReqConClientListDeltaMes()                    { Protocol.CreateReqConClientListDeltaMes(); }
+    void CreateReqChannelLevelListDeltaMes()                 { Protocol.CreateReqChannelLevelListDeltaMes(); }
     void CreateChatTextMes ( const QString& strChatText )    { Protocol.CreateChatTextMes ( strChatText ); }
     void CreateLicReqMes ( const ELicenceType eLicenceType ) { Protocol.CreateLicenceRequiredMes ( eLicenceType ); }
     void CreateReqChannelLevelListMes ( bool bOptIn )        { Protocol.CreateReqChannelLevelListMes ( bOptIn ); }
@@ -168,12 +208,19 @@ public:
     void CreateConClientListMes ( const CVector<CChannelInfo>& vecChanInfo )
         { Protocol.CreateConClientListMes ( vecChanInfo ); }
 
+    void CreateConClientListDeltaMes ( const int                              iVersion,
+                                       const bool                             bIsFullList,
+                                       const CVector<CChannelListDeltaEntry>& vecDelta )
+        { Protocol.CreateConClientListDeltaMes ( iVersion, bIsFullList, vecDelta ); }
+
     void CreateRecorderStateMes ( const ERecorderState eRecorderState )
         { Protocol.CreateRecorderStateMes ( eRecorderState ); }
 
     CNetworkTransportProps GetNetworkTransportPropsFromCurrentSettings();
 
     bool ChannelLevelsRequired() const                { return bChannelLevelsRequired; }
+    bool ConClientListDeltaRequired() const           { return bConClientListDelta; }
+    bool ChannelLevelDeltaRequired() const            { return bChannelLevelDelta; }
 
     double GetPrevLevel() const              { return dPrevLevel; }
     void   SetPrevLevel ( const double nPL ) { dPrevLevel = nPL; }
@@ -192,8 +239,25 @@ protected:
         iNumAudioChannels     = 1; // mono
 
         dPrevLevel            = 0.0;
+
+        // redundancy and the list changes must be negotiated again
+        bUseRedundancy        = false;
+        bConClientListDelta   = false;
+        bChannelLevelDelta    = false;
+        iLastRecSeqNum        = INVALID_INDEX;
+
+        // the counters refer to the current connection
+        for ( int i = 0; i < CC_NUM_COUNTERS; i++ )
+        {
+            Counters[i].store ( 0, std::memory_order_relaxed );
+        }
     }
 
+    void IncCounter ( const EChanCounter eCounter )
+        { Counters[eCounter].fetch_add ( 1, std::memory_order_relaxed ); }
+
+    void InitRedundancyBuffers();
+
     // connection parameters
     CHostAddress      InetAddr;
 
@@ -212,10 +276,24 @@ protected:
     // network output conversion buffer
     CConvBuf<uint8_t> ConvBuf;
 
+    // packet redundancy (forward error correction): each packet carries a
+    // copy of the previous packet and a sequence number so that a single
+    // lost packet can be restored before it reaches the jitter buffer
+    bool              bRedundancyRequested;
+    bool              bUseRedundancy;
+    CVector<uint8_t>  vecbyPrevPacket;
+    bool              bPrevPacketValid;
+    CVector<uint8_t>  vecbyRedPacket;
+    CVector<uint8_t>  vecbyRecoveredPacket;
+    uint8_t           iSendSeqNum;
+    int               iLastRecSeqNum;
+
     // network protocol
     CProtocol         Protocol;
 
-    int               iConTimeOut;
+    // the connection state is also queried by the connection less message
+    // threads without the channel locks
+    std::atomic<int>  iConTimeOut;
     int               iConTimeOutStartVal;
     int               iFadeInCnt;
     int               iFadeInCntMax;
@@ -235,11 +313,16 @@ protected:
     QMutex            MutexConvBuf;
 
     bool              bChannelLevelsRequired;
+    bool              bConClientListDelta;
+    bool              bChannelLevelDelta;
     double            dPrevLevel;
 
+    std::atomic<uint32_t> Counters[CC_NUM_COUNTERS];
+
 public slots:
     void OnSendProtMessage ( CVector<uint8_t> vecMessage );
     void OnJittBufSizeChange ( int iNewJitBufSize );
+    void OnProtRecGapTimeout();
     void OnChangeChanGain ( int iChanID, double dNewGain );
     void OnChangeChanPan ( int iChanID, double dNewPan );
     void OnChangeChanInfo ( CChannelCoreInfo ChanInfo );
@@ -272,6 +355,8 @@ public slots:
     void OnNewConnection() { emit NewConnection(); }
 
     void OnReqChannelLevelList ( bool bOptIn ) { bChannelLevelsRequired = bOptIn; }
+    void OnReqConClientListDelta() { bConClientListDelta = true; }
+    void OnReqChannelLevelListDelta() { bChannelLevelDelta = true; }
 
 signals:
     void MessReadyForSending ( CVector<uint8_t> vecMessage );
@@ -279,8 +364,12 @@ signals:
     void ReqJittBufSize();
     void JittBufSizeChanged ( int iNewJitBufSize );
     void ServerAutoSockBufSizeChange ( int iNNumFra );
+    void ProtRecGapTimeout();
     void ReqConnClientsList();
     void ConClientListMesReceived ( CVector<CChannelInfo> vecChanInfo );
+    void ConClientListDeltaMesReceived ( int                             iVersion,
+                                         bool                            bIsFullList,
+                                         CVector<CChannelListDeltaEntry> vecDelta );
     void ChanInfoHasChanged();
     void ClientIDReceived ( int iChanID );
     void MuteStateHasChanged ( int iChanID, bool bIsMuted );
@@ -81,6 +81,10 @@ CClient::CClient ( const quint16  iPortNumber,
     strCentralServerAddress          ( "" ),
     eCentralServerAddressType        ( AT_DEFAULT ),
     iServerSockBufNumFrames          ( DEF_NET_BUF_SIZE_NUM_BL ),
+    iServerArrivalLeadUs             ( 0 ),
+    vecConClientList                 ( 0 ),
+    iConClientListVersion            ( INVALID_INDEX ),
+    vecChannelLevels                 ( 0 ),
     pSignalHandler                   ( CSignalHandler::getSingletonP() )
 {
     int iOpusError;
@@ -144,6 +148,9 @@ CClient::CClient ( const quint16  iPortNumber,
     QObject::connect ( &Channel, &CChannel::ConClientListMesReceived,
         this, &CClient::ConClientListMesReceived );
 
+    QObject::connect ( &Channel, &CChannel::ConClientListDeltaMesReceived,
+        this, &CClient::OnConClientListDeltaMesReceived );
+
     QObject::connect ( &Channel, &CChannel::Disconnected,
         this, &CClient::Disconnected );
 
@@ -183,6 +190,9 @@ CClient::CClient ( const quint16  iPortNumber,
     QObject::connect ( &ConnLessProtocol, &CProtocol::CLPingWithNumClientsReceived,
         this, &CClient::OnCLPingWithNumClientsReceived );
 
+    QObject::connect ( &ConnLessProtocol, &CProtocol::CLTickPhaseReceived,
+        this, &CClient::OnCLTickPhaseReceived );
+
     QObject::connect ( &ConnLessProtocol, &CProtocol::CLDisconnection ,
         this, &CClient::OnCLDisconnection );
 
@@ -194,6 +204,9 @@ CClient::CClient ( const quint16  iPortNumber,
     QObject::connect ( &ConnLessProtocol, &CProtocol::CLChannelLevelListReceived,
         this, &CClient::CLChannelLevelListReceived );
 
+    QObject::connect ( &ConnLessProtocol, &CProtocol::CLChannelLevelListDeltaReceived,
+        this, &CClient::OnCLChannelLevelListDeltaReceived );
+
     // other
     QObject::connect ( &Sound, &CSound::ReinitRequest,
         this, &CClient::OnSndCrdReinitRequest );
@@ -282,10 +295,18 @@ void CClient::OnNewConnection()
     // waiting for the channel time-out). If we now connect again, we would
     // not get the list because the server does not know about a new connection.
     // Same problem is with the jitter buffer message.
+    // A server which supports it shall only send the changes of the list
+    // from now on (this request must be sent before the list request since
+    // the server answers it with a complete list of the current version).
+    iConClientListVersion = INVALID_INDEX;
+    Channel.CreateReqConClientListDeltaMes();
     Channel.CreateReqConnClientsList();
     CreateServerJitterBufferMessage();
 
-    // send opt-in / out for Channel Level updates
+    // send opt-in / out for Channel Level updates, a server which supports it
+    // shall only send the changed levels
+    vecChannelLevels.Init ( 0 );
+    Channel.CreateReqChannelLevelListDeltaMes();
     Channel.CreateReqChannelLevelListMes ( bDisplayChannelLevels );
 }
 
@@ -334,6 +355,163 @@ void CClient::OnCLPingWithNumClientsReceived ( CHostAddress InetAddr,
     }
 }
 
+void CClient::OnCLTickPhaseReceived ( CHostAddress InetAddr,
+                                      int          iTickPeriodUs,
+                                      int          iArrivalLeadUs,
+                                      int          iArrivalJitterUs )
+{
+    // make sure we are running and the server address is correct
+    if ( IsRunning() && ( InetAddr == Channel.GetAddress() ) && ( iTickPeriodUs > 0 ) )
+    {
+        // our packets wait this time in the server jitter buffer in addition
+        // to the jitter buffer size
+        iServerArrivalLeadUs = iArrivalLeadUs;
+
+        // Shift the send phase so that our packets arrive just before the
+        // tick with a margin which the network jitter does not move a packet
+        // across. If the margin is larger than the tick period, every phase
+        // is as good as the unshifted one and the packets are not delayed.
+        const double dPeriodUs     = iTickPeriodUs;
+        const double dTargetLeadUs = SEND_PHASE_MIN_LEAD_US +
+            SEND_PHASE_JITTER_FACTOR * static_cast<double> ( iArrivalJitterUs );
+
+        if ( dTargetLeadUs >= dPeriodUs )
+        {
+            Socket.SetSendDelayUs ( 0 );
+            return;
+        }
+
+        // the phase error is wrapped around to the shorter direction
+        double dErrorUs = iArrivalLeadUs - dTargetLeadUs;
+
+        dErrorUs -= dPeriodUs * floor ( dErrorUs / dPeriodUs + 0.5 );
+
+        const double dStepUs = std::max ( -SEND_PHASE_CTRL_MAX_STEP * dPeriodUs,
+                                          std::min ( SEND_PHASE_CTRL_MAX_STEP * dPeriodUs,
+                                                     SEND_PHASE_CTRL_GAIN * dErrorUs ) );
+
+        // the delay is a fraction of the tick period, if it wraps around, the
+        // packets cross the tick like the unshifted packets do on clock drift
+        double dDelayUs = fmod ( Socket.GetSendDelayUs() + dStepUs, dPeriodUs );
+
+        if ( dDelayUs < 0 )
+        {
+            dDelayUs += dPeriodUs;
+        }
+
+        // the pacer thread is only started for servers which report the
+        // arrival phase and is bypassed as long as the delay is zero
+        if ( dDelayUs > 0 )
+        {
+            Socket.EnableSendPacer();
+        }
+
+        Socket.SetSendDelayUs ( static_cast<int> ( dDelayUs ) );
+    }
+}
+
+void CClient::OnConClientListDeltaMesReceived ( int                             iVersion,
+                                                bool                            bIsFullList,
+                                                CVector<CChannelListDeltaEntry> vecDelta )
+{
+    const int iNumEntries = vecDelta.Size();
+
+    if ( bIsFullList )
+    {
+        // the complete list replaces our list
+        vecConClientList.Init ( 0 );
+
+        for ( int i = 0; i < iNumEntries; i++ )
+        {
+            vecConClientList.Add ( vecDelta[i].ChanInfo );
+        }
+    }
+    else
+    {
+        // if we do not have a complete list, it was already requested and the
+        // changes are ignored until it arrives
+        if ( iConClientListVersion == INVALID_INDEX )
+        {
+            return;
+        }
+
+        // the changes can only be applied to the previous version of the list,
+        // otherwise we have missed a change and request the complete list
+        if ( iVersion != ( ( iConClientListVersion + 1 ) & 0xFFFF ) )
+        {
+            iConClientListVersion = INVALID_INDEX;
+            Channel.CreateReqConnClientsList();
+            return;
+        }
+
+        for ( int i = 0; i < iNumEntries; i++ )
+        {
+            const CChannelInfo& ChanInfo = vecDelta[i].ChanInfo;
+
+            // search for the channel in our list
+            int iIdx = 0;
+
+            while ( ( iIdx < vecConClientList.Size() ) &&
+                    ( vecConClientList[iIdx].iChanID != ChanInfo.iChanID ) )
+            {
+                iIdx++;
+            }
+
+            if ( vecDelta[i].eType == CD_REMOVE )
+            {
+                if ( iIdx < vecConClientList.Size() )
+                {
+                    vecConClientList.erase ( vecConClientList.begin() + iIdx );
+                }
+            }
+            else if ( iIdx < vecConClientList.Size() )
+            {
+                vecConClientList[iIdx] = ChanInfo;
+            }
+            else
+            {
+                vecConClientList.Add ( ChanInfo );
+            }
+        }
+    }
+
+    iConClientListVersion = iVersion;
+
+    // the mixer board works on the complete list
+    emit ConClientListMesReceived ( vecConClientList );
+}
+
+void CClient::OnCLChannelLevelListDeltaReceived ( CHostAddress      InetAddr,
+                                                  CVector<uint16_t> vecLevelList )
+{
+    const int iNumClients = vecLevelList.Size();
+
+    if ( vecChannelLevels.Size() != iNumClients )
+    {
+        // the connected clients have changed, the levels can only be used if
+        // all of them were sent
+        for ( int i = 0; i < iNumClients; i++ )
+        {
+            if ( vecLevelList[i] == PROT_CHANNEL_LEVEL_UNCHANGED )
+            {
+                return;
+            }
+        }
+
+        vecChannelLevels.Init ( iNumClients );
+    }
+
+    for ( int i = 0; i < iNumClients; i++ )
+    {
+        if ( vecLevelList[i] != PROT_CHANNEL_LEVEL_UNCHANGED )
+        {
+            vecChannelLevels[i] = vecLevelList[i];
+        }
+    }
+
+    emit CLChannelLevelListReceived ( InetAddr, vecChannelLevels );
+}
+
 int CClient::PreparePingMessage()
 {
     // transmit the current precise time (in ms)
@@ -475,6 +653,27 @@ void CClient::SetEnableOPUS64 ( const bool eNEnableOPUS64 )
     }
 }
 
+void CClient::SetEnableRedundancy ( const bool bNEnableRedundancy )
+{
+    // init with new parameter, if client was running then first
+    // stop it and restart again after new initialization (the new
+    // network transport properties are then sent to the server)
+    const bool bWasRunning = Sound.IsRunning();
+    if ( bWasRunning )
+    {
+        Sound.Stop();
+    }
+
+    // set new parameter
+    Channel.SetRedundancyRequested ( bNEnableRedundancy );
+    Init();
+
+    if ( bWasRunning )
+    {
+        Sound.Start();
+    }
+}
+
 void CClient::SetAudioQuality ( const EAudioQuality eNAudioQuality )
 {
     // init with new parameter, if client was running then first
@@ -689,6 +888,11 @@ void CClient::Start()
     // init object
     Init();
 
+    // the arrival phase is reported by the server after the connection, the
+    // send phase is only shifted for servers which report it
+    iServerArrivalLeadUs = 0;
+    Socket.SetSendDelayUs ( 0 );
+
     // enable channel
     Channel.SetEnable ( true );
 
@@ -1189,11 +1393,17 @@ int CClient::EstimatedOverallDelay ( const int iPingTimeMs )
     // OPUS additional delay at small frame sizes is half a frame size
     const double dAdditionalAudioCodecDelayMs = dSystemBlockDurationMs / 2;
 
+    // the server reports how long our packets wait for the next mix tick,
+    // the delay of our send phase is the part of the wait which was moved
+    // from the server to us, so it is not added again
+    const double dServerArrivalLeadMs = static_cast<double> ( iServerArrivalLeadUs ) / 1000;
+
     const double dTotalBufferDelayMs =
         dDelayToFillNetworkPacketsMs +
         dTotalJitterBufferDelayMs +
         dTotalSoundCardDelayMs +
-        dAdditionalAudioCodecDelayMs;
+        dAdditionalAudioCodecDelayMs +
+        dServerArrivalLeadMs;
 
     return MathUtils::round ( dTotalBufferDelayMs + iPingTimeMs );
 }
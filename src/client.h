@@ -97,6 +97,16 @@
 #define OPUS_NUM_BYTES_STEREO_NORMAL_QUALITY_DBLE_FRAMESIZE 71
 #define OPUS_NUM_BYTES_STEREO_HIGH_QUALITY_DBLE_FRAMESIZE   142
 
+// the audio packets are delayed so that they arrive shortly before the server
+// mix tick, the lead is a fixed margin plus a multiple of the arrival jitter
+// reported by the server (the delay is corrected by the given fraction of the
+// phase error per report of the server, limited to the given fraction of the
+// tick period)
+#define SEND_PHASE_MIN_LEAD_US                              250
+#define SEND_PHASE_JITTER_FACTOR                            3
+#define SEND_PHASE_CTRL_GAIN                                0.5
+#define SEND_PHASE_CTRL_MAX_STEP                            0.125
+
 
 /* Classes ********************************************************************/
 class CClient : public QObject
@@ -120,6 +130,9 @@ public:
 
     bool   GetAndResetbJitterBufferOKFlag();
 
+    // emulation of network impairments for tests
+    void   EnableNetImpairment ( const CNetImpairmentParams& Params ) { Socket.EnableNetImpairment ( Params ); }
+
     bool   IsConnected() { return Channel.IsConnected(); }
 
     EGUIDesign GetGUIDesign() const { return eGUIDesign; }
@@ -207,6 +220,9 @@ public:
     void SetEnableOPUS64 ( const bool eNEnableOPUS64 );
     bool GetEnableOPUS64() { return bEnableOPUS64; }
 
+    void SetEnableRedundancy ( const bool bNEnableRedundancy );
+    bool GetEnableRedundancy() { return Channel.GetRedundancyRequested(); }
+
     int GetSndCrdActualMonoBlSize()
     {
         // the actual sound card mono block size depends on whether a
@@ -387,6 +403,17 @@ protected:
     // for ping measurement
     CPreciseTime            PreciseTime;
 
+    // arrival phase of our audio packets at the server mix tick
+    int                     iServerArrivalLeadUs;
+
+    // connected clients list to which the changes sent by the server are
+    // applied and its version (invalid if we do not have a complete list)
+    CVector<CChannelInfo>   vecConClientList;
+    int                     iConClientListVersion;
+
+    // channel levels to which the changed levels sent by the server are applied
+    CVector<uint16_t>       vecChannelLevels;
+
     CSignalHandler*         pSignalHandler;
 
 public slots:
@@ -413,8 +440,20 @@ public slots:
                                           int          iMs,
                                           int          iNumClients );
 
+    void OnCLTickPhaseReceived ( CHostAddress InetAddr,
+                                 int          iTickPeriodUs,
+                                 int          iArrivalLeadUs,
+                                 int          iArrivalJitterUs );
+
     void OnSndCrdReinitRequest ( int iSndCrdResetType );
 
+    void OnConClientListDeltaMesReceived ( int                             iVersion,
+                                           bool                            bIsFullList,
+                                           CVector<CChannelListDeltaEntry> vecDelta );
+
+    void OnCLChannelLevelListDeltaReceived ( CHostAddress      InetAddr,
+                                             CVector<uint16_t> vecLevelList );
+
 signals:
     void ConClientListMesReceived ( CVector<CChannelInfo> vecChanInfo );
     void ChatTextReceived ( QString strChatText );
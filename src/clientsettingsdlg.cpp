@@ -130,6 +130,17 @@ CClientSettingsDlg::CClientSettingsDlg ( CClient* pNCliP, QWidget* parent,
 
     chbEnableOPUS64->setAccessibleName ( tr ( "Enable small network buffers check box" ) );
 
+    // enable packet redundancy
+    chbEnableRedundancy->setWhatsThis ( "<b>" + tr ( "Redundancy" ) + ":</b> " + tr (
+        "If enabled, each network audio packet additionally carries a copy of the "
+        "previous packet so that a single lost packet can be restored. With this "
+        "setting, a smaller jitter buffer size can be used on networks with "
+        "occasional packet loss. But at the same time the upload and download "
+        "network rates are doubled. The setting is only active if the server "
+        "supports it." ) );
+
+    chbEnableRedundancy->setAccessibleName ( tr ( "Enable packet redundancy check box" ) );
+
     // sound card buffer delay
     QString strSndCrdBufDelay = "<b>" + tr ( "Sound Card Buffer Delay" ) + ":</b> " +
         tr ( "The buffer delay setting is a fundamental setting of this "
@@ -345,6 +356,9 @@ CClientSettingsDlg::CClientSettingsDlg ( CClient* pNCliP, QWidget* parent,
     // update enable small network buffers check box
     chbEnableOPUS64->setCheckState ( pClient->GetEnableOPUS64() ? Qt::Checked : Qt::Unchecked );
 
+    // update enable packet redundancy check box
+    chbEnableRedundancy->setCheckState ( pClient->GetEnableRedundancy() ? Qt::Checked : Qt::Unchecked );
+
     // set text for sound card buffer delay radio buttons
     rbtBufferDelayPreferred->setText ( GenSndCrdBufferDelayString (
         FRAME_SIZE_FACTOR_PREFERRED * SYSTEM_FRAME_SIZE_SAMPLES ) );
@@ -386,6 +400,9 @@ CClientSettingsDlg::CClientSettingsDlg ( CClient* pNCliP, QWidget* parent,
     QObject::connect ( chbEnableOPUS64, &QCheckBox::stateChanged,
         this, &CClientSettingsDlg::OnEnableOPUS64StateChanged );
 
+    QObject::connect ( chbEnableRedundancy, &QCheckBox::stateChanged,
+        this, &CClientSettingsDlg::OnEnableRedundancyStateChanged );
+
     // line edits
     QObject::connect ( edtCentralServerAddress, &QLineEdit::editingFinished,
         this, &CClientSettingsDlg::OnCentralServerAddressEditingFinished );
@@ -655,6 +672,12 @@ void CClientSettingsDlg::OnEnableOPUS64StateChanged ( int value )
     UpdateDisplay();
 }
 
+void CClientSettingsDlg::OnEnableRedundancyStateChanged ( int value )
+{
+    pClient->SetEnableRedundancy ( value == Qt::Checked );
+    UpdateDisplay();
+}
+
 void CClientSettingsDlg::OnDisplayChannelLevelsStateChanged ( int value )
 {
     pClient->SetDisplayChannelLevels ( value != Qt::Unchecked );
@@ -192,6 +192,10 @@ LED bar:      lbr
 // defines the interval between Channel Level updates from the server
 #define CHANNEL_LEVEL_UPDATE_INTERVAL    200  // number of frames at 64 samples frame size
 
+// the clients which only get the changed channel levels get all levels every
+// this number of channel level updates
+#define CHANNEL_LEVEL_FULL_LIST_INTERVAL 4
+
 // time-out until a registered server is deleted from the server list if no
 // new registering was made in minutes
 #define SERVLIST_TIME_OUT_MINUTES        33 // minutes (should include 3 UDP registration messages)
@@ -0,0 +1,576 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#include "loadgenerator.h"
+#include <QFile>
+#include <QtEndian>
+
+
+/* Implementation *************************************************************/
+// Virtual client implementation ***********************************************
+CVirtualClient::CVirtualClient ( const int               iNewID,
+                                 const CHostAddress&     NewServerAddr,
+                                 const CVector<int16_t>& vecsNewSource ) :
+    iID                ( iNewID ),
+    ServerAddr         ( NewServerAddr ),
+    vecsSource         ( vecsNewSource ),
+    iSourcePos         ( 0 ),
+    Channel            ( false ), /* we need a client channel -> "false" */
+    ConnLessProtocol   (),
+    Socket             ( &Channel, 0 /* random port */ ),
+    iCeltNumCodedBytes ( OPUS_NUM_BYTES_MONO_NORMAL_QUALITY_DBLE_FRAMESIZE ),
+    iNumFrames         ( 0 ),
+    iNumUnderruns      ( 0 ),
+    iNumPings          ( 0 ),
+    iSumPingTimeMs     ( 0 ),
+    iMaxPingTimeMs     ( 0 )
+{
+    int iOpusError;
+
+    // the virtual clients use the default client settings: mono, normal
+    // audio quality and 128 samples frame size
+    OpusMode    = opus_custom_mode_create ( SYSTEM_SAMPLE_RATE_HZ,
+                                            DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES,
+                                            &iOpusError );
+
+    OpusEncoder = opus_custom_encoder_create ( OpusMode, 1, &iOpusError );
+    OpusDecoder = opus_custom_decoder_create ( OpusMode, 1, &iOpusError );
+
+    opus_custom_encoder_ctl ( OpusEncoder, OPUS_SET_VBR ( 0 ) );
+    opus_custom_encoder_ctl ( OpusEncoder, OPUS_SET_COMPLEXITY ( 1 ) );
+
+    vecsAudio.Init     ( DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES );
+    vecCeltData.Init   ( iCeltNumCodedBytes );
+    vecbyNetwData.Init ( iCeltNumCodedBytes );
+
+    // start at a different position in the source signal for each client so
+    // that the mix at the server is not just a scaled version of one client
+    iSourcePos = ( iID * 7919 ) % vecsSource.Size();
+    iSourcePos -= iSourcePos % DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES;
+
+    ChannelInfo.strName = QString ( "Load %1" ).arg ( iID );
+
+    Channel.SetDoAutoSockBufSize ( true );
+    Channel.SetAddress ( ServerAddr );
+
+
+    // Connections -------------------------------------------------------------
+    QObject::connect ( &Channel, &CChannel::MessReadyForSending,
+        this, &CVirtualClient::OnSendProtMessage );
+
+    QObject::connect ( &Channel, &CChannel::DetectedCLMessage,
+        this, &CVirtualClient::OnDetectedCLMessage );
+
+    QObject::connect ( &Channel, &CChannel::ReqJittBufSize,
+        this, &CVirtualClient::OnReqJittBufSize );
+
+    QObject::connect ( &Channel, &CChannel::ReqChanInfo,
+        this, &CVirtualClient::OnReqChanInfo );
+
+    QObject::connect ( &Channel, &CChannel::NewConnection,
+        this, &CVirtualClient::OnNewConnection );
+
+    QObject::connect ( &ConnLessProtocol, &CProtocol::CLMessReadyForSending,
+        this, &CVirtualClient::OnSendCLProtMessage );
+
+    QObject::connect ( &ConnLessProtocol, &CProtocol::CLPingReceived,
+        this, &CVirtualClient::OnCLPingReceived );
+
+    Socket.Start();
+}
+
+CVirtualClient::~CVirtualClient()
+{
+    Stop();
+
+    opus_custom_encoder_destroy ( OpusEncoder );
+    opus_custom_decoder_destroy ( OpusDecoder );
+    opus_custom_mode_destroy ( OpusMode );
+}
+
+void CVirtualClient::Start()
+{
+    // the network transport properties are sent to the server which
+    // initiates the connection with the first audio packet
+    Channel.SetAudioStreamProperties ( CT_OPUS,
+                                       iCeltNumCodedBytes,
+                                       1, /* network frame size factor */
+                                       1  /* mono */ );
+
+    Channel.SetEnable ( true );
+}
+
+void CVirtualClient::Stop()
+{
+    if ( Channel.IsEnabled() )
+    {
+        // tell the server that we are gone
+        ConnLessProtocol.CreateCLDisconnection ( ServerAddr );
+        Channel.SetEnable ( false );
+    }
+}
+
+void CVirtualClient::ProcessFrame()
+{
+    // Transmit signal ---------------------------------------------------------
+    // take the next block of the source signal (the source length is a
+    // multiple of the frame size)
+    for ( int i = 0; i < DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES; i++ )
+    {
+        vecsAudio[i] = vecsSource[iSourcePos + i];
+    }
+
+    iSourcePos += DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES;
+
+    if ( iSourcePos >= vecsSource.Size() )
+    {
+        iSourcePos = 0;
+    }
+
+    opus_custom_encode ( OpusEncoder,
+                         &vecsAudio[0],
+                         DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES,
+                         &vecCeltData[0],
+                         iCeltNumCodedBytes );
+
+    Channel.PrepAndSendPacket ( &Socket,
+                                vecCeltData,
+                                iCeltNumCodedBytes );
+
+
+    // Receive signal ----------------------------------------------------------
+    const bool bReceiveDataOk =
+        ( Channel.GetData ( vecbyNetwData, iCeltNumCodedBytes ) == GS_BUFFER_OK );
+
+    // we decode the received data to get the same processing load as a
+    // real client (for lost packets use null pointer as coded input data)
+    opus_custom_decode ( OpusDecoder,
+                         bReceiveDataOk ? &vecbyNetwData[0] : nullptr,
+                         iCeltNumCodedBytes,
+                         &vecsAudio[0],
+                         DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES );
+
+    // only count frames when we are connected (a frame which is not
+    // available in the jitter buffer is an underrun, it may have been lost in
+    // the network or it may just arrive too late)
+    if ( Channel.IsConnected() )
+    {
+        iNumFrames++;
+
+        if ( !bReceiveDataOk )
+        {
+            iNumUnderruns++;
+        }
+    }
+
+    Channel.UpdateSocketBufferSize();
+}
+
+void CVirtualClient::CreateCLPingMes()
+{
+    ConnLessProtocol.CreateCLPingMes ( ServerAddr, PreciseTime.elapsed() );
+}
+
+QString CVirtualClient::GetAndResetStatistics()
+{
+    // per client: jitter buffer underrun rate, jitter buffer size chosen by
+    // the auto jitter buffer algorithm and round trip time
+    const double dUnderrunPercent = iNumFrames > 0 ?
+        100.0 * iNumUnderruns / iNumFrames : 0.0;
+
+    const int iAvPingTimeMs = iNumPings > 0 ?
+        iSumPingTimeMs / iNumPings : 0;
+
+    const QString strStatistics = QString ( "%1: %2, underruns %3 %, jitbuf %4, rtt %5/%6 ms" ).
+        arg ( iID, 4 ).
+        arg ( Channel.IsConnected() ? "connected" : "not connected" ).
+        arg ( dUnderrunPercent, 0, 'f', 2 ).
+        arg ( Channel.GetSockBufNumFrames() ).
+        arg ( iAvPingTimeMs ).
+        arg ( iMaxPingTimeMs );
+
+    iNumFrames     = 0;
+    iNumUnderruns  = 0;
+    iNumPings      = 0;
+    iSumPingTimeMs = 0;
+    iMaxPingTimeMs = 0;
+
+    return strStatistics;
+}
+
+void CVirtualClient::OnSendProtMessage ( CVector<uint8_t> vecMessage )
+{
+    Socket.SendPacket ( vecMessage, Channel.GetAddress() );
+}
+
+void CVirtualClient::OnSendCLProtMessage ( CHostAddress     InetAddr,
+                                           CVector<uint8_t> vecMessage )
+{
+    Socket.SendPacket ( vecMessage, InetAddr );
+}
+
+void CVirtualClient::OnDetectedCLMessage ( CVector<uint8_t> vecbyMesBodyData,
+                                           int              iRecID,
+                                           CHostAddress     RecHostAddr )
+{
+    ConnLessProtocol.ParseConnectionLessMessageBody ( vecbyMesBodyData,
+                                                      iRecID,
+                                                      RecHostAddr );
+}
+
+void CVirtualClient::OnNewConnection()
+{
+    // same as for a real client: send infos and the jitter buffer size
+    Channel.SetRemoteInfo ( ChannelInfo );
+    OnReqJittBufSize();
+}
+
+void CVirtualClient::OnCLPingReceived ( CHostAddress InetAddr,
+                                        int          iMs )
+{
+    if ( InetAddr == ServerAddr )
+    {
+        const int iCurDiff = PreciseTime.elapsed() - iMs;
+
+        // take care of wrap arounds (if wrapping, do not use result)
+        if ( iCurDiff >= 0 )
+        {
+            iNumPings++;
+            iSumPingTimeMs += iCurDiff;
+            iMaxPingTimeMs  = std::max ( iMaxPingTimeMs, iCurDiff );
+        }
+    }
+}
+
+
+// Load generator implementation ***********************************************
+CLoadGenerator::CLoadGenerator ( const QString& strServerAddr,
+                                 const int      iNumClients,
+                                 const QString& strWaveFileName,
+                                 QTextStream&   tsNConsole ) :
+    tsConsole          ( tsNConsole ),
+    HighPrecisionTimer ( true ) /* 128 samples frame size */
+{
+    CHostAddress ServerAddr;
+
+    if ( !NetworkUtil().ParseNetworkAddress ( strServerAddr, ServerAddr ) )
+    {
+        throw CGenErr ( "The server address of the load generator is invalid." );
+    }
+
+    // audio source signal
+    if ( strWaveFileName.isEmpty() )
+    {
+        GenSyntheticSource();
+    }
+    else if ( !LoadWaveFile ( strWaveFileName ) )
+    {
+        throw CGenErr ( "The wave file could not be loaded (only 16 bit PCM "
+            "files with 48 kHz sample rate are supported)." );
+    }
+
+    // create the virtual clients
+    vecpClients.Init ( iNumClients );
+
+    for ( int i = 0; i < iNumClients; i++ )
+    {
+        vecpClients[i] = new CVirtualClient ( i, ServerAddr, vecsSource );
+        vecpClients[i]->Start();
+    }
+
+    tsConsole << "- load generator started " << iNumClients <<
+        " virtual clients connecting to " << strServerAddr << endl;
+
+
+    // Connections -------------------------------------------------------------
+    QObject::connect ( &HighPrecisionTimer, &CHighPrecisionTimer::timeout,
+        this, &CLoadGenerator::OnTimer );
+
+    QObject::connect ( &TimerPing, &QTimer::timeout,
+        this, &CLoadGenerator::OnTimerPing );
+
+    QObject::connect ( &TimerReport, &QTimer::timeout,
+        this, &CLoadGenerator::OnTimerReport );
+
+    HighPrecisionTimer.Start();
+    TimerPing.start ( LOAD_GEN_PING_INTERVAL_MS );
+    TimerReport.start ( LOAD_GEN_REPORT_INTERVAL_MS );
+}
+
+CLoadGenerator::~CLoadGenerator()
+{
+    HighPrecisionTimer.Stop();
+
+    for ( int i = 0; i < vecpClients.Size(); i++ )
+    {
+        delete vecpClients[i];
+    }
+}
+
+void CLoadGenerator::GenSyntheticSource()
+{
+    const double dPi = 3.14159265358979323846;
+
+    // a chord of three tones plus some noise so that the encoder has to do
+    // similar work as for a real instrument signal
+    vecsSource.Init ( LOAD_GEN_SYNTH_SOURCE_LEN );
+
+    for ( int i = 0; i < LOAD_GEN_SYNTH_SOURCE_LEN; i++ )
+    {
+        const double dTime = static_cast<double> ( i ) / SYSTEM_SAMPLE_RATE_HZ;
+
+        vecsSource[i] = Double2Short ( 4000.0 * (
+            sin ( 2 * dPi * 220.0 * dTime ) +
+            sin ( 2 * dPi * 277.2 * dTime ) +
+            sin ( 2 * dPi * 329.6 * dTime ) ) +
+            500.0 * ( 2.0 * rand() / RAND_MAX - 1.0 ) );
+    }
+}
+
+bool CLoadGenerator::LoadWaveFile ( const QString& strFileName )
+{
+    QFile WaveFile ( strFileName );
+
+    if ( !WaveFile.open ( QIODevice::ReadOnly ) )
+    {
+        return false;
+    }
+
+    const QByteArray baWave = WaveFile.readAll();
+    const uchar*     pData  = reinterpret_cast<const uchar*> ( baWave.constData() );
+
+    if ( ( baWave.size() < 12 ) ||
+         !baWave.startsWith ( "RIFF" ) ||
+         ( baWave.mid ( 8, 4 ) != "WAVE" ) )
+    {
+        return false;
+    }
+
+    // search for the format and data chunks
+    int iNumChannels = 0;
+    int iPos         = 12;
+
+    while ( iPos + 8 <= baWave.size() )
+    {
+        const QByteArray baChunkID   = baWave.mid ( iPos, 4 );
+        const int        iChunkSize  = static_cast<int> ( qFromLittleEndian<quint32> ( pData + iPos + 4 ) );
+        const int        iChunkStart = iPos + 8;
+
+        if ( ( iChunkSize < 0 ) || ( iChunkStart + iChunkSize > baWave.size() ) )
+        {
+            return false;
+        }
+
+        if ( ( baChunkID == "fmt " ) && ( iChunkSize >= 16 ) )
+        {
+            const int iFormat     = qFromLittleEndian<quint16> ( pData + iChunkStart );
+            const int iSampleRate = static_cast<int> ( qFromLittleEndian<quint32> ( pData + iChunkStart + 4 ) );
+            const int iBitsPerSam = qFromLittleEndian<quint16> ( pData + iChunkStart + 14 );
+
+            iNumChannels = qFromLittleEndian<quint16> ( pData + iChunkStart + 2 );
+
+            if ( ( iFormat != 1 /* PCM */ ) || ( iSampleRate != SYSTEM_SAMPLE_RATE_HZ ) ||
+                 ( iBitsPerSam != 16 ) || ( iNumChannels < 1 ) )
+            {
+                return false;
+            }
+        }
+        else if ( ( baChunkID == "data" ) && ( iNumChannels > 0 ) )
+        {
+            // down-mix to mono and cut the signal to a multiple of the frame
+            // size (we need at least one frame)
+            int iNumSamples = iChunkSize / ( 2 * iNumChannels );
+            iNumSamples    -= iNumSamples % DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES;
+
+            if ( iNumSamples == 0 )
+            {
+                return false;
+            }
+
+            vecsSource.Init ( iNumSamples );
+
+            for ( int i = 0; i < iNumSamples; i++ )
+            {
+                int iSum = 0;
+
+                for ( int j = 0; j < iNumChannels; j++ )
+                {
+                    iSum += static_cast<int16_t> ( qFromLittleEndian<quint16> (
+                        pData + iChunkStart + 2 * ( i * iNumChannels + j ) ) );
+                }
+
+                vecsSource[i] = static_cast<int16_t> ( iSum / iNumChannels );
+            }
+
+            return true;
+        }
+
+        // chunks are word aligned
+        iPos = iChunkStart + iChunkSize + ( iChunkSize & 1 );
+    }
+
+    return false;
+}
+
+void CLoadGenerator::OnTimer()
+{
+    for ( int i = 0; i < vecpClients.Size(); i++ )
+    {
+        vecpClients[i]->ProcessFrame();
+    }
+}
+
+void CLoadGenerator::OnTimerPing()
+{
+    for ( int i = 0; i < vecpClients.Size(); i++ )
+    {
+        vecpClients[i]->CreateCLPingMes();
+    }
+}
+
+void CLoadGenerator::OnTimerReport()
+{
+    tsConsole << "- load generator statistics:" << endl;
+
+    for ( int i = 0; i < vecpClients.Size(); i++ )
+    {
+        tsConsole << "  " << vecpClients[i]->GetAndResetStatistics() << endl;
+    }
+}
+
+
+// Packet replay implementation ************************************************
+CPacketReplay::CPacketReplay ( const QString& strServerAddr,
+                               QTextStream&   tsNConsole ) :
+    tsConsole ( tsNConsole )
+{
+    if ( !NetworkUtil().ParseNetworkAddress ( strServerAddr, ServerAddr ) )
+    {
+        throw CGenErr ( "The server address of the packet replay is invalid." );
+    }
+}
+
+CPacketReplay::~CPacketReplay()
+{
+    for ( int i = 0; i < vecpSockets.Size(); i++ )
+    {
+        delete vecpSockets[i];
+    }
+}
+
+void CPacketReplay::Run ( const QString& strCaptureFileName,
+                          const int      iNumCopies,
+                          const double   dSpeed )
+{
+    std::vector<CCapturedPacket> vecPackets;
+
+    if ( !CPacketCapture::ReadFile ( strCaptureFileName, vecPackets ) )
+    {
+        throw CGenErr ( "The capture file could not be read." );
+    }
+
+    if ( vecPackets.empty() )
+    {
+        tsConsole << "- the capture file does not contain any packets" << endl;
+        return;
+    }
+
+    // each sender address of the capture is a client
+    QMap<QPair<quint32, quint16>, int> mapClients;
+    CVector<int>                       veciPacketClient ( static_cast<int> ( vecPackets.size() ) );
+
+    for ( size_t i = 0; i < vecPackets.size(); i++ )
+    {
+        const QPair<quint32, quint16> Addr ( vecPackets[i].HostAddr.InetAddr.toIPv4Address(),
+                                             vecPackets[i].HostAddr.iPort );
+
+        if ( !mapClients.contains ( Addr ) )
+        {
+            mapClients.insert ( Addr, mapClients.size() );
+        }
+
+        veciPacketClient[static_cast<int> ( i )] = mapClients.value ( Addr );
+    }
+
+    // the copies of a client are the sockets iClient * iNumCopies + iCopy
+    for ( int i = 0; i < mapClients.size() * iNumCopies; i++ )
+    {
+        QUdpSocket* pSocket = new QUdpSocket();
+        vecpSockets.Add ( pSocket );
+
+        if ( !pSocket->bind ( QHostAddress ( QHostAddress::AnyIPv4 ), 0 ) )
+        {
+            throw CGenErr ( "The sockets of the packet replay could not be created "
+                "(maybe the limit of open files is too low)." );
+        }
+    }
+
+    const qint64 iFirstTimeNs = vecPackets.front().iTimeNs;
+
+    tsConsole << "- replay of " << vecPackets.size() << " packets (" <<
+        ( vecPackets.back().iTimeNs - iFirstTimeNs ) / 1000000000 << " s) of " <<
+        mapClients.size() << " clients with " << iNumCopies << " copies each" << endl;
+
+    QElapsedTimer ElapsedTimer;
+    qint64        iMaxLateNs     = 0;
+    qint64        iNextReportSec = PACKET_REPLAY_REPORT_INTERVAL_SEC;
+
+    ElapsedTimer.start();
+
+    for ( size_t i = 0; i < vecPackets.size(); i++ )
+    {
+        const CCapturedPacket& Packet = vecPackets[i];
+
+        // original time of the packet relative to the start of the replay
+        const qint64 iReplayTimeNs = static_cast<qint64> ( ( Packet.iTimeNs - iFirstTimeNs ) / dSpeed );
+        const qint64 iWaitNs       = iReplayTimeNs - ElapsedTimer.nsecsElapsed();
+
+        if ( iWaitNs >= 1000 )
+        {
+            QThread::usleep ( static_cast<unsigned long> ( iWaitNs / 1000 ) );
+        }
+
+        iMaxLateNs = std::max ( iMaxLateNs, ElapsedTimer.nsecsElapsed() - iReplayTimeNs );
+
+        for ( int j = 0; j < iNumCopies; j++ )
+        {
+            vecpSockets[veciPacketClient[static_cast<int> ( i )] * iNumCopies + j]->writeDatagram (
+                reinterpret_cast<const char*> ( &Packet.vecbyData[0] ),
+                Packet.vecbyData.Size(),
+                ServerAddr.InetAddr,
+                ServerAddr.iPort );
+        }
+
+        if ( iReplayTimeNs / 1000000000 >= iNextReportSec )
+        {
+            tsConsole << "- replayed " << iNextReportSec << " s, maximum delay " <<
+                iMaxLateNs / 1000 << " us" << endl;
+
+            iNextReportSec += PACKET_REPLAY_REPORT_INTERVAL_SEC;
+        }
+    }
+
+    tsConsole << "- replay finished after " << ElapsedTimer.elapsed() / 1000 <<
+        " s, maximum delay " << iMaxLateNs / 1000 << " us" << endl;
+}
@@ -0,0 +1,195 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QTimer>
+#include <QTextStream>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QUdpSocket>
+#include <QMap>
+#include <QPair>
+#include <vector>
+#ifdef USE_OPUS_SHARED_LIB
+# include "opus/opus_custom.h"
+#else
+# include "opus_custom.h"
+#endif
+#include "global.h"
+#include "socket.h"
+#include "channel.h"
+#include "protocol.h"
+#include "server.h"
+#include "client.h"
+#include "packetcapture.h"
+#include "util.h"
+
+
+/* Definitions ****************************************************************/
+// interval of the ping messages for the round trip time measurement
+#define LOAD_GEN_PING_INTERVAL_MS           1000
+
+// interval for printing the statistics of the virtual clients
+#define LOAD_GEN_REPORT_INTERVAL_MS         5000
+
+// length of the synthetic audio source signal in samples (one second)
+#define LOAD_GEN_SYNTH_SOURCE_LEN           SYSTEM_SAMPLE_RATE_HZ
+
+// interval for printing the progress of a replay in replayed seconds
+#define PACKET_REPLAY_REPORT_INTERVAL_SEC   10
+
+
+/* Classes ********************************************************************/
+// Virtual client --------------------------------------------------------------
+// A virtual client behaves like a real client connected to a server (it uses
+// the regular channel and protocol implementation) but instead of a sound card
+// it uses a source signal and the received audio is only decoded.
+class CVirtualClient : public QObject
+{
+    Q_OBJECT
+
+public:
+    CVirtualClient ( const int               iNewID,
+                     const CHostAddress&     NewServerAddr,
+                     const CVector<int16_t>& vecsNewSource );
+
+    virtual ~CVirtualClient();
+
+    void Start();
+    void Stop();
+
+    void ProcessFrame();
+    void CreateCLPingMes();
+
+    QString GetAndResetStatistics();
+
+protected:
+    int                     iID;
+    CHostAddress            ServerAddr;
+    const CVector<int16_t>& vecsSource;
+    int                     iSourcePos;
+
+    CChannel                Channel;
+    CChannelCoreInfo        ChannelInfo;
+    CProtocol               ConnLessProtocol;
+    CHighPrioSocket         Socket;
+
+    OpusCustomMode*         OpusMode;
+    OpusCustomEncoder*      OpusEncoder;
+    OpusCustomDecoder*      OpusDecoder;
+    int                     iCeltNumCodedBytes;
+    CVector<int16_t>        vecsAudio;
+    CVector<uint8_t>        vecCeltData;
+    CVector<uint8_t>        vecbyNetwData;
+
+    // for ping measurement
+    CPreciseTime            PreciseTime;
+
+    // statistics
+    int                     iNumFrames;
+    int                     iNumUnderruns;
+    int                     iNumPings;
+    int                     iSumPingTimeMs;
+    int                     iMaxPingTimeMs;
+
+public slots:
+    void OnSendProtMessage ( CVector<uint8_t> vecMessage );
+
+    void OnSendCLProtMessage ( CHostAddress     InetAddr,
+                               CVector<uint8_t> vecMessage );
+
+    void OnDetectedCLMessage ( CVector<uint8_t> vecbyMesBodyData,
+                               int              iRecID,
+                               CHostAddress     RecHostAddr );
+
+    void OnReqJittBufSize() { Channel.CreateJitBufMes ( AUTO_NET_BUF_SIZE_FOR_PROTOCOL ); }
+    void OnReqChanInfo() { Channel.SetRemoteInfo ( ChannelInfo ); }
+    void OnNewConnection();
+
+    void OnCLPingReceived ( CHostAddress InetAddr,
+                            int          iMs );
+};
+
+
+// Load generator --------------------------------------------------------------
+// Starts a number of virtual clients which connect to the given server and
+// send paced audio packets so that the maximum number of clients of a server
+// can be determined without real clients.
+class CLoadGenerator : public QObject
+{
+    Q_OBJECT
+
+public:
+    CLoadGenerator ( const QString& strServerAddr,
+                     const int      iNumClients,
+                     const QString& strWaveFileName,
+                     QTextStream&   tsNConsole );
+
+    virtual ~CLoadGenerator();
+
+protected:
+    bool LoadWaveFile ( const QString& strFileName );
+    void GenSyntheticSource();
+
+    QTextStream&             tsConsole;
+    CVector<int16_t>         vecsSource;
+    CVector<CVirtualClient*> vecpClients;
+
+    CHighPrecisionTimer      HighPrecisionTimer;
+    QTimer                   TimerPing;
+    QTimer                   TimerReport;
+
+public slots:
+    void OnTimer();
+    void OnTimerPing();
+    void OnTimerReport();
+};
+
+
+// Packet replay ---------------------------------------------------------------
+// Sends the datagrams of a server capture (see --capture) to a server with the
+// original timing or faster. Each client of the capture is replayed with its
+// own socket, optionally several times with additional sockets so that the
+// load of an incident can be reproduced with multiplied client counts. The
+// answers of the server are ignored, i.e. the protocol messages are replayed
+// exactly as captured.
+class CPacketReplay
+{
+public:
+    CPacketReplay ( const QString& strServerAddr,
+                    QTextStream&   tsNConsole );
+
+    virtual ~CPacketReplay();
+
+    void Run ( const QString& strCaptureFileName,
+               const int      iNumCopies,
+               const double   dSpeed );
+
+protected:
+    QTextStream&         tsConsole;
+    CHostAddress         ServerAddr;
+    CVector<QUdpSocket*> vecpSockets;
+};
@@ -35,7 +35,18 @@
 # include "serverdlg.h"
 #endif
 #include "settings.h"
+#include "serveradmin.h"
+#include "recorder/cmixdown.h"
 #include "testbench.h"
+#ifdef LOAD_GENERATOR
+# include "loadgenerator.h"
+#endif
+#ifdef BENCHMARK
+# include "benchmark.h"
+#endif
+#ifdef SIMULATION
+# include "simulation.h"
+#endif
 #include "util.h"
 #ifdef ANDROID
 # include <QtAndroidExtras/QtAndroid>
@@ -67,27 +78,52 @@ int main ( int argc, char** argv )
     bool         bShowComplRegConnList       = false;
     bool         bDisconnectAllClientsOnQuit = false;
     bool         bUseDoubleSystemFrameSize   = true; // default is 128 samples frame size
+    bool         bUseDriftCompensation       = false;
+    bool         bUseAdaptiveComplexity      = false;
+    bool         bRecordCodedPackets         = false;
     bool         bShowAnalyzerConsole        = false;
     bool         bCentServPingServerInList   = false;
     bool         bNoAutoJackConnect          = false;
     bool         bUseTranslation             = true;
     bool         bCustomPortNumberGiven      = false;
+    bool         bRunBenchmark               = false;
     int          iNumServerChannels          = DEFAULT_USED_NUM_CHANNELS;
     int          iMaxDaysHistory             = DEFAULT_DAYS_HISTORY;
     int          iCtrlMIDIChannel            = INVALID_MIDI_CH;
+    int          iNumLoadGenClients          = 0;
+    int          iNumConnLessWorkers         = 1;
+    int          iPacketCaptureSizeMB        = PACKET_CAPTURE_DEFAULT_SIZE_MB;
+    int          iNumReplayCopies            = 1;
+    double       dReplaySpeed                = 1.0;
     quint16      iPortNumber                 = DEFAULT_PORT_NUMBER;
     ELicenceType eLicenceType                = LT_NO_LICENCE;
     QString      strConnOnStartupAddress     = "";
     QString      strIniFileName              = "";
     QString      strHTMLStatusFileName       = "";
+    QString      strJSONStatusFileName       = "";
+    QString      strAdminSocketName          = "";
     QString      strServerName               = "";
     QString      strLoggingFileName          = "";
     QString      strHistoryFileName          = "";
     QString      strRecordingDirName         = "";
+    QString      strDecodeRecordingDirName   = "";
+    QString      strMixdownDirName           = "";
+    QString      strMixdownSettingsFileName  = "";
+    QString      strStreamOutputName         = "";
+    QString      strStreamGainsFileName      = "";
+    QString      strPacketCaptureFileName    = "";
+    QString      strReplayFileName           = "";
     QString      strCentralServer            = "";
     QString      strServerInfo               = "";
     QString      strWelcomeMessage           = "";
     QString      strClientName               = APP_NAME;
+    QString      strLoadGenWaveFileName      = "";
+    QString      strBenchmarkBaselineName    = "";
+    QString      strSimulationConfigName     = "";
+    QString      strSimulationOutputDirName  = "";
+
+    // emulated network impairments of the client or server socket
+    CNetImpairmentParams NetImpairmentParams;
 
     // QT docu: argv()[0] is the program name, argv()[1] is the first
     // argument and argv()[argc()-1] is the last argument.
@@ -143,6 +179,30 @@ int main ( int argc, char** argv )
         }
 
 
+        // Clock drift compensation --------------------------------------------
+        if ( GetFlagArgument ( argv,
+                               i,
+                               "--driftcomp", // no short form
+                               "--driftcomp" ) )
+        {
+            bUseDriftCompensation = true;
+            tsConsole << "- clock drift compensation enabled" << endl;
+            continue;
+        }
+
+
+        // Adaptive encoder complexity -----------------------------------------
+        if ( GetFlagArgument ( argv,
+                               i,
+                               "--adaptcomplexity", // no short form
+                               "--adaptcomplexity" ) )
+        {
+            bUseAdaptiveComplexity = true;
+            tsConsole << "- adaptive encoder complexity enabled" << endl;
+            continue;
+        }
+
+
         // Maximum number of channels ------------------------------------------
         if ( GetNumericArgument ( tsConsole,
                                   argc,
@@ -163,6 +223,26 @@ int main ( int argc, char** argv )
         }
 
 
+        // Number of connection less message threads ---------------------------
+        if ( GetNumericArgument ( tsConsole,
+                                  argc,
+                                  argv,
+                                  i,
+                                  "--connlessthreads", // no short form
+                                  "--connlessthreads",
+                                  1,
+                                  MAX_NUM_CONN_LESS_WORKERS,
+                                  rDbleArgument ) )
+        {
+            iNumConnLessWorkers = static_cast<int> ( rDbleArgument );
+
+            tsConsole << "- number of connection less message threads: "
+                << iNumConnLessWorkers << endl;
+
+            continue;
+        }
+
+
         // Maximum days in history display -------------------------------------
         if ( GetNumericArgument ( tsConsole,
                                   argc,
@@ -336,6 +416,35 @@ int main ( int argc, char** argv )
             continue;
         }
 
+
+        // JSON status file ----------------------------------------------------
+        if ( GetStringArgument ( tsConsole,
+                                 argc,
+                                 argv,
+                                 i,
+                                 "--jsonstatus", // no short form
+                                 "--jsonstatus",
+                                 strArgument ) )
+        {
+            strJSONStatusFileName = strArgument;
+            tsConsole << "- JSON status file name: " << strJSONStatusFileName << endl;
+            continue;
+        }
+
+        // Admin socket --------------------------------------------------------
+        if ( GetStringArgument ( tsConsole,
+                                 argc,
+                                 argv,
+                                 i,
+                                 "--adminsocket", // no short form
+                                 "--adminsocket",
+                                 strArgument ) )
+        {
+            strAdminSocketName = strArgument;
+            tsConsole << "- admin socket name: " << strAdminSocketName << endl;
+            continue;
+        }
+
         if ( GetStringArgument ( tsConsole,
                                  argc,
                                  argv,
@@ -395,6 +504,125 @@ int main ( int argc, char** argv )
         }
 
 
+        // Record coded packets ------------------------------------------------
+        if ( GetFlagArgument ( argv,
+                               i,
+                               "--recordpackets", // no short form
+                               "--recordpackets" ) )
+        {
+            bRecordCodedPackets = true;
+            tsConsole << "- recording of the coded packets" << endl;
+            continue;
+        }
+
+
+        // Decode packet recording ---------------------------------------------
+        if ( GetStringArgument ( tsConsole,
+                                 argc,
+                                 argv,
+                                 i,
+                                 "--decoderecording", // no short form
+                                 "--decoderecording",
+                                 strArgument ) )
+        {
+            strDecodeRecordingDirName = strArgument;
+            tsConsole << "- decode packet recording: " << strDecodeRecordingDirName << endl;
+            continue;
+        }
+
+
+        // Mixdown of a recording ----------------------------------------------
+        if ( GetStringArgument ( tsConsole,
+                                 argc,
+                                 argv,
+                                 i,
+                                 "--mixdown", // no short form
+                                 "--mixdown",
+                                 strArgument ) )
+        {
+            strMixdownDirName = strArgument;
+            tsConsole << "- mixdown of recording: " << strMixdownDirName << endl;
+            continue;
+        }
+
+
+        // Mixdown settings file -----------------------------------------------
+        if ( GetStringArgument ( tsConsole,
+                                 argc,
+                                 argv,
+                                 i,
+                                 "--mixdownsettings", // no short form
+                                 "--mixdownsettings",
+                                 strArgument ) )
+        {
+            strMixdownSettingsFileName = strArgument;
+            tsConsole << "- mixdown settings file: " << strMixdownSettingsFileName << endl;
+            continue;
+        }
+
+
+        // Live mix stream output ----------------------------------------------
+        if ( GetStringArgument ( tsConsole,
+                                 argc,
+                                 argv,
+                                 i,
+                                 "--streamout", // no short form
+                                 "--streamout",
+                                 strArgument ) )
+        {
+            strStreamOutputName = strArgument;
+            tsConsole << "- live mix stream output: " << strStreamOutputName << endl;
+            continue;
+        }
+
+
+        // Live mix stream gains file ------------------------------------------
+        if ( GetStringArgument ( tsConsole,
+                                 argc,
+                                 argv,
+                                 i,
+                                 "--streamgains", // no short form
+                                 "--streamgains",
+                                 strArgument ) )
+        {
+            strStreamGainsFileName = strArgument;
+            tsConsole << "- live mix stream gains file: " << strStreamGainsFileName << endl;
+            continue;
+        }
+
+
+        // Packet capture file -------------------------------------------------
+        if ( GetStringArgument ( tsConsole,
+                                 argc,
+                                 argv,
+                                 i,
+                                 "--capture", // no short form
+                                 "--capture",
+                                 strArgument ) )
+        {
+            strPacketCaptureFileName = strArgument;
+            tsConsole << "- packet capture file: " << strPacketCaptureFileName << endl;
+            continue;
+        }
+
+
+        // Packet capture file size --------------------------------------------
+        if ( GetNumericArgument ( tsConsole,
+                                  argc,
+                                  argv,
+                                  i,
+                                  "--capturesize", // no short form
+                                  "--capturesize",
+                                  1,
+                                  65535,
+                                  rDbleArgument ) )
+        {
+            iPacketCaptureSizeMB = static_cast<int> ( rDbleArgument );
+            tsConsole << "- packet capture file size: " << iPacketCaptureSizeMB << " MB" << endl;
+            continue;
+        }
+
+
         // Central server ------------------------------------------------------
         if ( GetStringArgument ( tsConsole,
                                  argc,
@@ -470,6 +698,180 @@ int main ( int argc, char** argv )
         }
 
 
+#ifdef LOAD_GENERATOR
+        // Load generator ------------------------------------------------------
+        if ( GetNumericArgument ( tsConsole,
+                                  argc,
+                                  argv,
+                                  i,
+                                  "--loadgen", // no short form
+                                  "--loadgen",
+                                  1,
+                                  1000,
+                                  rDbleArgument ) )
+        {
+            iNumLoadGenClients = static_cast<int> ( rDbleArgument );
+            bUseGUI            = false;
+
+            tsConsole << "- load generator with virtual clients: "
+                << iNumLoadGenClients << endl;
+
+            continue;
+        }
+
+
+        // Load generator wave file --------------------------------------------
+        if ( GetStringArgument ( tsConsole,
+                                 argc,
+                                 argv,
+                                 i,
+                                 "--loadgenwav", // no short form
+                                 "--loadgenwav",
+                                 strArgument ) )
+        {
+            strLoadGenWaveFileName = strArgument;
+            tsConsole << "- load generator wave file: " << strLoadGenWaveFileName << endl;
+            continue;
+        }
+
+
+        // Packet replay -------------------------------------------------------
+        if ( GetStringArgument ( tsConsole,
+                                 argc,
+                                 argv,
+                                 i,
+                                 "--replay", // no short form
+                                 "--replay",
+                                 strArgument ) )
+        {
+            strReplayFileName = strArgument;
+            bUseGUI           = false;
+            tsConsole << "- replay of the capture file: " << strReplayFileName << endl;
+            continue;
+        }
+
+
+        // Packet replay copies ------------------------------------------------
+        if ( GetNumericArgument ( tsConsole,
+                                  argc,
+                                  argv,
+                                  i,
+                                  "--replaycopies", // no short form
+                                  "--replaycopies",
+                                  1,
+                                  100,
+                                  rDbleArgument ) )
+        {
+            iNumReplayCopies = static_cast<int> ( rDbleArgument );
+            tsConsole << "- replay copies of each client: " << iNumReplayCopies << endl;
+            continue;
+        }
+
+
+        // Packet replay speed -------------------------------------------------
+        if ( GetNumericArgument ( tsConsole,
+                                  argc,
+                                  argv,
+                                  i,
+                                  "--replayspeed", // no short form
+                                  "--replayspeed",
+                                  0.01,
+                                  100,
+                                  rDbleArgument ) )
+        {
+            dReplaySpeed = rDbleArgument;
+            tsConsole << "- replay speed factor: " << dReplaySpeed << endl;
+            continue;
+        }
+#endif
+
+
+#ifdef BENCHMARK
+        // Benchmark -----------------------------------------------------------
+        if ( GetFlagArgument ( argv,
+                               i,
+                               "--benchmark", // no short form
+                               "--benchmark" ) )
+        {
+            bRunBenchmark = true;
+            bUseGUI       = false;
+            tsConsole << "- run benchmark" << endl;
+            continue;
+        }
+
+
+        // Benchmark baseline file ---------------------------------------------
+        if ( GetStringArgument ( tsConsole,
+                                 argc,
+                                 argv,
+                                 i,
+                                 "--benchmarkbaseline", // no short form
+                                 "--benchmarkbaseline",
+                                 strArgument ) )
+        {
+            strBenchmarkBaselineName = strArgument;
+            tsConsole << "- benchmark baseline file: " << strBenchmarkBaselineName << endl;
+            continue;
+        }
+#endif
+
+
+#ifdef SIMULATION
+        // Offline server simulation -------------------------------------------
+        if ( GetStringArgument ( tsConsole,
+                                 argc,
+                                 argv,
+                                 i,
+                                 "--simulate", // no short form
+                                 "--simulate",
+                                 strArgument ) )
+        {
+            strSimulationConfigName = strArgument;
+            bUseGUI                 = false;
+            tsConsole << "- simulation configuration file: " << strSimulationConfigName << endl;
+            continue;
+        }
+
+
+        // Offline server simulation output directory --------------------------
+        if ( GetStringArgument ( tsConsole,
+                                 argc,
+                                 argv,
+                                 i,
+                                 "--simulateout", // no short form
+                                 "--simulateout",
+                                 strArgument ) )
+        {
+            strSimulationOutputDirName = strArgument;
+            tsConsole << "- simulation output directory: " << strSimulationOutputDirName << endl;
+            continue;
+        }
+#endif
+
+
+        // Network impairment emulation ----------------------------------------
+        if ( GetStringArgument ( tsConsole,
+                                 argc,
+                                 argv,
+                                 i,
+                                 "--netimpair", // no short form
+                                 "--netimpair",
+                                 strArgument ) )
+        {
+            if ( !NetImpairmentParams.Parse ( strArgument ) )
+            {
+                tsConsole << argv[0] << ": ";
+                tsConsole << "'--netimpair' needs a list of settings like "
+                    "'delay=20,jitter=5,loss=1' -- use '--help' for help" << endl;
+
+                exit ( 1 );
+            }
+
+            tsConsole << "- network impairment emulation: " << strArgument << endl;
+            continue;
+        }
+
+
         // Version number ------------------------------------------------------
         if ( ( !strcmp ( argv[i], "--version" ) ) ||
              ( !strcmp ( argv[i], "-v" ) ) )
@@ -606,7 +1008,82 @@ int main ( int argc, char** argv )
 
     try
     {
-        if ( bIsClient )
+#ifdef BENCHMARK
+        if ( bRunBenchmark )
+        {
+            // Benchmark:
+            // runs all benchmarks and quits the application afterwards
+            CBenchmark Benchmark ( tsConsole );
+            Benchmark.Run ( strBenchmarkBaselineName );
+        }
+        else
+#endif
+#ifdef SIMULATION
+        if ( !strSimulationConfigName.isEmpty() )
+        {
+            // Offline server simulation:
+            // runs the server with the configured clients on a virtual clock
+            // and quits the application afterwards
+            CSimulation Simulation ( bUseDoubleSystemFrameSize, tsConsole );
+            Simulation.Run ( strSimulationConfigName, strSimulationOutputDirName );
+        }
+        else
+#endif
+#ifdef LOAD_GENERATOR
+        if ( !strReplayFileName.isEmpty() )
+        {
+            // Packet replay:
+            // sends the captured datagrams to the server given by the connect
+            // option and quits the application afterwards
+            CPacketReplay PacketReplay ( strConnOnStartupAddress, tsConsole );
+            PacketReplay.Run ( strReplayFileName, iNumReplayCopies, dReplaySpeed );
+        }
+        else if ( iNumLoadGenClients > 0 )
+        {
+            // Load generator:
+            // the virtual clients connect to the server given by the connect
+            // option
+            CLoadGenerator LoadGenerator ( strConnOnStartupAddress,
+                                           iNumLoadGenClients,
+                                           strLoadGenWaveFileName,
+                                           tsConsole );
+
+            pApp->exec();
+        }
+        else
+#endif
+        if ( !strDecodeRecordingDirName.isEmpty() )
+        {
+            // Recording decoder:
+            // decodes the packet files of a recorded session and quits the
+            // application afterwards
+            try
+            {
+                recorder::CJamRecorder::DecodePacketSession ( strDecodeRecordingDirName );
+            }
+            catch ( const std::runtime_error& error )
+            {
+                tsConsole << error.what() << endl;
+            }
+        }
+        else if ( !strMixdownDirName.isEmpty() )
+        {
+            // Mixdown:
+            // renders a stereo mix of a recorded session and quits the
+            // application afterwards, the frame size must be the one the
+            // session was recorded with (see --fastupdate)
+            try
+            {
+                recorder::CMixdown::Render ( strMixdownDirName,
+                                             bUseDoubleSystemFrameSize ? DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES : SYSTEM_FRAME_SIZE_SAMPLES,
+                                             strMixdownSettingsFileName );
+            }
+            catch ( const std::runtime_error& error )
+            {
+                tsConsole << error.what() << endl;
+            }
+        }
+        else if ( bIsClient )
         {
             // Client:
             // actual client object
@@ -616,6 +1093,11 @@ int main ( int argc, char** argv )
                              bNoAutoJackConnect,
                              strClientName );
 
+            if ( NetImpairmentParams.bEnabled )
+            {
+                Client.EnableNetImpairment ( NetImpairmentParams );
+            }
+
             // load settings from init-file
             CSettings Settings ( &Client, strIniFileName );
             Settings.Load();
@@ -655,16 +1137,47 @@ int main ( int argc, char** argv )
                              strLoggingFileName,
                              iPortNumber,
                              strHTMLStatusFileName,
+                             strJSONStatusFileName,
                              strHistoryFileName,
                              strServerName,
                              strCentralServer,
                              strServerInfo,
                              strWelcomeMessage,
                              strRecordingDirName,
+                             bRecordCodedPackets,
                              bCentServPingServerInList,
                              bDisconnectAllClientsOnQuit,
                              bUseDoubleSystemFrameSize,
-                             eLicenceType );
+                             eLicenceType,
+                             iNumConnLessWorkers );
+
+            Server.SetUseDriftCompensation ( bUseDriftCompensation );
+            Server.SetUseAdaptiveComplexity ( bUseAdaptiveComplexity );
+
+            if ( NetImpairmentParams.bEnabled )
+            {
+                Server.EnableNetImpairment ( NetImpairmentParams );
+            }
+
+            if ( !strStreamOutputName.isEmpty() &&
+                 !Server.EnableMixStream ( strStreamOutputName, strStreamGainsFileName ) )
+            {
+                tsConsole << "- could not open the live mix stream: " << strStreamOutputName << endl;
+            }
+
+            if ( !strPacketCaptureFileName.isEmpty() &&
+                 !Server.EnablePacketCapture ( strPacketCaptureFileName, iPacketCaptureSizeMB ) )
+            {
+                tsConsole << "- could not open the packet capture file: " << strPacketCaptureFileName << endl;
+            }
+
+            // local socket for status queries
+            CServerAdmin ServerAdmin ( &Server );
+
+            if ( !strAdminSocketName.isEmpty() && !ServerAdmin.Start ( strAdminSocketName ) )
+            {
+                tsConsole << "- could not open the admin socket: " << strAdminSocketName << endl;
+            }
 
 #ifndef HEADLESS
             if ( bUseGUI )
@@ -747,10 +1260,34 @@ QString UsageArguments ( char **argv )
         "  -p, --port            set your local port number\n"
         "  -t, --notranslation   disable translation (use englisch language)\n"
         "  -v, --version         output version information and exit\n"
+        "  --decoderecording     decode the packet files of a recorded session\n"
+        "                        directory to wave files and exit\n"
+        "  --netimpair           emulate network impairments on the socket for\n"
+        "                        tests, comma separated list of delay=ms,\n"
+        "                        jitter=ms, dist=uniform|normal|pareto, loss=%,\n"
+        "                        burst=%, burstlen=n, burstloss=%, reorder=%,\n"
+        "                        dup=%, dir=send|recv|both, seed=n\n"
+        "  --mixdown             render a stereo mix of a recorded session\n"
+        "                        directory and exit (add -F if the session was\n"
+        "                        recorded with it)\n"
+        "  --mixdownsettings     file with lines \"track;gain;pan\" for --mixdown\n"
         "\nServer only:\n"
         "  -a, --servername      server name, required for HTML status\n"
+        "  --adaptcomplexity     lower the encoder complexity of single clients\n"
+        "                        if the server is near to overload\n"
+        "  --adminsocket         enable the local admin socket for JSON status\n"
+        "                        queries, set socket name or path\n"
+        "  --capture             write all received datagrams with time stamps\n"
+        "                        to the given file for a replay (see --replay)\n"
+        "  --capturesize         maximum size of the capture file in MB, the\n"
+        "                        oldest datagrams are overwritten (default 64)\n"
+        "  --connlessthreads     number of threads for processing connection\n"
+        "                        less messages, e.g. server list requests\n"
+        "                        (central server)\n"
         "  -d, --discononquit    disconnect all clients on quit\n"
         "  -D, --histdays        number of days of history to display\n"
+        "  --driftcomp           compensate the clock drift of the clients by\n"
+        "                        resampling\n"
         "  -e, --centralserver   address of the central server\n"
         "  -F, --fastupdate      use 64 samples frame size mode\n"
         "  -g, --pingservers     ping servers in list to keep NAT port open\n"
@@ -759,6 +1296,7 @@ QString UsageArguments ( char **argv )
         "  -L, --licence         a licence must be accepted on a new\n"
         "                        connection\n"
         "  -m, --htmlstatus      enable HTML status file, set file name\n"
+        "  --jsonstatus          enable JSON status file, set file name\n"
         "  -o, --serverinfo      infos of the server(s) in the format:\n"
         "                        [name];[city];[country as QLocale ID]; ...\n"
         "                        [server1 address];[server1 name]; ...\n"
@@ -767,7 +1305,14 @@ QString UsageArguments ( char **argv )
         "                        [server2 address]; ...\n"
         "  -R, --recording       enables recording and sets directory to contain\n"
         "                        recorded jams\n"
+        "  --recordpackets       record the received OPUS packets instead of the\n"
+        "                        decoded audio (see --decoderecording)\n"
         "  -s, --server          start server\n"
+        "  --streamout           write a live stereo mix as raw PCM (48 kHz,\n"
+        "                        16 bit) to a file or FIFO, or to the readers\n"
+        "                        of a local socket with \"local:[name]\"\n"
+        "  --streamgains         file with lines \"name;gain;pan\" for the\n"
+        "                        clients in the --streamout mix\n"
         "  -u, --numchannels     maximum number of channels\n"
         "  -w, --welcomemessage  welcome message on connect\n"
         "  -y, --history         enable connection history and set file name\n"
@@ -777,6 +1322,32 @@ QString UsageArguments ( char **argv )
         "  -j, --nojackconnect   disable auto Jack connections\n"
         "  --ctrlmidich          MIDI controller channel to listen\n"
         "  --clientname          client name (window title and jack client name)\n"
+#ifdef LOAD_GENERATOR
+        "\nLoad generator only:\n"
+        "  --loadgen             number of virtual clients connecting to the\n"
+        "                        server given by --connect\n"
+        "  --loadgenwav          16 bit, 48 kHz wave file as audio source of the\n"
+        "                        virtual clients (default: synthetic signal)\n"
+        "  --replay              send the datagrams of a capture file with the\n"
+        "                        original timing to the server given by --connect\n"
+        "  --replaycopies        number of copies of each captured client\n"
+        "  --replayspeed         speed factor of the replay (default 1)\n"
+#endif
+#ifdef BENCHMARK
+        "\nBenchmark only:\n"
+        "  --benchmark           run the benchmark of the audio and network\n"
+        "                        functions and exit\n"
+        "  --benchmarkbaseline   compare with the given baseline file, if the\n"
+        "                        file does not exist the results are stored in it\n"
+#endif
+#ifdef SIMULATION
+        "\nSimulation only:\n"
+        "  --simulate            run the server offline with the clients of the\n"
+        "                        given configuration file (lines with\n"
+        "                        name;file[;start s[;jitter ms[;loss %]]]) and exit\n"
+        "  --simulateout         directory for the received mix of each client\n"
+        "                        and the statistics of the simulation\n"
+#endif
         "\nExample: " + QString ( argv[0] ) + " -s --inifile myinifile.ini\n";
 }
 
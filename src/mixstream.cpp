@@ -0,0 +1,409 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#include "mixstream.h"
+
+
+/* Implementation *************************************************************/
+CMixStream::CMixStream() :
+    pThread              ( nullptr ),
+    pOwnerThread         ( nullptr ),
+    bUseLocalSocket      ( false ),
+    iFrameSizeSamples    ( SYSTEM_FRAME_SIZE_SAMPLES ),
+    iRingWriteIdx        ( 0 ),
+    iRingReadIdx         ( 0 ),
+    iNumDroppedFrames    ( 0 ),
+    bOutputFileWasOpened ( false )
+#ifndef _WIN32
+  , iOutputFd            ( -1 )
+#endif
+{
+    // Connections -------------------------------------------------------------
+    QObject::connect ( &TimerWrite, &QTimer::timeout,
+        this, &CMixStream::OnTimerWrite );
+
+    QObject::connect ( &LocalServer, &QLocalServer::newConnection,
+        this, &CMixStream::OnNewConnection );
+}
+
+CMixStream::~CMixStream()
+{
+    if ( pThread != nullptr )
+    {
+        // the timer, the local server and the sockets must be stopped in the
+        // stream thread and are moved back before the thread is stopped, so
+        // that they are destroyed in the thread they belong to
+        pOwnerThread = QThread::currentThread();
+
+        QMetaObject::invokeMethod ( this,
+                                    "OnStop",
+                                    Qt::BlockingQueuedConnection );
+
+        pThread->quit();
+        pThread->wait();
+        delete pThread;
+    }
+
+    CloseOutputFile();
+}
+
+bool CMixStream::Init ( const QString& strNOutputName,
+                        const QString& strGainsFileName,
+                        const int      iNFrameSizeSamples )
+{
+    strOutputName        = strNOutputName;
+    iFrameSizeSamples    = iNFrameSizeSamples;
+    bUseLocalSocket      = strOutputName.startsWith ( MIX_STREAM_LOCAL_SOCKET_PREFIX );
+    bOutputFileWasOpened = false;
+
+    if ( !strGainsFileName.isEmpty() && !ReadGainsFile ( strGainsFileName ) )
+    {
+        return false;
+    }
+
+    // the cache starts with the settings of an empty client name
+    const QPair<double, double> DefGainAndPan =
+        mapGainAndPan.value ( "", qMakePair ( 1.0, 0.5 ) );
+
+    vecstrChanNames.Init ( MAX_NUM_CHANNELS );
+    vecdChanGains.Init   ( MAX_NUM_CHANNELS, DefGainAndPan.first );
+    vecdChanPans.Init    ( MAX_NUM_CHANNELS, DefGainAndPan.second );
+
+    // stereo frames
+    vecsRing.Init ( MIX_STREAM_RING_NUM_FRAMES * 2 * iFrameSizeSamples );
+
+    if ( bUseLocalSocket )
+    {
+        const QString strSocketName =
+            strOutputName.mid ( QString ( MIX_STREAM_LOCAL_SOCKET_PREFIX ).length() );
+
+        // see CServerAdmin::Start()
+        QLocalServer::removeServer ( strSocketName );
+        LocalServer.setSocketOptions ( QLocalServer::UserAccessOption );
+
+        if ( !LocalServer.listen ( strSocketName ) )
+        {
+            return false;
+        }
+    }
+#ifndef _WIN32
+    else
+    {
+        // a reader of the FIFO which goes away must not terminate the server,
+        // the write fails instead
+        signal ( SIGPIPE, SIG_IGN );
+    }
+#endif
+
+    // the timer and the local server are not child objects and must be moved
+    // explicitly
+    pThread = new QThread();
+    moveToThread ( pThread );
+    TimerWrite.moveToThread ( pThread );
+    LocalServer.moveToThread ( pThread );
+    pThread->start();
+
+    // the timer must be started in its thread
+    QMetaObject::invokeMethod ( &TimerWrite,
+                                "start",
+                                Qt::QueuedConnection,
+                                Q_ARG ( int, MIX_STREAM_WRITE_INTERVAL_MS ) );
+
+    return true;
+}
+
+bool CMixStream::ReadGainsFile ( const QString& strGainsFileName )
+{
+    QFile GainsFile ( strGainsFileName );
+
+    if ( !GainsFile.open ( QIODevice::ReadOnly | QIODevice::Text ) )
+    {
+        return false;
+    }
+
+    // each line has the format "name;gain;pan" where the pan goes from 0
+    // (left) to 1 (right), clients which are not listed are mixed with unity
+    // gain in the center
+    QTextStream in ( &GainsFile );
+
+    while ( !in.atEnd() )
+    {
+        const QStringList slFields = in.readLine().split ( ";" );
+
+        if ( slFields.size() == 3 )
+        {
+            const double dPan = std::max ( 0.0, std::min ( 1.0, slFields[2].toDouble() ) );
+
+            mapGainAndPan.insert ( slFields[0].trimmed(),
+                                   qMakePair ( std::max ( 0.0, slFields[1].toDouble() ), dPan ) );
+        }
+    }
+
+    return true;
+}
+
+void CMixStream::GetGainAndPan ( const int      iChanID,
+                                 const QString& strName,
+                                 double&        dGain,
+                                 double&        dPan )
+{
+    // the settings are only looked up if the name of the channel has changed
+    if ( vecstrChanNames[iChanID] != strName )
+    {
+        const QPair<double, double> GainAndPan =
+            mapGainAndPan.value ( strName, qMakePair ( 1.0, 0.5 ) );
+
+        vecstrChanNames[iChanID] = strName;
+        vecdChanGains[iChanID]   = GainAndPan.first;
+        vecdChanPans[iChanID]    = GainAndPan.second;
+    }
+
+    dGain = vecdChanGains[iChanID];
+    dPan  = vecdChanPans[iChanID];
+}
+
+void CMixStream::PutFrame ( const CVector<int16_t>& vecsStereoData )
+{
+    const uint32_t iWriteIdx = iRingWriteIdx.load ( std::memory_order_relaxed );
+
+    if ( iWriteIdx - iRingReadIdx.load ( std::memory_order_acquire ) >= MIX_STREAM_RING_NUM_FRAMES )
+    {
+        // the stream thread is too slow, the tick must not wait for it
+        iNumDroppedFrames.fetch_add ( 1, std::memory_order_relaxed );
+        return;
+    }
+
+    const int iFrameLen = 2 * iFrameSizeSamples;
+
+    std::copy ( vecsStereoData.begin(),
+                vecsStereoData.begin() + iFrameLen,
+                vecsRing.begin() + ( iWriteIdx % MIX_STREAM_RING_NUM_FRAMES ) * iFrameLen );
+
+    iRingWriteIdx.store ( iWriteIdx + 1, std::memory_order_release );
+}
+
+void CMixStream::OnTimerWrite()
+{
+    // take all frames from the ring and convert them to little endian
+    const int      iFrameLen = 2 * iFrameSizeSamples;
+    const uint32_t iWriteIdx = iRingWriteIdx.load ( std::memory_order_acquire );
+    uint32_t       iReadIdx  = iRingReadIdx.load ( std::memory_order_relaxed );
+
+    if ( iWriteIdx == iReadIdx )
+    {
+        return;
+    }
+
+    QByteArray vecbyData ( static_cast<int> ( iWriteIdx - iReadIdx ) * iFrameLen * 2, 0 );
+    char*      pData = vecbyData.data();
+
+    for ( ; iReadIdx != iWriteIdx; iReadIdx++ )
+    {
+        const int16_t* psFrame = &vecsRing[( iReadIdx % MIX_STREAM_RING_NUM_FRAMES ) * iFrameLen];
+
+        for ( int i = 0; i < iFrameLen; i++, pData += 2 )
+        {
+            qToLittleEndian<qint16> ( psFrame[i], pData );
+        }
+    }
+
+    iRingReadIdx.store ( iReadIdx, std::memory_order_release );
+
+    if ( bUseLocalSocket )
+    {
+        // a reader which lags behind misses whole blocks, so the samples of
+        // the stream stay aligned
+        for ( int i = 0; i < vecpSockets.size(); i++ )
+        {
+            if ( vecpSockets[i]->bytesToWrite() < MIX_STREAM_MAX_PENDING_BYTES )
+            {
+                vecpSockets[i]->write ( vecbyData );
+            }
+        }
+    }
+    else
+    {
+        // the data are discarded as long as there is no reader of the FIFO
+        if ( !OpenOutputFile() )
+        {
+            return;
+        }
+
+        if ( vecbyPending.size() < MIX_STREAM_MAX_PENDING_BYTES )
+        {
+            vecbyPending.append ( vecbyData );
+        }
+
+        WriteOutputFile();
+    }
+}
+
+bool CMixStream::OpenOutputFile()
+{
+#ifdef _WIN32
+    if ( OutputFile.isOpen() )
+    {
+        return true;
+    }
+
+    OutputFile.setFileName ( strOutputName );
+
+    // a regular file is only truncated on the first open, after a write error
+    // the data are appended so that the recorded stream is not lost
+    QIODevice::OpenMode OpenMode = QIODevice::WriteOnly | QIODevice::Unbuffered;
+
+    if ( bOutputFileWasOpened )
+    {
+        OpenMode |= QIODevice::Append;
+    }
+
+    if ( !OutputFile.open ( OpenMode ) )
+    {
+        return false;
+    }
+#else
+    if ( iOutputFd >= 0 )
+    {
+        return true;
+    }
+
+    // a regular file is only truncated on the first open, after a write error
+    // the data are appended so that the recorded stream is not lost (for a
+    // FIFO both flags have no effect)
+    const int iFlags = O_WRONLY | O_CREAT | O_NONBLOCK |
+                       ( bOutputFileWasOpened ? O_APPEND : O_TRUNC );
+
+    // opening a FIFO without a reader fails instead of blocking the thread,
+    // it is tried again with the next block
+    iOutputFd = ::open ( strOutputName.toLocal8Bit().constData(), iFlags, 0644 );
+
+    if ( iOutputFd < 0 )
+    {
+        return false;
+    }
+#endif
+
+    bOutputFileWasOpened = true;
+
+    return true;
+}
+
+void CMixStream::CloseOutputFile()
+{
+#ifdef _WIN32
+    OutputFile.close();
+#else
+    if ( iOutputFd >= 0 )
+    {
+        ::close ( iOutputFd );
+        iOutputFd = -1;
+    }
+#endif
+
+    vecbyPending.clear();
+}
+
+void CMixStream::WriteOutputFile()
+{
+#ifdef _WIN32
+    if ( OutputFile.write ( vecbyPending ) < 0 )
+    {
+        CloseOutputFile();
+        return;
+    }
+
+    vecbyPending.clear();
+#else
+    while ( !vecbyPending.isEmpty() )
+    {
+        const ssize_t iNumWritten = ::write ( iOutputFd,
+                                              vecbyPending.constData(),
+                                              static_cast<size_t> ( vecbyPending.size() ) );
+
+        if ( iNumWritten > 0 )
+        {
+            vecbyPending.remove ( 0, static_cast<int> ( iNumWritten ) );
+        }
+        else if ( ( iNumWritten < 0 ) && ( errno == EINTR ) )
+        {
+            continue;
+        }
+        else if ( ( iNumWritten < 0 ) && ( ( errno == EAGAIN ) || ( errno == EWOULDBLOCK ) ) )
+        {
+            // the reader is slower than us, the rest is written with the next block
+            break;
+        }
+        else
+        {
+            // the reader of the FIFO has gone
+            CloseOutputFile();
+            break;
+        }
+    }
+#endif
+}
+
+void CMixStream::OnStop()
+{
+    TimerWrite.stop();
+    LocalServer.close();
+
+    // the sockets are disconnected first since closing a socket may emit its
+    // disconnected signal
+    foreach ( QLocalSocket* pSocket, vecpSockets )
+    {
+        QObject::disconnect ( pSocket, nullptr, this, nullptr );
+        delete pSocket;
+    }
+
+    vecpSockets.clear();
+
+    TimerWrite.moveToThread ( pOwnerThread );
+    LocalServer.moveToThread ( pOwnerThread );
+    moveToThread ( pOwnerThread );
+}
+
+void CMixStream::OnNewConnection()
+{
+    while ( LocalServer.hasPendingConnections() )
+    {
+        QLocalSocket* pSocket = LocalServer.nextPendingConnection();
+
+        vecpSockets.append ( pSocket );
+
+        QObject::connect ( pSocket, &QLocalSocket::disconnected,
+            this, &CMixStream::OnSocketDisconnected );
+    }
+}
+
+void CMixStream::OnSocketDisconnected()
+{
+    QLocalSocket* pSocket = qobject_cast<QLocalSocket*> ( sender() );
+
+    if ( pSocket != nullptr )
+    {
+        vecpSockets.removeAll ( pSocket );
+        pSocket->deleteLater();
+    }
+}
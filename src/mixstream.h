@@ -0,0 +1,145 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <QFile>
+#include <QTextStream>
+#include <QStringList>
+#include <QMap>
+#include <QPair>
+#include <QList>
+#include <QByteArray>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QtEndian>
+#include <atomic>
+#ifndef _WIN32
+# include <fcntl.h>
+# include <unistd.h>
+# include <signal.h>
+# include <errno.h>
+#endif
+#include "global.h"
+#include "util.h"
+
+
+/* Definitions ****************************************************************/
+// number of server frames in the ring between the server tick and the stream
+// thread (must be a power of two since the ring indices wrap around)
+#define MIX_STREAM_RING_NUM_FRAMES          1024
+
+// interval in which the stream thread writes the frames of the ring
+#define MIX_STREAM_WRITE_INTERVAL_MS        20
+
+// a reader which lags more than this behind does not get new data until it
+// has caught up (two seconds of stereo 16 bit audio)
+#define MIX_STREAM_MAX_PENDING_BYTES        ( 2 * SYSTEM_SAMPLE_RATE_HZ * 2 * 2 )
+
+// prefix of the stream output name which selects a local socket instead of
+// a file or FIFO
+#define MIX_STREAM_LOCAL_SOCKET_PREFIX      "local:"
+
+
+/* Classes ********************************************************************/
+// Live mix stream -------------------------------------------------------------
+// Writes a "program" mix of all clients as raw PCM (48 kHz, stereo, signed 16
+// bit little endian) to a file, a FIFO or to all readers of a local socket.
+// The mix is created in the server tick with its own gain and pan per client
+// and is passed through a lock-free ring to the stream thread, so the tick
+// never waits for the output.
+class CMixStream : public QObject
+{
+    Q_OBJECT
+
+public:
+    CMixStream();
+    virtual ~CMixStream();
+
+    // must be called before the first frame, starts the thread
+    bool Init ( const QString& strNOutputName,
+                const QString& strGainsFileName,
+                const int      iNFrameSizeSamples );
+
+    bool IsEnabled() const { return pThread != nullptr; }
+
+    // gain and pan of a client in the program mix, only called by the
+    // server tick (the settings of the last client name of a channel are kept)
+    void GetGainAndPan ( const int      iChanID,
+                         const QString& strName,
+                         double&        dGain,
+                         double&        dPan );
+
+    // only called by the server tick, a frame is dropped if the ring is full
+    void PutFrame ( const CVector<int16_t>& vecsStereoData );
+
+    uint32_t GetDroppedFrames() const { return iNumDroppedFrames.load ( std::memory_order_relaxed ); }
+
+protected:
+    bool ReadGainsFile ( const QString& strGainsFileName );
+    bool OpenOutputFile();
+    void CloseOutputFile();
+    void WriteOutputFile();
+
+    QThread*                               pThread;
+    QThread*                               pOwnerThread;
+    QTimer                                 TimerWrite;
+    QLocalServer                           LocalServer;
+    QList<QLocalSocket*>                   vecpSockets;
+
+    QString                                strOutputName;
+    bool                                   bUseLocalSocket;
+    int                                    iFrameSizeSamples;
+
+    // gain and pan by client name and the cached values of the channels
+    QMap<QString, QPair<double, double> >  mapGainAndPan;
+    CVector<QString>                       vecstrChanNames;
+    CVector<double>                        vecdChanGains;
+    CVector<double>                        vecdChanPans;
+
+    // the ring is written by the server tick and read by the stream thread
+    CVector<int16_t>                       vecsRing;
+    std::atomic<uint32_t>                  iRingWriteIdx;
+    std::atomic<uint32_t>                  iRingReadIdx;
+    std::atomic<uint32_t>                  iNumDroppedFrames;
+
+    // data which could not be written to the file or FIFO yet
+    QByteArray                             vecbyPending;
+    bool                                   bOutputFileWasOpened;
+
+#ifdef _WIN32
+    QFile                                  OutputFile;
+#else
+    int                                    iOutputFd;
+#endif
+
+public slots:
+    void OnStop();
+    void OnTimerWrite();
+    void OnNewConnection();
+    void OnSocketDisconnected();
+};
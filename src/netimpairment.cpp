@@ -0,0 +1,288 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#include "netimpairment.h"
+#include "socket.h"
+
+
+/* Implementation *************************************************************/
+bool CNetImpairmentParams::Parse ( const QString& strParams )
+{
+    const QStringList slParams = strParams.split ( ",", QString::SkipEmptyParts );
+
+    for ( int i = 0; i < slParams.size(); i++ )
+    {
+        const QStringList slKeyValue = slParams[i].split ( "=" );
+
+        if ( slKeyValue.size() != 2 )
+        {
+            return false;
+        }
+
+        const QString strKey   = slKeyValue[0].trimmed();
+        const QString strValue = slKeyValue[1].trimmed();
+
+        // the settings with names as values
+        if ( strKey == "dist" )
+        {
+            if ( strValue == "uniform" )
+            {
+                eJitterDist = JD_UNIFORM;
+            }
+            else if ( strValue == "normal" )
+            {
+                eJitterDist = JD_NORMAL;
+            }
+            else if ( strValue == "pareto" )
+            {
+                eJitterDist = JD_PARETO;
+            }
+            else
+            {
+                return false;
+            }
+
+            continue;
+        }
+
+        if ( strKey == "dir" )
+        {
+            if ( ( strValue != "send" ) && ( strValue != "recv" ) && ( strValue != "both" ) )
+            {
+                return false;
+            }
+
+            bOnSend    = ( strValue != "recv" );
+            bOnReceive = ( strValue != "send" );
+            continue;
+        }
+
+        // the numeric settings, the percentages are stored as probabilities
+        bool         bOk;
+        const double dValue   = strValue.toDouble ( &bOk );
+        const double dPercent = std::min ( 100.0, dValue ) / 100;
+
+        if ( !bOk || ( dValue < 0 ) )
+        {
+            return false;
+        }
+
+        if ( strKey == "delay" )
+        {
+            dDelayMs = dValue;
+        }
+        else if ( strKey == "jitter" )
+        {
+            dJitterMs = dValue;
+        }
+        else if ( strKey == "loss" )
+        {
+            dLossGood = dPercent;
+        }
+        else if ( strKey == "burst" )
+        {
+            dGoodToBad = dPercent;
+        }
+        else if ( strKey == "burstlen" )
+        {
+            dBadToGood = 1.0 / std::max ( 1.0, dValue );
+        }
+        else if ( strKey == "burstloss" )
+        {
+            dLossBad = dPercent;
+        }
+        else if ( strKey == "reorder" )
+        {
+            dReorder = dPercent;
+        }
+        else if ( strKey == "dup" )
+        {
+            dDuplicate = dPercent;
+        }
+        else if ( strKey == "seed" )
+        {
+            iSeed = static_cast<uint32_t> ( dValue );
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    bEnabled = !slParams.isEmpty();
+
+    return bEnabled;
+}
+
+CNetImpairment::CNetImpairment ( CSocket*                    pNSocket,
+                                 const CNetImpairmentParams& NParams ) :
+    pSocket      ( pNSocket ),
+    Params       ( NParams ),
+    bRun         ( true ),
+    SendState    ( NParams.iSeed ),
+    ReceiveState ( NParams.iSeed + 1 )
+{
+    ElapsedTimer.start();
+}
+
+void CNetImpairment::Stop()
+{
+    {
+        QMutexLocker locker ( &Mutex );
+
+        bRun = false;
+        WaitCondition.wakeOne();
+    }
+
+    wait();
+}
+
+void CNetImpairment::PutDatagram ( const bool              bIsSend,
+                                   const CVector<uint8_t>& vecbyData,
+                                   const int               iNumBytes,
+                                   const CHostAddress&     HostAddr )
+{
+    // the datagrams are sent by several threads
+    QMutexLocker locker ( &Mutex );
+
+    CDirectionState&                       State = bIsSend ? SendState : ReceiveState;
+    std::uniform_real_distribution<double> Uniform ( 0, 1 );
+
+    // Gilbert-Elliott model: state transition and loss with the probability of
+    // the current state
+    if ( State.bBadState )
+    {
+        State.bBadState = !( Uniform ( State.Rng ) < Params.dBadToGood );
+    }
+    else
+    {
+        State.bBadState = ( Uniform ( State.Rng ) < Params.dGoodToBad );
+    }
+
+    if ( Uniform ( State.Rng ) < ( State.bBadState ? Params.dLossBad : Params.dLossGood ) )
+    {
+        return;
+    }
+
+    const int iNumCopies = ( Uniform ( State.Rng ) < Params.dDuplicate ) ? 2 : 1;
+
+    for ( int i = 0; i < iNumCopies; i++ )
+    {
+        if ( mapQueue.size() >= NET_IMPAIRMENT_MAX_QUEUED_DATAGRAMS )
+        {
+            return;
+        }
+
+        // a reordered datagram overtakes the delayed ones
+        const qint64 iDelayNs = ( Uniform ( State.Rng ) < Params.dReorder ) ?
+            0 : GetDelayNs ( State.Rng );
+
+        CDatagram Datagram;
+
+        Datagram.bIsSend  = bIsSend;
+        Datagram.HostAddr = HostAddr;
+        Datagram.vecbyData.Init ( iNumBytes );
+
+        std::copy ( vecbyData.begin(),
+                    vecbyData.begin() + iNumBytes,
+                    Datagram.vecbyData.begin() );
+
+        mapQueue.insert ( std::make_pair ( ElapsedTimer.nsecsElapsed() + iDelayNs, Datagram ) );
+    }
+
+    WaitCondition.wakeOne();
+}
+
+qint64 CNetImpairment::GetDelayNs ( std::mt19937& Rng )
+{
+    double dDelayMs = Params.dDelayMs;
+
+    if ( Params.dJitterMs > 0 )
+    {
+        switch ( Params.eJitterDist )
+        {
+        case JD_UNIFORM:
+            dDelayMs += std::uniform_real_distribution<double> ( -Params.dJitterMs, Params.dJitterMs ) ( Rng );
+            break;
+
+        case JD_NORMAL:
+            dDelayMs += std::normal_distribution<double> ( 0, Params.dJitterMs ) ( Rng );
+            break;
+
+        case JD_PARETO:
+        {
+            // Pareto distribution shifted to zero with the jitter as mean
+            const double dShape = NET_IMPAIRMENT_PARETO_SHAPE;
+            const double dRand  = std::uniform_real_distribution<double> ( 0, 1 ) ( Rng );
+
+            dDelayMs += Params.dJitterMs * ( dShape - 1 ) * ( pow ( 1 - dRand, -1 / dShape ) - 1 );
+            break;
+        }
+        }
+    }
+
+    return static_cast<qint64> ( std::max ( 0.0, dDelayMs ) * 1000000 );
+}
+
+void CNetImpairment::run()
+{
+    Mutex.lock();
+
+    while ( bRun )
+    {
+        if ( mapQueue.empty() )
+        {
+            WaitCondition.wait ( &Mutex );
+            continue;
+        }
+
+        const qint64 iWaitNs = mapQueue.begin()->first - ElapsedTimer.nsecsElapsed();
+
+        if ( iWaitNs > NET_IMPAIRMENT_SLEEP_THRESHOLD_NS )
+        {
+            // a new datagram with a shorter delay wakes us up
+            WaitCondition.wait ( &Mutex, static_cast<unsigned long> ( iWaitNs / 1000000 - 1 ) );
+            continue;
+        }
+
+        if ( iWaitNs > 0 )
+        {
+            Mutex.unlock();
+            QThread::usleep ( static_cast<unsigned long> ( iWaitNs / 1000 ) );
+            Mutex.lock();
+            continue;
+        }
+
+        // the socket is called without the lock since sending a datagram may
+        // put a new one into the queue
+        const CDatagram Datagram = mapQueue.begin()->second;
+        mapQueue.erase ( mapQueue.begin() );
+
+        Mutex.unlock();
+        pSocket->ProcessImpairedDatagram ( Datagram.bIsSend, Datagram.vecbyData, Datagram.HostAddr );
+        Mutex.lock();
+    }
+
+    Mutex.unlock();
+}
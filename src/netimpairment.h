@@ -0,0 +1,178 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#pragma once
+
+#include <QThread>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QString>
+#include <QStringList>
+#include <map>
+#include <random>
+#include <cmath>
+#include <algorithm>
+#include "global.h"
+#include "util.h"
+
+
+// the datagrams are given back to the socket after their delay
+class CSocket; // forward declaration of CSocket
+
+
+/* Definitions ****************************************************************/
+// maximum number of delayed datagrams, further datagrams are dropped
+#define NET_IMPAIRMENT_MAX_QUEUED_DATAGRAMS 10000
+
+// shape of the Pareto distributed jitter (the smaller, the heavier the tail)
+#define NET_IMPAIRMENT_PARETO_SHAPE         3.0
+
+// below this waiting time the thread sleeps instead of waiting for the
+// condition since the wait has only a millisecond resolution
+#define NET_IMPAIRMENT_SLEEP_THRESHOLD_NS   2000000
+
+// jitter distributions
+enum EJitterDist
+{
+    JD_UNIFORM = 0, // delay +/- jitter
+    JD_NORMAL  = 1, // jitter is the standard deviation
+    JD_PARETO  = 2  // additional delay with the jitter as mean
+};
+
+
+/* Classes ********************************************************************/
+// Network impairment settings -------------------------------------------------
+// The settings are given as a comma separated list of "key=value", e.g.
+// "delay=20,jitter=5,dist=normal,loss=1,burst=0.5,burstlen=4,dir=recv":
+//   delay     mean delay in ms
+//   jitter    jitter in ms, see dist
+//   dist      jitter distribution: uniform (default), normal or pareto
+//   loss      loss in percent (in the good state of the Gilbert-Elliott model)
+//   burst     probability in percent of a transition to the bad state
+//   burstlen  mean length of a bad state in datagrams (default 1)
+//   burstloss loss in percent in the bad state (default 100)
+//   reorder   probability in percent that a datagram is not delayed
+//   dup       probability in percent that a datagram is duplicated
+//   dir       impaired direction: send, recv or both (default)
+//   seed      seed of the random generators
+class CNetImpairmentParams
+{
+public:
+    CNetImpairmentParams() :
+        bEnabled    ( false ),
+        dDelayMs    ( 0 ),
+        dJitterMs   ( 0 ),
+        eJitterDist ( JD_UNIFORM ),
+        dLossGood   ( 0 ),
+        dLossBad    ( 1 ),
+        dGoodToBad  ( 0 ),
+        dBadToGood  ( 1 ),
+        dReorder    ( 0 ),
+        dDuplicate  ( 0 ),
+        bOnSend     ( true ),
+        bOnReceive  ( true ),
+        iSeed       ( 1 ) {}
+
+    bool Parse ( const QString& strParams );
+
+    bool        bEnabled;
+    double      dDelayMs;
+    double      dJitterMs;
+    EJitterDist eJitterDist;
+
+    // Gilbert-Elliott loss model (probabilities per datagram)
+    double      dLossGood;
+    double      dLossBad;
+    double      dGoodToBad;
+    double      dBadToGood;
+
+    double      dReorder;
+    double      dDuplicate;
+    bool        bOnSend;
+    bool        bOnReceive;
+    uint32_t    iSeed;
+};
+
+
+// Network impairment ----------------------------------------------------------
+// Drops, delays, reorders and duplicates the datagrams of a socket. The
+// datagrams which pass are given back to the socket by the thread of the
+// impairment when their delay has expired, i.e. for the impaired directions
+// the socket does not send or process the datagrams itself. This is only for
+// tests, the datagrams are copied with memory allocations.
+class CNetImpairment : public QThread
+{
+public:
+    CNetImpairment ( CSocket*                    pNSocket,
+                     const CNetImpairmentParams& NParams );
+
+    virtual ~CNetImpairment() { Stop(); }
+
+    bool IsActive ( const bool bIsSend ) const { return bIsSend ? Params.bOnSend : Params.bOnReceive; }
+
+    void PutDatagram ( const bool              bIsSend,
+                       const CVector<uint8_t>& vecbyData,
+                       const int               iNumBytes,
+                       const CHostAddress&     HostAddr );
+
+    void Stop();
+
+protected:
+    // random generator and loss state of one direction
+    class CDirectionState
+    {
+    public:
+        CDirectionState ( const uint32_t iSeed ) : Rng ( iSeed ), bBadState ( false ) {}
+
+        std::mt19937 Rng;
+        bool         bBadState;
+    };
+
+    class CDatagram
+    {
+    public:
+        bool             bIsSend;
+        CVector<uint8_t> vecbyData;
+        CHostAddress     HostAddr;
+    };
+
+    qint64 GetDelayNs ( std::mt19937& Rng );
+
+    virtual void run();
+
+    CSocket*                          pSocket;
+    CNetImpairmentParams              Params;
+    QElapsedTimer                     ElapsedTimer;
+    QMutex                            Mutex;
+    QWaitCondition                    WaitCondition;
+    bool                              bRun;
+
+    CDirectionState                   SendState;
+    CDirectionState                   ReceiveState;
+
+    // delayed datagrams by their due time
+    std::multimap<qint64, CDatagram>  mapQueue;
+};
@@ -0,0 +1,343 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#include "packetcapture.h"
+
+
+/* Implementation *************************************************************/
+CPacketCapture::CPacketCapture() :
+    pThread               ( nullptr ),
+    iNumBlocks            ( 1 ),
+    iRingWriteIdx         ( 0 ),
+    iRingReadIdx          ( 0 ),
+    iNumDroppedPackets    ( 0 ),
+    iBlockSeqNum          ( 0 ),
+    iBlockTimeNs          ( 0 ),
+    iBlockNumPackets      ( 0 ),
+    iBlockNumWrittenBytes ( 0 )
+{
+    // Connections -------------------------------------------------------------
+    QObject::connect ( &TimerWrite, &QTimer::timeout,
+        this, &CPacketCapture::OnTimerWrite );
+}
+
+CPacketCapture::~CPacketCapture()
+{
+    if ( pThread != nullptr )
+    {
+        // the timer must be stopped in its thread
+        QMetaObject::invokeMethod ( &TimerWrite,
+                                    "stop",
+                                    Qt::BlockingQueuedConnection );
+
+        pThread->quit();
+        pThread->wait();
+        delete pThread;
+
+        // write the datagrams which are still in the ring
+        OnTimerWrite();
+        File.close();
+    }
+}
+
+bool CPacketCapture::Init ( const QString& strFileName,
+                            const int      iSizeMB )
+{
+    iNumBlocks = std::max ( 1, static_cast<int> ( static_cast<qint64> ( iSizeMB ) * 1024 * 1024 / PACKET_CAPTURE_BLOCK_SIZE ) );
+
+    File.setFileName ( strFileName );
+
+    if ( !File.open ( QIODevice::ReadWrite | QIODevice::Truncate ) )
+    {
+        return false;
+    }
+
+    // file header
+    uchar FileHeader[PACKET_CAPTURE_FILE_HEADER_SIZE];
+
+    memcpy ( FileHeader, PACKET_CAPTURE_FILE_ID, 4 );
+    qToLittleEndian<quint32> ( PACKET_CAPTURE_FILE_VER, FileHeader + 4 );
+    qToLittleEndian<quint32> ( PACKET_CAPTURE_BLOCK_SIZE, FileHeader + 8 );
+    qToLittleEndian<quint32> ( static_cast<quint32> ( iNumBlocks ), FileHeader + 12 );
+
+    if ( File.write ( reinterpret_cast<const char*> ( FileHeader ), PACKET_CAPTURE_FILE_HEADER_SIZE ) !=
+         PACKET_CAPTURE_FILE_HEADER_SIZE )
+    {
+        File.close();
+        return false;
+    }
+
+    vecbyRingData.Init    ( PACKET_CAPTURE_RING_NUM_PACKETS * PACKET_CAPTURE_MAX_PACKET_BYTES );
+    veciRingTimeNs.Init   ( PACKET_CAPTURE_RING_NUM_PACKETS );
+    veciRingInetAddr.Init ( PACKET_CAPTURE_RING_NUM_PACKETS );
+    veciRingPort.Init     ( PACKET_CAPTURE_RING_NUM_PACKETS );
+    veciRingNumBytes.Init ( PACKET_CAPTURE_RING_NUM_PACKETS );
+
+    // monotonic time base of the capture
+    ElapsedTimer.start();
+
+    // the timer is not a child object and must be moved explicitly
+    pThread = new QThread();
+    moveToThread ( pThread );
+    TimerWrite.moveToThread ( pThread );
+    pThread->start();
+
+    // the timer must be started in its thread
+    QMetaObject::invokeMethod ( &TimerWrite,
+                                "start",
+                                Qt::QueuedConnection,
+                                Q_ARG ( int, PACKET_CAPTURE_WRITE_INTERVAL_MS ) );
+
+    return true;
+}
+
+void CPacketCapture::PutPacket ( const CVector<uint8_t>& vecbyData,
+                                 const int               iNumBytes,
+                                 const CHostAddress&     HostAddr )
+{
+    const uint32_t iWriteIdx = iRingWriteIdx.load ( std::memory_order_relaxed );
+
+    if ( ( iNumBytes > PACKET_CAPTURE_MAX_PACKET_BYTES ) ||
+         ( iWriteIdx - iRingReadIdx.load ( std::memory_order_acquire ) >= PACKET_CAPTURE_RING_NUM_PACKETS ) )
+    {
+        // the socket thread must never wait for the capture thread
+        iNumDroppedPackets.fetch_add ( 1, std::memory_order_relaxed );
+        return;
+    }
+
+    const int iSlot = iWriteIdx % PACKET_CAPTURE_RING_NUM_PACKETS;
+
+    veciRingTimeNs[iSlot]   = ElapsedTimer.nsecsElapsed();
+    veciRingInetAddr[iSlot] = HostAddr.InetAddr.toIPv4Address();
+    veciRingPort[iSlot]     = HostAddr.iPort;
+    veciRingNumBytes[iSlot] = iNumBytes;
+
+    std::copy ( vecbyData.begin(),
+                vecbyData.begin() + iNumBytes,
+                vecbyRingData.begin() + iSlot * PACKET_CAPTURE_MAX_PACKET_BYTES );
+
+    iRingWriteIdx.store ( iWriteIdx + 1, std::memory_order_release );
+}
+
+void CPacketCapture::OnTimerWrite()
+{
+    TakePackets();
+
+    if ( ( iBlockSeqNum != 0 ) && ( vecbyBlock.size() > iBlockNumWrittenBytes ) )
+    {
+        WriteBlock();
+    }
+}
+
+void CPacketCapture::TakePackets()
+{
+    const uint32_t iWriteIdx = iRingWriteIdx.load ( std::memory_order_acquire );
+    uint32_t       iReadIdx  = iRingReadIdx.load ( std::memory_order_relaxed );
+
+    for ( ; iReadIdx != iWriteIdx; iReadIdx++ )
+    {
+        const int    iSlot     = iReadIdx % PACKET_CAPTURE_RING_NUM_PACKETS;
+        const int    iNumBytes = veciRingNumBytes[iSlot];
+        const qint64 iTimeNs   = veciRingTimeNs[iSlot];
+
+        // a new block is started if the record does not fit or if its time
+        // cannot be given relative to the block
+        if ( ( iBlockSeqNum == 0 ) ||
+             ( vecbyBlock.size() + PACKET_CAPTURE_RECORD_HEADER_SIZE + iNumBytes > PACKET_CAPTURE_BLOCK_SIZE ) ||
+             ( ( iTimeNs - iBlockTimeNs ) / 1000 > static_cast<qint64> ( 0xFFFFFFFF ) ) )
+        {
+            if ( iBlockSeqNum != 0 )
+            {
+                WriteBlock();
+            }
+
+            StartBlock ( iTimeNs );
+        }
+
+        uchar RecordHeader[PACKET_CAPTURE_RECORD_HEADER_SIZE];
+
+        qToLittleEndian<quint32> ( static_cast<quint32> ( ( iTimeNs - iBlockTimeNs ) / 1000 ), RecordHeader );
+        qToLittleEndian<quint32> ( veciRingInetAddr[iSlot], RecordHeader + 4 );
+        qToLittleEndian<quint16> ( veciRingPort[iSlot], RecordHeader + 8 );
+        qToLittleEndian<quint16> ( static_cast<quint16> ( iNumBytes ), RecordHeader + 10 );
+
+        vecbyBlock.append ( reinterpret_cast<const char*> ( RecordHeader ), PACKET_CAPTURE_RECORD_HEADER_SIZE );
+        vecbyBlock.append ( reinterpret_cast<const char*> ( &vecbyRingData[iSlot * PACKET_CAPTURE_MAX_PACKET_BYTES] ), iNumBytes );
+        iBlockNumPackets++;
+    }
+
+    iRingReadIdx.store ( iReadIdx, std::memory_order_release );
+}
+
+void CPacketCapture::StartBlock ( const qint64 iTimeNs )
+{
+    iBlockSeqNum++;
+    iBlockTimeNs          = iTimeNs;
+    iBlockNumPackets      = 0;
+    iBlockNumWrittenBytes = PACKET_CAPTURE_BLOCK_HEADER_SIZE;
+
+    vecbyBlock.fill ( 0, PACKET_CAPTURE_BLOCK_HEADER_SIZE );
+    vecbyBlock.reserve ( PACKET_CAPTURE_BLOCK_SIZE );
+}
+
+void CPacketCapture::WriteBlock()
+{
+    // the oldest block is overwritten
+    const qint64 iBlockPos = PACKET_CAPTURE_FILE_HEADER_SIZE +
+        static_cast<qint64> ( ( iBlockSeqNum - 1 ) % iNumBlocks ) * PACKET_CAPTURE_BLOCK_SIZE;
+
+    uchar* pHeader = reinterpret_cast<uchar*> ( vecbyBlock.data() );
+
+    // the header of a reused block still describes the old records, it is
+    // marked as unused before the first records are written over them
+    if ( iBlockNumWrittenBytes == PACKET_CAPTURE_BLOCK_HEADER_SIZE )
+    {
+        memset ( pHeader, 0, PACKET_CAPTURE_BLOCK_HEADER_SIZE );
+
+        File.seek ( iBlockPos );
+        File.write ( vecbyBlock.constData(), PACKET_CAPTURE_BLOCK_HEADER_SIZE );
+        File.flush();
+    }
+
+    // first the new records and then the header, so that the header never
+    // refers to records which are not in the file
+    if ( vecbyBlock.size() > iBlockNumWrittenBytes )
+    {
+        File.seek ( iBlockPos + iBlockNumWrittenBytes );
+        File.write ( vecbyBlock.constData() + iBlockNumWrittenBytes,
+                     vecbyBlock.size() - iBlockNumWrittenBytes );
+    }
+
+    qToLittleEndian<quint64> ( iBlockSeqNum, pHeader );
+    qToLittleEndian<qint64>  ( iBlockTimeNs, pHeader + 8 );
+    qToLittleEndian<quint32> ( static_cast<quint32> ( vecbyBlock.size() ), pHeader + 16 );
+    qToLittleEndian<quint32> ( static_cast<quint32> ( iBlockNumPackets ), pHeader + 20 );
+
+    File.seek ( iBlockPos );
+    File.write ( vecbyBlock.constData(), PACKET_CAPTURE_BLOCK_HEADER_SIZE );
+    File.flush();
+
+    iBlockNumWrittenBytes = vecbyBlock.size();
+}
+
+bool CPacketCapture::ReadFile ( const QString&                strFileName,
+                                std::vector<CCapturedPacket>& vecPackets )
+{
+    QFile CaptureFile ( strFileName );
+
+    if ( !CaptureFile.open ( QIODevice::ReadOnly ) )
+    {
+        return false;
+    }
+
+    const QByteArray baFileHeader = CaptureFile.read ( PACKET_CAPTURE_FILE_HEADER_SIZE );
+    const uchar*     pFileHeader  = reinterpret_cast<const uchar*> ( baFileHeader.constData() );
+
+    if ( ( baFileHeader.size() < PACKET_CAPTURE_FILE_HEADER_SIZE ) ||
+         !baFileHeader.startsWith ( PACKET_CAPTURE_FILE_ID ) ||
+         ( qFromLittleEndian<quint32> ( pFileHeader + 4 ) != PACKET_CAPTURE_FILE_VER ) )
+    {
+        return false;
+    }
+
+    const qint64 iBlockSize = qFromLittleEndian<quint32> ( pFileHeader + 8 );
+    const qint64 iNumBlocks = qFromLittleEndian<quint32> ( pFileHeader + 12 );
+
+    if ( iBlockSize <= PACKET_CAPTURE_BLOCK_HEADER_SIZE )
+    {
+        return false;
+    }
+
+    // the used blocks in the order in which they were written (the blocks at
+    // the end of the file do not exist if the ring has not wrapped around)
+    std::vector<std::pair<quint64, qint64> > vecBlocks;
+
+    for ( qint64 i = 0; i < iNumBlocks; i++ )
+    {
+        if ( !CaptureFile.seek ( PACKET_CAPTURE_FILE_HEADER_SIZE + i * iBlockSize ) )
+        {
+            break;
+        }
+
+        const QByteArray baBlockHeader = CaptureFile.read ( PACKET_CAPTURE_BLOCK_HEADER_SIZE );
+
+        if ( baBlockHeader.size() < PACKET_CAPTURE_BLOCK_HEADER_SIZE )
+        {
+            break;
+        }
+
+        const quint64 iSeqNum = qFromLittleEndian<quint64> (
+            reinterpret_cast<const uchar*> ( baBlockHeader.constData() ) );
+
+        if ( iSeqNum != 0 )
+        {
+            vecBlocks.push_back ( std::make_pair ( iSeqNum, i ) );
+        }
+    }
+
+    std::sort ( vecBlocks.begin(), vecBlocks.end() );
+
+    vecPackets.clear();
+
+    for ( size_t i = 0; i < vecBlocks.size(); i++ )
+    {
+        CaptureFile.seek ( PACKET_CAPTURE_FILE_HEADER_SIZE + vecBlocks[i].second * iBlockSize );
+
+        const QByteArray baBlock = CaptureFile.read ( iBlockSize );
+        const uchar*     pBlock  = reinterpret_cast<const uchar*> ( baBlock.constData() );
+        const qint64     iTimeNs = qFromLittleEndian<qint64> ( pBlock + 8 );
+        const int        iUsed   = std::min ( baBlock.size(),
+                                              static_cast<int> ( qFromLittleEndian<quint32> ( pBlock + 16 ) ) );
+
+        int iPos = PACKET_CAPTURE_BLOCK_HEADER_SIZE;
+
+        while ( iPos + PACKET_CAPTURE_RECORD_HEADER_SIZE <= iUsed )
+        {
+            const int iNumBytes = qFromLittleEndian<quint16> ( pBlock + iPos + 10 );
+
+            if ( iPos + PACKET_CAPTURE_RECORD_HEADER_SIZE + iNumBytes > iUsed )
+            {
+                break;
+            }
+
+            CCapturedPacket Packet;
+
+            Packet.iTimeNs  = iTimeNs + 1000 * static_cast<qint64> ( qFromLittleEndian<quint32> ( pBlock + iPos ) );
+            Packet.HostAddr = CHostAddress ( QHostAddress ( qFromLittleEndian<quint32> ( pBlock + iPos + 4 ) ),
+                                             qFromLittleEndian<quint16> ( pBlock + iPos + 8 ) );
+
+            Packet.vecbyData.Init ( iNumBytes );
+
+            std::copy ( pBlock + iPos + PACKET_CAPTURE_RECORD_HEADER_SIZE,
+                        pBlock + iPos + PACKET_CAPTURE_RECORD_HEADER_SIZE + iNumBytes,
+                        Packet.vecbyData.begin() );
+
+            vecPackets.push_back ( Packet );
+
+            iPos += PACKET_CAPTURE_RECORD_HEADER_SIZE + iNumBytes;
+        }
+    }
+
+    return true;
+}
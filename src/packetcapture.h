@@ -0,0 +1,153 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <QFile>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QtEndian>
+#include <atomic>
+#include <cstring>
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include "global.h"
+#include "util.h"
+
+
+/* Definitions ****************************************************************/
+// capture file format (all values little endian):
+// file header:   id (4 bytes), version, block size, number of blocks (uint32)
+// block header:  sequence number (uint64, 0 for an unused block), time of the
+//                block (int64 ns), used bytes including the header, number of
+//                packets (uint32)
+// packet record: time relative to the block (uint32 us), IPv4 address of the
+//                sender (uint32), port (uint16), number of bytes (uint16) and
+//                the datagram
+#define PACKET_CAPTURE_FILE_ID              "JCAP"
+#define PACKET_CAPTURE_FILE_VER             1
+#define PACKET_CAPTURE_FILE_HEADER_SIZE     16
+#define PACKET_CAPTURE_BLOCK_HEADER_SIZE    24
+#define PACKET_CAPTURE_RECORD_HEADER_SIZE   12
+
+// the file is a ring of blocks, the oldest block is overwritten when the
+// capture reaches the maximum file size
+#define PACKET_CAPTURE_BLOCK_SIZE           65536
+
+// default maximum size of the capture file
+#define PACKET_CAPTURE_DEFAULT_SIZE_MB      64
+
+// larger datagrams (which are fragmented on the network anyway) are not
+// captured
+#define PACKET_CAPTURE_MAX_PACKET_BYTES     1500
+
+// number of datagrams in the ring between the socket thread and the capture
+// thread (must be a power of two since the ring indices wrap around)
+#define PACKET_CAPTURE_RING_NUM_PACKETS     2048
+
+// interval in which the capture thread writes the datagrams of the ring, this
+// is the maximum time which is missing in the file if the server is killed
+#define PACKET_CAPTURE_WRITE_INTERVAL_MS    100
+
+
+/* Classes ********************************************************************/
+// Captured datagram -----------------------------------------------------------
+class CCapturedPacket
+{
+public:
+    qint64           iTimeNs;
+    CHostAddress     HostAddr;
+    CVector<uint8_t> vecbyData;
+};
+
+
+// Packet capture --------------------------------------------------------------
+// Writes all datagrams received by the server socket with a monotonic time
+// stamp to a file of fixed maximum size, i.e. the file always contains the
+// last minutes of the traffic. The socket thread only copies the datagram in
+// a lock-free ring, the file is written by the capture thread.
+class CPacketCapture : public QObject
+{
+    Q_OBJECT
+
+public:
+    CPacketCapture();
+    virtual ~CPacketCapture();
+
+    // must be called before the capture is passed to the socket, starts the
+    // thread
+    bool Init ( const QString& strFileName,
+                const int      iSizeMB );
+
+    bool IsEnabled() const { return pThread != nullptr; }
+
+    // only called by the socket thread, a datagram is dropped if the ring is
+    // full
+    void PutPacket ( const CVector<uint8_t>& vecbyData,
+                     const int               iNumBytes,
+                     const CHostAddress&     HostAddr );
+
+    uint32_t GetDroppedPackets() const { return iNumDroppedPackets.load ( std::memory_order_relaxed ); }
+
+    // reads all datagrams of a capture file in the order of their reception
+    static bool ReadFile ( const QString&                strFileName,
+                           std::vector<CCapturedPacket>& vecPackets );
+
+protected:
+    void TakePackets();
+    void StartBlock ( const qint64 iTimeNs );
+    void WriteBlock();
+
+    QThread*              pThread;
+    QTimer                TimerWrite;
+    QFile                 File;
+    QElapsedTimer         ElapsedTimer;
+    int                   iNumBlocks;
+
+    // the ring is written by the socket thread and read by the capture thread
+    // (the address is stored as numbers to avoid allocations in the socket
+    // thread)
+    CVector<uint8_t>      vecbyRingData;
+    CVector<qint64>       veciRingTimeNs;
+    CVector<quint32>      veciRingInetAddr;
+    CVector<quint16>      veciRingPort;
+    CVector<int>          veciRingNumBytes;
+    std::atomic<uint32_t> iRingWriteIdx;
+    std::atomic<uint32_t> iRingReadIdx;
+    std::atomic<uint32_t> iNumDroppedPackets;
+
+    // current block, only the bytes which are not in the file yet are written
+    QByteArray            vecbyBlock;
+    quint64               iBlockSeqNum;
+    qint64                iBlockTimeNs;
+    int                   iBlockNumPackets;
+    int                   iBlockNumWrittenBytes;
+
+public slots:
+    void OnTimerWrite();
+};
@@ -29,6 +29,13 @@ Protocol message definition
 - All messages received need to be acknowledged by an acknowledge packet (except
   of connection less messages)
 
+- Per default only one message is in flight, i.e., the next message is sent
+  when the acknowledgement of the previous message was received. If the other
+  side supports it (PROTMESSID_MESS_WINDOW_SIZE), up to the given number of
+  messages are sent without waiting for their acknowledgements. Each message is
+  acknowledged separately. The receiver processes the messages in the order of
+  their counters and stores messages which arrive before a missing message.
+
 
 
 MAIN FRAME
@@ -162,9 +169,9 @@ MESSAGES (with connection)
         ... ------------------+-----------------------+ ...
         ...  4 bytes sam rate | 2 bytes audiocod type | ...
         ... ------------------+-----------------------+ ...
-        ... -----------------+----------------------+
-        ...  2 bytes version | 4 bytes audiocod arg |
-        ... -----------------+----------------------+
+        ... ---------------+----------------------+
+        ...  2 bytes flags | 4 bytes audiocod arg |
+        ... ---------------+----------------------+
 
     - "base netw size":  length of the base network packet (frame) in bytes
     - "block size fact": block size factor
@@ -176,8 +183,26 @@ MESSAGES (with connection)
                           - 1: CELT
                           - 2: OPUS
                           - 3: OPUS64
-    - "version":         version of the audio coder, if not used this value
-                         shall be set to 0
+    - "flags":           network transport flags (this field was formerly the
+                         unused version of the audio coder which was always 0),
+                         the following flags are defined:
+                          - bit 0: with redundancy, each audio packet carries a
+                                   copy of the previous packet followed by one
+                                   trailing byte, i.e. the audio packet size is
+                                   2 * packet size + 1 (the client sets this
+                                   flag to request redundancy, the server
+                                   confirms by sending this message back to the
+                                   client with the flag set), the trailing byte
+                                   is defined as follows:
+                                    - bits 0-6: sequence number, incremented
+                                                by one with each packet
+                                                (modulo 128, see
+                                                REDUNDANCY_SEQ_NUM_MASK)
+                                    - bit 7:    set if the copy of the previous
+                                                packet is valid, it is not set
+                                                for the first packet after the
+                                                sender was initialized (see
+                                                REDUNDANCY_PREV_VALID_FLAG)
     - "audiocod arg":    argument for the audio coder, if not used this value
                          shall be set to 0
 
@@ -227,6 +252,65 @@ MESSAGES (with connection)
     - tbc
 
 
+- PROTMESSID_MESS_WINDOW_SIZE: number of messages which may be in flight
+
+    +---------------------------+
+    | 1 byte number of messages |
+    +---------------------------+
+
+    - the sender of this message stores up to this number of messages which
+      arrive before a missing message
+    - the server sends this message on a new connection, the client answers
+      with its own window size
+
+
+- PROTMESSID_REQ_CONN_CLIENTS_LIST_DELTA: Request that changes of the connected
+  clients list are sent as PROTMESSID_CONN_CLIENTS_LIST_DELTA
+
+    note: does not have any data -> n = 0
+
+    - the client sends this message before requesting the connected clients
+      list, the server then answers PROTMESSID_REQ_CONN_CLIENTS_LIST with a
+      full list in PROTMESSID_CONN_CLIENTS_LIST_DELTA (an old server ignores
+      this message and keeps sending the complete list)
+
+
+- PROTMESSID_CONN_CLIENTS_LIST_DELTA: Changes of the connected clients list
+
+    +-----------------+-----------------------+-------------+-------------+ ...
+    | 2 bytes version | 1 byte is full list   | 1st entry   | 2nd entry   | ...
+    +-----------------+-----------------------+-------------+-------------+ ...
+
+    each entry starts with the type of change (EChanListDeltaType), for a
+    removed channel only the channel ID follows:
+
+    +------------------+-------------------+
+    | 1 byte type (0)  | 1 byte channel ID |
+    +------------------+-------------------+
+
+    for an added (1) or updated (2) channel the channel information follows in
+    the same format as one entry of PROTMESSID_CONN_CLIENTS_LIST:
+
+    +------------------+-------------------------------------------+
+    | 1 byte type      | PROTMESSID_CONN_CLIENTS_LIST entry        |
+    +------------------+-------------------------------------------+
+
+    - the version is incremented by one (modulo 2^16) with each change of the
+      list
+    - if the full list flag is set, the entries contain the complete list
+      (only added channels) which replaces the list of the receiver
+    - if a change does not follow the version of the list of the receiver, the
+      receiver requests the complete list with PROTMESSID_REQ_CONN_CLIENTS_LIST
+
+
+- PROTMESSID_REQ_CHANNEL_LEVEL_LIST_DELTA: Request that the channel levels are
+  sent as PROTMESSID_CLM_CHANNEL_LEVEL_LIST_DELTA
+
+    note: does not have any data -> n = 0
+
+    - the opt in / out is still done with PROTMESSID_REQ_CHANNEL_LEVEL_LIST
+
+
 CONNECTION LESS MESSAGES
 ------------------------
 
@@ -371,6 +455,26 @@ CONNECTION LESS MESSAGES
     PROTMESSID_CLM_REQ_CHANNEL_LEVEL_LIST to opt in
 
 
+- PROTMESSID_CLM_CHANNEL_LEVEL_LIST_DELTA: The changed channel levels
+
+    +-----------------+-------------------------+----------------------------+
+    | 1 byte number n | ( n + 7 ) / 8 bytes map | ( ( m + 1 ) / 2 ) * 4 bits |
+    +-----------------+-------------------------+----------------------------+
+
+    n is number of connected clients, m is the number of changed levels
+
+    bit i of the map (starting with the lowest bit of the first byte) is set
+    if the level of the i-th client in the order of
+    PROTMESSID_CLM_CHANNEL_LEVEL_LIST has changed, the changed levels follow
+    in the format of PROTMESSID_CLM_CHANNEL_LEVEL_LIST
+
+    the server sends all levels at regular intervals and whenever the
+    connected clients have changed since the message is not acknowledged
+
+    the server should issue the message only to a client that has used
+    PROTMESSID_REQ_CHANNEL_LEVEL_LIST_DELTA
+
+
 - PROTMESSID_CLM_REGISTER_SERVER_RESP: result of registration request
 
     +---------------+
@@ -388,6 +492,25 @@ CONNECTION LESS MESSAGES
           five times for one registration request at 500ms intervals.
           Beyond this, it should "ping" every 15 minutes
           (standard re-registration timeout).
+
+
+- PROTMESSID_CLM_TICK_PHASE: Arrival phase of the audio packets of a connected
+                             client relative to the server mix tick
+
+    +---------------------------+---------------------------+-----------------------------+
+    | 2 bytes tick period in us | 2 bytes arrival lead in us | 2 bytes arrival jitter in us |
+    +---------------------------+---------------------------+-----------------------------+
+
+    - "tick period": time between two mix ticks of the server
+
+    - "arrival lead": averaged time between the arrival of an audio packet of
+      the client and the next mix tick of the server
+
+    - "arrival jitter": standard deviation of the arrival time of the audio
+      packets of the client relative to the mix tick
+
+    Note: the server sends this message in response to a
+          PROTMESSID_CLM_PING_MS of a connected client.
 */
 
 #include "protocol.h"
@@ -398,10 +521,15 @@ CProtocol::CProtocol()
 {
     Reset();
 
+    TimerRecGap.setSingleShot ( true );
+
 
     // Connections -------------------------------------------------------------
     QObject::connect ( &TimerSendMess, &QTimer::timeout,
         this, &CProtocol::OnTimerSendMess );
+
+    QObject::connect ( &TimerRecGap, &QTimer::timeout,
+        this, &CProtocol::OnTimerRecGap );
 }
 
 void CProtocol::Reset()
@@ -409,9 +537,26 @@ void CProtocol::Reset()
     QMutexLocker locker ( &Mutex );
 
     // prepare internal variables for initial protocol transfer
-    iCounter   = 0;
-    iOldRecID  = PROTMESSID_ILLEGAL;
-    iOldRecCnt = 0;
+    iCounter            = 0;
+    iRecExpCnt          = 0;
+    bRecExpCntValid     = false;
+    iRecWindowSize      = 1; // until we tell the other side our window size
+    iSendWindowSize     = 1; // until the other side tells us its window size
+    bMessWindowSizeSent = false;
+
+    for ( int i = 0; i < 256; i++ )
+    {
+        iRecHistID[i] = PROTMESSID_ILLEGAL;
+    }
+
+    // delete all stored received messages
+    for ( int i = 0; i < PROT_MESS_WINDOW_SIZE; i++ )
+    {
+        RecMessBuf[i].bIsValid = false;
+    }
+
+    // the reset may be done by another thread than the one of the timer
+    QMetaObject::invokeMethod ( &TimerRecGap, "stop" );
 
     // delete complete "send message queue"
     SendMessQueue.clear();
@@ -421,13 +566,8 @@ void CProtocol::EnqueueMessage ( CVector<uint8_t>& vecMessage,
                                  const int         iCnt,
                                  const int         iID )
 {
-    bool bListWasEmpty;
-
     Mutex.lock();
     {
-        // check if list is empty so that we have to initiate a send process
-        bListWasEmpty = SendMessQueue.empty();
-
         // create send message object for the queue
         CSendMessage SendMessageObj ( vecMessage, iCnt, iID );
 
@@ -436,37 +576,54 @@ void CProtocol::EnqueueMessage ( CVector<uint8_t>& vecMessage,
     }
     Mutex.unlock();
 
-    // if list was empty, initiate send process
-    if ( bListWasEmpty )
-    {
-        SendMessage();
-    }
+    // send the message if it is within the window
+    SendMessages ( false );
 }
 
-void CProtocol::SendMessage()
+void CProtocol::SendMessages ( const bool bResend )
 {
-    CVector<uint8_t> vecMessage;
-    bool             bSendMess = false;
+    CVector<CVector<uint8_t> > vecvecMessages;
+    bool                       bQueueIsEmpty;
 
     Mutex.lock();
     {
         // we have to check that list is not empty, since in another thread the
         // last element of the list might have been erased
-        if ( !SendMessQueue.empty() )
+        bQueueIsEmpty = SendMessQueue.empty();
+
+        if ( !bQueueIsEmpty )
         {
-            vecMessage.Init ( SendMessQueue.front().vecMessage.Size() );
-            vecMessage = SendMessQueue.front().vecMessage;
+            // all messages within the window which starts at the oldest not
+            // acknowledged message may be in flight, on a time out all of them
+            // are sent again
+            const int iFirstCnt = SendMessQueue.front().iCnt;
+
+            for ( std::list<CSendMessage>::iterator it = SendMessQueue.begin();
+                  it != SendMessQueue.end(); ++it )
+            {
+                if ( ( ( it->iCnt - iFirstCnt ) & 0xFF ) >= iSendWindowSize )
+                {
+                    break;
+                }
 
-            bSendMess = true;
+                if ( bResend || !it->bIsSent )
+                {
+                    vecvecMessages.Add ( it->vecMessage );
+                    it->bIsSent = true;
+                }
+            }
         }
     }
     Mutex.unlock();
 
-    if ( bSendMess )
+    // send messages
+    for ( int i = 0; i < vecvecMessages.Size(); i++ )
     {
-        // send message
-        emit MessReadyForSending ( vecMessage );
+        emit MessReadyForSending ( vecvecMessages[i] );
+    }
 
+    if ( !bQueueIsEmpty )
+    {
         // start time-out timer if not active
         if ( !TimerSendMess.isActive() )
         {
@@ -542,153 +699,282 @@ bool CProtocol::ParseMessageBody ( const CVector<uint8_t>& vecbyMesBodyData,
     return code: false -> ok; true -> error
 */
     bool bRet = false;
-    bool bSendNextMess;
 
 /*
 // TEST channel implementation: randomly delete protocol messages (50 % loss)
 if ( rand() < ( RAND_MAX / 2 ) ) return false;
 */
 
-    // In case we received a message and returned an answer but our answer
-    // did not make it to the receiver, he will resend his message. We check
-    // here if the message is the same as the old one, and if this is the
-    // case, just resend our old answer again
-    if ( ( iOldRecID == iRecID ) && ( iOldRecCnt == iRecCounter ) )
+    // special treatment for acknowledge messages
+    if ( iRecID == PROTMESSID_ACKN )
     {
-        // acknowledgments are not acknowledged
-        if ( iRecID != PROTMESSID_ACKN )
+        // check size
+        if ( vecbyMesBodyData.Size() != 2 )
         {
-            // resend acknowledgement
-            CreateAndImmSendAcknMess ( iRecID, iRecCounter );
+            return true; // return error code
         }
-    }
-    else
-    {
-        // special treatment for acknowledge messages
-        if ( iRecID == PROTMESSID_ACKN )
-        {
-            // check size
-            if ( vecbyMesBodyData.Size() != 2 )
-            {
-                return true; // return error code
-            }
 
-            // extract data from stream and emit signal for received value
-            int       iPos = 0;
-            const int iData =
-                static_cast<int> ( GetValFromStream ( vecbyMesBodyData, iPos, 2 ) );
+        // extract data from stream and emit signal for received value
+        int       iPos = 0;
+        const int iData =
+            static_cast<int> ( GetValFromStream ( vecbyMesBodyData, iPos, 2 ) );
+
+        bool bMessAcknowledged = false;
 
-            Mutex.lock();
+        Mutex.lock();
+        {
+            // the acknowledgement may be for any of the messages in flight
+            for ( std::list<CSendMessage>::iterator it = SendMessQueue.begin();
+                  it != SendMessQueue.end(); ++it )
             {
-                // check if this is the correct acknowledgment
-                bSendNextMess = false;
-                if ( !SendMessQueue.empty() )
+                if ( it->bIsSent && ( it->iCnt == iRecCounter ) && ( it->iID == iData ) )
                 {
-                    if ( ( SendMessQueue.front().iCnt == iRecCounter ) &&
-                         ( SendMessQueue.front().iID == iData ) )
-                    {
-                        // message acknowledged, remove from queue
-                        SendMessQueue.pop_front();
-
-                        // send next message in queue
-                        bSendNextMess = true;
-                    }
+                    // message acknowledged, remove from queue
+                    SendMessQueue.erase ( it );
+                    bMessAcknowledged = true;
+                    break;
                 }
             }
-            Mutex.unlock();
+        }
+        Mutex.unlock();
 
-            if ( bSendNextMess )
-            {
-                SendMessage();
-            }
+        // the window may have moved, send the next messages in queue
+        if ( bMessAcknowledged )
+        {
+            SendMessages ( false );
         }
-        else
+
+        return false;
+    }
+
+    // position of the received message relative to the expected one
+    const int iDistAhead  = ( iRecCounter - iRecExpCnt ) & 0xFF;
+    const int iDistBehind = ( iRecExpCnt - iRecCounter ) & 0xFF;
+
+    // In case we received a message and returned an answer but our answer
+    // did not make it to the receiver, he will resend his message. We check
+    // here if the message is one of the recently processed ones within the
+    // send window of the other side, and if this is the case, just resend our
+    // old answer again
+    if ( bRecExpCntValid &&
+         ( iDistBehind >= 1 ) && ( iDistBehind <= iRecWindowSize ) &&
+         ( iRecHistID[iRecCounter] == iRecID ) )
+    {
+        CreateAndImmSendAcknMess ( iRecID, iRecCounter );
+        return false;
+    }
+
+    // a message which arrives before a missing message is stored and
+    // acknowledged, it is processed after the missing message
+    if ( bRecExpCntValid &&
+         ( iDistAhead >= 1 ) && ( iDistAhead < iRecWindowSize ) )
+    {
+        CRecMessage& RecMess = RecMessBuf[iRecCounter % PROT_MESS_WINDOW_SIZE];
+
+        if ( !RecMess.bIsValid )
         {
-            // check which type of message we received and do action
-            switch ( iRecID )
-            {
-            case PROTMESSID_JITT_BUF_SIZE:
-                bRet = EvaluateJitBufMes ( vecbyMesBodyData );
-                break;
+            RecMess.vecData  = vecbyMesBodyData;
+            RecMess.iID      = iRecID;
+            RecMess.iCnt     = iRecCounter;
+            RecMess.bIsValid = true;
+        }
 
-            case PROTMESSID_REQ_JITT_BUF_SIZE:
-                bRet = EvaluateReqJitBufMes();
-                break;
+        CreateAndImmSendAcknMess ( iRecID, iRecCounter );
 
-            case PROTMESSID_CLIENT_ID:
-                bRet = EvaluateClientIDMes ( vecbyMesBodyData );
-                break;
+        if ( !TimerRecGap.isActive() )
+        {
+            TimerRecGap.start ( PROT_REC_GAP_TIMEOUT_MS );
+        }
 
-            case PROTMESSID_CHANNEL_GAIN:
-                bRet = EvaluateChanGainMes ( vecbyMesBodyData );
-                break;
+        return false;
+    }
 
-            case PROTMESSID_CHANNEL_PAN:
-                bRet = EvaluateChanPanMes ( vecbyMesBodyData );
-                break;
+    // if the message is not the expected one, we lost track of the counter
+    // of the other side (e.g., it was reset), in this case the stored
+    // messages are processed first and the history of the old counters is
+    // cleared, otherwise the messages of a new session with the same counters
+    // and IDs would be taken as resent messages
+    if ( bRecExpCntValid && ( iDistAhead != 0 ) )
+    {
+        ProcessStoredMessages ( true );
 
-            case PROTMESSID_MUTE_STATE_CHANGED:
-                bRet = EvaluateMuteStateHasChangedMes ( vecbyMesBodyData );
-                break;
+        for ( int i = 0; i < 256; i++ )
+        {
+            iRecHistID[i] = PROTMESSID_ILLEGAL;
+        }
 
-            case PROTMESSID_CONN_CLIENTS_LIST:
-                bRet = EvaluateConClientListMes ( vecbyMesBodyData );
-                break;
+        bRecExpCntValid = false;
+    }
 
-            case PROTMESSID_REQ_CONN_CLIENTS_LIST:
-                bRet = EvaluateReqConnClientsList();
-                break;
+    bRet = ProcessMessage ( vecbyMesBodyData, iRecCounter, iRecID );
 
-            case PROTMESSID_CHANNEL_INFOS:
-                bRet = EvaluateChanInfoMes ( vecbyMesBodyData );
-                break;
+    // immediately send acknowledge message
+    CreateAndImmSendAcknMess ( iRecID, iRecCounter );
 
-            case PROTMESSID_REQ_CHANNEL_INFOS:
-                bRet = EvaluateReqChanInfoMes();
-                break;
+    // process the stored messages which directly follow this message
+    ProcessStoredMessages ( false );
 
-            case PROTMESSID_CHAT_TEXT:
-                bRet = EvaluateChatTextMes ( vecbyMesBodyData );
-                break;
+    return bRet;
+}
 
-            case PROTMESSID_NETW_TRANSPORT_PROPS:
-                bRet = EvaluateNetwTranspPropsMes ( vecbyMesBodyData );
-                break;
+bool CProtocol::ProcessMessage ( const CVector<uint8_t>& vecbyMesBodyData,
+                                 const int               iRecCounter,
+                                 const int               iRecID )
+{
+    bool bRet = false;
+
+    // check which type of message we received and do action
+    switch ( iRecID )
+    {
+    case PROTMESSID_JITT_BUF_SIZE:
+        bRet = EvaluateJitBufMes ( vecbyMesBodyData );
+        break;
 
-            case PROTMESSID_REQ_NETW_TRANSPORT_PROPS:
-                bRet = EvaluateReqNetwTranspPropsMes();
-                break;
+    case PROTMESSID_REQ_JITT_BUF_SIZE:
+        bRet = EvaluateReqJitBufMes();
+        break;
 
-            case PROTMESSID_LICENCE_REQUIRED:
-                bRet = EvaluateLicenceRequiredMes ( vecbyMesBodyData );
-                break;
+    case PROTMESSID_CLIENT_ID:
+        bRet = EvaluateClientIDMes ( vecbyMesBodyData );
+        break;
 
-            case PROTMESSID_REQ_CHANNEL_LEVEL_LIST:
-                bRet = EvaluateReqChannelLevelListMes ( vecbyMesBodyData );
-                break;
+    case PROTMESSID_CHANNEL_GAIN:
+        bRet = EvaluateChanGainMes ( vecbyMesBodyData );
+        break;
 
-            case PROTMESSID_VERSION_AND_OS:
-                bRet = EvaluateVersionAndOSMes ( vecbyMesBodyData );
-                break;
+    case PROTMESSID_CHANNEL_PAN:
+        bRet = EvaluateChanPanMes ( vecbyMesBodyData );
+        break;
 
-            case PROTMESSID_RECORDER_STATE:
-                bRet = EvaluateRecorderStateMes ( vecbyMesBodyData );
-                break;
-            }
+    case PROTMESSID_MUTE_STATE_CHANGED:
+        bRet = EvaluateMuteStateHasChangedMes ( vecbyMesBodyData );
+        break;
 
-            // immediately send acknowledge message
-            CreateAndImmSendAcknMess ( iRecID, iRecCounter );
+    case PROTMESSID_CONN_CLIENTS_LIST:
+        bRet = EvaluateConClientListMes ( vecbyMesBodyData );
+        break;
 
-            // save current message ID and counter to find out if message
-            // was resent
-            iOldRecID  = iRecID;
-            iOldRecCnt = iRecCounter;
-        }
+    case PROTMESSID_REQ_CONN_CLIENTS_LIST:
+        bRet = EvaluateReqConnClientsList();
+        break;
+
+    case PROTMESSID_CHANNEL_INFOS:
+        bRet = EvaluateChanInfoMes ( vecbyMesBodyData );
+        break;
+
+    case PROTMESSID_REQ_CHANNEL_INFOS:
+        bRet = EvaluateReqChanInfoMes();
+        break;
+
+    case PROTMESSID_CHAT_TEXT:
+        bRet = EvaluateChatTextMes ( vecbyMesBodyData );
+        break;
+
+    case PROTMESSID_NETW_TRANSPORT_PROPS:
+        bRet = EvaluateNetwTranspPropsMes ( vecbyMesBodyData );
+        break;
+
+    case PROTMESSID_REQ_NETW_TRANSPORT_PROPS:
+        bRet = EvaluateReqNetwTranspPropsMes();
+        break;
+
+    case PROTMESSID_LICENCE_REQUIRED:
+        bRet = EvaluateLicenceRequiredMes ( vecbyMesBodyData );
+        break;
+
+    case PROTMESSID_REQ_CHANNEL_LEVEL_LIST:
+        bRet = EvaluateReqChannelLevelListMes ( vecbyMesBodyData );
+        break;
+
+    case PROTMESSID_VERSION_AND_OS:
+        bRet = EvaluateVersionAndOSMes ( vecbyMesBodyData );
+        break;
+
+    case PROTMESSID_RECORDER_STATE:
+        bRet = EvaluateRecorderStateMes ( vecbyMesBodyData );
+        break;
+
+    case PROTMESSID_MESS_WINDOW_SIZE:
+        bRet = EvaluateMessWindowSizeMes ( vecbyMesBodyData );
+        break;
+
+    case PROTMESSID_REQ_CONN_CLIENTS_LIST_DELTA:
+        bRet = EvaluateReqConClientListDeltaMes();
+        break;
+
+    case PROTMESSID_CONN_CLIENTS_LIST_DELTA:
+        bRet = EvaluateConClientListDeltaMes ( vecbyMesBodyData );
+        break;
+
+    case PROTMESSID_REQ_CHANNEL_LEVEL_LIST_DELTA:
+        bRet = EvaluateReqChannelLevelListDeltaMes();
+        break;
     }
 
+    // save current message ID and counter to find out if message was resent
+    // and which message we expect next
+    iRecHistID[iRecCounter] = iRecID;
+    iRecExpCnt              = ( iRecCounter + 1 ) & 0xFF;
+    bRecExpCntValid         = true;
+
     return bRet;
 }
 
+void CProtocol::ProcessStoredMessages ( const bool bFlush )
+{
+    // process the stored messages in the order of their counters, normally we
+    // stop at the next missing message, on a flush the missing messages are
+    // skipped
+    const int iFirstCnt = iRecExpCnt;
+
+    for ( int i = 0; i < PROT_MESS_WINDOW_SIZE; i++ )
+    {
+        const int    iCurCnt = ( iFirstCnt + i ) & 0xFF;
+        CRecMessage& RecMess = RecMessBuf[iCurCnt % PROT_MESS_WINDOW_SIZE];
+
+        if ( RecMess.bIsValid && ( RecMess.iCnt == iCurCnt ) &&
+             ( bFlush || ( iCurCnt == iRecExpCnt ) ) )
+        {
+            // the message is copied since processing it may change the storage
+            const CVector<uint8_t> vecbyMesBodyData = RecMess.vecData;
+            const int              iRecID           = RecMess.iID;
+
+            RecMess.bIsValid = false;
+
+            ProcessMessage ( vecbyMesBodyData, iCurCnt, iRecID );
+        }
+        else if ( !bFlush )
+        {
+            break;
+        }
+    }
+
+    // stop the gap time out if no stored message is left
+    bool bMessIsStored = false;
+
+    for ( int i = 0; i < PROT_MESS_WINDOW_SIZE; i++ )
+    {
+        if ( RecMessBuf[i].bIsValid )
+        {
+            // on a flush all stored messages must be gone, remaining ones
+            // would be outside the current window
+            if ( bFlush )
+            {
+                RecMessBuf[i].bIsValid = false;
+            }
+            else
+            {
+                bMessIsStored = true;
+            }
+        }
+    }
+
+    if ( !bMessIsStored )
+    {
+        TimerRecGap.stop();
+    }
+}
+
 bool CProtocol::ParseConnectionLessMessageBody ( const CVector<uint8_t>& vecbyMesBodyData,
                                                  const int               iRecID,
                                                  const CHostAddress&     InetAddr )
@@ -767,6 +1053,14 @@ if ( rand() < ( RAND_MAX / 2 ) ) return false;
         case PROTMESSID_CLM_REGISTER_SERVER_RESP:
             bRet = EvaluateCLRegisterServerResp ( InetAddr, vecbyMesBodyData );
             break;
+
+        case PROTMESSID_CLM_TICK_PHASE:
+            bRet = EvaluateCLTickPhaseMes ( InetAddr, vecbyMesBodyData );
+            break;
+
+        case PROTMESSID_CLM_CHANNEL_LEVEL_LIST_DELTA:
+            bRet = EvaluateCLChannelLevelListDeltaMes ( InetAddr, vecbyMesBodyData );
+            break;
         }
     }
     else
@@ -994,46 +1288,7 @@ void CProtocol::CreateConClientListMes ( const CVector<CChannelInfo>& vecChanInf
 
     for ( int i = 0; i < iNumClients; i++ )
     {
-        // convert strings to utf-8
-        const QByteArray strUTF8Name = vecChanInfo[i].strName.toUtf8();
-        const QByteArray strUTF8City = vecChanInfo[i].strCity.toUtf8();
-
-        // size of current list entry
-        const int iCurListEntrLen =
-            1 /* chan ID */ + 2 /* country */ +
-            4 /* instrument */ + 1 /* skill level */ +
-            4 /* IP address */ +
-            2 /* utf-8 str. size */ + strUTF8Name.size() +
-            2 /* utf-8 str. size */ + strUTF8City.size();
-
-        // make space for new data
-        vecData.Enlarge ( iCurListEntrLen );
-
-        // channel ID (1 byte)
-        PutValOnStream ( vecData, iPos,
-            static_cast<uint32_t> ( vecChanInfo[i].iChanID ), 1 );
-
-        // country (2 bytes)
-        PutValOnStream ( vecData, iPos,
-            static_cast<uint32_t> ( vecChanInfo[i].eCountry ), 2 );
-
-        // instrument (4 bytes)
-        PutValOnStream ( vecData, iPos,
-            static_cast<uint32_t> ( vecChanInfo[i].iInstrument ), 4 );
-
-        // skill level (1 byte)
-        PutValOnStream ( vecData, iPos,
-            static_cast<uint32_t> ( vecChanInfo[i].eSkillLevel ), 1 );
-
-        // IP address (4 bytes)
-        PutValOnStream ( vecData, iPos,
-            static_cast<uint32_t> ( vecChanInfo[i].iIpAddr ), 4 );
-
-        // name
-        PutStringUTF8OnStream ( vecData, iPos, strUTF8Name );
-
-        // city
-        PutStringUTF8OnStream ( vecData, iPos, strUTF8City );
+        PutChanInfoOnStream ( vecData, iPos, vecChanInfo[i] );
     }
 
     CreateAndSendMessage ( PROTMESSID_CONN_CLIENTS_LIST, vecData );
@@ -1047,60 +1302,15 @@ bool CProtocol::EvaluateConClientListMes ( const CVector<uint8_t>& vecData )
 
     while ( iPos < iDataLen )
     {
-        // check size (the next 12 bytes)
-        if ( ( iDataLen - iPos ) < 12 )
-        {
-            return true; // return error code
-        }
-
-        // channel ID (1 byte)
-        const int iChanID =
-            static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
-
-        // country (2 bytes)
-        const QLocale::Country eCountry =
-            static_cast<QLocale::Country> ( GetValFromStream ( vecData, iPos, 2 ) );
-
-        // instrument (4 bytes)
-        const int iInstrument =
-            static_cast<int> ( GetValFromStream ( vecData, iPos, 4 ) );
-
-        // skill level (1 byte)
-        const ESkillLevel eSkillLevel =
-            static_cast<ESkillLevel> ( GetValFromStream ( vecData, iPos, 1 ) );
+        CChannelInfo CurChanInfo;
 
-        // IP address (4 bytes)
-        const int iIpAddr =
-            static_cast<int> ( GetValFromStream ( vecData, iPos, 4 ) );
-
-        // name
-        QString strCurName;
-        if ( GetStringFromStream ( vecData,
-                                   iPos,
-                                   MAX_LEN_FADER_TAG,
-                                   strCurName ) )
-        {
-            return true; // return error code
-        }
-
-        // city
-        QString strCurCity;
-        if ( GetStringFromStream ( vecData,
-                                   iPos,
-                                   MAX_LEN_SERVER_CITY,
-                                   strCurCity ) )
+        if ( GetChanInfoFromStream ( vecData, iPos, CurChanInfo ) )
         {
             return true; // return error code
         }
 
         // add channel information to vector
-        vecChanInfo.Add ( CChannelInfo ( iChanID,
-                                         iIpAddr,
-                                         strCurName,
-                                         eCountry,
-                                         strCurCity,
-                                         iInstrument,
-                                         eSkillLevel ) );
+        vecChanInfo.Add ( CurChanInfo );
     }
 
     // check size: all data is read, the position must now be at the end
@@ -1128,6 +1338,141 @@ bool CProtocol::EvaluateReqConnClientsList()
     return false; // no error
 }
 
+void CProtocol::CreateReqConClientListDeltaMes()
+{
+    CreateAndSendMessage ( PROTMESSID_REQ_CONN_CLIENTS_LIST_DELTA, CVector<uint8_t> ( 0 ) );
+}
+
+bool CProtocol::EvaluateReqConClientListDeltaMes()
+{
+    // invoke message action
+    emit ReqConClientListDelta();
+
+    return false; // no error
+}
+
+void CProtocol::CreateConClientListDeltaMes ( const int                              iVersion,
+                                              const bool                             bIsFullList,
+                                              const CVector<CChannelListDeltaEntry>& vecDelta )
+{
+    const int iNumEntries = vecDelta.Size();
+
+    // build data vector
+    CVector<uint8_t> vecData ( 3 ); // 3 bytes of data for the header
+    int              iPos = 0;      // init position pointer
+
+    // version of the list (2 bytes)
+    PutValOnStream ( vecData, iPos,
+        static_cast<uint32_t> ( iVersion ), 2 );
+
+    // full list flag (1 byte)
+    PutValOnStream ( vecData, iPos,
+        static_cast<uint32_t> ( bIsFullList ), 1 );
+
+    for ( int i = 0; i < iNumEntries; i++ )
+    {
+        // type of the change (1 byte)
+        vecData.Enlarge ( 1 );
+
+        PutValOnStream ( vecData, iPos,
+            static_cast<uint32_t> ( vecDelta[i].eType ), 1 );
+
+        if ( vecDelta[i].eType == CD_REMOVE )
+        {
+            // channel ID (1 byte)
+            vecData.Enlarge ( 1 );
+
+            PutValOnStream ( vecData, iPos,
+                static_cast<uint32_t> ( vecDelta[i].ChanInfo.iChanID ), 1 );
+        }
+        else
+        {
+            PutChanInfoOnStream ( vecData, iPos, vecDelta[i].ChanInfo );
+        }
+    }
+
+    CreateAndSendMessage ( PROTMESSID_CONN_CLIENTS_LIST_DELTA, vecData );
+}
+
+bool CProtocol::EvaluateConClientListDeltaMes ( const CVector<uint8_t>& vecData )
+{
+    int                             iPos     = 0; // init position pointer
+    const int                       iDataLen = vecData.Size();
+    CVector<CChannelListDeltaEntry> vecDelta ( 0 );
+
+    // check size (the header)
+    if ( iDataLen < 3 )
+    {
+        return true; // return error code
+    }
+
+    // version of the list (2 bytes)
+    const int iVersion =
+        static_cast<int> ( GetValFromStream ( vecData, iPos, 2 ) );
+
+    // full list flag (1 byte)
+    const int iIsFullList =
+        static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
+
+    if ( ( iIsFullList != 0 ) && ( iIsFullList != 1 ) )
+    {
+        return true; // return error code
+    }
+
+    while ( iPos < iDataLen )
+    {
+        CChannelListDeltaEntry CurEntry;
+
+        // check size (type and channel ID)
+        if ( ( iDataLen - iPos ) < 2 )
+        {
+            return true; // return error code
+        }
+
+        // type of the change (1 byte)
+        const int iType =
+            static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
+
+        if ( iType == CD_REMOVE )
+        {
+            // channel ID (1 byte)
+            CurEntry.ChanInfo.iChanID =
+                static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
+        }
+        else if ( ( iType == CD_ADD ) || ( iType == CD_UPDATE ) )
+        {
+            if ( GetChanInfoFromStream ( vecData, iPos, CurEntry.ChanInfo ) )
+            {
+                return true; // return error code
+            }
+        }
+        else
+        {
+            return true; // return error code
+        }
+
+        // a full list can only contain added channels
+        if ( ( iIsFullList == 1 ) && ( iType != CD_ADD ) )
+        {
+            return true; // return error code
+        }
+
+        CurEntry.eType = static_cast<EChanListDeltaType> ( iType );
+        vecDelta.Add ( CurEntry );
+    }
+
+    // check size: all data is read, the position must now be at the end
+    if ( iPos != iDataLen )
+    {
+        return true; // return error code
+    }
+
+    // invoke message action
+    emit ConClientListDeltaMesReceived ( iVersion, iIsFullList == 1, vecDelta );
+
+    return false; // no error
+}
+
 void CProtocol::CreateChanInfoMes ( const CChannelCoreInfo ChanInfo )
 {
     int iPos = 0; // init position pointer
@@ -1286,7 +1631,7 @@ void CProtocol::CreateNetwTranspPropsMes ( const CNetworkTransportProps& NetTrPr
         1 /* num chan */ +
         4 /* sam rate */ +
         2 /* audiocod type */ +
-        2 /* version */ +
+        2 /* flags */ +
         4 /* audiocod arg */;
 
     // build data vector
@@ -1307,8 +1652,8 @@ void CProtocol::CreateNetwTranspPropsMes ( const CNetworkTransportProps& NetTrPr
     // audio coding type (2 bytes)
     PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( NetTrProps.eAudioCodingType ), 2 );
 
-    // version (2 bytes)
-    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( NetTrProps.iVersion ), 2 );
+    // network transport flags (2 bytes)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( NetTrProps.iFlags ), 2 );
 
     // argument for the audio coder (4 bytes)
     PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( NetTrProps.iAudioCodingArg ), 4 );
@@ -1328,7 +1673,7 @@ bool CProtocol::EvaluateNetwTranspPropsMes ( const CVector<uint8_t>& vecData )
         1 /* num chan */ +
         4 /* sam rate */ +
         2 /* audiocod type */ +
-        2 /* version */ +
+        2 /* flags */ +
         4 /* audiocod arg */;
 
     // check size
@@ -1390,8 +1735,8 @@ bool CProtocol::EvaluateNetwTranspPropsMes ( const CVector<uint8_t>& vecData )
     ReceivedNetwTranspProps.eAudioCodingType =
         static_cast<EAudComprType> ( iRecCodingType );
 
-    // version (2 bytes)
-    ReceivedNetwTranspProps.iVersion =
+    // network transport flags (2 bytes)
+    ReceivedNetwTranspProps.iFlags =
         static_cast<uint32_t> ( GetValFromStream ( vecData, iPos, 2 ) );
 
     // argument for the audio coder (4 bytes)
@@ -1494,6 +1839,19 @@ bool CProtocol::EvaluateReqChannelLevelListMes ( const CVector<uint8_t>& vecData
     return false; // no error
 }
 
+void CProtocol::CreateReqChannelLevelListDeltaMes()
+{
+    CreateAndSendMessage ( PROTMESSID_REQ_CHANNEL_LEVEL_LIST_DELTA, CVector<uint8_t> ( 0 ) );
+}
+
+bool CProtocol::EvaluateReqChannelLevelListDeltaMes()
+{
+    // invoke message action
+    emit ReqChannelLevelListDelta();
+
+    return false; // no error
+}
+
 void CProtocol::CreateVersionAndOSMes()
 {
     int iPos = 0; // init position pointer
@@ -1550,30 +1908,82 @@ bool CProtocol::EvaluateVersionAndOSMes ( const CVector<uint8_t>& vecData )
     // check size: all data is read, the position must now be at the end
     if ( iPos != iDataLen )
     {
-        return true; // return error code
+        return true; // return error code
+    }
+
+    // invoke message action
+    emit VersionAndOSReceived ( eOSType, strVersion );
+
+    return false; // no error
+}
+
+void CProtocol::CreateRecorderStateMes ( const ERecorderState eRecorderState )
+{
+    CVector<uint8_t> vecData ( 1 ); // 1 byte of data
+    int              iPos = 0;      // init position pointer
+
+    // build data vector
+    // server jam recorder state (1 byte)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( eRecorderState ), 1 );
+
+    CreateAndSendMessage ( PROTMESSID_RECORDER_STATE, vecData );
+}
+
+bool CProtocol::EvaluateRecorderStateMes(const CVector<uint8_t>& vecData)
+{
+    int iPos = 0; // init position pointer
+
+    // check size
+    if ( vecData.Size() != 1 )
+    {
+        return true; // return error code
+    }
+
+    // server jam recorder state (1 byte)
+    const int iRecorderState =
+        static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
+
+    // note that RS_UNDEFINED is only internally used
+    if ( ( iRecorderState != RS_NOT_INITIALISED ) &&
+         ( iRecorderState != RS_NOT_ENABLED ) &&
+         ( iRecorderState != RS_RECORDING ) )
+    {
+        return true;
     }
 
     // invoke message action
-    emit VersionAndOSReceived ( eOSType, strVersion );
+    emit RecorderStateReceived ( static_cast<ERecorderState> ( iRecorderState ) );
 
     return false; // no error
 }
 
-void CProtocol::CreateRecorderStateMes ( const ERecorderState eRecorderState )
+void CProtocol::CreateMessWindowSizeMes()
 {
     CVector<uint8_t> vecData ( 1 ); // 1 byte of data
     int              iPos = 0;      // init position pointer
 
     // build data vector
-    // server jam recorder state (1 byte)
-    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( eRecorderState ), 1 );
+    // number of messages which we can store (1 byte)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( PROT_MESS_WINDOW_SIZE ), 1 );
 
-    CreateAndSendMessage ( PROTMESSID_RECORDER_STATE, vecData );
+    Mutex.lock();
+    {
+        bMessWindowSizeSent = true;
+
+        // the other side may enlarge its send window as soon as it receives
+        // our window size, i.e. before we get its answer, so we must accept
+        // the full window from now on
+        iRecWindowSize = PROT_MESS_WINDOW_SIZE;
+    }
+    Mutex.unlock();
+
+    CreateAndSendMessage ( PROTMESSID_MESS_WINDOW_SIZE, vecData );
 }
 
-bool CProtocol::EvaluateRecorderStateMes(const CVector<uint8_t>& vecData)
+bool CProtocol::EvaluateMessWindowSizeMes ( const CVector<uint8_t>& vecData )
 {
-    int iPos = 0; // init position pointer
+    int  iPos = 0; // init position pointer
+    bool bAnswerWindowSize;
 
     // check size
     if ( vecData.Size() != 1 )
@@ -1581,20 +1991,31 @@ bool CProtocol::EvaluateRecorderStateMes(const CVector<uint8_t>& vecData)
         return true; // return error code
     }
 
-    // server jam recorder state (1 byte)
-    const int iRecorderState =
+    // number of messages the other side can store (1 byte)
+    const int iWindowSize =
         static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
 
-    // note that RS_UNDEFINED is only internally used
-    if ( ( iRecorderState != RS_NOT_INITIALISED ) &&
-         ( iRecorderState != RS_NOT_ENABLED ) &&
-         ( iRecorderState != RS_RECORDING ) )
+    if ( iWindowSize < 1 )
     {
         return true;
     }
 
-    // invoke message action
-    emit RecorderStateReceived ( static_cast<ERecorderState> ( iRecorderState ) );
+    Mutex.lock();
+    {
+        // we must not send more messages than the other side can store
+        iSendWindowSize   = ( iWindowSize < PROT_MESS_WINDOW_SIZE ) ? iWindowSize : PROT_MESS_WINDOW_SIZE;
+        bAnswerWindowSize = !bMessWindowSizeSent;
+    }
+    Mutex.unlock();
+
+    // the other side needs to know our window size, too
+    if ( bAnswerWindowSize )
+    {
+        CreateMessWindowSizeMes();
+    }
+
+    // the queued messages which are now within the window can be sent
+    SendMessages ( false );
 
     return false; // no error
 }
@@ -1835,6 +2256,19 @@ bool CProtocol::EvaluateCLUnregisterServerMes ( const CHostAddress& InetAddr )
 
 void CProtocol::CreateCLServerListMes ( const CHostAddress&        InetAddr,
                                         const CVector<CServerInfo> vecServerInfo )
+{
+    CVector<uint8_t> vecNewMessage;
+    CVector<int>     veciAddrPos;
+
+    GenCLServerListMesFrame ( vecNewMessage, veciAddrPos, vecServerInfo );
+
+    // immediately send message
+    emit CLMessReadyForSending ( InetAddr, vecNewMessage );
+}
+
+void CProtocol::GenCLServerListMesFrame ( CVector<uint8_t>&          vecMessage,
+                                          CVector<int>&              veciAddrPos,
+                                          const CVector<CServerInfo> vecServerInfo )
 {
     const int iNumServers = vecServerInfo.Size();
 
@@ -1842,6 +2276,8 @@ void CProtocol::CreateCLServerListMes ( const CHostAddress&        InetAddr,
     CVector<uint8_t> vecData ( 0 );
     int              iPos = 0; // init position pointer
 
+    veciAddrPos.Init ( iNumServers );
+
     for ( int i = 0; i < iNumServers; i++ )
     {
         // convert server list strings to utf-8
@@ -1863,6 +2299,9 @@ void CProtocol::CreateCLServerListMes ( const CHostAddress&        InetAddr,
         // make space for new data
         vecData.Enlarge ( iCurListEntrLen );
 
+        // position of the address in the complete message (after the header)
+        veciAddrPos[i] = MESS_HEADER_LENGTH_BYTE + iPos;
+
         // IP address (4 bytes)
         // note the Server List manager has put the internal details in HostAddr where required
         PutValOnStream ( vecData, iPos, static_cast<uint32_t> (
@@ -1895,9 +2334,26 @@ void CProtocol::CreateCLServerListMes ( const CHostAddress&        InetAddr,
         PutStringUTF8OnStream ( vecData, iPos, strUTF8City );
     }
 
-    CreateAndImmSendConLessMessage ( PROTMESSID_CLM_SERVER_LIST,
-                                     vecData,
-                                     InetAddr );
+    // build complete message (counter per definition=0 for connection less
+    // messages)
+    GenMessageFrame ( vecMessage, 0, PROTMESSID_CLM_SERVER_LIST, vecData );
+}
+
+void CProtocol::SetCLServerListMesAddress ( CVector<uint8_t>&   vecMessage,
+                                            const int           iAddrPos,
+                                            const CHostAddress& HostAddr )
+{
+    int iPos = iAddrPos;
+
+    // IP address (4 bytes) and port number (2 bytes)
+    PutValOnStream ( vecMessage, iPos, static_cast<uint32_t> (
+        HostAddr.InetAddr.toIPv4Address() ), 4 );
+
+    PutValOnStream ( vecMessage, iPos,
+        static_cast<uint32_t> ( HostAddr.iPort ), 2 );
+
+    // the message was changed, the CRC must be calculated again
+    PutMessageCRC ( vecMessage );
 }
 
 bool CProtocol::EvaluateCLServerListMes ( const CHostAddress&     InetAddr,
@@ -2291,6 +2747,18 @@ bool CProtocol::EvaluateCLReqConnClientsListMes ( const CHostAddress& InetAddr )
 void CProtocol::CreateCLChannelLevelListMes  ( const CHostAddress&      InetAddr,
                                                const CVector<uint16_t>& vecLevelList,
                                                const int                iNumClients )
+{
+    CVector<uint8_t> vecNewMessage;
+
+    GenCLChannelLevelListMesFrame ( vecNewMessage, vecLevelList, iNumClients );
+
+    // immediately send message
+    emit CLMessReadyForSending ( InetAddr, vecNewMessage );
+}
+
+void CProtocol::GenCLChannelLevelListMesFrame ( CVector<uint8_t>&        vecMessage,
+                                                const CVector<uint16_t>& vecLevelList,
+                                                const int                iNumClients )
 {
     // This must be a multiple of bytes at four bits per client
     const int        iNumBytes = ( iNumClients + 1 ) / 2;
@@ -2306,9 +2774,157 @@ void CProtocol::CreateCLChannelLevelListMes  ( const CHostAddress&      InetAddr
         PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( byte ), 1 );
     }
 
-    CreateAndImmSendConLessMessage ( PROTMESSID_CLM_CHANNEL_LEVEL_LIST,
-                                     vecData,
-                                     InetAddr );
+    // build complete message (counter per definition=0 for connection less
+    // messages)
+    GenMessageFrame ( vecMessage, 0, PROTMESSID_CLM_CHANNEL_LEVEL_LIST, vecData );
+}
+
+void CProtocol::GenCLChannelLevelListDeltaMesFrame ( CVector<uint8_t>&        vecMessage,
+                                                     const CVector<uint16_t>& vecLevelList,
+                                                     const int                iNumClients )
+{
+    int i;
+    int iNumChanged = 0;
+
+    for ( i = 0; i < iNumClients; i++ )
+    {
+        if ( vecLevelList[i] != PROT_CHANNEL_LEVEL_UNCHANGED )
+        {
+            iNumChanged++;
+        }
+    }
+
+    // number of clients, the map with one bit per client and four bits per
+    // changed level
+    const int        iNumMapBytes = ( iNumClients + 7 ) / 8;
+    CVector<uint8_t> vecData ( 1 + iNumMapBytes + ( iNumChanged + 1 ) / 2 );
+    int              iPos = 0; // init position pointer
+
+    // number of clients (1 byte)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iNumClients ), 1 );
+
+    // map of the changed levels
+    for ( i = 0; i < iNumMapBytes; i++ )
+    {
+        uint8_t byte = 0;
+
+        for ( int k = 0; ( k < 8 ) && ( 8 * i + k < iNumClients ); k++ )
+        {
+            if ( vecLevelList[8 * i + k] != PROT_CHANNEL_LEVEL_UNCHANGED )
+            {
+                byte |= static_cast<uint8_t> ( 1 << k );
+            }
+        }
+
+        PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( byte ), 1 );
+    }
+
+    // changed levels, two per byte with the earlier one in the lower half
+    int iLevelLo = INVALID_INDEX;
+
+    for ( i = 0; i < iNumClients; i++ )
+    {
+        if ( vecLevelList[i] != PROT_CHANNEL_LEVEL_UNCHANGED )
+        {
+            if ( iLevelLo == INVALID_INDEX )
+            {
+                iLevelLo = vecLevelList[i] & 0x0F;
+            }
+            else
+            {
+                PutValOnStream ( vecData, iPos, static_cast<uint32_t> (
+                    iLevelLo | ( ( vecLevelList[i] & 0x0F ) << 4 ) ), 1 );
+
+                iLevelLo = INVALID_INDEX;
+            }
+        }
+    }
+
+    // odd number of changed levels: the unused upper bits contain 0xF
+    if ( iLevelLo != INVALID_INDEX )
+    {
+        PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iLevelLo | 0xF0 ), 1 );
+    }
+
+    // build complete message (counter per definition=0 for connection less
+    // messages)
+    GenMessageFrame ( vecMessage, 0, PROTMESSID_CLM_CHANNEL_LEVEL_LIST_DELTA, vecData );
+}
+
+bool CProtocol::EvaluateCLChannelLevelListDeltaMes ( const CHostAddress&     InetAddr,
+                                                     const CVector<uint8_t>& vecData )
+{
+    int       iPos     = 0; // init position pointer
+    const int iDataLen = vecData.Size();
+
+    // check size (number of clients)
+    if ( iDataLen < 1 )
+    {
+        return true; // return error code
+    }
+
+    // number of clients (1 byte)
+    const int iNumClients = static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
+
+    if ( iNumClients > MAX_NUM_CHANNELS )
+    {
+        return true; // return error code
+    }
+
+    // check size (map)
+    const int iNumMapBytes = ( iNumClients + 7 ) / 8;
+
+    if ( ( iDataLen - iPos ) < iNumMapBytes )
+    {
+        return true; // return error code
+    }
+
+    CVector<uint16_t> vecLevelList ( iNumClients, PROT_CHANNEL_LEVEL_UNCHANGED );
+    CVector<int>      veciChangedIdx ( 0 );
+
+    for ( int i = 0; i < iNumMapBytes; i++ )
+    {
+        const int iByte = static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
+
+        for ( int k = 0; k < 8; k++ )
+        {
+            if ( iByte & ( 1 << k ) )
+            {
+                // bits beyond the number of clients must not be set
+                if ( 8 * i + k >= iNumClients )
+                {
+                    return true; // return error code
+                }
+
+                veciChangedIdx.Add ( 8 * i + k );
+            }
+        }
+    }
+
+    // check size (changed levels, four bits each)
+    const int iNumChanged = veciChangedIdx.Size();
+
+    if ( ( iDataLen - iPos ) != ( iNumChanged + 1 ) / 2 )
+    {
+        return true; // return error code
+    }
+
+    for ( int i = 0; i < iNumChanged; i += 2 )
+    {
+        const uint8_t byte = static_cast<uint8_t> ( GetValFromStream ( vecData, iPos, 1 ) );
+
+        vecLevelList[veciChangedIdx[i]] = byte & 0x0F;
+
+        if ( i + 1 < iNumChanged )
+        {
+            vecLevelList[veciChangedIdx[i + 1]] = ( byte >> 4 ) & 0x0F;
+        }
+    }
+
+    // invoke message action
+    emit CLChannelLevelListDeltaReceived ( InetAddr, vecLevelList );
+
+    return false; // no error
 }
 
 bool CProtocol::EvaluateCLChannelLevelListMes  ( const CHostAddress&     InetAddr,
@@ -2383,6 +2999,64 @@ bool CProtocol::EvaluateCLRegisterServerResp ( const CHostAddress&     InetAddr,
     return false; // no error
 }
 
+void CProtocol::CreateCLTickPhaseMes ( const CHostAddress& InetAddr,
+                                       const int           iTickPeriodUs,
+                                       const int           iArrivalLeadUs,
+                                       const int           iArrivalJitterUs )
+{
+    int iPos = 0; // init position pointer
+
+    // build data vector (6 bytes long)
+    CVector<uint8_t> vecData ( 6 );
+
+    // tick period (2 bytes)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iTickPeriodUs ), 2 );
+
+    // arrival lead (2 bytes)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iArrivalLeadUs ), 2 );
+
+    // arrival jitter (2 bytes)
+    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iArrivalJitterUs ), 2 );
+
+    CreateAndImmSendConLessMessage ( PROTMESSID_CLM_TICK_PHASE,
+                                     vecData,
+                                     InetAddr );
+}
+
+bool CProtocol::EvaluateCLTickPhaseMes ( const CHostAddress&     InetAddr,
+                                         const CVector<uint8_t>& vecData )
+{
+    int iPos = 0; // init position pointer
+
+    // check size
+    if ( vecData.Size() != 6 )
+    {
+        return true; // return error code
+    }
+
+    // tick period
+    const int iTickPeriodUs = static_cast<int> ( GetValFromStream ( vecData, iPos, 2 ) );
+
+    // arrival lead
+    const int iArrivalLeadUs = static_cast<int> ( GetValFromStream ( vecData, iPos, 2 ) );
+
+    // arrival jitter
+    const int iArrivalJitterUs = static_cast<int> ( GetValFromStream ( vecData, iPos, 2 ) );
+
+    // check for valid values
+    if ( ( iTickPeriodUs == 0 ) ||
+         ( iArrivalLeadUs > iTickPeriodUs ) ||
+         ( iArrivalJitterUs > iTickPeriodUs ) )
+    {
+        return true; // return error code
+    }
+
+    // invoke message action
+    emit CLTickPhaseReceived ( InetAddr, iTickPeriodUs, iArrivalLeadUs, iArrivalJitterUs );
+
+    return false; // no error
+}
+
 /******************************************************************************\
 * Message generation and parsing                                               *
 \******************************************************************************/
@@ -2533,6 +3207,110 @@ bool CProtocol::GetStringFromStream ( const CVector<uint8_t>& vecIn,
     return false; // no error
 }
 
+void CProtocol::PutChanInfoOnStream ( CVector<uint8_t>&   vecIn,
+                                      int&                iPos,
+                                      const CChannelInfo& ChanInfo )
+{
+/*
+    note: the vector is enlarged by the size of the channel info and iPos is
+          automatically incremented in this function
+*/
+    // convert strings to utf-8
+    const QByteArray strUTF8Name = ChanInfo.strName.toUtf8();
+    const QByteArray strUTF8City = ChanInfo.strCity.toUtf8();
+
+    // size of current list entry
+    const int iCurListEntrLen =
+        1 /* chan ID */ + 2 /* country */ +
+        4 /* instrument */ + 1 /* skill level */ +
+        4 /* IP address */ +
+        2 /* utf-8 str. size */ + strUTF8Name.size() +
+        2 /* utf-8 str. size */ + strUTF8City.size();
+
+    // make space for new data
+    vecIn.Enlarge ( iCurListEntrLen );
+
+    // channel ID (1 byte)
+    PutValOnStream ( vecIn, iPos,
+        static_cast<uint32_t> ( ChanInfo.iChanID ), 1 );
+
+    // country (2 bytes)
+    PutValOnStream ( vecIn, iPos,
+        static_cast<uint32_t> ( ChanInfo.eCountry ), 2 );
+
+    // instrument (4 bytes)
+    PutValOnStream ( vecIn, iPos,
+        static_cast<uint32_t> ( ChanInfo.iInstrument ), 4 );
+
+    // skill level (1 byte)
+    PutValOnStream ( vecIn, iPos,
+        static_cast<uint32_t> ( ChanInfo.eSkillLevel ), 1 );
+
+    // IP address (4 bytes)
+    PutValOnStream ( vecIn, iPos,
+        static_cast<uint32_t> ( ChanInfo.iIpAddr ), 4 );
+
+    // name
+    PutStringUTF8OnStream ( vecIn, iPos, strUTF8Name );
+
+    // city
+    PutStringUTF8OnStream ( vecIn, iPos, strUTF8City );
+}
+
+bool CProtocol::GetChanInfoFromStream ( const CVector<uint8_t>& vecIn,
+                                        int&                    iPos,
+                                        CChannelInfo&           ChanInfo )
+{
+/*
+    note: iPos is automatically incremented in this function
+*/
+    // check size (the next 12 bytes)
+    if ( ( vecIn.Size() - iPos ) < 12 )
+    {
+        return true; // return error code
+    }
+
+    // channel ID (1 byte)
+    ChanInfo.iChanID =
+        static_cast<int> ( GetValFromStream ( vecIn, iPos, 1 ) );
+
+    // country (2 bytes)
+    ChanInfo.eCountry =
+        static_cast<QLocale::Country> ( GetValFromStream ( vecIn, iPos, 2 ) );
+
+    // instrument (4 bytes)
+    ChanInfo.iInstrument =
+        static_cast<int> ( GetValFromStream ( vecIn, iPos, 4 ) );
+
+    // skill level (1 byte)
+    ChanInfo.eSkillLevel =
+        static_cast<ESkillLevel> ( GetValFromStream ( vecIn, iPos, 1 ) );
+
+    // IP address (4 bytes)
+    ChanInfo.iIpAddr =
+        static_cast<quint32> ( GetValFromStream ( vecIn, iPos, 4 ) );
+
+    // name
+    if ( GetStringFromStream ( vecIn,
+                               iPos,
+                               MAX_LEN_FADER_TAG,
+                               ChanInfo.strName ) )
+    {
+        return true; // return error code
+    }
+
+    // city
+    if ( GetStringFromStream ( vecIn,
+                               iPos,
+                               MAX_LEN_SERVER_CITY,
+                               ChanInfo.strCity ) )
+    {
+        return true; // return error code
+    }
+
+    return false; // no error
+}
+
 void CProtocol::GenMessageFrame ( CVector<uint8_t>&       vecOut,
                                   const int               iCnt,
                                   const int               iID,
@@ -2573,18 +3351,25 @@ void CProtocol::GenMessageFrame ( CVector<uint8_t>&       vecOut,
 
 
     // Encode CRC --------------------------------------------------------------
+    PutMessageCRC ( vecOut );
+}
+
+void CProtocol::PutMessageCRC ( CVector<uint8_t>& vecMessage )
+{
     CCRC CRCObj;
 
-    iCurPos = 0; // start from beginning
+    int iCurPos = 0; // start from beginning
 
-    const int iLenCRCCalc = MESS_HEADER_LENGTH_BYTE + iDataLenByte;
+    // the CRC is calculated over the header and the data and is stored in
+    // the last two bytes of the message
+    const int iLenCRCCalc = vecMessage.Size() - 2;
 
-    for ( i = 0; i < iLenCRCCalc; i++ )
+    for ( int i = 0; i < iLenCRCCalc; i++ )
     {
-        CRCObj.AddByte ( static_cast<uint8_t> ( GetValFromStream ( vecOut, iCurPos, 1 ) ) );
+        CRCObj.AddByte ( static_cast<uint8_t> ( GetValFromStream ( vecMessage, iCurPos, 1 ) ) );
     }
 
-    PutValOnStream ( vecOut, iCurPos, static_cast<uint32_t> ( CRCObj.GetCRC() ), 2 );
+    PutValOnStream ( vecMessage, iCurPos, static_cast<uint32_t> ( CRCObj.GetCRC() ), 2 );
 }
 
 void CProtocol::PutValOnStream ( CVector<uint8_t>& vecIn,
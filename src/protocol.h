@@ -60,6 +60,10 @@
 #define PROTMESSID_MUTE_STATE_CHANGED         31 // mute state of your signal at another client has changed
 #define PROTMESSID_CLIENT_ID                  32 // current user ID and server status
 #define PROTMESSID_RECORDER_STATE             33 // contains the state of the jam recorder (ERecorderState)
+#define PROTMESSID_MESS_WINDOW_SIZE           34 // number of messages which may be in flight
+#define PROTMESSID_REQ_CONN_CLIENTS_LIST_DELTA 35 // request changes of the connected client list
+#define PROTMESSID_CONN_CLIENTS_LIST_DELTA    36 // changes of the connected client list
+#define PROTMESSID_REQ_CHANNEL_LEVEL_LIST_DELTA 37 // request the changed channel levels only
 
 // message IDs of connection less messages (CLM)
 // DEFINITION -> start at 1000, end at 1999, see IsConnectionLessMessageID
@@ -79,6 +83,8 @@
 #define PROTMESSID_CLM_REQ_CONN_CLIENTS_LIST  1014 // request the connected clients list
 #define PROTMESSID_CLM_CHANNEL_LEVEL_LIST     1015 // channel level list
 #define PROTMESSID_CLM_REGISTER_SERVER_RESP   1016 // status of server registration request
+#define PROTMESSID_CLM_TICK_PHASE             1017 // audio packet arrival phase at server mix tick
+#define PROTMESSID_CLM_CHANNEL_LEVEL_LIST_DELTA 1018 // changed channel levels
 
 // lengths of message as defined in protocol.cpp file
 #define MESS_HEADER_LENGTH_BYTE         7 // TAG (2), ID (2), cnt (1), length (2)
@@ -87,6 +93,20 @@
 // time out for message re-send if no acknowledgement was received
 #define SEND_MESS_TIMEOUT_MS            400 // ms
 
+// maximum number of messages which are sent without waiting for their
+// acknowledgements (if supported by the other side), this is also the number
+// of messages which the receiver stores if a message is missing (must be a
+// power of two so that the 8 bit counter maps to the same storage positions
+// after the wrap around)
+#define PROT_MESS_WINDOW_SIZE           8
+
+// time out for processing the stored messages if a missing message does not
+// arrive (e.g., because the other side was reset)
+#define PROT_REC_GAP_TIMEOUT_MS         ( 3 * SEND_MESS_TIMEOUT_MS )
+
+// marks a level in the channel level delta list which has not changed
+#define PROT_CHANNEL_LEVEL_UNCHANGED    0xFFFF
+
 
 /* Classes ********************************************************************/
 class CProtocol : public QObject
@@ -98,6 +118,10 @@ public:
 
     void Reset();
 
+    // processes the stored received messages after the gap time out (the
+    // owner must call this with the same locks as the message parsing)
+    void FlushStoredMessages() { ProcessStoredMessages ( true ); }
+
     void CreateJitBufMes ( const int iJitBufSize );
     void CreateReqJitBufMes();
     void CreateClientIDMes ( const int iChanID );
@@ -106,6 +130,11 @@ public:
     void CreateMuteStateHasChangedMes ( const int iChanID, const bool bIsMuted );
     void CreateConClientListMes ( const CVector<CChannelInfo>& vecChanInfo );
     void CreateReqConnClientsList();
+    void CreateReqConClientListDeltaMes();
+    void CreateConClientListDeltaMes ( const int                              iVersion,
+                                       const bool                             bIsFullList,
+                                       const CVector<CChannelListDeltaEntry>& vecDelta );
+    void CreateReqChannelLevelListDeltaMes();
     void CreateChanInfoMes ( const CChannelCoreInfo ChanInfo );
     void CreateReqChanInfoMes();
     void CreateChatTextMes ( const QString strChatText );
@@ -116,6 +145,7 @@ public:
     void CreateReqChannelLevelListMes ( const bool bRCL );
     void CreateVersionAndOSMes();
     void CreateRecorderStateMes ( const ERecorderState eRecorderState );
+    void CreateMessWindowSizeMes();
 
     void CreateCLPingMes               ( const CHostAddress& InetAddr, const int iMs );
     void CreateCLPingWithNumClientsMes ( const CHostAddress& InetAddr,
@@ -143,6 +173,36 @@ public:
                                          const int                iNumClients );
     void CreateCLRegisterServerResp    ( const CHostAddress& InetAddr,
                                          const ESvrRegResult eResult );
+    void CreateCLTickPhaseMes          ( const CHostAddress& InetAddr,
+                                         const int           iTickPeriodUs,
+                                         const int           iArrivalLeadUs,
+                                         const int           iArrivalJitterUs );
+
+    // the server list message can be generated once and then be sent to many
+    // clients, the positions of the server addresses in the message are
+    // returned so that they can be replaced for single clients
+    void GenCLServerListMesFrame ( CVector<uint8_t>&          vecMessage,
+                                   CVector<int>&              veciAddrPos,
+                                   const CVector<CServerInfo> vecServerInfo );
+
+    void SetCLServerListMesAddress ( CVector<uint8_t>&   vecMessage,
+                                     const int           iAddrPos,
+                                     const CHostAddress& HostAddr );
+
+    // the channel level list messages are generated once per level update
+    // and sent to all clients which have opted in, in the delta list the
+    // unchanged levels are marked with PROT_CHANNEL_LEVEL_UNCHANGED
+    void GenCLChannelLevelListMesFrame ( CVector<uint8_t>&        vecMessage,
+                                         const CVector<uint16_t>& vecLevelList,
+                                         const int                iNumClients );
+
+    void GenCLChannelLevelListDeltaMesFrame ( CVector<uint8_t>&        vecMessage,
+                                              const CVector<uint16_t>& vecLevelList,
+                                              const int                iNumClients );
+
+    void SendCLMessageFrame ( const CHostAddress&     InetAddr,
+                              const CVector<uint8_t>& vecMessage )
+        { emit CLMessReadyForSending ( InetAddr, vecMessage ); }
 
     static bool ParseMessageFrame ( const CVector<uint8_t>& vecbyData,
                                     const int               iNumBytesIn,
@@ -170,23 +230,36 @@ protected:
     {
     public:
         CSendMessage() : vecMessage ( 0 ), iID ( PROTMESSID_ILLEGAL ),
-            iCnt ( 0 ) {}
+            iCnt ( 0 ), bIsSent ( false ) {}
         CSendMessage ( const CVector<uint8_t>& nMess, const int iNCnt,
             const int iNID ) : vecMessage ( nMess ), iID ( iNID ),
-            iCnt ( iNCnt ) {}
+            iCnt ( iNCnt ), bIsSent ( false ) {}
 
         CSendMessage& operator= ( const CSendMessage& NewSendMess )
         {
             vecMessage.Init ( NewSendMess.vecMessage.Size() );
             vecMessage = NewSendMess.vecMessage;
 
-            iID  = NewSendMess.iID;
-            iCnt = NewSendMess.iCnt;
+            iID     = NewSendMess.iID;
+            iCnt    = NewSendMess.iCnt;
+            bIsSent = NewSendMess.bIsSent;
             return *this; 
         }
 
         CVector<uint8_t> vecMessage;
         int              iID, iCnt;
+        bool             bIsSent;
+    };
+
+    class CRecMessage
+    {
+    public:
+        CRecMessage() : vecData ( 0 ), iID ( PROTMESSID_ILLEGAL ),
+            iCnt ( 0 ), bIsValid ( false ) {}
+
+        CVector<uint8_t> vecData;
+        int              iID, iCnt;
+        bool             bIsValid;
     };
 
     void EnqueueMessage ( CVector<uint8_t>& vecMessage,
@@ -198,6 +271,8 @@ protected:
                            const int               iID,
                            const CVector<uint8_t>& vecData );
 
+    void PutMessageCRC ( CVector<uint8_t>& vecMessage );
+
     void PutValOnStream ( CVector<uint8_t>& vecIn,
                           int&              iPos,
                           const uint32_t    iVal,
@@ -216,7 +291,21 @@ protected:
                                const int               iMaxStringLen,
                                QString&                strOut );
 
-    void SendMessage();
+    void PutChanInfoOnStream ( CVector<uint8_t>&   vecIn,
+                               int&                iPos,
+                               const CChannelInfo& ChanInfo );
+
+    bool GetChanInfoFromStream ( const CVector<uint8_t>& vecIn,
+                                 int&                    iPos,
+                                 CChannelInfo&           ChanInfo );
+
+    void SendMessages ( const bool bResend );
+
+    bool ProcessMessage ( const CVector<uint8_t>& vecbyMesBodyData,
+                          const int               iRecCounter,
+                          const int               iRecID );
+
+    void ProcessStoredMessages ( const bool bFlush );
 
     void CreateAndSendMessage ( const int               iID,
                                 const CVector<uint8_t>& vecData );
@@ -233,6 +322,9 @@ protected:
     bool EvaluateMuteStateHasChangedMes ( const CVector<uint8_t>& vecData );
     bool EvaluateConClientListMes       ( const CVector<uint8_t>& vecData );
     bool EvaluateReqConnClientsList();
+    bool EvaluateReqConClientListDeltaMes();
+    bool EvaluateReqChannelLevelListDeltaMes();
+    bool EvaluateConClientListDeltaMes  ( const CVector<uint8_t>& vecData );
     bool EvaluateChanInfoMes            ( const CVector<uint8_t>& vecData );
     bool EvaluateReqChanInfoMes();
     bool EvaluateChatTextMes            ( const CVector<uint8_t>& vecData );
@@ -242,6 +334,7 @@ protected:
     bool EvaluateReqChannelLevelListMes ( const CVector<uint8_t>& vecData );
     bool EvaluateVersionAndOSMes        ( const CVector<uint8_t>& vecData );
     bool EvaluateRecorderStateMes       ( const CVector<uint8_t>& vecData );
+    bool EvaluateMessWindowSizeMes      ( const CVector<uint8_t>& vecData );
 
     bool EvaluateCLPingMes               ( const CHostAddress&     InetAddr,
                                            const CVector<uint8_t>& vecData );
@@ -266,19 +359,34 @@ protected:
                                            const CVector<uint8_t>& vecData );
     bool EvaluateCLRegisterServerResp    ( const CHostAddress&     InetAddr,
                                            const CVector<uint8_t>& vecData );
-
-    int                     iOldRecID;
-    int                     iOldRecCnt;
-
-    // these two objects must be sequred by a mutex
+    bool EvaluateCLTickPhaseMes          ( const CHostAddress&     InetAddr,
+                                           const CVector<uint8_t>& vecData );
+    bool EvaluateCLChannelLevelListDeltaMes ( const CHostAddress&     InetAddr,
+                                              const CVector<uint8_t>& vecData );
+
+    // receiving: counter of the next expected message, IDs of the processed
+    // messages per counter value (to detect resent messages), the messages
+    // which arrived before a missing message and the window in which the
+    // other side may send (1 until we have announced our window size)
+    int                     iRecExpCnt;
+    bool                    bRecExpCntValid;
+    int                     iRecWindowSize;
+    int                     iRecHistID[256];
+    CRecMessage             RecMessBuf[PROT_MESS_WINDOW_SIZE];
+    QTimer                  TimerRecGap;
+
+    // these objects must be sequred by a mutex
     uint8_t                 iCounter;
     std::list<CSendMessage> SendMessQueue;
+    int                     iSendWindowSize;
+    bool                    bMessWindowSizeSent;
 
     QTimer                  TimerSendMess;
     QMutex                  Mutex;
 
 public slots:
-    void OnTimerSendMess() { SendMessage(); }
+    void OnTimerSendMess() { SendMessages ( true ); }
+    void OnTimerRecGap() { emit RecGapTimeout(); }
 
 signals:
     // transmitting
@@ -286,6 +394,9 @@ signals:
     void CLMessReadyForSending ( CHostAddress     InetAddr,
                                  CVector<uint8_t> vecMessage );
 
+    // the stored messages must be processed by FlushStoredMessages()
+    void RecGapTimeout();
+
     // receiving
     void ChangeJittBufSize ( int iNewJitBufSize );
     void ReqJittBufSize();
@@ -297,6 +408,11 @@ signals:
     void ConClientListMesReceived ( CVector<CChannelInfo> vecChanInfo );
     void ServerFullMesReceived();
     void ReqConnClientsList();
+    void ReqConClientListDelta();
+    void ReqChannelLevelListDelta();
+    void ConClientListDeltaMesReceived ( int                             iVersion,
+                                         bool                            bIsFullList,
+                                         CVector<CChannelListDeltaEntry> vecDelta );
     void ChangeChanInfo ( CChannelCoreInfo ChanInfo );
     void ReqChanInfo();
     void ChatTextReceived ( QString strChatText );
@@ -332,4 +448,10 @@ signals:
                                         CVector<uint16_t>      vecLevelList );
     void CLRegisterServerResp         ( CHostAddress           InetAddr,
                                         ESvrRegResult          eStatus );
+    void CLTickPhaseReceived          ( CHostAddress           InetAddr,
+                                        int                    iTickPeriodUs,
+                                        int                    iArrivalLeadUs,
+                                        int                    iArrivalJitterUs );
+    void CLChannelLevelListDeltaReceived ( CHostAddress      InetAddr,
+                                           CVector<uint16_t> vecLevelList );
 };
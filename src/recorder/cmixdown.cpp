@@ -0,0 +1,238 @@
+/******************************************************************************\
+ * Copyright (c) 2020
+ *
+ * Author(s):
+ *  pljones
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#include "cmixdown.h"
+#include "jamrecorder.h"
+
+using namespace recorder;
+
+/**
+ * @brief CMixdown::Render Write the mixdown of a session into the session directory
+ * @param strSessionDirName Where the session wave files are
+ * @param serverFrameSizeSamples What the server frame size was for the session
+ * @param strSettingsFileName Optional gain and pan of the tracks
+ * @return the name of the written file
+ *
+ * The output file is sized up front and memory mapped as well, so each chunk is rendered straight
+ * into its own part of the file and the chunks need no synchronisation.
+ */
+QString CMixdown::Render(const QString& strSessionDirName, int serverFrameSizeSamples, const QString& strSettingsFileName)
+{
+    const QFileInfo fiSessionDir(QDir::cleanPath(strSessionDirName));
+    if (!fiSessionDir.exists() || !fiSessionDir.isDir())
+    {
+        throw std::runtime_error( (fiSessionDir.absoluteFilePath() + " does not exist or is not a directory.  Aborting.").toStdString() );
+    }
+
+    const QDir sessionDir(fiSessionDir.absoluteFilePath());
+
+    // gain and pan per track name
+    QMap<QString, QPair<double, double>> settings;
+
+    if (!strSettingsFileName.isEmpty())
+    {
+        QFile settingsFile(strSettingsFileName);
+        if (!settingsFile.open(QFile::ReadOnly | QFile::Text))
+        {
+            throw std::runtime_error( (strSettingsFileName + " could not be read.  Aborting.").toStdString() );
+        }
+
+        QTextStream in(&settingsFile);
+        while (!in.atEnd())
+        {
+            const QStringList fields = in.readLine().split(";");
+            if (fields.size() == 3)
+            {
+                settings.insert(fields[0].trimmed(), qMakePair(fields[1].toDouble(), fields[2].toDouble()));
+            }
+        }
+    }
+
+    const QMap<QString, QList<STrackItem>> tracks = CJamSession::TracksFromSessionDir(sessionDir.absolutePath(), serverFrameSizeSamples);
+
+    if (tracks.isEmpty())
+    {
+        throw std::runtime_error( (fiSessionDir.absoluteFilePath() + " does not contain wave files.  Aborting.").toStdString() );
+    }
+
+    // map all track files, the mappings are released when the files are destroyed
+    QList<QFile*>     files;
+    QVector<SMixItem> items;
+    qint64            totalSamples = 0;
+
+    foreach (auto trackName, tracks.keys())
+    {
+        const QPair<double, double> setting = settings.value(trackName, qMakePair(1.0, 0.5));
+
+        foreach (auto item, tracks[trackName])
+        {
+            QFile* file = new QFile(item.fileName);
+            files.append(file);
+
+            const uchar* data = file->open(QFile::ReadOnly) ? file->map(0, file->size()) : nullptr;
+            const qint64 offset = data == nullptr ? -1 : WaveDataOffset(data, file->size());
+
+            if (offset < 0 || (item.numAudioChannels != 1 && item.numAudioChannels != 2))
+            {
+                qWarning() << "CMixdown::Render():" << item.fileName << "could not be read, skipped.";
+                continue;
+            }
+
+            SMixItem mixItem;
+            mixItem.samples          = data + offset;
+            mixItem.numAudioChannels = item.numAudioChannels;
+            mixItem.startSample      = item.startFrame * serverFrameSizeSamples;
+            mixItem.numSamples       = (file->size() - offset) / (item.numAudioChannels * static_cast<qint64>(sizeof(int16_t)));
+            mixItem.gainL            = static_cast<float>(MathUtils::GetLeftPan(setting.second, false) * setting.first);
+            mixItem.gainR            = static_cast<float>(MathUtils::GetRightPan(setting.second, false) * setting.first);
+            items.append(mixItem);
+
+            totalSamples = std::max(totalSamples, mixItem.startSample + mixItem.numSamples);
+        }
+    }
+
+    const QString mixdownFileName = sessionDir.absoluteFilePath(sessionDir.dirName() + "_mixdown.wav");
+
+    QFile outf(mixdownFileName);
+    if (!outf.open(QFile::ReadWrite | QFile::Truncate))
+    {
+        qDeleteAll(files);
+        throw std::runtime_error( (mixdownFileName + " could not be written.  Aborting.").toStdString() );
+    }
+
+    CWaveStream out(&outf, 2);
+    const qint64 dataOffset = outf.pos();
+    const qint64 dataSize   = totalSamples * 2 * static_cast<qint64>(sizeof(int16_t));
+
+    uchar* outData = nullptr;
+    if (outf.resize(dataOffset + dataSize) && dataSize > 0)
+    {
+        outData = outf.map(dataOffset, dataSize);
+    }
+
+    if (outData == nullptr && dataSize > 0)
+    {
+        qDeleteAll(files);
+        throw std::runtime_error( (mixdownFileName + " could not be mapped.  Aborting.").toStdString() );
+    }
+
+    // the chunks are spread over the threads of the global thread pool
+    QVector<qint64> chunkBegins;
+    for (qint64 begin = 0; begin < totalSamples; begin += MIXDOWN_CHUNK_SIZE_SAMPLES)
+    {
+        chunkBegins.append(begin);
+    }
+
+    QtConcurrent::blockingMap(chunkBegins, [&items, totalSamples, outData](const qint64& begin)
+    {
+        const qint64 end = std::min(begin + MIXDOWN_CHUNK_SIZE_SAMPLES, totalSamples);
+
+        RenderChunk(items, begin, end, outData + begin * 2 * sizeof(int16_t));
+    });
+
+    if (outData != nullptr)
+    {
+        outf.unmap(outData);
+    }
+
+    outf.seek(dataOffset + dataSize);
+    out.finalise();
+
+    qDeleteAll(files);
+
+    qDebug() << "Session mixdown:" << mixdownFileName;
+
+    return mixdownFileName;
+}
+
+/**
+ * @brief CMixdown::WaveDataOffset Find the samples of a wave file
+ * @param data the file content
+ * @param size the file size
+ * @return the offset of the samples or -1 if the file is no wave file
+ */
+qint64 CMixdown::WaveDataOffset(const uchar* data, const qint64 size)
+{
+    if (size < 12 || memcmp(data, "RIFF", 4) != 0 || memcmp(data + 8, "WAVE", 4) != 0)
+    {
+        return -1;
+    }
+
+    // walk the chunks up to the data chunk
+    qint64 pos = 12;
+
+    while (pos + 8 <= size)
+    {
+        if (memcmp(data + pos, "data", 4) == 0)
+        {
+            // the size of the data chunk is not used as it is not set if the recording was aborted
+            return pos + 8;
+        }
+
+        pos += 8 + qFromLittleEndian<quint32>(data + pos + 4);
+    }
+
+    return -1;
+}
+
+/**
+ * @brief CMixdown::RenderChunk Mix a part of the session
+ * @param items the tracks
+ * @param begin the first sample of the part
+ * @param end the sample after the part
+ * @param out where the stereo samples of the part are written to
+ */
+void CMixdown::RenderChunk(const QVector<SMixItem>& items, const qint64 begin, const qint64 end, uchar* out)
+{
+    QVector<float> mix(2 * (end - begin), 0.0f);
+
+    foreach (const SMixItem& item, items)
+    {
+        const qint64 from = std::max(begin, item.startSample);
+        const qint64 to   = std::min(end, item.startSample + item.numSamples);
+
+        for (qint64 i = from; i < to; i++)
+        {
+            const uchar* in = item.samples + (i - item.startSample) * item.numAudioChannels * sizeof(int16_t);
+            float*       m  = &mix[2 * (i - begin)];
+
+            if (item.numAudioChannels == 1)
+            {
+                const float value = qFromLittleEndian<qint16>(in);
+                m[0] += value * item.gainL;
+                m[1] += value * item.gainR;
+            }
+            else
+            {
+                m[0] += qFromLittleEndian<qint16>(in) * item.gainL;
+                m[1] += qFromLittleEndian<qint16>(in + sizeof(int16_t)) * item.gainR;
+            }
+        }
+    }
+
+    for (int i = 0; i < mix.size(); i++)
+    {
+        qToLittleEndian<qint16>(Double2Short(mix[i]), out + i * sizeof(int16_t));
+    }
+}
@@ -0,0 +1,77 @@
+/******************************************************************************\
+ * Copyright (c) 2020
+ *
+ * Author(s):
+ *  pljones
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#pragma once
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QtEndian>
+#include <QtConcurrent>
+#include "util.h"
+
+#include "cwavestream.h"
+
+// the mixdown is rendered in chunks of this many samples, the chunks are distributed over the cores
+#define MIXDOWN_CHUNK_SIZE_SAMPLES  ( 10 * 48000 )
+
+namespace recorder {
+
+/**
+ * @brief Renders a stereo mixdown of the tracks of a recorded session
+ *
+ * The wave files of the tracks are memory mapped and aligned by their start frame.  Each track
+ * can have its own gain and pan, given by a settings file with lines "track name;gain;pan" where
+ * the track name is as in the RPP file, the gain is a factor and the pan goes from 0 (left) over
+ * 0.5 (center) to 1 (right) as on the mixer board.
+ */
+class CMixdown
+{
+public:
+    /**
+     * @brief Render Write the mixdown of a session into the session directory
+     * @param strSessionDirName Where the session wave files are
+     * @param serverFrameSizeSamples What the server frame size was for the session
+     * @param strSettingsFileName Optional gain and pan of the tracks
+     * @return the name of the written file
+     */
+    static QString Render( const QString& strSessionDirName, int serverFrameSizeSamples, const QString& strSettingsFileName );
+
+private:
+    struct SMixItem
+    {
+        const uchar* samples;
+        int          numAudioChannels;
+        qint64       startSample;
+        qint64       numSamples;
+        float        gainL;
+        float        gainR;
+    };
+
+    static qint64 WaveDataOffset( const uchar* data, const qint64 size );
+    static void   RenderChunk( const QVector<SMixItem>& items, const qint64 begin, const qint64 end, uchar* out );
+};
+
+}
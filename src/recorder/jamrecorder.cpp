@@ -24,8 +24,205 @@
 
 #include "jamrecorder.h"
 
+#ifdef USE_OPUS_SHARED_LIB
+# include "opus/opus_custom.h"
+#else
+# include "opus_custom.h"
+#endif
+
+#ifdef Q_OS_LINUX
+# include <fcntl.h>
+#endif
+
 using namespace recorder;
 
+/* ********************************************************************************************************
+ * CJamChannelRing
+ * ********************************************************************************************************/
+
+/**
+ * @brief CJamChannelRing::Init Allocate the ring entries
+ * @param maxNumSamples the maximum number of samples of a frame (all audio channels)
+ * @param maxNumPacketBytes the maximum size of a packet
+ *
+ * Only the buffers of the recording mode in use need a size.
+ */
+void CJamChannelRing::Init(const int maxNumSamples, const int maxNumPacketBytes)
+{
+    vecEntries.resize(JAM_RECORDER_RING_SIZE);
+
+    for (int i = 0; i < vecEntries.size(); i++)
+    {
+        vecEntries[i].data.Init(maxNumSamples);
+        vecEntries[i].packet.Init(maxNumPacketBytes);
+    }
+}
+
+/**
+ * @brief CJamChannelRing::BeginPut Get the next free entry
+ * @return the entry or nullptr if the ring is full
+ */
+CJamChannelRing::SEntry* CJamChannelRing::BeginPut()
+{
+    const uint32_t iWrite = writeIdx.load(std::memory_order_relaxed);
+
+    if (iWrite - readIdx.load(std::memory_order_acquire) >= JAM_RECORDER_RING_SIZE)
+    {
+        return nullptr;
+    }
+
+    return &vecEntries[iWrite % JAM_RECORDER_RING_SIZE];
+}
+
+/**
+ * @brief CJamChannelRing::Front Get the oldest entry
+ * @return the entry or nullptr if the ring is empty
+ */
+CJamChannelRing::SEntry* CJamChannelRing::Front()
+{
+    const uint32_t iRead = readIdx.load(std::memory_order_relaxed);
+
+    if (iRead == writeIdx.load(std::memory_order_acquire))
+    {
+        return nullptr;
+    }
+
+    return &vecEntries[iRead % JAM_RECORDER_RING_SIZE];
+}
+
+/**
+ * @brief CJamChannelRing::PutFrame Put a frame of the client into the ring
+ * @param frame the server frame counter
+ * @param name the client name
+ * @param address the client IP and port number
+ * @param numAudioChannels the client number of audio channels
+ * @param data the frame data
+ * @param numSamples the number of samples of the frame (all audio channels)
+ *
+ * The client details are only put into the ring if they have changed.  If the ring is full, the
+ * frame is dropped and the recorder fills the gap with silence.
+ */
+void CJamChannelRing::PutFrame(const qint64 frame, const QString& name, const CHostAddress& address, const int numAudioChannels, const CVector<int16_t>& data, const int numSamples)
+{
+    if (!PutInfo(frame, name, address))
+    {
+        droppedFrames++;
+        return;
+    }
+
+    SEntry* entry = BeginPut();
+
+    if (entry == nullptr)
+    {
+        droppedFrames++;
+        return;
+    }
+
+    entry->type             = ET_FRAME;
+    entry->frame            = frame;
+    entry->numAudioChannels = numAudioChannels;
+
+    for (int i = 0; i < numSamples; i++)
+    {
+        entry->data[i] = data[i];
+    }
+
+    EndPut();
+}
+
+/**
+ * @brief CJamChannelRing::PutPacket Put a received packet of the client into the ring
+ * @param frame the server frame counter
+ * @param name the client name
+ * @param address the client IP and port number
+ * @param numAudioChannels the client number of audio channels
+ * @param comprType the audio compression type of the packet
+ * @param packet the coded data or nullptr for a lost packet
+ * @param numBytes the size of the coded data
+ */
+void CJamChannelRing::PutPacket(const qint64 frame, const QString& name, const CHostAddress& address, const int numAudioChannels, const EAudComprType comprType, const uint8_t* packet, const int numBytes)
+{
+    if (vecEntries.isEmpty() || numBytes > vecEntries[0].packet.Size() || !PutInfo(frame, name, address))
+    {
+        droppedFrames++;
+        return;
+    }
+
+    SEntry* entry = BeginPut();
+
+    if (entry == nullptr)
+    {
+        droppedFrames++;
+        return;
+    }
+
+    entry->type             = ET_PACKET;
+    entry->frame            = frame;
+    entry->numAudioChannels = numAudioChannels;
+    entry->comprType        = comprType;
+    entry->numPacketBytes   = packet == nullptr ? 0 : numBytes;
+
+    for (int i = 0; i < entry->numPacketBytes; i++)
+    {
+        entry->packet[i] = packet[i];
+    }
+
+    EndPut();
+}
+
+/**
+ * @brief CJamChannelRing::PutInfo Put the client details into the ring if they have changed
+ * @return false if the ring is full
+ */
+bool CJamChannelRing::PutInfo(const qint64 frame, const QString& name, const CHostAddress& address)
+{
+    if (infoPut && name == putName && address == putAddress)
+    {
+        return true;
+    }
+
+    SEntry* entry = BeginPut();
+
+    if (entry == nullptr)
+    {
+        return false;
+    }
+
+    entry->type    = ET_INFO;
+    entry->frame   = frame;
+    entry->name    = name;
+    entry->address = address;
+    EndPut();
+
+    infoPut    = true;
+    putName    = name;
+    putAddress = address;
+
+    return true;
+}
+
+/**
+ * @brief CJamChannelRing::PutDisconnect Put the disconnection of the client into the ring
+ * @param frame the server frame counter
+ */
+void CJamChannelRing::PutDisconnect(const qint64 frame)
+{
+    // the next client on this channel always starts with its details
+    infoPut = false;
+
+    SEntry* entry = BeginPut();
+
+    if (entry == nullptr)
+    {
+        // the recorder starts a new file anyway when the address changes
+        return;
+    }
+
+    entry->type  = ET_DISCONNECT;
+    entry->frame = frame;
+    EndPut();
+}
+
 /* ********************************************************************************************************
  * CJamClient
  * ********************************************************************************************************/
@@ -37,59 +234,213 @@ using namespace recorder;
  * @param name The client's current name
  * @param address IP and Port
  * @param recordBaseDir Session recording directory
+ * @param _packets Store the received packets instead of the PCM data
+ * @param iServerFrameSizeSamples The server frame size, stored in the packet file header
+ *
+ * Creates a file for the raw PCM data and sets up a QDataStream which writes the headers.  The
+ * received frames are collected in a buffer which is written to the file in one go.  The data is
+ * stored Little Endian.
  *
- * Creates a file for the raw PCM data and sets up a QDataStream to which to write received frames.
- * The data is stored Little Endian.
+ * In the packet mode the file starts with the id, the version, the number of audio channels and
+ * the server frame size.  Each packet follows as frame offset to the start frame (4 bytes), audio
+ * compression type (1 byte), size (2 bytes, zero for a lost packet) and the coded data.
  */
-CJamClient::CJamClient(const qint64 frame, const int _numChannels, const QString name, const CHostAddress address, const QDir recordBaseDir) :
+CJamClient::CJamClient(const qint64 frame, const int _numChannels, const QString name, const CHostAddress address, const QDir recordBaseDir, const bool _packets, const int iServerFrameSizeSamples) :
     startFrame (frame),
     numChannels (static_cast<uint16_t>(_numChannels)),
+    packets (_packets),
     name (name),
     address (address)
 {
+    const QString extension = packets ? ".pkt" : ".wav";
+
     // At this point we may not have much of a name
     QString fileName = ClientName() + "-" + QString::number(frame) + "-" + QString::number(_numChannels);
     QString affix = "";
-    while (recordBaseDir.exists(fileName + affix + ".wav"))
+    while (recordBaseDir.exists(fileName + affix + extension))
     {
         affix = affix.length() == 0 ? "_1" : "_" + QString::number(affix.remove(0, 1).toInt() + 1);
     }
-    fileName = fileName + affix + ".wav";
+    fileName = fileName + affix + extension;
 
     wavFile = new QFile(recordBaseDir.absoluteFilePath(fileName));
-    if (!wavFile->open(QFile::OpenMode(QIODevice::OpenModeFlag::ReadWrite))) // need to allow rewriting headers
+    // need to allow rewriting headers, we do our own buffering
+    if (!wavFile->open(QFile::OpenMode(QIODevice::OpenModeFlag::ReadWrite | QIODevice::OpenModeFlag::Unbuffered)))
     {
-        throw new std::runtime_error( ("Could not write to WAV file "  + wavFile->fileName()).toStdString() );
+        throw new std::runtime_error( ("Could not write to file "  + wavFile->fileName()).toStdString() );
     }
-    out = new CWaveStream(wavFile, numChannels);
 
     filename = wavFile->fileName();
+
+    writeBuffer.reserve(JAM_RECORDER_WRITE_BUFFER_SIZE);
+
+    if (packets)
+    {
+        out = nullptr;
+
+        char* dest = Reserve(8);
+        memcpy(dest, JAM_RECORDER_PACKET_FILE_ID, 4);
+        dest[4] = JAM_RECORDER_PACKET_FILE_VER;
+        dest[5] = static_cast<char>(numChannels);
+        qToLittleEndian<quint16>(static_cast<quint16>(iServerFrameSizeSamples), dest + 6);
+    }
+    else
+    {
+        out = new CWaveStream(wavFile, numChannels);
+    }
 }
 
 /**
  * @brief CJamClient::Frame Handle a frame of PCM data from a client connected to the server
  * @param _name The client's current name
+ * @param frame The frame position within the session
  * @param pcm The PCM data
+ *
+ * Frames which the server dropped are replaced by silence, so the following frames stay in place.
  */
-void CJamClient::Frame(const QString _name, const CVector<int16_t>& pcm, int iServerFrameSizeSamples)
+void CJamClient::Frame(const QString _name, const qint64 frame, const CVector<int16_t>& pcm, int iServerFrameSizeSamples)
 {
     name = _name;
 
-    for(int i = 0; i < numChannels * iServerFrameSizeSamples; i++)
+    if (frame < startFrame + frameCount)
+    {
+        return;
+    }
+
+    for (qint64 missing = frame - (startFrame + frameCount); missing > 0; missing--)
     {
-        *out << pcm[i];
+        Append(nullptr, numChannels * iServerFrameSizeSamples);
+        frameCount++;
     }
 
+    Append(pcm.data(), numChannels * iServerFrameSizeSamples);
     frameCount++;
 }
 
+/**
+ * @brief CJamClient::Packet Handle a received packet of a client connected to the server
+ * @param _name The client's current name
+ * @param frame The frame position within the session
+ * @param comprType The audio compression type of the packet
+ * @param packet The coded data
+ * @param numBytes The size of the coded data, zero for a lost packet
+ */
+void CJamClient::Packet(const QString _name, const qint64 frame, const EAudComprType comprType, const CVector<uint8_t>& packet, const int numBytes)
+{
+    name = _name;
+
+    char* dest = Reserve(7 + numBytes);
+    qToLittleEndian<quint32>(static_cast<quint32>(frame - startFrame), dest);
+    dest[4] = static_cast<char>(comprType);
+    qToLittleEndian<quint16>(static_cast<quint16>(numBytes), dest + 5);
+    memcpy(dest + 7, packet.data(), numBytes);
+
+    frameCount = frame - startFrame + 1;
+}
+
+/**
+ * @brief CJamClient::Reserve Get space at the end of the write buffer, flushing it first if it is full
+ * @param numBytes The number of bytes
+ * @return the start of the space
+ */
+char* CJamClient::Reserve(const int numBytes)
+{
+    if (writeBuffer.size() + numBytes > JAM_RECORDER_WRITE_BUFFER_SIZE)
+    {
+        Flush();
+    }
+
+    // the buffer keeps its reserved capacity, so this does not allocate
+    const int pos = writeBuffer.size();
+    writeBuffer.resize(pos + numBytes);
+
+    return writeBuffer.data() + pos;
+}
+
+/**
+ * @brief CJamClient::Append Add samples to the write buffer
+ * @param pcm The samples or nullptr for silence
+ * @param numSamples The number of samples
+ */
+void CJamClient::Append(const int16_t* pcm, const int numSamples)
+{
+    const int numBytes = numSamples * static_cast<int>(sizeof(int16_t));
+    char*     dest     = Reserve(numBytes);
+
+    if (pcm == nullptr)
+    {
+        memset(dest, 0, numBytes);
+        return;
+    }
+
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    memcpy(dest, pcm, numBytes);
+#else
+    for (int i = 0; i < numSamples; i++)
+    {
+        qToLittleEndian<qint16>(pcm[i], dest + i * sizeof(int16_t));
+    }
+#endif
+}
+
+/**
+ * @brief CJamClient::Flush Write the buffered samples to the file
+ *
+ * On Linux the file space is reserved ahead, the write back of the block is started right away
+ * and the previous block is dropped from the page cache, as we never read it again.
+ */
+void CJamClient::Flush()
+{
+    if (writeBuffer.isEmpty())
+    {
+        return;
+    }
+
+    const qint64 pos = wavFile->pos();
+
+#ifdef Q_OS_LINUX
+    const int fd = wavFile->handle();
+
+    if (pos + writeBuffer.size() > allocatedSize)
+    {
+        // failures are ignored, not every file system supports it
+        allocatedSize = pos + JAM_RECORDER_PREALLOCATE_SIZE;
+        fallocate(fd, FALLOC_FL_KEEP_SIZE, pos, JAM_RECORDER_PREALLOCATE_SIZE);
+    }
+#endif
+
+    if (wavFile->write(writeBuffer.constData(), writeBuffer.size()) != writeBuffer.size())
+    {
+        qWarning() << "CJamClient::Flush():" << wavFile->fileName() << "could not be written:" << wavFile->errorString();
+    }
+
+#ifdef Q_OS_LINUX
+    sync_file_range(fd, pos, writeBuffer.size(), SYNC_FILE_RANGE_WRITE);
+
+    if (lastFlushSize > 0)
+    {
+        posix_fadvise(fd, lastFlushPos, lastFlushSize, POSIX_FADV_DONTNEED);
+    }
+
+    lastFlushPos  = pos;
+    lastFlushSize = writeBuffer.size();
+#endif
+
+    writeBuffer.resize(0);
+}
+
 /**
  * @brief CJamClient::Disconnect Clean up after a disconnected client
  */
 void CJamClient::Disconnect()
 {
-    static_cast<CWaveStream*>(out)->finalise();
-    out = nullptr;
+    Flush();
+
+    if (out != nullptr)
+    {
+        static_cast<CWaveStream*>(out)->finalise();
+        out = nullptr;
+    }
 
     wavFile->close();
 
@@ -104,13 +455,16 @@ void CJamClient::Disconnect()
 /**
  * @brief CJamSession::CJamSession Construct a new jam recording session
  * @param recordBaseDir The recording base directory
+ * @param _packets Store the received packets instead of the PCM data
+ * @param _frameSizeSamples The server frame size, stored in the session index
  *
  * Each session is stored into its own subdirectory of the recording base directory.
  */
-CJamSession::CJamSession(QDir recordBaseDir) :
+CJamSession::CJamSession(QDir recordBaseDir, const bool _packets, const int _frameSizeSamples) :
     sessionDir (QDir(recordBaseDir.absoluteFilePath("Jam-" + QDateTime().currentDateTimeUtc().toString("yyyyMMdd-HHmmsszzz")))),
-    currentFrame (0),
-    chIdDisconnected (-1),
+    packets (_packets),
+    frameSizeSamples (_frameSizeSamples),
+    firstFrame (-1),
     vecptrJamClients (MAX_NUM_CHANNELS),
     jamClientConnections()
 {
@@ -150,35 +504,82 @@ void CJamSession::DisconnectClient(int iChID)
 
     delete vecptrJamClients[iChID];
     vecptrJamClients[iChID] = nullptr;
-    chIdDisconnected = iChID;
+
+    UpdateIndex();
 }
 
 /**
- * @brief CJamSession::Frame Process a frame emited for a client by the server
+ * @brief CJamSession::Frame Process a frame put by the server for a client
  * @param iChID the client channel id
+ * @param serverFrame the server frame counter of the frame
  * @param name the client name
  * @param address the client IP and port number
  * @param numAudioChannels the client number of audio channels
  * @param data the frame data
  *
- * Manages changes that affect how the recording is stored - i.e. if the number of audio channels changes, we need a new file.
- * Files are grouped by IP and port number, so if either of those change for a connection, we also start a new file.
- *
- * Also manages the overall current frame counter for the session.
+ * The position of the frame within the session is taken from the server frame counter.
  */
-void CJamSession::Frame(const int iChID, const QString name, const CHostAddress address, const int numAudioChannels, const CVector<int16_t> data, int iServerFrameSizeSamples)
+void CJamSession::Frame(const int iChID, const qint64 serverFrame, const QString name, const CHostAddress address, const int numAudioChannels, const CVector<int16_t>& data, int iServerFrameSizeSamples)
 {
-    if ( iChID == chIdDisconnected )
+    const qint64 frame = serverFrame - firstFrame;
+
+    if (frame < 0)
     {
-        // DisconnectClient has just been called for this channel - this frame is "too late"
-        chIdDisconnected = -1;
+        // the frame is from before the session started
         return;
     }
 
+    CJamClient* client = ClientForFrame(iChID, frame, name, address, numAudioChannels, iServerFrameSizeSamples);
+
+    if (client != nullptr)
+    {
+        client->Frame(name, frame, data, iServerFrameSizeSamples);
+    }
+}
+
+/**
+ * @brief CJamSession::Packet Process a received packet put by the server for a client
+ * @param iChID the client channel id
+ * @param serverFrame the server frame counter of the packet
+ * @param name the client name
+ * @param address the client IP and port number
+ * @param numAudioChannels the client number of audio channels
+ * @param comprType the audio compression type of the packet
+ * @param packet the coded data
+ * @param numBytes the size of the coded data, zero for a lost packet
+ */
+void CJamSession::Packet(const int iChID, const qint64 serverFrame, const QString name, const CHostAddress address, const int numAudioChannels, const EAudComprType comprType, const CVector<uint8_t>& packet, const int numBytes, int iServerFrameSizeSamples)
+{
+    const qint64 frame = serverFrame - firstFrame;
+
+    if (frame < 0)
+    {
+        // the packet is from before the session started
+        return;
+    }
+
+    CJamClient* client = ClientForFrame(iChID, frame, name, address, numAudioChannels, iServerFrameSizeSamples);
+
+    if (client != nullptr)
+    {
+        client->Packet(name, frame, comprType, packet, numBytes);
+    }
+}
+
+/**
+ * @brief CJamSession::ClientForFrame Get the client which stores the frame
+ * @return the client or nullptr if the client details cannot be established
+ *
+ * Manages changes that affect how the recording is stored - i.e. if the number of audio channels changes, we need a new file.
+ * Files are grouped by IP and port number, so if either of those change for a connection, we also start a new file.
+ */
+CJamClient* CJamSession::ClientForFrame(const int iChID, const qint64 frame, const QString name, const CHostAddress address, const int numAudioChannels, int iServerFrameSizeSamples)
+{
     if (vecptrJamClients[iChID] == nullptr)
     {
         // then we have not seen this client this session
-        vecptrJamClients[iChID] = new CJamClient(currentFrame, numAudioChannels, name, address, sessionDir);
+        vecptrJamClients[iChID] = new CJamClient(frame, numAudioChannels, name, address, sessionDir, packets, iServerFrameSizeSamples);
+        UpdateIndex();
     }
     else if (numAudioChannels != vecptrJamClients[iChID]->NumAudioChannels()
              || address.InetAddr != vecptrJamClients[iChID]->ClientAddress().InetAddr
@@ -191,23 +592,13 @@ void CJamSession::Frame(const int iChID, const QString name, const CHostAddress
         }
         else
         {
-            vecptrJamClients[iChID] = new CJamClient(currentFrame, numAudioChannels, name, address, sessionDir);
+            vecptrJamClients[iChID] = new CJamClient(frame, numAudioChannels, name, address, sessionDir, packets, iServerFrameSizeSamples);
+            UpdateIndex();
         }
     }
 
-    if (vecptrJamClients[iChID] == nullptr)
-    {
-        // Frame allegedly from iChID but unable to establish client details
-        return;
-    }
-
-    vecptrJamClients[iChID]->Frame(name, data, iServerFrameSizeSamples);
-
-    // If _any_ connected client frame steps past currentFrame, increase currentFrame
-    if (vecptrJamClients[iChID]->StartFrame() + vecptrJamClients[iChID]->FrameCount() > currentFrame)
-    {
-        currentFrame++;
-    }
+    // nullptr if the frame is allegedly from iChID but we are unable to establish client details
+    return vecptrJamClients[iChID];
 }
 
 /**
@@ -253,20 +644,171 @@ QMap<QString, QList<STrackItem>> CJamSession::Tracks()
     return tracks;
 }
 
+/**
+ * @brief CJamSession::UpdateIndex Write the session index with the closed and the currently open connections
+ *
+ * Called whenever a connection opens or closes, which is rare compared to the frames.
+ */
+void CJamSession::UpdateIndex()
+{
+    QMap<QString, QList<STrackItem>> openTracks;
+
+    for (int iChID = 0; iChID < vecptrJamClients.size(); iChID++)
+    {
+        CJamClient* client = vecptrJamClients[iChID];
+
+        if (client != nullptr)
+        {
+            openTracks[client->ClientName()].append(STrackItem(client->NumAudioChannels(), client->StartFrame(), client->FrameCount(), client->FileName()));
+        }
+    }
+
+    WriteIndex(sessionDir, Tracks(), openTracks, frameSizeSamples, packets);
+}
+
+/**
+ * @brief CJamSession::WriteIndex Write the index of the tracks of a session
+ * @param sessionDir the session directory
+ * @param tracks the closed connections
+ * @param openTracks the connections which are still recorded, their length is not known yet
+ * @param iServerFrameSizeSamples the server frame size of the session
+ * @param packets true if the tracks are packet files
+ *
+ * The index is a JSON file which is replaced atomically.  The file names are stored relative to the
+ * session directory so that the session can be moved.
+ */
+void CJamSession::WriteIndex(const QDir& sessionDir, const QMap<QString, QList<STrackItem>>& tracks, const QMap<QString, QList<STrackItem>>& openTracks, int iServerFrameSizeSamples, bool packets)
+{
+    QJsonArray items;
+
+    for (int open = 0; open < 2; open++)
+    {
+        const QMap<QString, QList<STrackItem>>& map = open ? openTracks : tracks;
+
+        foreach (auto trackName, map.keys())
+        {
+            foreach (auto item, map[trackName])
+            {
+                QJsonObject jsonItem;
+
+                jsonItem["track"]       = trackName;
+                jsonItem["file"]        = QFileInfo(item.fileName).fileName();
+                jsonItem["channels"]    = item.numAudioChannels;
+                jsonItem["start_frame"] = item.startFrame;
+                jsonItem["length"]      = item.frameCount;
+                jsonItem["open"]        = open != 0;
+
+                items.append(jsonItem);
+            }
+        }
+    }
+
+    QJsonObject index;
+
+    index["version"]    = JAM_RECORDER_INDEX_VERSION;
+    index["frame_size"] = iServerFrameSizeSamples;
+    index["packets"]    = packets;
+    index["tracks"]     = items;
+
+    QSaveFile indexFile(sessionDir.filePath(sessionDir.dirName() + JAM_RECORDER_INDEX_FILE_SUFFIX));
+
+    if (!indexFile.open(QIODevice::WriteOnly))
+    {
+        qWarning() << "CJamSession::WriteIndex():" << indexFile.fileName() << "could not be written.";
+        return;
+    }
+
+    indexFile.write(QJsonDocument(index).toJson());
+    indexFile.commit();
+}
+
+/**
+ * @brief CJamSession::TracksFromIndex Construct the track item map from the session index
+ * @param sessionDir the session directory
+ * @param tracks the map of (latest) client name to connection items
+ * @param iServerFrameSizeSamples set to the server frame size of the session
+ * @return false if there is no usable index, i.e. it is missing or lists packet files
+ *
+ * Only the files of connections which were still open when the recording stopped are looked at
+ * to get their length.
+ */
+bool CJamSession::TracksFromIndex(const QDir& sessionDir, QMap<QString, QList<STrackItem>>& tracks, int& iServerFrameSizeSamples)
+{
+    QFile indexFile(sessionDir.filePath(sessionDir.dirName() + JAM_RECORDER_INDEX_FILE_SUFFIX));
+
+    if (!indexFile.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    const QJsonObject index = QJsonDocument::fromJson(indexFile.readAll()).object();
+
+    if (index["version"].toInt() != JAM_RECORDER_INDEX_VERSION || index["packets"].toBool() || index["frame_size"].toInt() <= 0)
+    {
+        return false;
+    }
+
+    const int frameSize = index["frame_size"].toInt();
+
+    tracks.clear();
+
+    foreach (auto value, index["tracks"].toArray())
+    {
+        const QJsonObject jsonItem    = value.toObject();
+        const QString     fileName    = sessionDir.absoluteFilePath(jsonItem["file"].toString());
+        const int         numChannels = jsonItem["channels"].toInt();
+        qint64            length      = static_cast<qint64>(jsonItem["length"].toDouble());
+
+        if (numChannels <= 0)
+        {
+            continue;
+        }
+
+        if (jsonItem["open"].toBool())
+        {
+            // the samples follow the 44 bytes wave header written by CWaveStream
+            length = (QFileInfo(fileName).size() - 44) / static_cast<qint64>(sizeof(int16_t)) / numChannels / frameSize;
+        }
+
+        tracks[jsonItem["track"].toString()].append(STrackItem(numChannels,
+                                                               static_cast<qint64>(jsonItem["start_frame"].toDouble()),
+                                                               length,
+                                                               fileName));
+    }
+
+    iServerFrameSizeSamples = frameSize;
+
+    return true;
+}
+
 /**
  * @brief CJamSession::TracksFromSessionDir Replica of CJamSession::Tracks but using the directory contents to construct the track item map
  * @param sessionDirName the directory name to scan
+ * @param iServerFrameSizeSamples the server frame size, replaced by the one of the session index if there is one
  * @return a map of (latest) client name to connection items
+ *
+ * The session index is used if available, otherwise the wave files are listed.
  */
-QMap<QString, QList<STrackItem>> CJamSession::TracksFromSessionDir(const QString& sessionDirName, int iServerFrameSizeSamples)
+QMap<QString, QList<STrackItem>> CJamSession::TracksFromSessionDir(const QString& sessionDirName, int& iServerFrameSizeSamples)
 {
     QMap<QString, QList<STrackItem>> tracks;
 
     const QDir sessionDir(sessionDirName);
-    foreach(auto entry, sessionDir.entryList({ "*.pcm" }))
+
+    if (TracksFromIndex(sessionDir, tracks, iServerFrameSizeSamples))
+    {
+        return tracks;
+    }
+
+    foreach(auto entry, sessionDir.entryList({ "*.wav" }))
     {
 
         auto split = entry.split(".")[0].split("-");
+        if (split.size() < 4)
+        {
+            // not a track, e.g. a mixdown
+            continue;
+        }
         QString name = split[0];
         QString hostPort = split[1];
         QString frame = split[2];
@@ -279,8 +821,9 @@ QMap<QString, QList<STrackItem>> CJamSession::TracksFromSessionDir(const QString
             tracks.insert(trackName, { });
         }
 
+        // the samples follow the 44 bytes wave header written by CWaveStream
         QFileInfo fiEntry(sessionDir.absoluteFilePath(entry));
-        qint64 length = fiEntry.size() / numChannels.toInt() / iServerFrameSizeSamples;
+        qint64 length = (fiEntry.size() - 44) / static_cast<qint64>(sizeof(int16_t)) / numChannels.toInt() / iServerFrameSizeSamples;
 
         STrackItem track (
                     numChannels.toInt(),
@@ -302,8 +845,10 @@ QMap<QString, QList<STrackItem>> CJamSession::TracksFromSessionDir(const QString
 /**
  * @brief CJamRecorder::Init Create recording directory, if necessary, and connect signal handlers
  * @param server Server object emiting signals
+ * @param iMaxNumChannels Number of server channels, a ring is allocated for each of them
  */
 bool CJamRecorder::Init( const CServer* server,
+                         const int      iMaxNumChannels,
                          const int      _iServerFrameSizeSamples )
 {
     QFileInfo fi(recordBaseDir.absolutePath());
@@ -337,35 +882,148 @@ bool CJamRecorder::Init( const CServer* server,
                       this, SLOT( OnEnd() ),
                       Qt::ConnectionType::QueuedConnection );
 
-    QObject::connect( (const QObject *)server, SIGNAL ( ClientDisconnected ( int ) ),
-                      this, SLOT( OnDisconnected ( int ) ),
-                      Qt::ConnectionType::QueuedConnection );
-
-    qRegisterMetaType<CVector<int16_t>> ( "CVector<int16_t>" );
-    QObject::connect( (const QObject *)server, SIGNAL ( AudioFrame( const int, const QString, const CHostAddress, const int, const CVector<int16_t> ) ),
-                      this, SLOT(  OnFrame (const int, const QString, const CHostAddress, const int, const CVector<int16_t> ) ),
-                      Qt::ConnectionType::QueuedConnection );
-
     QObject::connect( QCoreApplication::instance(), SIGNAL ( aboutToQuit() ),
                       this, SLOT( OnAboutToQuit() ) );
 
+    QObject::connect( &timerDrain, SIGNAL ( timeout() ),
+                      this, SLOT( OnTimerDrain() ) );
+
     iServerFrameSizeSamples = _iServerFrameSizeSamples;
 
+    // the frames and disconnections are passed through the rings, the server never waits for us
+    numRings = iMaxNumChannels;
+
+    for ( int i = 0; i < numRings; i++ )
+    {
+        if ( recordPackets )
+        {
+            rings[i].Init( 0, JAM_RECORDER_MAX_PACKET_BYTES );
+        }
+        else
+        {
+            rings[i].Init( 2 * iServerFrameSizeSamples, 0 );
+        }
+    }
+
+    // the timer is not a child object and must be moved explicitly, it can only be
+    // started from within the thread
     thisThread = new QThread();
     moveToThread ( thisThread );
+    timerDrain.moveToThread ( thisThread );
     thisThread->start();
 
+    QMetaObject::invokeMethod( &timerDrain, "start", Qt::QueuedConnection, Q_ARG( int, JAM_RECORDER_DRAIN_INTERVAL_MS ) );
+
     return true;
 }
 
+/**
+ * @brief CJamRecorder::DroppedFrames Number of frames which were dropped because a ring was full
+ */
+uint32_t CJamRecorder::DroppedFrames()
+{
+    uint32_t droppedFrames = 0;
+
+    for ( int i = 0; i < numRings; i++ )
+    {
+        droppedFrames += rings[i].DroppedFrames();
+    }
+
+    return droppedFrames;
+}
+
+/**
+ * @brief CJamRecorder::DrainRings Process all entries waiting in the channel rings
+ *
+ * Ensures recording has started.  A new session starts with the oldest entry of all rings, so the
+ * position of a frame in the session follows from the server frame counter.
+ */
+void CJamRecorder::DrainRings()
+{
+    qint64 firstFrame = -1;
+
+    for ( int i = 0; i < numRings; i++ )
+    {
+        const CJamChannelRing::SEntry* entry = rings[i].Front();
+
+        if ( entry != nullptr && ( firstFrame < 0 || entry->frame < firstFrame ) )
+        {
+            firstFrame = entry->frame;
+        }
+    }
+
+    if ( firstFrame < 0 )
+    {
+        // nothing to do
+        return;
+    }
+
+    // Make sure we are ready
+    if ( !isRecording )
+    {
+        Start();
+    }
+
+    if ( currentSession->FirstFrame() < 0 )
+    {
+        currentSession->SetFirstFrame( firstFrame );
+    }
+
+    for ( int iChID = 0; iChID < numRings; iChID++ )
+    {
+        CJamChannelRing&         ring  = rings[iChID];
+        CJamChannelRing::SEntry* entry;
+
+        while ( ( entry = ring.Front() ) != nullptr )
+        {
+            switch ( entry->type )
+            {
+            case CJamChannelRing::ET_INFO:
+                ring.name    = entry->name;
+                ring.address = entry->address;
+
+                // release the string here rather than in the server tick
+                entry->name.clear();
+                break;
+
+            case CJamChannelRing::ET_DISCONNECT:
+                // the frame of the tick in which the client disconnected is "too late"
+                ring.disconnectFrame = entry->frame;
+
+                if ( currentSession->Clients()[iChID] != nullptr )
+                {
+                    currentSession->DisconnectClient( iChID );
+                }
+                break;
+
+            case CJamChannelRing::ET_FRAME:
+                if ( entry->frame > ring.disconnectFrame )
+                {
+                    currentSession->Frame( iChID, entry->frame, ring.name, ring.address, entry->numAudioChannels, entry->data, iServerFrameSizeSamples );
+                }
+                break;
+
+            case CJamChannelRing::ET_PACKET:
+                if ( entry->frame > ring.disconnectFrame )
+                {
+                    currentSession->Packet( iChID, entry->frame, ring.name, ring.address, entry->numAudioChannels, entry->comprType, entry->packet, entry->numPacketBytes, iServerFrameSizeSamples );
+                }
+                break;
+            }
+
+            ring.Pop();
+        }
+    }
+}
+
 /**
  * @brief CJamRecorder::Start Start up tasks for a new session
  */
 void CJamRecorder::Start() {
     // Ensure any previous cleaning up has been done.
-    OnEnd();
+    End();
 
-    currentSession = new CJamSession( recordBaseDir );
+    currentSession = new CJamSession( recordBaseDir, recordPackets, iServerFrameSizeSamples );
     isRecording = true;
 
     emit RecordingSessionStarted ( currentSession->SessionDir().path() );
@@ -373,17 +1031,30 @@ void CJamRecorder::Start() {
 
 
 /**
- * @brief CJamRecorder::OnEnd Finalise the recording and write the Reaper RPP file
+ * @brief CJamRecorder::OnEnd Record the waiting frames, then finalise the recording
  */
 void CJamRecorder::OnEnd()
+{
+    DrainRings();
+    End();
+}
+
+/**
+ * @brief CJamRecorder::End Finalise the recording and write the Reaper RPP file
+ */
+void CJamRecorder::End()
 {
     if ( isRecording )
     {
         isRecording = false;
         currentSession->End();
 
-        ReaperProjectFromCurrentSession();
-        AudacityLofFromCurrentSession();
+        // the packet files are decoded later, which also writes the project files
+        if ( !recordPackets )
+        {
+            ReaperProject( currentSession->SessionDir(), currentSession->Tracks(), iServerFrameSizeSamples );
+            AudacityLof( currentSession->SessionDir(), currentSession->Tracks(), iServerFrameSizeSamples );
+        }
 
         delete currentSession;
         currentSession = nullptr;
@@ -399,6 +1070,7 @@ void CJamRecorder::OnTriggerSession()
     // This should magically get everything right...
     if ( isRecording )
     {
+        DrainRings();
         Start();
     }
 }
@@ -410,17 +1082,18 @@ void CJamRecorder::OnAboutToQuit()
 {
     OnEnd();
 
+    timerDrain.stop();
     thisThread->exit();
 }
 
-void CJamRecorder::ReaperProjectFromCurrentSession()
+void CJamRecorder::ReaperProject(const QDir& sessionDir, const QMap<QString, QList<STrackItem>>& tracks, int serverFrameSizeSamples)
 {
-    QString reaperProjectFileName = currentSession->SessionDir().filePath(currentSession->Name().append(".rpp"));
+    QString reaperProjectFileName = sessionDir.filePath(sessionDir.dirName().append(".rpp"));
     const QFileInfo fi(reaperProjectFileName);
 
     if (fi.exists())
     {
-        qWarning() << "CJamRecorder::ReaperProjectFromCurrentSession():" << fi.absolutePath() << "exists and will not be overwritten.";
+        qWarning() << "CJamRecorder::ReaperProject():" << fi.absolutePath() << "exists and will not be overwritten.";
     }
     else
     {
@@ -428,24 +1101,24 @@ void CJamRecorder::ReaperProjectFromCurrentSession()
         if ( outf.open(QFile::WriteOnly) )
         {
             QTextStream out(&outf);
-            out << CReaperProject( currentSession->Tracks(), iServerFrameSizeSamples ).toString() << endl;
+            out << CReaperProject( tracks, serverFrameSizeSamples ).toString() << endl;
             qDebug() << "Session RPP:" << reaperProjectFileName;
         }
         else
         {
-            qWarning() << "CJamRecorder::ReaperProjectFromCurrentSession():" << fi.absolutePath() << "could not be created, no RPP written.";
+            qWarning() << "CJamRecorder::ReaperProject():" << fi.absolutePath() << "could not be created, no RPP written.";
         }
     }
 }
 
-void CJamRecorder::AudacityLofFromCurrentSession()
+void CJamRecorder::AudacityLof(const QDir& sessionDir, const QMap<QString, QList<STrackItem>>& tracks, int serverFrameSizeSamples)
 {
-    QString audacityLofFileName = currentSession->SessionDir().filePath(currentSession->Name().append(".lof"));
+    QString audacityLofFileName = sessionDir.filePath(sessionDir.dirName().append(".lof"));
     const QFileInfo fi(audacityLofFileName);
 
     if (fi.exists())
     {
-        qWarning() << "CJamRecorder::AudacityLofFromCurrentSession():" << fi.absolutePath() << "exists and will not be overwritten.";
+        qWarning() << "CJamRecorder::AudacityLof():" << fi.absolutePath() << "exists and will not be overwritten.";
     }
     else
     {
@@ -454,12 +1127,12 @@ void CJamRecorder::AudacityLofFromCurrentSession()
         {
             QTextStream sOut(&outf);
 
-            foreach ( auto trackName, currentSession->Tracks().keys() )
+            foreach ( auto trackName, tracks.keys() )
             {
-                foreach ( auto item, currentSession->Tracks()[trackName] ) {
+                foreach ( auto item, tracks[trackName] ) {
                     QFileInfo fi ( item.fileName );
                     sOut << "file " << '"' << fi.fileName() << '"';
-                    sOut << " offset " << secondsAt48K( item.startFrame, iServerFrameSizeSamples ) << endl;
+                    sOut << " offset " << secondsAt48K( item.startFrame, serverFrameSizeSamples ) << endl;
                 }
             }
 
@@ -468,7 +1141,7 @@ void CJamRecorder::AudacityLofFromCurrentSession()
         }
         else
         {
-            qWarning() << "CJamRecorder::AudacityLofFromCurrentSession():" << fi.absolutePath() << "could not be created, no LOF written.";
+            qWarning() << "CJamRecorder::AudacityLof():" << fi.absolutePath() << "could not be created, no LOF written.";
         }
     }
 }
@@ -479,6 +1152,9 @@ void CJamRecorder::AudacityLofFromCurrentSession()
  */
 void CJamRecorder::SessionDirToReaper(QString& strSessionDirName, int serverFrameSizeSamples)
 {
+    // the session index may know better
+    int frameSize = serverFrameSizeSamples;
+
     const QFileInfo fiSessionDir(QDir::cleanPath(strSessionDirName));
     if (!fiSessionDir.exists() || !fiSessionDir.isDir())
     {
@@ -499,46 +1175,174 @@ void CJamRecorder::SessionDirToReaper(QString& strSessionDirName, int serverFram
     }
     QTextStream out(&outf);
 
-    out << CReaperProject( CJamSession::TracksFromSessionDir( fiSessionDir.absoluteFilePath(), serverFrameSizeSamples ), serverFrameSizeSamples ).toString() << endl;
+    const QMap<QString, QList<STrackItem>> tracks = CJamSession::TracksFromSessionDir( fiSessionDir.absoluteFilePath(), frameSize );
+
+    out << CReaperProject( tracks, frameSize ).toString() << endl;
 
     qDebug() << "Session RPP:" << reaperProjectFileName;
 }
 
 /**
- * @brief CJamRecorder::OnDisconnected Handle disconnection of a client
- * @param iChID the client channel id
+ * @brief CJamRecorder::DecodePacketSession Decode the packet files of a session recorded in the packet mode
+ * @param strSessionDirName the session directory
+ *
+ * Each packet file is decoded to a wave file next to it.  Lost packets are concealed by the decoder
+ * and packets which the server could not pass to the recorder are replaced by silence.  Then the
+ * RPP and LOF files are written as at the end of a PCM recording.  As the decoding does not know
+ * about the server's clock drift compensation, a track may differ by a few samples from the mix.
  */
-void CJamRecorder::OnDisconnected(int iChID)
+void CJamRecorder::DecodePacketSession(const QString& strSessionDirName)
 {
-    if ( !isRecording )
+    const QFileInfo fiSessionDir(QDir::cleanPath(strSessionDirName));
+    if (!fiSessionDir.exists() || !fiSessionDir.isDir())
     {
-        qWarning() << "CJamRecorder::OnDisconnected: channel" << iChID << "disconnected but not recording";
+        throw std::runtime_error( (fiSessionDir.absoluteFilePath() + " does not exist or is not a directory.  Aborting.").toStdString() );
     }
-    if ( currentSession == nullptr )
+
+    const QDir sessionDir(fiSessionDir.absoluteFilePath());
+
+    QMap<QString, QList<STrackItem>> tracks;
+    int serverFrameSizeSamples = 0;
+
+    foreach(auto entry, sessionDir.entryList({ "*.pkt" }))
     {
-        qWarning() << "CJamRecorder::OnDisconnected: channel" << iChID << "disconnected but no currentSession";
-        return;
+        QFile inf(sessionDir.absoluteFilePath(entry));
+        if (!inf.open(QFile::ReadOnly))
+        {
+            throw std::runtime_error( (inf.fileName() + " could not be read.  Aborting.").toStdString() );
+        }
+
+        QDataStream in(&inf);
+        in.setByteOrder(QDataStream::LittleEndian);
+
+        char    id[4];
+        quint8  version, numChannels;
+        quint16 frameSize;
+
+        in.readRawData(id, 4);
+        in >> version >> numChannels >> frameSize;
+
+        if (memcmp(id, JAM_RECORDER_PACKET_FILE_ID, 4) != 0 || version != JAM_RECORDER_PACKET_FILE_VER
+            || (numChannels != 1 && numChannels != 2) || frameSize == 0)
+        {
+            qWarning() << "CJamRecorder::DecodePacketSession():" << inf.fileName() << "is not a packet file, skipped.";
+            continue;
+        }
+        serverFrameSizeSamples = frameSize;
+
+        // same name format as the wave files: name-hostport-frame-numChannels[_n]
+        auto split = entry.split(".")[0].split("-");
+        if (split.size() < 4)
+        {
+            qWarning() << "CJamRecorder::DecodePacketSession():" << inf.fileName() << "has an unexpected name, skipped.";
+            continue;
+        }
+        const QString trackName = split[0] + "-" + split[1];
+        const qint64  startFrame = split[2].toLongLong();
+
+        QFile outf(sessionDir.absoluteFilePath(entry.left(entry.length() - 4) + ".wav"));
+        if (!outf.open(QFile::ReadWrite | QFile::Truncate))
+        {
+            throw std::runtime_error( (outf.fileName() + " could not be written.  Aborting.").toStdString() );
+        }
+        CWaveStream out(&outf, numChannels);
+
+        // the OPUS modes of the server, CT_OPUS uses the double frame size
+        int opusError;
+        OpusCustomMode*    opusMode      = opus_custom_mode_create(SYSTEM_SAMPLE_RATE_HZ, DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES, &opusError);
+        OpusCustomMode*    opus64Mode    = opus_custom_mode_create(SYSTEM_SAMPLE_RATE_HZ, SYSTEM_FRAME_SIZE_SAMPLES, &opusError);
+        OpusCustomDecoder* opusDecoder   = opus_custom_decoder_create(opusMode, numChannels, &opusError);
+        OpusCustomDecoder* opus64Decoder = opus_custom_decoder_create(opus64Mode, numChannels, &opusError);
+
+        CVector<uint8_t> packet(JAM_RECORDER_MAX_PACKET_BYTES);
+        CVector<int16_t> pcm(DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES * numChannels);
+        qint64           numSamplesWritten = 0;
+
+        while (!in.atEnd())
+        {
+            quint32 frame;
+            quint8  comprType;
+            quint16 numBytes;
+
+            in >> frame >> comprType >> numBytes;
+
+            if (in.status() != QDataStream::Ok || numBytes > JAM_RECORDER_MAX_PACKET_BYTES
+                || in.readRawData(reinterpret_cast<char*>(&packet[0]), numBytes) != numBytes)
+            {
+                // e.g. the server stopped while writing the file
+                qWarning() << "CJamRecorder::DecodePacketSession():" << inf.fileName() << "is truncated.";
+                break;
+            }
+
+            OpusCustomDecoder* decoder;
+            int                decodedSamples;
+
+            if (comprType == CT_OPUS)
+            {
+                decoder        = opusDecoder;
+                decodedSamples = DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES;
+            }
+            else if (comprType == CT_OPUS64)
+            {
+                decoder        = opus64Decoder;
+                decodedSamples = SYSTEM_FRAME_SIZE_SAMPLES;
+            }
+            else
+            {
+                continue;
+            }
+
+            // fill the frames the recorder did not get with silence
+            while (numSamplesWritten < static_cast<qint64>(frame) * frameSize)
+            {
+                for (int j = 0; j < numChannels; j++)
+                {
+                    out << static_cast<int16_t>(0);
+                }
+                numSamplesWritten++;
+            }
+
+            opus_custom_decode(decoder,
+                               numBytes == 0 ? nullptr : &packet[0],
+                               numBytes,
+                               &pcm[0],
+                               decodedSamples);
+
+            for (int i = 0; i < decodedSamples * numChannels; i++)
+            {
+                out << pcm[i];
+            }
+            numSamplesWritten += decodedSamples;
+        }
+
+        out.finalise();
+
+        opus_custom_decoder_destroy(opusDecoder);
+        opus_custom_decoder_destroy(opus64Decoder);
+        opus_custom_mode_destroy(opusMode);
+        opus_custom_mode_destroy(opus64Mode);
+
+        if (!tracks.contains(trackName))
+        {
+            tracks.insert(trackName, { });
+        }
+
+        tracks[trackName].append(STrackItem(numChannels,
+                                            startFrame,
+                                            (numSamplesWritten + frameSize - 1) / frameSize,
+                                            outf.fileName()));
+
+        qDebug() << "Decoded:" << outf.fileName();
     }
-    currentSession->DisconnectClient(iChID);
-}
 
-/**
- * @brief CJamRecorder::OnFrame Handle a frame emited for a client by the server
- * @param iChID the client channel id
- * @param name the client name
- * @param address the client IP and port number
- * @param numAudioChannels the client number of audio channels
- * @param data the frame data
- *
- * Ensures recording has started.
- */
-void CJamRecorder::OnFrame(const int iChID, const QString name, const CHostAddress address, const int numAudioChannels, const CVector<int16_t> data)
-{
-    // Make sure we are ready
-    if ( !isRecording )
+    if (tracks.isEmpty())
     {
-        Start();
+        throw std::runtime_error( (fiSessionDir.absoluteFilePath() + " does not contain packet files.  Aborting.").toStdString() );
     }
 
-    currentSession->Frame( iChID, name, address, numAudioChannels, data, iServerFrameSizeSamples );
+    // from now on the session consists of the decoded wave files
+    CJamSession::WriteIndex(sessionDir, tracks, { }, serverFrameSizeSamples, false);
+
+    ReaperProject(sessionDir, tracks, serverFrameSizeSamples);
+    AudacityLof(sessionDir, tracks, serverFrameSizeSamples);
 }
@@ -27,6 +27,12 @@
 #include <QDir>
 #include <QFile>
 #include <QDateTime>
+#include <QTimer>
+#include <QtEndian>
+#include <QSaveFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
 
 #include "../util.h"
 #include "../channel.h"
@@ -34,8 +40,103 @@
 #include "creaperproject.h"
 #include "cwavestream.h"
 
+// number of entries of each channel ring (must be a power of two) and the interval in which the
+// recorder thread drains the rings
+#define JAM_RECORDER_RING_SIZE          256
+#define JAM_RECORDER_DRAIN_INTERVAL_MS  50
+
+// the samples of a client are collected and written to its file in blocks of this size, on Linux
+// the file space is reserved in steps of the preallocation size
+#define JAM_RECORDER_WRITE_BUFFER_SIZE  ( 256 * 1024 )
+#define JAM_RECORDER_PREALLOCATE_SIZE   ( 16 * 1024 * 1024 )
+
+// in the packet recording mode the received OPUS packets are stored instead of the decoded audio,
+// larger packets are dropped
+#define JAM_RECORDER_MAX_PACKET_BYTES   512
+#define JAM_RECORDER_PACKET_FILE_ID     "JPKT"
+#define JAM_RECORDER_PACKET_FILE_VER    1
+
+// each session directory has an index of its tracks, so the tools need not scan the track files
+#define JAM_RECORDER_INDEX_FILE_SUFFIX  ".index.json"
+#define JAM_RECORDER_INDEX_VERSION      1
+
 namespace recorder {
 
+/**
+ * @brief Single producer / single consumer ring of the frames of one server channel
+ *
+ * The entries are allocated once, so the server tick neither locks nor allocates when it puts a
+ * frame.  Besides the audio, the ring carries changes of the client details and the disconnection
+ * of the client, so that the recorder sees them in order with the frames.
+ */
+class CJamChannelRing
+{
+public:
+    enum EEntryType
+    {
+        ET_FRAME,
+        ET_PACKET,
+        ET_INFO,
+        ET_DISCONNECT
+    };
+
+    struct SEntry
+    {
+        EEntryType       type;
+        qint64           frame;
+        int              numAudioChannels;
+        QString          name;
+        CHostAddress     address;
+        CVector<int16_t> data;
+        EAudComprType    comprType;
+        CVector<uint8_t> packet;
+        int              numPacketBytes; // zero for a lost packet
+    };
+
+    CJamChannelRing() :
+        writeIdx (0),
+        readIdx (0),
+        droppedFrames (0),
+        infoPut (false),
+        disconnectFrame (-1)
+    {
+    }
+
+    void Init(const int maxNumSamples, const int maxNumPacketBytes);
+
+    // producer side (server tick)
+    void PutFrame(const qint64 frame, const QString& name, const CHostAddress& address, const int numAudioChannels, const CVector<int16_t>& data, const int numSamples);
+    void PutPacket(const qint64 frame, const QString& name, const CHostAddress& address, const int numAudioChannels, const EAudComprType comprType, const uint8_t* packet, const int numBytes);
+    void PutDisconnect(const qint64 frame);
+
+    uint32_t DroppedFrames() const { return droppedFrames.load(); }
+
+    // consumer side (recorder thread), Front returns nullptr if the ring is empty
+    SEntry* Front();
+    void    Pop() { readIdx.store(readIdx.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    // client details as seen by the consumer
+    QString      name;
+    CHostAddress address;
+    qint64       disconnectFrame;
+
+private:
+    bool    PutInfo(const qint64 frame, const QString& name, const CHostAddress& address);
+    SEntry* BeginPut();
+    void    EndPut() { writeIdx.store(writeIdx.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    QVector<SEntry> vecEntries;
+
+    std::atomic<uint32_t> writeIdx;
+    std::atomic<uint32_t> readIdx;
+    std::atomic<uint32_t> droppedFrames;
+
+    // client details last put into the ring, only used by the producer
+    bool         infoPut;
+    QString      putName;
+    CHostAddress putAddress;
+};
+
 class CJamClientConnection : public QObject
 {
     Q_OBJECT
@@ -69,9 +170,11 @@ class CJamClient : public QObject
     Q_OBJECT
 
 public:
-    CJamClient(const qint64 frame, const int numChannels, const QString name, const CHostAddress address, const QDir recordBaseDir);
+    CJamClient(const qint64 frame, const int numChannels, const QString name, const CHostAddress address, const QDir recordBaseDir, const bool _packets, const int iServerFrameSizeSamples);
 
-    void Frame(const QString name, const CVector<int16_t>& pcm, int iServerFrameSizeSamples);
+    void Frame(const QString name, const qint64 frame, const CVector<int16_t>& pcm, int iServerFrameSizeSamples);
+
+    void Packet(const QString name, const qint64 frame, const EAudComprType comprType, const CVector<uint8_t>& packet, const int numBytes);
 
     void Disconnect();
 
@@ -88,8 +191,13 @@ public:
     QString      FileName()         { return filename; }
 
 private:
+    char* Reserve(const int numBytes);
+    void  Append(const int16_t* pcm, const int numSamples);
+    void  Flush();
+
     const qint64       startFrame;
     const uint16_t     numChannels;
+    const bool         packets;
           QString      name;
     const CHostAddress address;
 
@@ -97,6 +205,11 @@ private:
           QFile*       wavFile;
           QDataStream* out;
           qint64       frameCount = 0;
+
+          QByteArray   writeBuffer;
+          qint64       allocatedSize = 0;
+          qint64       lastFlushPos = 0;
+          qint64       lastFlushSize = 0;
 };
 
 class CJamSession : public QObject
@@ -105,9 +218,11 @@ class CJamSession : public QObject
 
 public:
 
-    CJamSession(QDir recordBaseDir);
+    CJamSession(QDir recordBaseDir, const bool _packets, const int _frameSizeSamples);
+
+    void Frame(const int iChID, const qint64 serverFrame, const QString name, const CHostAddress address, const int numAudioChannels, const CVector<int16_t>& data, int iServerFrameSizeSamples);
 
-    void Frame(const int iChID, const QString name, const CHostAddress address, const int numAudioChannels, const CVector<int16_t> data, int iServerFrameSizeSamples);
+    void Packet(const int iChID, const qint64 serverFrame, const QString name, const CHostAddress address, const int numAudioChannels, const EAudComprType comprType, const CVector<uint8_t>& packet, const int numBytes, int iServerFrameSizeSamples);
 
     void End();
 
@@ -119,17 +234,29 @@ public:
 
     const QDir SessionDir() { return sessionDir; }
 
+    qint64 FirstFrame() { return firstFrame; }
+    void   SetFirstFrame(const qint64 frame) { firstFrame = frame; }
+
     void DisconnectClient(int iChID);
 
-    static QMap<QString, QList<STrackItem>> TracksFromSessionDir(const QString& name, int iServerFrameSizeSamples);
+    static QMap<QString, QList<STrackItem>> TracksFromSessionDir(const QString& name, int& iServerFrameSizeSamples);
+
+    static bool TracksFromIndex(const QDir& sessionDir, QMap<QString, QList<STrackItem>>& tracks, int& iServerFrameSizeSamples);
+
+    static void WriteIndex(const QDir& sessionDir, const QMap<QString, QList<STrackItem>>& tracks, const QMap<QString, QList<STrackItem>>& openTracks, int iServerFrameSizeSamples, bool packets);
 
 private:
     CJamSession();
 
+    CJamClient* ClientForFrame(const int iChID, const qint64 frame, const QString name, const CHostAddress address, const int numAudioChannels, int iServerFrameSizeSamples);
+
+    void UpdateIndex();
+
     const QDir sessionDir;
+    const bool packets;
+    const int  frameSizeSamples;
 
-    qint64 currentFrame;
-    int chIdDisconnected;
+    qint64 firstFrame;
     QVector<CJamClient*> vecptrJamClients;
     QList<CJamClientConnection*> jamClientConnections;
 };
@@ -139,8 +266,9 @@ class CJamRecorder : public QObject
     Q_OBJECT
 
 public:
-    CJamRecorder ( const QString recordingDirName ) :
+    CJamRecorder ( const QString recordingDirName, const bool _recordPackets ) :
         recordBaseDir ( recordingDirName ),
+        recordPackets ( _recordPackets ),
         isRecording   ( false )
     {
     }
@@ -149,7 +277,36 @@ public:
      * @brief Create recording directory, if necessary, and connect signal handlers
      * @param server Server object emiting signals
      */
-    bool Init( const CServer* server, const int _iServerFrameSizeSamples );
+    bool Init( const CServer* server, const int iMaxNumChannels, const int _iServerFrameSizeSamples );
+
+    /**
+     * @brief Put a frame of a client into the ring of its channel, called by the server tick
+     * @param iChID channel number of client
+     * @param frame server frame counter of the tick
+     */
+    void PutFrame( const int iChID, const qint64 frame, const QString& name, const CHostAddress& address, const int numAudioChannels, const CVector<int16_t>& data )
+    {
+        rings[iChID].PutFrame( frame, name, address, numAudioChannels, data, numAudioChannels * iServerFrameSizeSamples );
+    }
+
+    /**
+     * @brief Put the disconnection of a client into the ring of its channel, called by the server tick
+     */
+    void PutDisconnect( const int iChID, const qint64 frame ) { rings[iChID].PutDisconnect( frame ); }
+
+    /**
+     * @brief Put a received OPUS packet of a client into the ring of its channel, called by the server tick
+     * @param packet the coded data or nullptr for a lost packet
+     */
+    void PutPacket( const int iChID, const qint64 frame, const QString& name, const CHostAddress& address, const int numAudioChannels, const EAudComprType comprType, const uint8_t* packet, const int numBytes )
+    {
+        rings[iChID].PutPacket( frame, name, address, numAudioChannels, comprType, packet, numBytes );
+    }
+
+    /**
+     * @brief Number of frames which were dropped because a ring was full
+     */
+    uint32_t DroppedFrames();
 
     /**
      * @brief SessionDirToReaper Method that allows an RPP file to be recreated
@@ -158,17 +315,31 @@ public:
      */
     static void SessionDirToReaper( QString& strSessionDirName, int serverFrameSizeSamples );
 
+    /**
+     * @brief DecodePacketSession Decode the packet files of a session to wave files and write the RPP and LOF files
+     * @param strSessionDirName Where the session packet files are
+     */
+    static void DecodePacketSession( const QString& strSessionDirName );
+
 private:
     void Start();
-    void ReaperProjectFromCurrentSession();
-    void AudacityLofFromCurrentSession();
+    void End();
+    void DrainRings();
+
+    static void ReaperProject( const QDir& sessionDir, const QMap<QString, QList<STrackItem>>& tracks, int serverFrameSizeSamples );
+    static void AudacityLof( const QDir& sessionDir, const QMap<QString, QList<STrackItem>>& tracks, int serverFrameSizeSamples );
 
     QDir recordBaseDir;
+    bool recordPackets;
 
     bool         isRecording;
     CJamSession* currentSession;
     int          iServerFrameSizeSamples;
 
+    CJamChannelRing rings[MAX_NUM_CHANNELS];
+    int             numRings = 0;
+    QTimer          timerDrain;
+
     QThread* thisThread;
 
 signals:
@@ -191,18 +362,9 @@ private slots:
     void OnAboutToQuit();
 
     /**
-     * @brief Raised when an existing client leaves the server.
-     * @param iChID channel number of client
+     * @brief Raised periodically to process the frames waiting in the channel rings
      */
-    void OnDisconnected ( int iChID );
-
-    /**
-     * @brief Raised when a frame of data is available to process
-     */
-    void OnFrame ( const int iChID, const QString name, const CHostAddress address, const int numAudioChannels, const CVector<int16_t> data );
+    void OnTimerDrain() { DrainRings(); }
 };
 
 }
-
-Q_DECLARE_METATYPE(int16_t)
-Q_DECLARE_METATYPE(CVector<int16_t>)
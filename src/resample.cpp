@@ -0,0 +1,238 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#include "resample.h"
+
+
+/* Implementation *************************************************************/
+void CDriftResampler::Init ( const int iNewFrameSizeSamples )
+{
+    const double dPi          = 3.14159265358979323846;
+    const int    iHalfNumTaps = DRIFT_RESAMPLER_NUM_TAPS / 2;
+
+    iFrameSizeSamples = iNewFrameSizeSamples;
+
+    // calculate the polyphase filter table: windowed sinc with a Blackman
+    // window, we need one additional phase for the linear interpolation
+    // between the phases
+    vecfFilterTable.Init ( ( DRIFT_RESAMPLER_NUM_PHASES + 1 ) * DRIFT_RESAMPLER_NUM_TAPS );
+
+    for ( int iPhase = 0; iPhase <= DRIFT_RESAMPLER_NUM_PHASES; iPhase++ )
+    {
+        const double dFrac = static_cast<double> ( iPhase ) / DRIFT_RESAMPLER_NUM_PHASES;
+        double       dSum  = 0.0;
+
+        for ( int iTap = 0; iTap < DRIFT_RESAMPLER_NUM_TAPS; iTap++ )
+        {
+            // distance of the current tap to the interpolation point
+            const double dX = iTap - ( iHalfNumTaps - 1 ) - dFrac;
+            double       dSinc;
+
+            if ( fabs ( dX ) < 1e-9 )
+            {
+                dSinc = DRIFT_RESAMPLER_CUTOFF;
+            }
+            else
+            {
+                dSinc = sin ( dPi * DRIFT_RESAMPLER_CUTOFF * dX ) / ( dPi * dX );
+            }
+
+            const double dWin = 0.42 +
+                0.5  * cos ( 2 * dPi * dX / DRIFT_RESAMPLER_NUM_TAPS ) +
+                0.08 * cos ( 4 * dPi * dX / DRIFT_RESAMPLER_NUM_TAPS );
+
+            vecfFilterTable[iPhase * DRIFT_RESAMPLER_NUM_TAPS + iTap] = static_cast<float> ( dSinc * dWin );
+            dSum += dSinc * dWin;
+        }
+
+        // normalize each phase for unity gain at DC
+        for ( int iTap = 0; iTap < DRIFT_RESAMPLER_NUM_TAPS; iTap++ )
+        {
+            vecfFilterTable[iPhase * DRIFT_RESAMPLER_NUM_TAPS + iTap] /= static_cast<float> ( dSum );
+        }
+    }
+
+    // allocate worst case memory for the history buffers (we must not
+    // allocate memory in the time-critical thread)
+    for ( int iCh = 0; iCh < 2; iCh++ )
+    {
+        vecfHistory[iCh].Init ( DRIFT_RESAMPLER_MAX_NUM_FRAMES * iFrameSizeSamples +
+                                DRIFT_RESAMPLER_NUM_TAPS );
+    }
+
+    Reset();
+}
+
+void CDriftResampler::Reset()
+{
+    // pre-fill the history with zeros so that the very first output block can
+    // be calculated from exactly one input frame, the additional delay is
+    // therefore only the group delay of the interpolation filter
+    for ( int iCh = 0; iCh < 2; iCh++ )
+    {
+        vecfHistory[iCh].Reset ( 0 );
+    }
+
+    iHistorySize = DRIFT_RESAMPLER_NUM_TAPS - 1;
+    dReadPos     = 0.0;
+}
+
+bool CDriftResampler::NeedsInput ( const int    iNewNumChannels,
+                                   const double dRatio ) const
+{
+    // a change of the number of audio channels resets the history
+    if ( iNewNumChannels != iNumChannels )
+    {
+        return true;
+    }
+
+    // check if the last output sample of the next block can be interpolated
+    const int iLastPos = static_cast<int> ( dReadPos + ( iFrameSizeSamples - 1 ) * dRatio );
+
+    return iLastPos + DRIFT_RESAMPLER_NUM_TAPS > iHistorySize;
+}
+
+void CDriftResampler::Put ( const CVector<int16_t>& vecsInData,
+                            const int               iNewNumChannels )
+{
+    if ( iNewNumChannels != iNumChannels )
+    {
+        iNumChannels = iNewNumChannels;
+        Reset();
+    }
+
+    // this should never happen if NeedsInput() is used correctly but we
+    // must make sure not to write outside the allocated memory
+    if ( iHistorySize + iFrameSizeSamples > vecfHistory[0].Size() )
+    {
+        Reset();
+    }
+
+    // de-interleave the audio channels so that the filter loop runs on
+    // contiguous memory
+    for ( int iCh = 0; iCh < iNumChannels; iCh++ )
+    {
+        float* pfHist = &vecfHistory[iCh][iHistorySize];
+
+        for ( int i = 0; i < iFrameSizeSamples; i++ )
+        {
+            pfHist[i] = vecsInData[i * iNumChannels + iCh];
+        }
+    }
+
+    iHistorySize += iFrameSizeSamples;
+}
+
+void CDriftResampler::Get ( CVector<int16_t>& vecsOutData,
+                            const double      dRatio )
+{
+    const int iMaxIntPos = iHistorySize - DRIFT_RESAMPLER_NUM_TAPS;
+
+    // no output sample can be interpolated before the first frame was put
+    if ( iMaxIntPos < 0 )
+    {
+        std::fill ( vecsOutData.begin(),
+                    vecsOutData.begin() + iFrameSizeSamples * iNumChannels,
+                    static_cast<int16_t> ( 0 ) );
+        return;
+    }
+
+    float fCoeff[DRIFT_RESAMPLER_NUM_TAPS];
+
+    for ( int i = 0; i < iFrameSizeSamples; i++ )
+    {
+        const double dPos    = dReadPos + i * dRatio;
+        int          iIntPos = static_cast<int> ( dPos );
+
+        // split the fractional part in the table phase and the interpolation
+        // weight between two neighbour phases
+        const double dPhase   = ( dPos - iIntPos ) * DRIFT_RESAMPLER_NUM_PHASES;
+        const int    iPhase   = static_cast<int> ( dPhase );
+        const float  fPhaseW  = static_cast<float> ( dPhase - iPhase );
+        const float* pfCoeff0 = &vecfFilterTable[iPhase * DRIFT_RESAMPLER_NUM_TAPS];
+        const float* pfCoeff1 = pfCoeff0 + DRIFT_RESAMPLER_NUM_TAPS;
+
+        // guard against an input underrun (caller did not use NeedsInput())
+        if ( iIntPos > iMaxIntPos )
+        {
+            iIntPos = iMaxIntPos;
+        }
+
+        // the interpolated coefficients are the same for all audio channels
+        for ( int iTap = 0; iTap < DRIFT_RESAMPLER_NUM_TAPS; iTap++ )
+        {
+            fCoeff[iTap] = pfCoeff0[iTap] + fPhaseW * ( pfCoeff1[iTap] - pfCoeff0[iTap] );
+        }
+
+        for ( int iCh = 0; iCh < iNumChannels; iCh++ )
+        {
+            const float* pfIn = &vecfHistory[iCh][iIntPos];
+            float        fPartSum[DRIFT_RESAMPLER_NUM_PART_SUMS] = { 0.0f };
+
+            // inner product with independent partial sums, the inner loop
+            // maps to one packed multiply and add (a single sum would be a
+            // chain of scalar additions)
+            for ( int iTap = 0; iTap < DRIFT_RESAMPLER_NUM_TAPS; iTap += DRIFT_RESAMPLER_NUM_PART_SUMS )
+            {
+                for ( int k = 0; k < DRIFT_RESAMPLER_NUM_PART_SUMS; k++ )
+                {
+                    fPartSum[k] += pfIn[iTap + k] * fCoeff[iTap + k];
+                }
+            }
+
+            float fSum = 0.0f;
+
+            for ( int k = 0; k < DRIFT_RESAMPLER_NUM_PART_SUMS; k++ )
+            {
+                fSum += fPartSum[k];
+            }
+
+            vecsOutData[i * iNumChannels + iCh] = Double2Short ( fSum );
+        }
+    }
+
+    // advance the read position and remove the consumed samples from the
+    // history
+    dReadPos += iFrameSizeSamples * dRatio;
+
+    int iNumConsumed = static_cast<int> ( dReadPos );
+
+    if ( iNumConsumed > iHistorySize - ( DRIFT_RESAMPLER_NUM_TAPS - 1 ) )
+    {
+        iNumConsumed = iHistorySize - ( DRIFT_RESAMPLER_NUM_TAPS - 1 );
+    }
+
+    if ( iNumConsumed > 0 )
+    {
+        for ( int iCh = 0; iCh < iNumChannels; iCh++ )
+        {
+            std::copy ( vecfHistory[iCh].begin() + iNumConsumed,
+                        vecfHistory[iCh].begin() + iHistorySize,
+                        vecfHistory[iCh].begin() );
+        }
+
+        iHistorySize -= iNumConsumed;
+        dReadPos     -= iNumConsumed;
+    }
+}
@@ -0,0 +1,83 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#pragma once
+
+#include "util.h"
+#include "global.h"
+
+
+/* Definitions ****************************************************************/
+// number of filter taps of the interpolation filter (must be a multiple of
+// DRIFT_RESAMPLER_NUM_PART_SUMS)
+#define DRIFT_RESAMPLER_NUM_TAPS            16
+
+// number of independent partial sums of the inner product, the compiler may
+// not reorder a float sum, the partial sums are one SIMD register (SSE/NEON)
+#define DRIFT_RESAMPLER_NUM_PART_SUMS       4
+
+// number of phases of the polyphase filter table, intermediate phases are
+// linearly interpolated
+#define DRIFT_RESAMPLER_NUM_PHASES          64
+
+// cut-off frequency of the interpolation low pass normalized to the Nyquist
+// frequency (we only resample by a few hundred ppm so no real anti-aliasing
+// is required)
+#define DRIFT_RESAMPLER_CUTOFF              0.9
+
+// maximum number of frames which can be stored in the input history
+#define DRIFT_RESAMPLER_MAX_NUM_FRAMES      3
+
+
+/* Classes ********************************************************************/
+// Asynchronous resampler for clock drift compensation -------------------------
+// The resampler consumes slightly more or less input samples than it outputs
+// according to the given ratio (input samples per output sample). Decoded
+// frames are put in an internal history buffer and the caller must check
+// with NeedsInput() if a new frame is required before calling Get().
+class CDriftResampler
+{
+public:
+    CDriftResampler() : iFrameSizeSamples ( 0 ), iNumChannels ( 0 ) {}
+
+    void Init ( const int iNewFrameSizeSamples );
+    void Reset();
+
+    bool NeedsInput ( const int    iNewNumChannels,
+                      const double dRatio ) const;
+
+    void Put ( const CVector<int16_t>& vecsInData,
+               const int               iNewNumChannels );
+
+    void Get ( CVector<int16_t>& vecsOutData,
+               const double      dRatio );
+
+protected:
+    CVector<float> vecfFilterTable;
+    CVector<float> vecfHistory[2]; // one history buffer per audio channel
+    int            iFrameSizeSamples;
+    int            iNumChannels;
+    int            iHistorySize;
+    double         dReadPos;
+};
@@ -218,31 +218,76 @@ void CHighPrecisionTimer::run()
 #endif
 
 
+// CConnLessWorker implementation **********************************************
+void CConnLessWorker::Start ( CProtocol* pNConLProt )
+{
+    pConnLessProtocol = pNConLProt;
+
+    QObject::connect ( this, &CConnLessWorker::MessageReceived,
+        this, &CConnLessWorker::OnMessageReceived );
+
+    // the queued signal is processed in the worker thread
+    moveToThread ( &Thread );
+    Thread.start();
+}
+
+void CConnLessWorker::Stop()
+{
+    if ( Thread.isRunning() )
+    {
+        Thread.quit();
+        Thread.wait();
+    }
+}
+
+void CConnLessWorker::OnMessageReceived ( int              iRecID,
+                                          CVector<uint8_t> vecbyMesBodyData,
+                                          CHostAddress     RecHostAddr )
+{
+    pConnLessProtocol->ParseConnectionLessMessageBody ( vecbyMesBodyData,
+                                                        iRecID,
+                                                        RecHostAddr );
+}
+
+
 // CServer implementation ******************************************************
 CServer::CServer ( const int          iNewMaxNumChan,
                    const int          iMaxDaysHistory,
                    const QString&     strLoggingFileName,
                    const quint16      iPortNumber,
                    const QString&     strHTMLStatusFileName,
+                   const QString&     strJSONStatusFileName,
                    const QString&     strHistoryFileName,
                    const QString&     strServerNameForHTMLStatusFile,
                    const QString&     strCentralServer,
                    const QString&     strServerInfo,
                    const QString&     strNewWelcomeMessage,
                    const QString&     strRecordingDirName,
+                   const bool         bNRecordCodedPackets,
                    const bool         bNCentServPingServerInList,
                    const bool         bNDisconnectAllClientsOnQuit,
                    const bool         bNUseDoubleSystemFrameSize,
-                   const ELicenceType eNLicenceType ) :
+                   const ELicenceType eNLicenceType,
+                   const int          iNNumConnLessWorkers ) :
     vecWindowPosMain            (), // empty array
     bUseDoubleSystemFrameSize   ( bNUseDoubleSystemFrameSize ),
     iMaxNumChannels             ( iNewMaxNumChan ),
+    vecLastChanList             ( 0 ),
+    iChanListVersion            ( 0 ),
+    bUseDriftCompensation       ( false ),
+    iLastTickTimeNs             ( 0 ),
+    bUseAdaptiveComplexity      ( false ),
+    iComplexityCtrlNumTicks     ( 0 ),
+    iComplexityCtrlNumHighTicks ( 0 ),
+    dComplexityCtrlLoadSum      ( 0 ),
+    iNumConnLessWorkers         ( std::max ( 1, std::min ( iNNumConnLessWorkers, MAX_NUM_CONN_LESS_WORKERS ) ) ),
     Socket                      ( this, iPortNumber ),
     Logging                     ( iMaxDaysHistory ),
     iFrameCount                 ( 0 ),
-    JamRecorder                 ( strRecordingDirName ),
+    JamRecorder                 ( strRecordingDirName, bNRecordCodedPackets ),
     bEnableRecording            ( false ),
-    bWriteStatusHTMLFile        ( false ),
+    bRecordCodedPackets         ( bNRecordCodedPackets ),
+    iRecorderFrame              ( 0 ),
     HighPrecisionTimer          ( bNUseDoubleSystemFrameSize ),
     ServerListManager           ( iPortNumber,
                                   strCentralServer,
@@ -298,9 +343,12 @@ CServer::CServer ( const int          iNewMaxNumChan,
         opus_custom_encoder_ctl ( Opus64EncoderMono[i],   OPUS_SET_APPLICATION ( OPUS_APPLICATION_RESTRICTED_LOWDELAY ) );
         opus_custom_encoder_ctl ( Opus64EncoderStereo[i], OPUS_SET_APPLICATION ( OPUS_APPLICATION_RESTRICTED_LOWDELAY ) );
 
-        // set encoder low complexity for legacy 128 samples frame size
-        opus_custom_encoder_ctl ( OpusEncoderMono[i],   OPUS_SET_COMPLEXITY ( 1 ) );
-        opus_custom_encoder_ctl ( OpusEncoderStereo[i], OPUS_SET_COMPLEXITY ( 1 ) );
+        // set encoder low complexity for legacy 128 samples frame size, the
+        // bit rate and complexity are only changed by the ctl caches from now
+        OpusEncoderMonoCtl[i].Init     ( OpusEncoderMono[i],     OPUS_ENCODER_COMPLEXITY );
+        OpusEncoderStereoCtl[i].Init   ( OpusEncoderStereo[i],   OPUS_ENCODER_COMPLEXITY );
+        Opus64EncoderMonoCtl[i].Init   ( Opus64EncoderMono[i],   OPUS64_ENCODER_COMPLEXITY );
+        Opus64EncoderStereoCtl[i].Init ( Opus64EncoderStereo[i], OPUS64_ENCODER_COMPLEXITY );
 
 
         // init double-to-normal frame size conversion buffers -----------------
@@ -347,6 +395,9 @@ CServer::CServer ( const int          iNewMaxNumChan,
     vecNumFrameSizeConvBlocks.Init     ( iMaxNumChannels );
     vecUseDoubleSysFraSizeConvBuf.Init ( iMaxNumChannels );
     vecAudioComprType.Init             ( iMaxNumChannels );
+    vecdStreamGains.Init               ( iMaxNumChannels );
+    vecdStreamPannings.Init            ( iMaxNumChannels );
+    vecsStreamData.Init                ( 2 /* stereo */ * DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES /* worst case buffer size */ );
 
     for ( i = 0; i < iMaxNumChannels; i++ )
     {
@@ -356,13 +407,46 @@ CServer::CServer ( const int          iNewMaxNumChan,
 
         // we always use stereo audio buffers (see "vecsSendData")
         vecvecsData[i].Init ( 2 /* stereo */ * DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES /* worst case buffer size */ );
+
+        // the drift compensation resampler always works on the server frame size
+        DriftResampler[i].Init ( iServerFrameSizeSamples );
+
+        dArrivalPhaseRe[i] = 0.0;
+        dArrivalPhaseIm[i] = 0.0;
+        iArrivalLeadUs[i].store ( 0 );
+        iArrivalJitterUs[i].store ( 0 );
     }
 
+    // time base for the arrival phase measurement and the tick timing
+    TickPhaseTimer.start();
+
+    // per client processing times of the current tick
+    vecMixTimeNs.Init    ( iMaxNumChannels, 0 );
+    vecEncodeTimeNs.Init ( iMaxNumChannels, 0 );
+    vecSendTimeNs.Init   ( iMaxNumChannels, 0 );
+
+    // adaptive encoder complexity
+    veciComplexityCtrlEncodeTimeNs.Init ( iMaxNumChannels, 0 );
+    veciComplexityReduction.Init        ( iMaxNumChannels, 0 );
+    vecComplexityResetPending.Init      ( iMaxNumChannels, 0 );
+
+    iNumTickOverruns.store ( 0 );
+    iPrevTickStartNs = INVALID_INDEX;
+
+    // temporary buffer for decoded audio if the drift compensation is used
+    vecsDecodedData.Init ( 2 /* stereo */ * DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES /* worst case buffer size */ );
+
     // allocate worst case memory for the coded data
     vecbyCodedData.Init ( MAX_SIZE_BYTES_NETW_BUF );
 
     // allocate worst case memory for the channel levels
-    vecChannelLevels.Init     ( iMaxNumChannels );
+    vecChannelLevels.Init      ( iMaxNumChannels );
+    vecChannelLevelsDelta.Init ( iMaxNumChannels );
+    vecPrevChannelLevels.Init  ( iMaxNumChannels, 0 );
+    veciPrevLevelChanIDs.Init  ( iMaxNumChannels, INVALID_CHANNEL_ID );
+    iPrevNumLevelClients    = 0;
+    iLevelListFullCnt       = 0;
+    bLevelListDeltaMesValid = false;
 
     // enable history graph (if requested)
     if ( !strHistoryFileName.isEmpty() )
@@ -384,8 +468,8 @@ CServer::CServer ( const int          iNewMaxNumChan,
         Logging.Start ( strLoggingFileName );
     }
 
-    // HTML status file writing
-    if ( !strHTMLStatusFileName.isEmpty() )
+    // status file writing (HTML and/or JSON)
+    if ( !strHTMLStatusFileName.isEmpty() || !strJSONStatusFileName.isEmpty() )
     {
         QString strCurServerNameForHTMLStatusFile = strServerNameForHTMLStatusFile;
 
@@ -397,9 +481,17 @@ CServer::CServer ( const int          iNewMaxNumChan,
 
         // (the static cast to integer of the port number is required so that it
         // works correctly under Linux)
-        StartStatusHTMLFileWriting ( strHTMLStatusFileName,
-            strCurServerNameForHTMLStatusFile + ":" +
-            QString().number( static_cast<int> ( iPortNumber ) ) );
+        StatusFileWriter.Init ( strHTMLStatusFileName,
+                                strJSONStatusFileName,
+                                strCurServerNameForHTMLStatusFile + ":" +
+                                QString().number( static_cast<int> ( iPortNumber ) ) );
+
+        // the files are written in the thread of the status file writer
+        QObject::connect ( this, &CServer::StatusChanged,
+            &StatusFileWriter, &CStatusFileWriter::OnStatusChanged );
+
+        // write the initial (empty) client list
+        emit StatusChanged ( CreateChannelList() );
     }
 
     // manage welcome message: if the welcome message is a valid link to a local
@@ -422,7 +514,7 @@ CServer::CServer ( const int          iNewMaxNumChan,
     // enable jam recording (if requested) - kicks off the thread
     if ( !strRecordingDirName.isEmpty() )
     {
-        bRecorderInitialised = JamRecorder.Init ( this, iServerFrameSizeSamples );
+        bRecorderInitialised = JamRecorder.Init ( this, iMaxNumChannels, iServerFrameSizeSamples );
         SetEnableRecording ( bRecorderInitialised );
     }
 
@@ -439,38 +531,46 @@ CServer::CServer ( const int          iNewMaxNumChan,
     QObject::connect ( &HighPrecisionTimer, &CHighPrecisionTimer::timeout,
         this, &CServer::OnTimer );
 
+    // the registration result is passed to the main thread
+    qRegisterMetaType<ESvrRegResult> ( "ESvrRegResult" );
+
+    // The connection less messages are parsed in the socket thread (pings) and
+    // in the worker threads, the handlers which only send an answer or which
+    // use the locked server list are called directly in these threads. The
+    // handlers which change the channels or use timers of the server list
+    // still run in the main thread.
     QObject::connect ( &ConnLessProtocol, &CProtocol::CLMessReadyForSending,
-        this, &CServer::OnSendCLProtMessage );
+        this, &CServer::OnSendCLProtMessage, Qt::DirectConnection );
 
     QObject::connect ( &ConnLessProtocol, &CProtocol::CLPingReceived,
-        this, &CServer::OnCLPingReceived );
+        this, &CServer::OnCLPingReceived, Qt::DirectConnection );
 
     QObject::connect ( &ConnLessProtocol, &CProtocol::CLPingWithNumClientsReceived,
-        this, &CServer::OnCLPingWithNumClientsReceived );
+        this, &CServer::OnCLPingWithNumClientsReceived, Qt::DirectConnection );
 
     QObject::connect ( &ConnLessProtocol, &CProtocol::CLRegisterServerReceived,
-        this, &CServer::OnCLRegisterServerReceived );
+        this, &CServer::OnCLRegisterServerReceived, Qt::DirectConnection );
 
     QObject::connect ( &ConnLessProtocol, &CProtocol::CLUnregisterServerReceived,
-        this, &CServer::OnCLUnregisterServerReceived );
+        this, &CServer::OnCLUnregisterServerReceived, Qt::DirectConnection );
 
     QObject::connect ( &ConnLessProtocol, &CProtocol::CLReqServerList,
-        this, &CServer::OnCLReqServerList );
+        this, &CServer::OnCLReqServerList, Qt::DirectConnection );
 
     QObject::connect ( &ConnLessProtocol, &CProtocol::CLRegisterServerResp,
-        this, &CServer::OnCLRegisterServerResp );
+        this, &CServer::OnCLRegisterServerResp, Qt::QueuedConnection );
 
     QObject::connect ( &ConnLessProtocol, &CProtocol::CLSendEmptyMes,
-        this, &CServer::OnCLSendEmptyMes );
+        this, &CServer::OnCLSendEmptyMes, Qt::DirectConnection );
 
     QObject::connect ( &ConnLessProtocol, &CProtocol::CLDisconnection,
-        this, &CServer::OnCLDisconnection );
+        this, &CServer::OnCLDisconnection, Qt::QueuedConnection );
 
     QObject::connect ( &ConnLessProtocol, &CProtocol::CLReqVersionAndOS,
-        this, &CServer::OnCLReqVersionAndOS );
+        this, &CServer::OnCLReqVersionAndOS, Qt::DirectConnection );
 
     QObject::connect ( &ConnLessProtocol, &CProtocol::CLReqConnClientsList,
-        this, &CServer::OnCLReqConnClientsList );
+        this, &CServer::OnCLReqConnClientsList, Qt::QueuedConnection );
 
     QObject::connect ( &ServerListManager, &CServerListManager::SvrRegStatusChanged,
         this, &CServer::SvrRegStatusChanged );
@@ -486,11 +586,26 @@ CServer::CServer ( const int          iNewMaxNumChan,
 
     connectChannelSignalsToServerSlots<MAX_NUM_CHANNELS>();
 
+    // start the connection less message workers before the first message
+    // can be received
+    for ( i = 0; i < iNumConnLessWorkers; i++ )
+    {
+        ConnLessWorkers[i].Start ( &ConnLessProtocol );
+    }
+
     // start the socket (it is important to start the socket after all
     // initializations and connections)
     Socket.Start();
 }
 
+CServer::~CServer()
+{
+    // the workers must not process messages while the members which the
+    // message handlers use are destroyed (the server may be destroyed without
+    // the "about to quit" signal, e.g. in the benchmark)
+    StopConnLessWorkers();
+}
+
 template<unsigned int slotId>
 inline void CServer::connectChannelSignalsToServerSlots()
 {
@@ -511,6 +626,9 @@ inline void CServer::connectChannelSignalsToServerSlots()
     void ( CServer::* pOnServerAutoSockBufSizeChangeCh )( int ) =
         &CServerSlots<slotId>::OnServerAutoSockBufSizeChangeCh;
 
+    void ( CServer::* pOnProtRecGapTimeoutCh )() =
+        &CServerSlots<slotId>::OnProtRecGapTimeoutCh;
+
     // send message
     QObject::connect ( &vecChannels[iCurChanID], &CChannel::MessReadyForSending,
                        this, pOnSendProtMessCh );
@@ -535,6 +653,10 @@ inline void CServer::connectChannelSignalsToServerSlots()
     QObject::connect ( &vecChannels[iCurChanID], &CChannel::ServerAutoSockBufSizeChange,
                        this, pOnServerAutoSockBufSizeChangeCh );
 
+    // gap in the received protocol messages timed out
+    QObject::connect ( &vecChannels[iCurChanID], &CChannel::ProtRecGapTimeout,
+                       this, pOnProtRecGapTimeoutCh );
+
     connectChannelSignalsToServerSlots<slotId - 1>();
 }
 
@@ -547,6 +669,15 @@ void CServer::CreateAndSendJitBufMessage ( const int iCurChanID,
     vecChannels[iCurChanID].CreateJitBufMes ( iNNumFra );
 }
 
+void CServer::FlushStoredProtMessages ( const int iCurChanID )
+{
+    // the stored messages are processed under the same lock as the received
+    // protocol messages (see OnProtcolMessageReceived)
+    QMutexLocker locker ( &Mutex );
+
+    vecChannels[iCurChanID].FlushStoredProtMessages();
+}
+
 void CServer::SendProtMessage ( int iChID, CVector<uint8_t> vecMessage )
 {
     // the protocol queries me to call the function to send the message
@@ -554,6 +685,13 @@ void CServer::SendProtMessage ( int iChID, CVector<uint8_t> vecMessage )
     Socket.SendPacket ( vecMessage, vecChannels[iChID].GetAddress() );
 }
 
+void CServer::SendAudioPacket ( const int               iChID,
+                                const CVector<uint8_t>& vecbyData,
+                                const int               iNumBytes )
+{
+    vecChannels[iChID].PrepAndSendPacket ( &Socket, vecbyData, iNumBytes );
+}
+
 void CServer::OnNewConnection ( int          iChID,
                                 CHostAddress RecHostAddr )
 {
@@ -561,6 +699,12 @@ void CServer::OnNewConnection ( int          iChID,
     // must be the first message to be sent for a new connection)
     vecChannels[iChID].CreateClientIDMes ( iChID );
 
+    // tell the client how many protocol messages we can receive out of order,
+    // a client which supports it answers with its own window size and the
+    // following messages are then sent without waiting for each single
+    // acknowledgement (old clients ignore this message)
+    vecChannels[iChID].CreateMessWindowSizeMes();
+
     // on a new connection we query the network transport properties for the
     // audio packets (to use the correct network block size and audio
     // compression properties, etc.)
@@ -617,6 +761,9 @@ void CServer::OnNewConnection ( int          iChID,
     DoubleFrameSizeConvBufIn[iChID].Reset();
     DoubleFrameSizeConvBufOut[iChID].Reset();
 
+    // reset the drift compensation resampler
+    DriftResampler[iChID].Reset();
+
     // logging of new connected channel
     Logging.AddNewConnection ( RecHostAddr.InetAddr );
 }
@@ -639,10 +786,23 @@ void CServer::OnProtcolCLMessageReceived ( int              iRecID,
                                            CVector<uint8_t> vecbyMesBodyData,
                                            CHostAddress     RecHostAddr )
 {
-    // connection less messages are always processed
-    ConnLessProtocol.ParseConnectionLessMessageBody ( vecbyMesBodyData,
-                                                      iRecID,
-                                                      RecHostAddr );
+    // note that this function is called in the socket thread
+
+    // pings are answered right away so that the measured ping time does not
+    // depend on the load of the workers
+    if ( ( iRecID == PROTMESSID_CLM_PING_MS ) ||
+         ( iRecID == PROTMESSID_CLM_PING_MS_WITHNUMCLIENTS ) )
+    {
+        ConnLessProtocol.ParseConnectionLessMessageBody ( vecbyMesBodyData,
+                                                          iRecID,
+                                                          RecHostAddr );
+        return;
+    }
+
+    // all other connection less messages are processed by the workers
+    ConnLessWorkers[qHash ( RecHostAddr ) % static_cast<uint> ( iNumConnLessWorkers )].PutMessage ( iRecID,
+                                                                               vecbyMesBodyData,
+                                                                               RecHostAddr );
 }
 
 void CServer::OnCLDisconnection ( CHostAddress InetAddr )
@@ -677,6 +837,9 @@ void CServer::OnAboutToQuit()
 
     Stop();
 
+    // no more connection less messages are processed from here on
+    StopConnLessWorkers();
+
     // if server was registered at the central server, unregister on shutdown
     if ( GetServerListEnabled() )
     {
@@ -706,6 +869,11 @@ void CServer::OnHandledSignal ( int sigNum )
         SetEnableRecording ( !bEnableRecording );
         break;
 
+    case SIGQUIT:
+        // print the tick timing statistics on the console
+        *( ( new ConsoleWriterFactory() )->get() ) << GetTickTimingReport() << flush;
+        break;
+
     case SIGINT:
     case SIGTERM:
         // This should trigger OnAboutToQuit
@@ -729,6 +897,17 @@ void CServer::RequestNewRecording()
     CreateAndSendRecorderStateForAllConChannels();
 }
 
+void CServer::SetUseDriftCompensation ( const bool bNUDC )
+{
+    // must be called before the first mix tick which reads the jitter buffers
+    bUseDriftCompensation = bNUDC;
+
+    for ( int i = 0; i < iMaxNumChannels; i++ )
+    {
+        vecChannels[i].SetUseDriftEstimation ( bNUDC );
+    }
+}
+
 void CServer::SetEnableRecording ( bool bNewEnableRecording )
 {
     if ( bRecorderInitialised )
@@ -758,11 +937,28 @@ void CServer::SetEnableRecording ( bool bNewEnableRecording )
     CreateAndSendRecorderStateForAllConChannels();
 }
 
+bool CServer::EnablePacketCapture ( const QString& strFileName,
+                                   const int      iSizeMB )
+{
+    if ( !PacketCapture.Init ( strFileName, iSizeMB ) )
+    {
+        return false;
+    }
+
+    // from now on the socket thread passes all datagrams to the capture
+    Socket.SetPacketCapture ( &PacketCapture );
+
+    return true;
+}
+
 void CServer::Start()
 {
     // only start if not already running
     if ( !IsRunning() )
     {
+        // the first tick after a pause has no valid tick interval
+        iPrevTickStartNs = INVALID_INDEX;
+
         // start timer
         HighPrecisionTimer.Start();
 
@@ -803,10 +999,22 @@ static CTimingMeas JitterMeas ( 1000, "test2.dat" ); JitterMeas.Measure(); // TE
     bool bUpdateChannelLevels      = false;
     bool bSendChannelLevels        = false;
 
+    // processing times of the tick phases
+    const qint64 iTickStartNs  = TickPhaseTimer.nsecsElapsed();
+    qint64       iDecodeTimeNs = 0;
+    qint64       iLevelsTimeNs = 0;
+
+    // the frames of this tick are passed to the recorder with a new frame count
+    iRecorderFrame++;
+
     // Make put and get calls thread safe. Do not forget to unlock mutex
     // afterwards!
     Mutex.lock();
     {
+        // store the time of the current mix tick for the arrival phase
+        // measurement of the audio packets
+        iLastTickTimeNs = TickPhaseTimer.nsecsElapsed();
+
         // first, get number and IDs of connected channels
         for ( int i = 0; i < iMaxNumChannels; i++ )
         {
@@ -826,11 +1034,19 @@ static CTimingMeas JitterMeas ( 1000, "test2.dat" ); JitterMeas.Measure(); // TE
         {
             int                iClientFrameSizeSamples = 0; // initialize to avoid a compiler warning
             OpusCustomDecoder* CurOpusDecoder;
-            unsigned char*     pCurCodedData;
 
             // get actual ID of current channel
             const int iCurChanID = vecChanIDsCurConChan[i];
 
+            // a new client of this channel starts with the full encoder
+            // complexity and without the encoding time of the previous client
+            if ( vecComplexityResetPending[iCurChanID] != 0 )
+            {
+                veciComplexityReduction[iCurChanID]        = 0;
+                veciComplexityCtrlEncodeTimeNs[iCurChanID] = 0;
+                vecComplexityResetPending[iCurChanID]      = 0;
+            }
+
             // get and store number of audio channels and compression type
             vecNumAudioChannels[i] = vecChannels[iCurChanID].GetNumAudioChannels();
             vecAudioComprType[i]   = vecChannels[iCurChanID].GetAudioCompressionType();
@@ -908,65 +1124,41 @@ static CTimingMeas JitterMeas ( 1000, "test2.dat" ); JitterMeas.Measure(); // TE
                 bUpdateChannelLevels = true;
             }
 
-            // If the server frame size is smaller than the received OPUS frame size, we need a conversion
-            // buffer which stores the large buffer.
-            // Note that we have a shortcut here. If the conversion buffer is not needed, the boolean flag
-            // is false and the Get() function is not called at all. Therefore if the buffer is not needed
-            // we do not spend any time in the function but go directly inside the if condition.
-            if ( ( vecUseDoubleSysFraSizeConvBuf[i] == 0 ) ||
-                 !DoubleFrameSizeConvBufIn[iCurChanID].Get ( vecvecsData[i], SYSTEM_FRAME_SIZE_SAMPLES * vecNumAudioChannels[i] ) )
+            const qint64 iDecodeStartNs = TickPhaseTimer.nsecsElapsed();
+
+            if ( bUseDriftCompensation )
             {
-                // get current number of OPUS coded bytes
-                const int iCeltNumCodedBytes = vecChannels[iCurChanID].GetNetwFrameSize();
+                // the ratio of input samples per output sample is derived
+                // from the clock drift estimation of the jitter buffer, note
+                // that depending on the drift, sometimes no frame or two frames
+                // are decoded in one timer period
+                const double dRatio = 1.0 + vecChannels[iCurChanID].GetDriftCorrection();
 
-                for ( int iB = 0; iB < vecNumFrameSizeConvBlocks[i]; iB++ )
+                while ( DriftResampler[iCurChanID].NeedsInput ( vecNumAudioChannels[i], dRatio ) )
                 {
-                    // get data
-                    const EGetDataStat eGetStat = vecChannels[iCurChanID].GetData ( vecbyCodedData, iCeltNumCodedBytes );
-
-                    // if channel was just disconnected, set flag that connected
-                    // client list is sent to all other clients
-                    // and emit the client disconnected signal
-                    if ( eGetStat == GS_CHAN_NOW_DISCONNECTED )
-                    {
-                        if ( bEnableRecording )
-                        {
-                            emit ClientDisconnected ( iCurChanID ); // TODO do this outside the mutex lock?
-                        }
-
-                        bChannelIsNowDisconnected = true;
-                    }
-
-                    // get pointer to coded data
-                    if ( eGetStat == GS_BUFFER_OK )
-                    {
-                        pCurCodedData = &vecbyCodedData[0];
-                    }
-                    else
-                    {
-                        // for lost packets use null pointer as coded input data
-                        pCurCodedData = nullptr;
-                    }
-
-                    // OPUS decode received data stream
-                    if ( CurOpusDecoder != nullptr )
-                    {
-                        iUnused = opus_custom_decode ( CurOpusDecoder,
-                                                       pCurCodedData,
-                                                       iCeltNumCodedBytes,
-                                                       &vecvecsData[i][iB * SYSTEM_FRAME_SIZE_SAMPLES * vecNumAudioChannels[i]],
-                                                       iClientFrameSizeSamples );
-                    }
+                    DecodeReceiveData ( i,
+                                        iCurChanID,
+                                        CurOpusDecoder,
+                                        iClientFrameSizeSamples,
+                                        vecsDecodedData,
+                                        bChannelIsNowDisconnected );
+
+                    DriftResampler[iCurChanID].Put ( vecsDecodedData, vecNumAudioChannels[i] );
                 }
 
-                // a new large frame is ready, if the conversion buffer is required, put it in the buffer
-                // and read out the small frame size immediately for further processing
-                if ( vecUseDoubleSysFraSizeConvBuf[i] != 0 )
-                {
-                    DoubleFrameSizeConvBufIn[iCurChanID].PutAll ( vecvecsData[i] );
-                    DoubleFrameSizeConvBufIn[iCurChanID].Get ( vecvecsData[i], SYSTEM_FRAME_SIZE_SAMPLES * vecNumAudioChannels[i] );
-                }
+                DriftResampler[iCurChanID].Get ( vecvecsData[i], dRatio );
             }
+            else
+            {
+                DecodeReceiveData ( i,
+                                    iCurChanID,
+                                    CurOpusDecoder,
+                                    iClientFrameSizeSamples,
+                                    vecvecsData[i],
+                                    bChannelIsNowDisconnected );
+            }
+
+            iDecodeTimeNs += TickPhaseTimer.nsecsElapsed() - iDecodeStartNs;
         }
 
         // a channel is now disconnected, take action on it
@@ -987,10 +1179,48 @@ static CTimingMeas JitterMeas ( 1000, "test2.dat" ); JitterMeas.Measure(); // TE
         // calculate levels for all connected clients
         if ( bUpdateChannelLevels )
         {
+            const qint64 iLevelsStartNs = TickPhaseTimer.nsecsElapsed();
+
             bSendChannelLevels = CreateLevelsForAllConChannels ( iNumClients,
                                                                  vecNumAudioChannels,
                                                                  vecvecsData,
                                                                  vecChannelLevels );
+
+            // the messages are the same for all clients
+            if ( bSendChannelLevels )
+            {
+                CreateChannelLevelListMes ( iNumClients );
+            }
+
+            iLevelsTimeNs = TickPhaseTimer.nsecsElapsed() - iLevelsStartNs;
+        }
+
+        // the program mix for the live stream is a stereo mix of all clients
+        // which is passed to the stream thread without waiting for it
+        if ( MixStream.IsEnabled() )
+        {
+            for ( int j = 0; j < iNumClients; j++ )
+            {
+                CChannel& Channel = vecChannels[vecChanIDsCurConChan[j]];
+
+                MixStream.GetGainAndPan ( vecChanIDsCurConChan[j],
+                                          Channel.GetName(),
+                                          vecdStreamGains[j],
+                                          vecdStreamPannings[j] );
+
+                // consider audio fade-in
+                vecdStreamGains[j] *= Channel.GetFadeInGain();
+            }
+
+            ProcessData ( vecvecsData,
+                          vecdStreamGains,
+                          vecdStreamPannings,
+                          vecNumAudioChannels,
+                          vecsStreamData,
+                          2 /* stereo */,
+                          iNumClients );
+
+            MixStream.PutFrame ( vecsStreamData );
         }
 
 #ifdef USE_OMP
@@ -998,8 +1228,9 @@ static CTimingMeas JitterMeas ( 1000, "test2.dat" ); JitterMeas.Measure(); // TE
 #endif
         for ( int i = 0; i < iNumClients; i++ )
         {
-            int                iClientFrameSizeSamples = 0; // initialize to avoid a compiler warning
-            OpusCustomEncoder* CurOpusEncoder;
+            int                   iClientFrameSizeSamples = 0; // initialize to avoid a compiler warning
+            OpusCustomEncoder*    CurOpusEncoder;
+            COpusEncoderCtlCache* pCurOpusEncoderCtl = nullptr;
 
             // get actual ID of current channel
             const int iCurChanID = vecChanIDsCurConChan[i];
@@ -1007,16 +1238,24 @@ static CTimingMeas JitterMeas ( 1000, "test2.dat" ); JitterMeas.Measure(); // TE
             // get number of audio channels of current channel
             const int iCurNumAudChan = vecNumAudioChannels[i];
 
-            // export the audio data for recording purpose
-            if ( bEnableRecording )
+            // export the audio data for recording purpose (each channel ring
+            // is only written by the thread which processes this client)
+            if ( bEnableRecording && !bRecordCodedPackets )
             {
-                emit AudioFrame ( iCurChanID,
-                                  vecChannels[iCurChanID].GetName(),
-                                  vecChannels[iCurChanID].GetAddress(),
-                                  iCurNumAudChan,
-                                  vecvecsData[i] );
+                JamRecorder.PutFrame ( iCurChanID,
+                                       iRecorderFrame,
+                                       vecChannels[iCurChanID].GetName(),
+                                       vecChannels[iCurChanID].GetAddress(),
+                                       iCurNumAudChan,
+                                       vecvecsData[i] );
             }
 
+            // the processing times are stored per client since the loop may
+            // run in parallel threads
+            qint64 iPhaseStartNs = TickPhaseTimer.nsecsElapsed();
+            vecEncodeTimeNs[i]   = 0;
+            vecSendTimeNs[i]     = 0;
+
             // generate a sparate mix for each channel
             // actual processing of audio data -> mix
             ProcessData ( vecvecsData,
@@ -1027,6 +1266,8 @@ static CTimingMeas JitterMeas ( 1000, "test2.dat" ); JitterMeas.Measure(); // TE
                           iCurNumAudChan,
                           iNumClients );
 
+            vecMixTimeNs[i] = TickPhaseTimer.nsecsElapsed() - iPhaseStartNs;
+
             // get current number of CELT coded bytes
             const int iCeltNumCodedBytes = vecChannels[iCurChanID].GetNetwFrameSize();
 
@@ -1037,11 +1278,13 @@ static CTimingMeas JitterMeas ( 1000, "test2.dat" ); JitterMeas.Measure(); // TE
 
                 if ( vecNumAudioChannels[i] == 1 )
                 {
-                    CurOpusEncoder = OpusEncoderMono[iCurChanID];
+                    CurOpusEncoder     = OpusEncoderMono[iCurChanID];
+                    pCurOpusEncoderCtl = &OpusEncoderMonoCtl[iCurChanID];
                 }
                 else
                 {
-                    CurOpusEncoder = OpusEncoderStereo[iCurChanID];
+                    CurOpusEncoder     = OpusEncoderStereo[iCurChanID];
+                    pCurOpusEncoderCtl = &OpusEncoderStereoCtl[iCurChanID];
                 }
             }
             else if ( vecAudioComprType[i] == CT_OPUS64 )
@@ -1050,11 +1293,13 @@ static CTimingMeas JitterMeas ( 1000, "test2.dat" ); JitterMeas.Measure(); // TE
 
                 if ( vecNumAudioChannels[i] == 1 )
                 {
-                    CurOpusEncoder = Opus64EncoderMono[iCurChanID];
+                    CurOpusEncoder     = Opus64EncoderMono[iCurChanID];
+                    pCurOpusEncoderCtl = &Opus64EncoderMonoCtl[iCurChanID];
                 }
                 else
                 {
-                    CurOpusEncoder = Opus64EncoderStereo[iCurChanID];
+                    CurOpusEncoder     = Opus64EncoderStereo[iCurChanID];
+                    pCurOpusEncoderCtl = &Opus64EncoderStereoCtl[iCurChanID];
                 }
             }
             else
@@ -1078,14 +1323,18 @@ static CTimingMeas JitterMeas ( 1000, "test2.dat" ); JitterMeas.Measure(); // TE
 
                 for ( int iB = 0; iB < vecNumFrameSizeConvBlocks[i]; iB++ )
                 {
+                    iPhaseStartNs = TickPhaseTimer.nsecsElapsed();
+
                     // OPUS encoding
                     if ( CurOpusEncoder != nullptr )
                     {
-// TODO find a better place than this: the setting does not change all the time
-//      so for speed optimization it would be better to set it only if the network
-//      frame size is changed
-opus_custom_encoder_ctl ( CurOpusEncoder,
-                          OPUS_SET_BITRATE ( CalcBitRateBitsPerSecFromCodedBytes ( iCeltNumCodedBytes, iClientFrameSizeSamples ) ) );
+                        // the ctl calls are only done if the network frame size or
+                        // the complexity of this client has changed
+                        pCurOpusEncoderCtl->SetBitRate ( CurOpusEncoder,
+                            CalcBitRateBitsPerSecFromCodedBytes ( iCeltNumCodedBytes, iClientFrameSizeSamples ) );
+
+                        pCurOpusEncoderCtl->SetComplexityReduction ( CurOpusEncoder,
+                                                                     veciComplexityReduction[iCurChanID] );
 
                         iUnused = opus_custom_encode ( CurOpusEncoder,
                                                        &vecsSendData[iB * SYSTEM_FRAME_SIZE_SAMPLES * vecNumAudioChannels[i]],
@@ -1094,10 +1343,15 @@ opus_custom_encoder_ctl ( CurOpusEncoder,
                                                        iCeltNumCodedBytes );
                     }
 
+                    const qint64 iSendStartNs = TickPhaseTimer.nsecsElapsed();
+                    vecEncodeTimeNs[i]       += iSendStartNs - iPhaseStartNs;
+
                     // send separate mix to current clients
-                    vecChannels[iCurChanID].PrepAndSendPacket ( &Socket,
-                                                                vecbyCodedData,
-                                                                iCeltNumCodedBytes );
+                    SendAudioPacket ( iCurChanID,
+                                      vecbyCodedData,
+                                      iCeltNumCodedBytes );
+
+                    vecSendTimeNs[i] += TickPhaseTimer.nsecsElapsed() - iSendStartNs;
                 }
 
                 // update socket buffer size
@@ -1106,12 +1360,63 @@ opus_custom_encoder_ctl ( CurOpusEncoder,
                 // send channel levels
                 if ( bSendChannelLevels && vecChannels[iCurChanID].ChannelLevelsRequired() )
                 {
-                    ConnLessProtocol.CreateCLChannelLevelListMes ( vecChannels[iCurChanID].GetAddress(),
-                                                                   vecChannelLevels,
-                                                                   iNumClients );
+                    iPhaseStartNs = TickPhaseTimer.nsecsElapsed();
+
+                    if ( !vecChannels[iCurChanID].ChannelLevelDeltaRequired() )
+                    {
+                        ConnLessProtocol.SendCLMessageFrame ( vecChannels[iCurChanID].GetAddress(),
+                                                              vecbyLevelListMes );
+                    }
+                    else if ( bLevelListDeltaMesValid )
+                    {
+                        ConnLessProtocol.SendCLMessageFrame ( vecChannels[iCurChanID].GetAddress(),
+                                                              vecbyLevelListDeltaMes );
+                    }
+
+                    vecSendTimeNs[i] += TickPhaseTimer.nsecsElapsed() - iPhaseStartNs;
                 }
             }
         }
+
+        // update the tick timing statistics
+        qint64 iMixTimeNs    = 0;
+        qint64 iEncodeTimeNs = 0;
+        qint64 iSendTimeNs   = 0;
+
+        for ( int i = 0; i < iNumClients; i++ )
+        {
+            iMixTimeNs    += vecMixTimeNs[i];
+            iEncodeTimeNs += vecEncodeTimeNs[i];
+            iSendTimeNs   += vecSendTimeNs[i];
+        }
+
+        const qint64 iTickTimeNs = TickPhaseTimer.nsecsElapsed() - iTickStartNs;
+
+        TickPhaseHist[TP_LOCK_WAIT].Add ( iLastTickTimeNs - iTickStartNs );
+        TickPhaseHist[TP_DECODE].Add    ( iDecodeTimeNs );
+        TickPhaseHist[TP_LEVELS].Add    ( iLevelsTimeNs );
+        TickPhaseHist[TP_MIX].Add       ( iMixTimeNs );
+        TickPhaseHist[TP_ENCODE].Add    ( iEncodeTimeNs );
+        TickPhaseHist[TP_SEND].Add      ( iSendTimeNs );
+        TickPhaseHist[TP_TOTAL].Add     ( iTickTimeNs );
+
+        if ( iPrevTickStartNs != INVALID_INDEX )
+        {
+            TickIntervalHist.Add ( iTickStartNs - iPrevTickStartNs );
+        }
+        iPrevTickStartNs = iTickStartNs;
+
+        if ( iTickTimeNs > GetTickPeriodNs() )
+        {
+            iNumTickOverruns.fetch_add ( 1, std::memory_order_relaxed );
+        }
+
+        // the parallel encoding of the clients is finished, the complexities
+        // may be changed for the next tick
+        if ( bUseAdaptiveComplexity )
+        {
+            UpdateEncoderComplexity ( iNumClients, iTickTimeNs );
+        }
     }
     else
     {
@@ -1123,6 +1428,226 @@ opus_custom_encoder_ctl ( CurOpusEncoder,
     Q_UNUSED ( iUnused )
 }
 
+void CServer::UpdateEncoderComplexity ( const int    iNumClients,
+                                        const qint64 iTickTimeNs )
+{
+    const double dLoad = static_cast<double> ( iTickTimeNs ) / GetTickPeriodNs();
+
+    for ( int i = 0; i < iNumClients; i++ )
+    {
+        veciComplexityCtrlEncodeTimeNs[vecChanIDsCurConChan[i]] += vecEncodeTimeNs[i];
+    }
+
+    dComplexityCtrlLoadSum += dLoad;
+
+    if ( dLoad > ENC_COMPLEXITY_CTRL_HIGH_LOAD )
+    {
+        iComplexityCtrlNumHighTicks++;
+    }
+
+    if ( ++iComplexityCtrlNumTicks < ENC_COMPLEXITY_CTRL_INTERVAL_TICKS )
+    {
+        return;
+    }
+
+    const double dMeanLoad = dComplexityCtrlLoadSum / iComplexityCtrlNumTicks;
+
+    if ( iComplexityCtrlNumHighTicks > ENC_COMPLEXITY_CTRL_MAX_HIGH_TICKS )
+    {
+        // lower the complexity of the client which needed the most encoding
+        // time, so that one more musician does not degrade all clients at once
+        int    iSelChanID    = INVALID_CHANNEL_ID;
+        qint64 iMaxEncTimeNs = -1;
+
+        for ( int i = 0; i < iNumClients; i++ )
+        {
+            const int iCurChanID         = vecChanIDsCurConChan[i];
+            const int iNominalComplexity = ( vecAudioComprType[i] == CT_OPUS64 ) ?
+                OPUS64_ENCODER_COMPLEXITY : OPUS_ENCODER_COMPLEXITY;
+
+            if ( ( veciComplexityReduction[iCurChanID] < iNominalComplexity ) &&
+                 ( veciComplexityCtrlEncodeTimeNs[iCurChanID] > iMaxEncTimeNs ) )
+            {
+                iSelChanID    = iCurChanID;
+                iMaxEncTimeNs = veciComplexityCtrlEncodeTimeNs[iCurChanID];
+            }
+        }
+
+        if ( iSelChanID != INVALID_CHANNEL_ID )
+        {
+            veciComplexityReduction[iSelChanID]++;
+        }
+    }
+    else if ( ( iComplexityCtrlNumHighTicks == 0 ) && ( dMeanLoad < ENC_COMPLEXITY_CTRL_LOW_LOAD ) )
+    {
+        // restore the client with the largest reduction first
+        int iSelChanID = INVALID_CHANNEL_ID;
+
+        for ( int i = 0; i < iNumClients; i++ )
+        {
+            const int iCurChanID = vecChanIDsCurConChan[i];
+
+            if ( ( veciComplexityReduction[iCurChanID] > 0 ) &&
+                 ( ( iSelChanID == INVALID_CHANNEL_ID ) ||
+                   ( veciComplexityReduction[iCurChanID] > veciComplexityReduction[iSelChanID] ) ) )
+            {
+                iSelChanID = iCurChanID;
+            }
+        }
+
+        if ( iSelChanID != INVALID_CHANNEL_ID )
+        {
+            veciComplexityReduction[iSelChanID]--;
+        }
+    }
+
+    for ( int i = 0; i < iMaxNumChannels; i++ )
+    {
+        veciComplexityCtrlEncodeTimeNs[i] = 0;
+    }
+
+    iComplexityCtrlNumTicks     = 0;
+    iComplexityCtrlNumHighTicks = 0;
+    dComplexityCtrlLoadSum      = 0;
+}
+
+qint64 CServer::GetTickPeriodNs() const
+{
+    return static_cast<qint64> ( iServerFrameSizeSamples ) * 1000000000 / SYSTEM_SAMPLE_RATE_HZ;
+}
+
+QString CServer::GetTickTimingReport() const
+{
+    const char* strPhaseNames[TP_NUM_PHASES] =
+        { "lock wait", "decode", "levels", "mix", "encode", "send", "total" };
+
+    // durations are reported in ms
+    auto FormatHistogram = [] ( const QString& strName, const CTimingHistogram& Hist )
+    {
+        return QString ( "  %1: p50 %2, p99 %3, p99.9 %4, max %5\n" ).
+            arg ( strName, -10 ).
+            arg ( Hist.GetPercentileNs ( 50 ) / 1000000.0, 0, 'f', 3 ).
+            arg ( Hist.GetPercentileNs ( 99 ) / 1000000.0, 0, 'f', 3 ).
+            arg ( Hist.GetPercentileNs ( 99.9 ) / 1000000.0, 0, 'f', 3 ).
+            arg ( Hist.GetMaxNs() / 1000000.0, 0, 'f', 3 );
+    };
+
+    QString strReport = QString ( "Tick timing in ms (period %1 ms, %2 ticks, %3 deadline overruns):\n" ).
+        arg ( GetTickPeriodNs() / 1000000.0, 0, 'f', 2 ).
+        arg ( TickPhaseHist[TP_TOTAL].GetCount() ).
+        arg ( GetNumTickOverruns() );
+
+    for ( int i = 0; i < TP_NUM_PHASES; i++ )
+    {
+        strReport += FormatHistogram ( strPhaseNames[i], TickPhaseHist[i] );
+    }
+
+    strReport += FormatHistogram ( "interval", TickIntervalHist );
+
+    return strReport;
+}
+
+void CServer::ResetTickTimingStatistics()
+{
+    // note that a reset while the timer is running may lose single updates
+    // which is acceptable for statistics
+    for ( int i = 0; i < TP_NUM_PHASES; i++ )
+    {
+        TickPhaseHist[i].Reset();
+    }
+
+    TickIntervalHist.Reset();
+    iNumTickOverruns.store ( 0, std::memory_order_relaxed );
+}
+
+void CServer::DecodeReceiveData ( const int          iChanCnt,
+                                  const int          iCurChanID,
+                                  OpusCustomDecoder* CurOpusDecoder,
+                                  const int          iClientFrameSizeSamples,
+                                  CVector<int16_t>&  vecsOutData,
+                                  bool&              bChannelIsNowDisconnected )
+{
+    int            iUnused;
+    unsigned char* pCurCodedData;
+
+    // If the server frame size is smaller than the received OPUS frame size, we need a conversion
+    // buffer which stores the large buffer.
+    // Note that we have a shortcut here. If the conversion buffer is not needed, the boolean flag
+    // is false and the Get() function is not called at all. Therefore if the buffer is not needed
+    // we do not spend any time in the function but go directly inside the if condition.
+    if ( ( vecUseDoubleSysFraSizeConvBuf[iChanCnt] == 0 ) ||
+         !DoubleFrameSizeConvBufIn[iCurChanID].Get ( vecsOutData, SYSTEM_FRAME_SIZE_SAMPLES * vecNumAudioChannels[iChanCnt] ) )
+    {
+        // get current number of OPUS coded bytes
+        const int iCeltNumCodedBytes = vecChannels[iCurChanID].GetNetwFrameSize();
+
+        for ( int iB = 0; iB < vecNumFrameSizeConvBlocks[iChanCnt]; iB++ )
+        {
+            // get data
+            const EGetDataStat eGetStat = vecChannels[iCurChanID].GetData ( vecbyCodedData, iCeltNumCodedBytes );
+
+            // if channel was just disconnected, set flag that connected
+            // client list is sent to all other clients
+            // and inform the recorder
+            if ( eGetStat == GS_CHAN_NOW_DISCONNECTED )
+            {
+                if ( bEnableRecording )
+                {
+                    JamRecorder.PutDisconnect ( iCurChanID, iRecorderFrame );
+                }
+
+                bChannelIsNowDisconnected = true;
+            }
+
+            // get pointer to coded data
+            if ( eGetStat == GS_BUFFER_OK )
+            {
+                pCurCodedData = &vecbyCodedData[0];
+            }
+            else
+            {
+                // for lost packets use null pointer as coded input data
+                pCurCodedData = nullptr;
+            }
+
+            // in the packet recording mode the recorder gets the coded data
+            // instead of the decoded audio, lost packets are marked
+            if ( bEnableRecording && bRecordCodedPackets && ( CurOpusDecoder != nullptr ) &&
+                 ( ( eGetStat == GS_BUFFER_OK ) || ( eGetStat == GS_BUFFER_UNDERRUN ) ) )
+            {
+                JamRecorder.PutPacket ( iCurChanID,
+                                        iRecorderFrame,
+                                        vecChannels[iCurChanID].GetName(),
+                                        vecChannels[iCurChanID].GetAddress(),
+                                        vecNumAudioChannels[iChanCnt],
+                                        vecAudioComprType[iChanCnt],
+                                        pCurCodedData,
+                                        iCeltNumCodedBytes );
+            }
+
+            // OPUS decode received data stream
+            if ( CurOpusDecoder != nullptr )
+            {
+                iUnused = opus_custom_decode ( CurOpusDecoder,
+                                               pCurCodedData,
+                                               iCeltNumCodedBytes,
+                                               &vecsOutData[iB * SYSTEM_FRAME_SIZE_SAMPLES * vecNumAudioChannels[iChanCnt]],
+                                               iClientFrameSizeSamples );
+            }
+        }
+
+        // a new large frame is ready, if the conversion buffer is required, put it in the buffer
+        // and read out the small frame size immediately for further processing
+        if ( vecUseDoubleSysFraSizeConvBuf[iChanCnt] != 0 )
+        {
+            DoubleFrameSizeConvBufIn[iCurChanID].PutAll ( vecsOutData );
+            DoubleFrameSizeConvBufIn[iCurChanID].Get ( vecsOutData, SYSTEM_FRAME_SIZE_SAMPLES * vecNumAudioChannels[iChanCnt] );
+        }
+    }
+
+    Q_UNUSED ( iUnused )
+}
+
 /// @brief Mix all audio data from all clients together.
 void CServer::ProcessData ( const CVector<CVector<int16_t> >& vecvecsData,
                             const CVector<double>&            vecdGains,
@@ -1283,30 +1808,116 @@ CVector<CChannelInfo> CServer::CreateChannelList()
     return vecChanInfo;
 }
 
+CVector<CChannelListDeltaEntry> CServer::CreateChannelListDelta (
+    const CVector<CChannelInfo>& vecOldChanInfo,
+    const CVector<CChannelInfo>& vecNewChanInfo )
+{
+    CVector<CChannelListDeltaEntry> vecDelta ( 0 );
+
+    const int iOldSize = vecOldChanInfo.Size();
+    const int iNewSize = vecNewChanInfo.Size();
+    int       iOld     = 0;
+    int       iNew     = 0;
+
+    // both lists are sorted by the channel ID (see CreateChannelList)
+    while ( ( iOld < iOldSize ) || ( iNew < iNewSize ) )
+    {
+        if ( ( iNew == iNewSize ) ||
+             ( ( iOld < iOldSize ) && ( vecOldChanInfo[iOld].iChanID < vecNewChanInfo[iNew].iChanID ) ) )
+        {
+            // the channel is not in the new list anymore
+            vecDelta.Add ( CChannelListDeltaEntry ( CD_REMOVE, vecOldChanInfo[iOld] ) );
+            iOld++;
+        }
+        else if ( ( iOld == iOldSize ) ||
+                  ( vecNewChanInfo[iNew].iChanID < vecOldChanInfo[iOld].iChanID ) )
+        {
+            // the channel is new in the list
+            vecDelta.Add ( CChannelListDeltaEntry ( CD_ADD, vecNewChanInfo[iNew] ) );
+            iNew++;
+        }
+        else
+        {
+            // the channel is in both lists, check if its infos have changed
+            if ( ( vecOldChanInfo[iOld] != vecNewChanInfo[iNew] ) ||
+                 ( vecOldChanInfo[iOld].iIpAddr != vecNewChanInfo[iNew].iIpAddr ) )
+            {
+                vecDelta.Add ( CChannelListDeltaEntry ( CD_UPDATE, vecNewChanInfo[iNew] ) );
+            }
+
+            iOld++;
+            iNew++;
+        }
+    }
+
+    return vecDelta;
+}
+
 void CServer::CreateAndSendChanListForAllConChannels()
 {
     // create channel list
     CVector<CChannelInfo> vecChanInfo ( CreateChannelList() );
 
+    QMutexLocker locker ( &MutexChanList );
+
+    // the clients which support it only get the changes since the last list,
+    // a new version of the list is only created if there are changes
+    const CVector<CChannelListDeltaEntry> vecDelta (
+        CreateChannelListDelta ( vecLastChanList, vecChanInfo ) );
+
+    if ( vecDelta.Size() > 0 )
+    {
+        vecLastChanList  = vecChanInfo;
+        iChanListVersion = ( iChanListVersion + 1 ) & 0xFFFF;
+    }
+
     // now send connected channels list to all connected clients
     for ( int i = 0; i < iMaxNumChannels; i++ )
     {
         if ( vecChannels[i].IsConnected() )
         {
             // send message
-            vecChannels[i].CreateConClientListMes ( vecChanInfo );
+            if ( vecChannels[i].ConClientListDeltaRequired() )
+            {
+                if ( vecDelta.Size() > 0 )
+                {
+                    vecChannels[i].CreateConClientListDeltaMes ( iChanListVersion, false, vecDelta );
+                }
+            }
+            else
+            {
+                vecChannels[i].CreateConClientListMes ( vecChanInfo );
+            }
         }
     }
 
-    // create status HTML file if enabled
-    if ( bWriteStatusHTMLFile )
+    // update the status files if enabled (the files are not written here but
+    // in the thread of the status file writer)
+    if ( StatusFileWriter.IsEnabled() )
     {
-        WriteHTMLChannelList();
+        emit StatusChanged ( vecChanInfo );
     }
 }
 
 void CServer::CreateAndSendChanListForThisChan ( const int iCurChanID )
 {
+    if ( vecChannels[iCurChanID].ConClientListDeltaRequired() )
+    {
+        QMutexLocker locker ( &MutexChanList );
+
+        // the following changes refer to the last sent list, therefore this
+        // list is sent as the complete list of the current version
+        CVector<CChannelListDeltaEntry> vecFullList ( 0 );
+
+        for ( int i = 0; i < vecLastChanList.Size(); i++ )
+        {
+            vecFullList.Add ( CChannelListDeltaEntry ( CD_ADD, vecLastChanList[i] ) );
+        }
+
+        vecChannels[iCurChanID].CreateConClientListDeltaMes ( iChanListVersion, true, vecFullList );
+        return;
+    }
+
     // create channel list
     CVector<CChannelInfo> vecChanInfo ( CreateChannelList() );
 
@@ -1406,6 +2017,9 @@ int CServer::GetFreeChan()
 
 int CServer::GetNumberOfConnectedClients()
 {
+    // this is called by the connection less message threads without the
+    // mutex, the connection state of the channels is atomic and the number
+    // may be outdated by one tick which is fine for the ping answer
     int iNumConnClients = 0;
 
     // check all possible channels for connection status
@@ -1523,7 +2137,17 @@ bool CServer::PutAudioData ( const CVector<uint8_t>& vecbyRecBuf,
             {
                 // in case we have a new connection return this information
                 bNewConnection = true;
+
+                // the arrival phase of the previous client is not valid anymore
+                dArrivalPhaseRe[iCurChanID] = 0.0;
+                dArrivalPhaseIm[iCurChanID] = 0.0;
+
+                // the encoder complexity reduction of the previous client is
+                // reset by the next mix tick
+                vecComplexityResetPending[iCurChanID] = 1;
             }
+
+            UpdateArrivalPhase ( iCurChanID );
         }
     }
     Mutex.unlock();
@@ -1532,6 +2156,105 @@ bool CServer::PutAudioData ( const CVector<uint8_t>& vecbyRecBuf,
     return bNewConnection;
 }
 
+void CServer::UpdateArrivalPhase ( const int iChanID )
+{
+    // note that the mutex must be locked by the caller
+    const double d2Pi          = 2 * 3.14159265358979323846;
+    const double dTickPeriodNs = static_cast<double> ( iServerFrameSizeSamples ) *
+        1e9 / SYSTEM_SAMPLE_RATE_HZ;
+
+    // phase of the packet arrival relative to the last mix tick as an angle
+    const double dAngle = d2Pi *
+        static_cast<double> ( TickPhaseTimer.nsecsElapsed() - iLastTickTimeNs ) / dTickPeriodNs;
+
+    dArrivalPhaseRe[iChanID] = ARRIVAL_PHASE_IIR_WEIGHT * dArrivalPhaseRe[iChanID] +
+        ( 1.0 - ARRIVAL_PHASE_IIR_WEIGHT ) * cos ( dAngle );
+
+    dArrivalPhaseIm[iChanID] = ARRIVAL_PHASE_IIR_WEIGHT * dArrivalPhaseIm[iChanID] +
+        ( 1.0 - ARRIVAL_PHASE_IIR_WEIGHT ) * sin ( dAngle );
+
+    iArrivalLeadUs[iChanID].store   ( CalcArrivalLeadUs ( iChanID ),   std::memory_order_relaxed );
+    iArrivalJitterUs[iChanID].store ( CalcArrivalJitterUs ( iChanID ), std::memory_order_relaxed );
+}
+
+int CServer::CalcArrivalLeadUs ( const int iChanID )
+{
+    // note that the mutex must be locked by the caller
+    const double d2Pi          = 2 * 3.14159265358979323846;
+    const double dTickPeriodUs = static_cast<double> ( iServerFrameSizeSamples ) *
+        1e6 / SYSTEM_SAMPLE_RATE_HZ;
+
+    // mean arrival phase in the range [0, 2 pi)
+    double dAngle = atan2 ( dArrivalPhaseIm[iChanID], dArrivalPhaseRe[iChanID] );
+
+    if ( dAngle < 0 )
+    {
+        dAngle += d2Pi;
+    }
+
+    // the lead is the time from the packet arrival until the next mix tick
+    return static_cast<int> ( dTickPeriodUs * ( 1.0 - dAngle / d2Pi ) );
+}
+
+int CServer::CalcArrivalJitterUs ( const int iChanID )
+{
+    // note that the mutex must be locked by the caller
+    const double d2Pi          = 2 * 3.14159265358979323846;
+    const double dTickPeriodUs = static_cast<double> ( iServerFrameSizeSamples ) *
+        1e6 / SYSTEM_SAMPLE_RATE_HZ;
+
+    // the length of the averaged unit vector shrinks with the spread of the
+    // arrival phase, the circular standard deviation is sqrt ( -2 ln R )
+    const double dLength = sqrt ( dArrivalPhaseRe[iChanID] * dArrivalPhaseRe[iChanID] +
+                                  dArrivalPhaseIm[iChanID] * dArrivalPhaseIm[iChanID] );
+
+    if ( dLength <= 0.0 )
+    {
+        // no estimate yet, the arrival phase may be anywhere in the period
+        return static_cast<int> ( dTickPeriodUs );
+    }
+
+    const double dJitterUs = sqrt ( -2.0 * log ( std::min ( 1.0, dLength ) ) ) * dTickPeriodUs / d2Pi;
+
+    return static_cast<int> ( std::min ( dJitterUs, dTickPeriodUs ) );
+}
+
+void CServer::StopConnLessWorkers()
+{
+    for ( int i = 0; i < iNumConnLessWorkers; i++ )
+    {
+        ConnLessWorkers[i].Stop();
+    }
+}
+
+void CServer::OnCLPingReceived ( CHostAddress InetAddr, int iMs )
+{
+    int iCurArrivalLeadUs   = INVALID_INDEX;
+    int iCurArrivalJitterUs = 0;
+
+    ConnLessProtocol.CreateCLPingMes ( InetAddr, iMs );
+
+    // connected clients additionally get the arrival phase of their audio
+    // packets relative to our mix tick (this is called by the socket or a
+    // worker thread which must not wait for the tick, FindChannel only locks
+    // the channels)
+    const int iChID = FindChannel ( InetAddr );
+
+    if ( iChID != INVALID_CHANNEL_ID )
+    {
+        iCurArrivalLeadUs   = iArrivalLeadUs[iChID].load   ( std::memory_order_relaxed );
+        iCurArrivalJitterUs = iArrivalJitterUs[iChID].load ( std::memory_order_relaxed );
+    }
+
+    if ( iCurArrivalLeadUs != INVALID_INDEX )
+    {
+        ConnLessProtocol.CreateCLTickPhaseMes ( InetAddr,
+            iServerFrameSizeSamples * 1000000 / SYSTEM_SAMPLE_RATE_HZ,
+            iCurArrivalLeadUs,
+            iCurArrivalJitterUs );
+    }
+}
+
 void CServer::GetConCliParam ( CVector<CHostAddress>& vecHostAddresses,
                                CVector<QString>&      vecsName,
                                CVector<int>&          veciJitBufNumFrames,
@@ -1559,55 +2282,6 @@ void CServer::GetConCliParam ( CVector<CHostAddress>& vecHostAddresses,
     }
 }
 
-void CServer::StartStatusHTMLFileWriting ( const QString& strNewFileName,
-                                           const QString& strNewServerNameWithPort )
-{
-    // set important parameters
-    strServerHTMLFileListName = strNewFileName;
-    strServerNameWithPort     = strNewServerNameWithPort;
-
-    // set flag
-    bWriteStatusHTMLFile = true;
-
-    // write initial file
-    WriteHTMLChannelList();
-}
-
-void CServer::WriteHTMLChannelList()
-{
-    // prepare file and stream
-    QFile serverFileListFile ( strServerHTMLFileListName );
-
-    if ( !serverFileListFile.open ( QIODevice::WriteOnly | QIODevice::Text ) )
-    {
-        return;
-    }
-
-    QTextStream streamFileOut ( &serverFileListFile );
-    streamFileOut << strServerNameWithPort << endl << "<ul>" << endl;
-
-    // depending on number of connected clients write list
-    if ( GetNumberOfConnectedClients() == 0 )
-    {
-        // no clients are connected -> empty server
-        streamFileOut << "  No client connected" << endl;
-    }
-    else
-    {
-        // write entry for each connected client
-        for ( int i = 0; i < iMaxNumChannels; i++ )
-        {
-            if ( vecChannels[i].IsConnected() )
-            {
-                streamFileOut << "  <li>" << vecChannels[i].GetName() << "</li>" << endl;
-            }
-        }
-    }
-
-    // finish list
-    streamFileOut << "</ul>" << endl;
-}
-
 void CServer::customEvent ( QEvent* pEvent )
 {
     if ( pEvent->type() == QEvent::User + 11 )
@@ -1701,3 +2375,57 @@ bool CServer::CreateLevelsForAllConChannels ( const int                        i
 
     return bLevelsWereUpdated;
 }
+
+void CServer::CreateChannelLevelListMes ( const int iNumClients )
+{
+    int i;
+
+    // complete list for the clients which do not support the changed levels
+    ConnLessProtocol.GenCLChannelLevelListMesFrame ( vecbyLevelListMes,
+                                                     vecChannelLevels,
+                                                     iNumClients );
+
+    // all levels are sent regularly (since the message may get lost) and if
+    // the connected clients have changed (since the levels are identified by
+    // their position in the list)
+    bool bSendAllLevels = ( iLevelListFullCnt == 0 ) || ( iNumClients != iPrevNumLevelClients );
+
+    for ( i = 0; i < iNumClients; i++ )
+    {
+        if ( vecChanIDsCurConChan[i] != veciPrevLevelChanIDs[i] )
+        {
+            bSendAllLevels = true;
+        }
+    }
+
+    int iNumChanged = 0;
+
+    for ( i = 0; i < iNumClients; i++ )
+    {
+        if ( bSendAllLevels || ( vecChannelLevels[i] != vecPrevChannelLevels[i] ) )
+        {
+            vecChannelLevelsDelta[i] = vecChannelLevels[i];
+            iNumChanged++;
+        }
+        else
+        {
+            vecChannelLevelsDelta[i] = PROT_CHANNEL_LEVEL_UNCHANGED;
+        }
+
+        vecPrevChannelLevels[i] = vecChannelLevels[i];
+        veciPrevLevelChanIDs[i] = vecChanIDsCurConChan[i];
+    }
+
+    iPrevNumLevelClients = iNumClients;
+    iLevelListFullCnt    = ( iLevelListFullCnt + 1 ) % CHANNEL_LEVEL_FULL_LIST_INTERVAL;
+
+    // nothing is sent if no level has changed
+    bLevelListDeltaMesValid = ( iNumChanged > 0 );
+
+    if ( bLevelListDeltaMesValid )
+    {
+        ConnLessProtocol.GenCLChannelLevelListDeltaMesFrame ( vecbyLevelListDeltaMes,
+                                                              vecChannelLevelsDelta,
+                                                              iNumClients );
+    }
+}
@@ -37,11 +37,14 @@
 #endif
 #include "global.h"
 #include "buffer.h"
+#include "resample.h"
 #include "signalhandler.h"
 #include "socket.h"
 #include "channel.h"
 #include "util.h"
 #include "serverlogging.h"
+#include "statusfilewriter.h"
+#include "mixstream.h"
 #include "serverlist.h"
 #include "multicolorledbar.h"
 #include "recorder/jamrecorder.h"
@@ -51,8 +54,92 @@
 // no valid channel number
 #define INVALID_CHANNEL_ID                  ( MAX_NUM_CHANNELS + 1 )
 
+// IIR weight for averaging the arrival phase of the client audio packets
+// relative to the mix tick (one update per received audio packet)
+#define ARRIVAL_PHASE_IIR_WEIGHT            0.99
+
+// maximum number of threads for processing the connection less messages
+#define MAX_NUM_CONN_LESS_WORKERS           8
+
+// complexity of the OPUS encoders without overload (the OPUS64 value is the
+// default of the CELT encoder)
+#define OPUS_ENCODER_COMPLEXITY             1
+#define OPUS64_ENCODER_COMPLEXITY           5
+
+// adaptive encoder complexity: the tick load (processing time relative to the
+// tick period) is evaluated in intervals of this number of ticks
+#define ENC_COMPLEXITY_CTRL_INTERVAL_TICKS  256
+
+// if more ticks of an interval than allowed have a load above the high limit,
+// the complexity of one more encoder is lowered by one step, if no tick was
+// above the high limit and the mean load is below the low limit, one step is
+// restored
+#define ENC_COMPLEXITY_CTRL_HIGH_LOAD       0.85
+#define ENC_COMPLEXITY_CTRL_LOW_LOAD        0.5
+#define ENC_COMPLEXITY_CTRL_MAX_HIGH_TICKS  2
+
+// phases of the server timer tick for which the processing time is measured
+// (mix, encode and send are summed over all connected clients)
+enum ETickPhase
+{
+    TP_LOCK_WAIT = 0, // waiting for the mutex at the start of the tick
+    TP_DECODE    = 1, // jitter buffer get and OPUS decoding
+    TP_LEVELS    = 2, // channel level calculation
+    TP_MIX       = 3, // mixing of the separate client mixes
+    TP_ENCODE    = 4, // OPUS encoding
+    TP_SEND      = 5, // sending audio packets and level messages
+    TP_TOTAL     = 6, // complete tick
+    TP_NUM_PHASES
+};
+
 
 /* Classes ********************************************************************/
+// OPUS encoder settings which may change during a connection, they are only
+// passed to the encoder if they differ from the current settings
+class COpusEncoderCtlCache
+{
+public:
+    COpusEncoderCtlCache() : iBitRate ( -1 ), iComplexity ( 0 ), iNominalComplexity ( 0 ) {}
+
+    void Init ( OpusCustomEncoder* pEncoder,
+                const int          iNNominalComplexity )
+    {
+        iNominalComplexity = iNNominalComplexity;
+        iComplexity        = iNNominalComplexity;
+        iBitRate           = -1; // the bit rate is set with the first frame
+
+        opus_custom_encoder_ctl ( pEncoder, OPUS_SET_COMPLEXITY ( iComplexity ) );
+    }
+
+    void SetBitRate ( OpusCustomEncoder* pEncoder,
+                      const int          iNewBitRate )
+    {
+        if ( iNewBitRate != iBitRate )
+        {
+            opus_custom_encoder_ctl ( pEncoder, OPUS_SET_BITRATE ( iNewBitRate ) );
+            iBitRate = iNewBitRate;
+        }
+    }
+
+    void SetComplexityReduction ( OpusCustomEncoder* pEncoder,
+                                  const int          iReduction )
+    {
+        const int iNewComplexity = std::max ( 0, iNominalComplexity - iReduction );
+
+        if ( iNewComplexity != iComplexity )
+        {
+            opus_custom_encoder_ctl ( pEncoder, OPUS_SET_COMPLEXITY ( iNewComplexity ) );
+            iComplexity = iNewComplexity;
+        }
+    }
+
+protected:
+    int iBitRate;
+    int iComplexity;
+    int iNominalComplexity;
+};
+
+
 #if ( defined ( WIN32 ) || defined ( _WIN32 ) )
 // using QTimer for Windows
 class CHighPrecisionTimer : public QObject
@@ -119,6 +206,42 @@ signals:
 #endif
 
 
+// Connection less message worker ----------------------------------------------
+// Parses the connection less protocol messages (and thereby answers them) in
+// its own thread. The messages of one address are always given to the same
+// worker so that their order is kept.
+class CConnLessWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    CConnLessWorker() : pConnLessProtocol ( nullptr ) {}
+    virtual ~CConnLessWorker() { Stop(); }
+
+    void Start ( CProtocol* pNConLProt );
+    void Stop();
+
+    // may be called from any thread, the message is queued for the worker
+    void PutMessage ( const int               iRecID,
+                      const CVector<uint8_t>& vecbyMesBodyData,
+                      const CHostAddress&     RecHostAddr )
+        { emit MessageReceived ( iRecID, vecbyMesBodyData, RecHostAddr ); }
+
+protected:
+    CProtocol* pConnLessProtocol;
+    QThread    Thread;
+
+public slots:
+    void OnMessageReceived ( int              iRecID,
+                             CVector<uint8_t> vecbyMesBodyData,
+                             CHostAddress     RecHostAddr );
+
+signals:
+    void MessageReceived ( int              iRecID,
+                           CVector<uint8_t> vecbyMesBodyData,
+                           CHostAddress     RecHostAddr );
+};
+
 template<unsigned int slotId>
 class CServerSlots : public CServerSlots<slotId - 1>
 {
@@ -141,6 +264,8 @@ public:
         CreateAndSendJitBufMessage ( slotId - 1, iNNumFra );
     }
 
+    void OnProtRecGapTimeoutCh() { FlushStoredProtMessages ( slotId - 1 ); }
+
 protected:
     virtual void SendProtMessage ( int              iChID,
                                    CVector<uint8_t> vecMessage ) = 0;
@@ -156,6 +281,8 @@ protected:
 
     virtual void CreateAndSendJitBufMessage ( const int iCurChanID,
                                               const int iNNumFra ) = 0;
+
+    virtual void FlushStoredProtMessages ( const int iCurChanID ) = 0;
 };
 
 template<>
@@ -173,16 +300,21 @@ public:
               const QString&     strLoggingFileName,
               const quint16      iPortNumber,
               const QString&     strHTMLStatusFileName,
+              const QString&     strJSONStatusFileName,
               const QString&     strHistoryFileName,
               const QString&     strServerNameForHTMLStatusFile,
               const QString&     strCentralServer,
               const QString&     strServerInfo,
               const QString&     strNewWelcomeMessage,
               const QString&     strRecordingDirName,
+              const bool         bNRecordCodedPackets,
               const bool         bNCentServPingServerInList,
               const bool         bNDisconnectAllClientsOnQuit,
               const bool         bNUseDoubleSystemFrameSize,
-              const ELicenceType eNLicenceType );
+              const ELicenceType eNLicenceType,
+              const int          iNNumConnLessWorkers = 1 );
+
+    virtual ~CServer();
 
     void Start();
     void Stop();
@@ -200,9 +332,25 @@ public:
 
     bool GetRecorderInitialised() { return bRecorderInitialised; }
     bool GetRecordingEnabled() { return bEnableRecording; }
+    uint32_t GetRecorderDroppedFrames() { return JamRecorder.DroppedFrames(); }
     void RequestNewRecording();
     void SetEnableRecording ( bool bNewEnableRecording );
 
+    // live mix stream (must be enabled before the server is started)
+    bool EnableMixStream ( const QString& strOutputName,
+                           const QString& strGainsFileName )
+        { return MixStream.Init ( strOutputName, strGainsFileName, iServerFrameSizeSamples ); }
+
+    bool GetMixStreamEnabled() const { return MixStream.IsEnabled(); }
+    uint32_t GetMixStreamDroppedFrames() const { return MixStream.GetDroppedFrames(); }
+
+    // capture of all received datagrams for a later replay
+    bool EnablePacketCapture ( const QString& strFileName,
+                               const int      iSizeMB );
+
+    bool GetPacketCaptureEnabled() const { return PacketCapture.IsEnabled(); }
+    uint32_t GetPacketCaptureDroppedPackets() const { return PacketCapture.GetDroppedPackets(); }
+
     // Server list management --------------------------------------------------
     void UpdateServerList() { ServerListManager.Update(); }
 
@@ -213,6 +361,8 @@ public:
 
     bool GetServerListEnabled() { return ServerListManager.GetEnabled(); }
 
+    int GetNumDroppedNatPunches() { return ServerListManager.GetNumDroppedNatPunches(); }
+
     void SetServerListCentralServerAddress ( const QString& sNCentServAddr )
         { ServerListManager.SetCentralServerAddress ( sNCentServAddr ); }
 
@@ -251,6 +401,34 @@ public:
     void SetLicenceType ( const ELicenceType NLiType ) { eLicenceType = NLiType; }
     ELicenceType GetLicenceType() { return eLicenceType; }
 
+    // clock drift compensation
+    void SetUseDriftCompensation ( const bool bNUDC );
+    bool GetUseDriftCompensation() { return bUseDriftCompensation; }
+
+    // lowering of the encoder complexity of single clients under overload
+    void SetUseAdaptiveComplexity ( const bool bNUAC ) { bUseAdaptiveComplexity = bNUAC; }
+    bool GetUseAdaptiveComplexity() { return bUseAdaptiveComplexity; }
+    int  GetEncoderComplexityReduction ( const int iChanNum ) const { return veciComplexityReduction[iChanNum]; }
+
+    // emulation of network impairments for tests
+    void EnableNetImpairment ( const CNetImpairmentParams& Params ) { Socket.EnableNetImpairment ( Params ); }
+
+    // channel access for the admin interface (note that the channel state may
+    // change at any time since the channels are not locked)
+    int       GetMaxNumChannels() const { return iMaxNumChannels; }
+    CChannel& GetChannel ( const int iChanNum ) { return vecChannels[iChanNum]; }
+    int       GetServerFrameSizeSamples() const { return iServerFrameSizeSamples; }
+
+    // tick timing statistics (may be queried while the server is running)
+    const CTimingHistogram& GetTickPhaseHistogram ( const ETickPhase ePhase ) const
+        { return TickPhaseHist[ePhase]; }
+
+    const CTimingHistogram& GetTickIntervalHistogram() const { return TickIntervalHist; }
+    uint32_t GetNumTickOverruns() const { return iNumTickOverruns.load ( std::memory_order_relaxed ); }
+    qint64   GetTickPeriodNs() const;
+    QString  GetTickTimingReport() const;
+    void     ResetTickTimingStatistics();
+
     // window position/state settings
     QByteArray vecWindowPosMain;
 
@@ -259,14 +437,15 @@ protected:
     bool IsConnected ( const int iChanNum )
         { return vecChannels[iChanNum].IsConnected(); }
 
-    void StartStatusHTMLFileWriting ( const QString& strNewFileName,
-                                      const QString& strNewServerNameWithPort );
-
     int GetFreeChan();
     int FindChannel ( const CHostAddress& CheckAddr );
     int GetNumberOfConnectedClients();
     CVector<CChannelInfo> CreateChannelList();
 
+    static CVector<CChannelListDeltaEntry> CreateChannelListDelta (
+        const CVector<CChannelInfo>& vecOldChanInfo,
+        const CVector<CChannelInfo>& vecNewChanInfo );
+
     virtual void CreateAndSendChanListForAllConChannels();
     virtual void CreateAndSendChanListForThisChan ( const int iCurChanID );
 
@@ -284,13 +463,32 @@ protected:
     virtual void CreateAndSendJitBufMessage ( const int iCurChanID,
                                               const int iNNumFra );
 
+    virtual void FlushStoredProtMessages ( const int iCurChanID );
+
     virtual void SendProtMessage ( int              iChID,
                                    CVector<uint8_t> vecMessage );
 
+    // sends the coded mix to the client of the channel, may be called by the
+    // parallel threads of the mix (the offline simulation captures it instead)
+    virtual void SendAudioPacket ( const int               iChID,
+                                   const CVector<uint8_t>& vecbyData,
+                                   const int               iNumBytes );
+
     template<unsigned int slotId>
     inline void connectChannelSignalsToServerSlots();
 
-    void WriteHTMLChannelList();
+    void DecodeReceiveData ( const int          iChanCnt,
+                             const int          iCurChanID,
+                             OpusCustomDecoder* CurOpusDecoder,
+                             const int          iClientFrameSizeSamples,
+                             CVector<int16_t>&  vecsOutData,
+                             bool&              bChannelIsNowDisconnected );
+
+    void UpdateArrivalPhase ( const int iChanID );
+    int  CalcArrivalLeadUs ( const int iChanID );
+    int  CalcArrivalJitterUs ( const int iChanID );
+
+    void StopConnLessWorkers();
 
     void ProcessData ( const CVector<CVector<int16_t> >& vecvecsData,
                        const CVector<double>&            vecdGains,
@@ -311,6 +509,11 @@ protected:
                                           const CVector<CVector<int16_t> > vecvecsData,
                                           CVector<uint16_t>&               vecLevelsOut );
 
+    void CreateChannelLevelListMes ( const int iNumClients );
+
+    void UpdateEncoderComplexity ( const int    iNumClients,
+                                   const qint64 iTickTimeNs );
+
     // do not use the vector class since CChannel does not have appropriate
     // copy constructor/operator
     CChannel                   vecChannels[MAX_NUM_CHANNELS];
@@ -318,6 +521,12 @@ protected:
     CProtocol                  ConnLessProtocol;
     QMutex                     Mutex;
 
+    // the last sent connected clients list and its version, the clients
+    // which support it only get the changes of this list
+    CVector<CChannelInfo>      vecLastChanList;
+    int                        iChanListVersion;
+    QMutex                     MutexChanList;
+
     // audio encoder/decoder
     OpusCustomMode*            Opus64Mode[MAX_NUM_CHANNELS];
     OpusCustomEncoder*         Opus64EncoderMono[MAX_NUM_CHANNELS];
@@ -329,9 +538,52 @@ protected:
     OpusCustomDecoder*         OpusDecoderMono[MAX_NUM_CHANNELS];
     OpusCustomEncoder*         OpusEncoderStereo[MAX_NUM_CHANNELS];
     OpusCustomDecoder*         OpusDecoderStereo[MAX_NUM_CHANNELS];
+    COpusEncoderCtlCache       Opus64EncoderMonoCtl[MAX_NUM_CHANNELS];
+    COpusEncoderCtlCache       Opus64EncoderStereoCtl[MAX_NUM_CHANNELS];
+    COpusEncoderCtlCache       OpusEncoderMonoCtl[MAX_NUM_CHANNELS];
+    COpusEncoderCtlCache       OpusEncoderStereoCtl[MAX_NUM_CHANNELS];
     CConvBuf<int16_t>          DoubleFrameSizeConvBufIn[MAX_NUM_CHANNELS];
     CConvBuf<int16_t>          DoubleFrameSizeConvBufOut[MAX_NUM_CHANNELS];
 
+    // clock drift compensation
+    CDriftResampler            DriftResampler[MAX_NUM_CHANNELS];
+    CVector<int16_t>           vecsDecodedData;
+    bool                       bUseDriftCompensation;
+
+    // arrival phase of the client audio packets relative to the mix tick,
+    // averaged as a unit vector since the phase wraps at the tick period
+    QElapsedTimer              TickPhaseTimer;
+    qint64                     iLastTickTimeNs;
+    double                     dArrivalPhaseRe[MAX_NUM_CHANNELS];
+    double                     dArrivalPhaseIm[MAX_NUM_CHANNELS];
+
+    // the lead and the jitter are read by the connection less message
+    // threads without the mutex (which is held by the timer for a whole tick)
+    std::atomic<int>           iArrivalLeadUs[MAX_NUM_CHANNELS];
+    std::atomic<int>           iArrivalJitterUs[MAX_NUM_CHANNELS];
+
+    // tick timing statistics, a tick which takes longer than the frame
+    // period is counted as an overrun of the deadline
+    CTimingHistogram           TickPhaseHist[TP_NUM_PHASES];
+    CTimingHistogram           TickIntervalHist;
+    std::atomic<uint32_t>      iNumTickOverruns;
+    qint64                     iPrevTickStartNs;
+    CVector<qint64>            vecMixTimeNs;
+    CVector<qint64>            vecEncodeTimeNs;
+    CVector<qint64>            vecSendTimeNs;
+
+    // adaptive encoder complexity, the encoding time per channel is summed
+    // over the evaluation interval to select the encoder which is lowered
+    // (the reset flag is set on a new connection under the mutex, the
+    // reduction itself is only accessed by the mix tick)
+    bool                       bUseAdaptiveComplexity;
+    int                        iComplexityCtrlNumTicks;
+    int                        iComplexityCtrlNumHighTicks;
+    double                     dComplexityCtrlLoadSum;
+    CVector<qint64>            veciComplexityCtrlEncodeTimeNs;
+    CVector<int>               veciComplexityReduction;
+    CVector<int>               vecComplexityResetPending;
+
     CVector<QString>           vstrChatColors;
     CVector<int>               vecChanIDsCurConChan;
 
@@ -348,6 +600,27 @@ protected:
     // Channel levels
     CVector<uint16_t>          vecChannelLevels;
 
+    // the channel level list messages are generated once per level update for
+    // all clients, the changed levels refer to the previous levels of the
+    // same clients
+    CVector<uint8_t>           vecbyLevelListMes;
+    CVector<uint8_t>           vecbyLevelListDeltaMes;
+    bool                       bLevelListDeltaMesValid;
+    CVector<uint16_t>          vecChannelLevelsDelta;
+    CVector<uint16_t>          vecPrevChannelLevels;
+    CVector<int>               veciPrevLevelChanIDs;
+    int                        iPrevNumLevelClients;
+    int                        iLevelListFullCnt;
+
+    // connection less messages (the workers must exist as long as the socket
+    // thread is running)
+    CConnLessWorker            ConnLessWorkers[MAX_NUM_CONN_LESS_WORKERS];
+    int                        iNumConnLessWorkers;
+
+    // capture of the received datagrams, it must be destroyed after the socket
+    // since the socket thread writes to it
+    CPacketCapture             PacketCapture;
+
     // actual working objects
     CHighPrioSocket            Socket;
 
@@ -357,15 +630,23 @@ protected:
     // channel level update frame interval counter
     int                        iFrameCount;
 
-    // recording thread
+    // recording thread, the frames are put into its rings together with the
+    // frame counter of the tick
     recorder::CJamRecorder     JamRecorder;
     bool                       bRecorderInitialised;
     bool                       bEnableRecording;
+    bool                       bRecordCodedPackets;
+    qint64                     iRecorderFrame;
+
+    // HTML/JSON file server status
+    CStatusFileWriter          StatusFileWriter;
 
-    // HTML file server status
-    bool                       bWriteStatusHTMLFile;
-    QString                    strServerHTMLFileListName;
-    QString                    strServerNameWithPort;
+    // program mix for the live stream, it is mixed once per tick with its own
+    // gains and pannings for all connected clients
+    CMixStream                 MixStream;
+    CVector<double>            vecdStreamGains;
+    CVector<double>            vecdStreamPannings;
+    CVector<int16_t>           vecsStreamData;
 
     CHighPrecisionTimer        HighPrecisionTimer;
 
@@ -385,13 +666,8 @@ protected:
 signals:
     void Started();
     void Stopped();
-    void ClientDisconnected ( const int iChID );
+    void StatusChanged ( CVector<CChannelInfo> vecChanInfo );
     void SvrRegStatusChanged();
-    void AudioFrame ( const int              iChID,
-                      const QString          stChName,
-                      const CHostAddress     RecHostAddr,
-                      const int              iNumAudChan,
-                      const CVector<int16_t> vecsData );
     void RestartRecorder();
     void StopRecorder();
     void RecordingSessionStarted ( QString sessionDir );
@@ -416,8 +692,7 @@ public slots:
                                     CVector<uint8_t> vecbyMesBodyData,
                                     CHostAddress     RecHostAddr );
 
-    void OnCLPingReceived ( CHostAddress InetAddr, int iMs )
-        { ConnLessProtocol.CreateCLPingMes ( InetAddr, iMs ); }
+    void OnCLPingReceived ( CHostAddress InetAddr, int iMs );
 
     void OnCLPingWithNumClientsReceived ( CHostAddress InetAddr,
                                           int          iMs,
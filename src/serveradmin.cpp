@@ -0,0 +1,325 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#include "serveradmin.h"
+
+
+/* Implementation *************************************************************/
+CServerAdmin::CServerAdmin ( CServer* pNServer ) :
+    pServer ( pNServer )
+{
+    const int iMaxNumChannels = pServer->GetMaxNumChannels();
+
+    veciPrevRecPackets.Init  ( iMaxNumChannels, 0 );
+    veciPrevSentPackets.Init ( iMaxNumChannels, 0 );
+    vecdRecPacketRate.Init   ( iMaxNumChannels, 0 );
+    vecdSentPacketRate.Init  ( iMaxNumChannels, 0 );
+
+
+    // Connections -------------------------------------------------------------
+    QObject::connect ( &LocalServer, &QLocalServer::newConnection,
+        this, &CServerAdmin::OnNewConnection );
+
+    QObject::connect ( &TimerRate, &QTimer::timeout,
+        this, &CServerAdmin::OnTimerRate );
+}
+
+bool CServerAdmin::Start ( const QString& strSocketName )
+{
+    // remove a stale socket file of a previous run which was not shut down
+    // properly (otherwise listen would fail)
+    QLocalServer::removeServer ( strSocketName );
+
+    // only the user running the server may access the socket
+    LocalServer.setSocketOptions ( QLocalServer::UserAccessOption );
+
+    if ( !LocalServer.listen ( strSocketName ) )
+    {
+        return false;
+    }
+
+    TimerRate.start ( SERVER_ADMIN_RATE_INTERVAL_MS );
+
+    return true;
+}
+
+void CServerAdmin::OnNewConnection()
+{
+    while ( LocalServer.hasPendingConnections() )
+    {
+        QLocalSocket* pSocket = LocalServer.nextPendingConnection();
+
+        QObject::connect ( pSocket, &QLocalSocket::readyRead,
+            this, &CServerAdmin::OnReadyRead );
+
+        QObject::connect ( pSocket, &QLocalSocket::disconnected,
+            pSocket, &QLocalSocket::deleteLater );
+    }
+}
+
+void CServerAdmin::OnReadyRead()
+{
+    QLocalSocket* pSocket = qobject_cast<QLocalSocket*> ( sender() );
+
+    if ( pSocket == nullptr )
+    {
+        return;
+    }
+
+    // answer each complete command line
+    while ( pSocket->canReadLine() )
+    {
+        const QString strCommand = QString::fromUtf8 ( pSocket->readLine() ).trimmed();
+
+        pSocket->write ( ProcessCommand ( strCommand ) );
+    }
+
+    // do not let a client without line breaks fill up our memory
+    if ( pSocket->bytesAvailable() > SERVER_ADMIN_MAX_COMMAND_LEN )
+    {
+        pSocket->disconnectFromServer();
+    }
+}
+
+QByteArray CServerAdmin::ProcessCommand ( const QString& strCommand )
+{
+    QJsonObject Response;
+
+    if ( strCommand == "status" )
+    {
+        Response["server"]   = GetServerJson();
+        Response["channels"] = GetChannelsJson();
+        Response["timing"]   = GetTimingJson();
+        Response["recorder"] = GetRecorderJson();
+    }
+    else if ( strCommand == "server" )
+    {
+        Response["server"] = GetServerJson();
+    }
+    else if ( strCommand == "channels" )
+    {
+        Response["channels"] = GetChannelsJson();
+    }
+    else if ( strCommand == "timing" )
+    {
+        Response["timing"] = GetTimingJson();
+    }
+    else if ( strCommand == "recorder" )
+    {
+        Response["recorder"] = GetRecorderJson();
+    }
+    else if ( strCommand == "resettiming" )
+    {
+        pServer->ResetTickTimingStatistics();
+        Response["result"] = "ok";
+    }
+    else
+    {
+        Response["error"] = QString ( "unknown command: " ) + strCommand.left ( SERVER_ADMIN_MAX_COMMAND_LEN );
+    }
+
+    return QJsonDocument ( Response ).toJson ( QJsonDocument::Compact ) + "\n";
+}
+
+QJsonObject CServerAdmin::GetServerJson()
+{
+    QJsonObject Server;
+
+    Server["version"]             = VERSION;
+    Server["name"]                = pServer->GetServerName();
+    Server["running"]             = pServer->IsRunning();
+    Server["max_channels"]        = pServer->GetMaxNumChannels();
+    Server["frame_size_samples"]  = pServer->GetServerFrameSizeSamples();
+    Server["drift_compensation"]  = pServer->GetUseDriftCompensation();
+    Server["adaptive_complexity"] = pServer->GetUseAdaptiveComplexity();
+
+    // NAT punch requests of the central server which were not sent in time
+    Server["nat_punch_dropped"] = pServer->GetNumDroppedNatPunches();
+
+    // capture of the received datagrams
+    Server["capture_enabled"]         = pServer->GetPacketCaptureEnabled();
+    Server["capture_dropped_packets"] = static_cast<qint64> ( pServer->GetPacketCaptureDroppedPackets() );
+
+    return Server;
+}
+
+QJsonArray CServerAdmin::GetChannelsJson()
+{
+    QJsonArray Channels;
+
+    for ( int i = 0; i < pServer->GetMaxNumChannels(); i++ )
+    {
+        CChannel&    Channel = pServer->GetChannel ( i );
+        CHostAddress InetAddr;
+
+        // the address is copied under the channel mutex since the channel may
+        // be disconnected and reused at any time
+        if ( !Channel.GetAddress ( InetAddr ) )
+        {
+            continue;
+        }
+
+        QJsonObject Chan;
+
+        Chan["id"]      = i;
+        Chan["name"]    = Channel.GetName();
+        Chan["address"] = InetAddr.toString();
+
+        // codec settings
+        switch ( Channel.GetAudioCompressionType() )
+        {
+        case CT_OPUS:
+            Chan["codec"] = "opus";
+            break;
+
+        case CT_OPUS64:
+            Chan["codec"] = "opus64";
+            break;
+
+        default:
+            Chan["codec"] = "none";
+            break;
+        }
+
+        Chan["audio_channels"]   = Channel.GetNumAudioChannels();
+        Chan["frame_size_fact"]  = Channel.GetNetwFrameSizeFact();
+        Chan["coded_bytes"]      = Channel.GetNetwFrameSize();
+        Chan["redundancy"]       = Channel.GetUseRedundancy();
+        Chan["upload_rate_kbps"] = Channel.GetUploadRateKbps();
+
+        // jitter buffer (the error rates are a copy taken under the jitter
+        // buffer mutex)
+        CVector<double> vecErrRates;
+        double          dLimit, dMaxUpLimit;
+
+        Channel.GetBufErrorRates ( vecErrRates, dLimit, dMaxUpLimit );
+
+        QJsonArray ErrorRates;
+
+        for ( int j = 0; j < vecErrRates.Size(); j++ )
+        {
+            ErrorRates.append ( vecErrRates[j] );
+        }
+
+        Chan["jitbuf_frames"]      = Channel.GetSockBufNumFrames();
+        Chan["jitbuf_auto"]        = Channel.GetDoAutoSockBufSize();
+        Chan["jitbuf_error_rates"] = ErrorRates;
+        Chan["jitbuf_error_limit"] = dLimit;
+        Chan["drift_correction"]   = Channel.GetDriftCorrection();
+
+        // steps by which the encoder complexity is lowered under overload
+        Chan["encoder_complexity_reduction"] = pServer->GetEncoderComplexityReduction ( i );
+
+        // packet statistics (the counters refer to the current connection)
+        Chan["rec_packets"]          = static_cast<qint64> ( Channel.GetCounter ( CC_REC_PACKETS ) );
+        Chan["recovered_packets"]    = static_cast<qint64> ( Channel.GetCounter ( CC_RECOVERED_PACKETS ) );
+        Chan["sent_packets"]         = static_cast<qint64> ( Channel.GetCounter ( CC_SENT_PACKETS ) );
+        Chan["jitbuf_underruns"]     = static_cast<qint64> ( Channel.GetCounter ( CC_BUF_UNDERRUNS ) );
+        Chan["jitbuf_overruns"]      = static_cast<qint64> ( Channel.GetCounter ( CC_BUF_OVERRUNS ) );
+        Chan["rec_packets_per_sec"]  = vecdRecPacketRate[i];
+        Chan["sent_packets_per_sec"] = vecdSentPacketRate[i];
+
+        Channels.append ( Chan );
+    }
+
+    return Channels;
+}
+
+QJsonObject CServerAdmin::GetTimingJson()
+{
+    const char* strPhaseNames[TP_NUM_PHASES] =
+        { "lock_wait", "decode", "levels", "mix", "encode", "send", "total" };
+
+    QJsonObject Timing;
+    QJsonObject Phases;
+
+    for ( int i = 0; i < TP_NUM_PHASES; i++ )
+    {
+        Phases[strPhaseNames[i]] =
+            HistogramToJson ( pServer->GetTickPhaseHistogram ( static_cast<ETickPhase> ( i ) ) );
+    }
+
+    Timing["period_ns"] = pServer->GetTickPeriodNs();
+    Timing["overruns"]  = static_cast<qint64> ( pServer->GetNumTickOverruns() );
+    Timing["phases"]    = Phases;
+    Timing["interval"]  = HistogramToJson ( pServer->GetTickIntervalHistogram() );
+
+    return Timing;
+}
+
+QJsonObject CServerAdmin::GetRecorderJson()
+{
+    QJsonObject Recorder;
+
+    Recorder["initialised"] = pServer->GetRecorderInitialised();
+    Recorder["enabled"]     = pServer->GetRecordingEnabled();
+
+    // frames which the recorder thread could not take in time
+    Recorder["dropped_frames"] = static_cast<qint64> ( pServer->GetRecorderDroppedFrames() );
+
+    // live mix stream
+    Recorder["stream_enabled"]        = pServer->GetMixStreamEnabled();
+    Recorder["stream_dropped_frames"] = static_cast<qint64> ( pServer->GetMixStreamDroppedFrames() );
+
+    return Recorder;
+}
+
+QJsonObject CServerAdmin::HistogramToJson ( const CTimingHistogram& Hist )
+{
+    QJsonObject Json;
+
+    // all durations in ns
+    Json["count"] = static_cast<qint64> ( Hist.GetCount() );
+    Json["p50"]   = static_cast<qint64> ( Hist.GetPercentileNs ( 50 ) );
+    Json["p90"]   = static_cast<qint64> ( Hist.GetPercentileNs ( 90 ) );
+    Json["p99"]   = static_cast<qint64> ( Hist.GetPercentileNs ( 99 ) );
+    Json["p99_9"] = static_cast<qint64> ( Hist.GetPercentileNs ( 99.9 ) );
+    Json["max"]   = static_cast<qint64> ( Hist.GetMaxNs() );
+
+    return Json;
+}
+
+void CServerAdmin::OnTimerRate()
+{
+    const double dIntervalSec = SERVER_ADMIN_RATE_INTERVAL_MS / 1000.0;
+
+    for ( int i = 0; i < pServer->GetMaxNumChannels(); i++ )
+    {
+        CChannel&      Channel         = pServer->GetChannel ( i );
+        const uint32_t iCurRecPackets  = Channel.GetCounter ( CC_REC_PACKETS );
+        const uint32_t iCurSentPackets = Channel.GetCounter ( CC_SENT_PACKETS );
+
+        // the counters are reset on a new connection
+        const uint32_t iRecDiff  = ( iCurRecPackets >= veciPrevRecPackets[i] ) ?
+            iCurRecPackets - veciPrevRecPackets[i] : iCurRecPackets;
+
+        const uint32_t iSentDiff = ( iCurSentPackets >= veciPrevSentPackets[i] ) ?
+            iCurSentPackets - veciPrevSentPackets[i] : iCurSentPackets;
+
+        vecdRecPacketRate[i]   = iRecDiff / dIntervalSec;
+        vecdSentPacketRate[i]  = iSentDiff / dIntervalSec;
+        veciPrevRecPackets[i]  = iCurRecPackets;
+        veciPrevSentPackets[i] = iCurSentPackets;
+    }
+}
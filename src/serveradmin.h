@@ -0,0 +1,96 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QTimer>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include "global.h"
+#include "channel.h"
+#include "server.h"
+#include "util.h"
+
+
+/* Definitions ****************************************************************/
+// interval for updating the packet rates of the channels
+#define SERVER_ADMIN_RATE_INTERVAL_MS       1000
+
+// maximum length of a command line, longer requests are discarded
+#define SERVER_ADMIN_MAX_COMMAND_LEN        256
+
+
+/* Classes ********************************************************************/
+// Server admin socket ---------------------------------------------------------
+// Local socket (a Unix domain socket on Linux/Mac, a named pipe on Windows)
+// which answers queries about the server state. Each request is a single line
+// with a command, each response is a single line with a JSON object:
+//   status      - all of the following
+//   server      - general server settings
+//   channels    - connected channels with codec, jitter buffer and statistics
+//   timing      - tick timing histograms
+//   recorder    - recorder and live mix stream state
+//   resettiming - reset the tick timing statistics
+// The values are taken from atomic counters or plain reads of the channel
+// state, the audio mutex of the server is never locked.
+class CServerAdmin : public QObject
+{
+    Q_OBJECT
+
+public:
+    CServerAdmin ( CServer* pNServer );
+
+    bool Start ( const QString& strSocketName );
+
+    // tick timing histograms (also used for the offline simulation)
+    QJsonObject GetTimingJson();
+
+protected:
+    QJsonObject GetServerJson();
+    QJsonArray  GetChannelsJson();
+    QJsonObject GetRecorderJson();
+
+    QByteArray ProcessCommand ( const QString& strCommand );
+
+    static QJsonObject HistogramToJson ( const CTimingHistogram& Hist );
+
+    CServer*          pServer;
+    QLocalServer      LocalServer;
+    QTimer            TimerRate;
+
+    // packet rates of the channels, calculated from the packet counters
+    CVector<uint32_t> veciPrevRecPackets;
+    CVector<uint32_t> veciPrevSentPackets;
+    CVector<double>   vecdRecPacketRate;
+    CVector<double>   vecdSentPacketRate;
+
+public slots:
+    void OnNewConnection();
+    void OnReadyRead();
+    void OnTimerRate();
+};
@@ -33,6 +33,9 @@ CServerListManager::CServerListManager ( const quint16  iNPortNum,
                                          CProtocol*     pNConLProt )
     : tsConsoleStream           ( *( ( new ConsoleWriterFactory() )->get() ) ),
       iNumPredefinedServers     ( 0 ),
+      bServerListMesValid       ( false ),
+      bNatPunchTimerActive      ( false ),
+      iNumDroppedNatPunches     ( 0 ),
       eCentralServerAddressType ( AT_CUSTOM ), // must be AT_CUSTOM for the "no GUI" case
       bCentServPingServerInList ( bNCentServPingServerInList ),
       pConnLessProtocol         ( pNConLProt ),
@@ -149,8 +152,9 @@ CServerListManager::CServerListManager ( const quint16  iNPortNum,
                 iCountry );
         }
 
-        // add the new server to the server list
-        ServerList.append ( NewServerListEntry );
+        // add the new server to the server list (predefined servers never
+        // expire)
+        AddServer ( NewServerListEntry );
 
         // we have used four items and have created one predefined server
         // (adjust counters)
@@ -171,6 +175,9 @@ CServerListManager::CServerListManager ( const quint16  iNPortNum,
     TimerCLRegisterServerResp.setSingleShot ( true );
     TimerCLRegisterServerResp.setInterval ( REGISTER_SERVER_TIME_OUT_MS );
 
+    TimerNatPunch.setInterval ( SERVLIST_NAT_PUNCH_INTERVAL_MS );
+    NatPunchClock.start();
+
 
     // Connections -------------------------------------------------------------
     QObject::connect ( &TimerPollList, &QTimer::timeout,
@@ -187,6 +194,9 @@ CServerListManager::CServerListManager ( const quint16  iNPortNum,
 
     QObject::connect ( &TimerCLRegisterServerResp, &QTimer::timeout,
         this, &CServerListManager::OnTimerCLRegisterServerResp );
+
+    QObject::connect ( &TimerNatPunch, &QTimer::timeout,
+        this, &CServerListManager::OnTimerNatPunch );
 }
 
 void CServerListManager::SetCentralServerAddress ( const QString sNCentServAddr )
@@ -274,6 +284,9 @@ void CServerListManager::Update()
         if ( bIsCentralServer )
         {
             TimerPollList.stop();
+            TimerNatPunch.stop();
+            bNatPunchTimerActive = false;
+            NatPunchTargets.clear();
 
             if ( bCentServPingServerInList )
             {
@@ -312,28 +325,31 @@ void CServerListManager::OnTimerPollList()
 
     QMutexLocker locker ( &Mutex );
 
-    // Check all list entries except of the very first one (which is the central
-    // server entry) and the predefined servers if they are still valid.
-    // Note that we have to use "ServerList.size()" function in the for loop
-    // since we may remove elements from the server list inside the for loop.
-    for ( int iIdx = 1 + iNumPredefinedServers; iIdx < ServerList.size(); )
+    QElapsedTimer CurTime;
+    CurTime.start();
+
+    // The registrations are queued in the order of their time stamps,
+    // therefore only the expired ones at the head of the queue have to be
+    // checked. The very first entry (which is the central server entry) and
+    // the predefined servers are never in the queue.
+    // 1 minute = 60 * 1000 ms
+    while ( !ExpiryQueue.isEmpty() &&
+            ( CurTime.msecsSinceReference() - ExpiryQueue.head().second > SERVLIST_TIME_OUT_MINUTES * 60000 ) )
     {
-        // 1 minute = 60 * 1000 ms
-        if ( ServerList[iIdx].RegisterTime.elapsed() > ( SERVLIST_TIME_OUT_MINUTES * 60000 ) )
+        const QPair<CHostAddress, qint64> Registration = ExpiryQueue.dequeue();
+        const int                         iIdx         = FindServer ( Registration.first );
+
+        // the server may have been unregistered or registered again in the
+        // meantime, only remove it if this is its latest registration
+        if ( ( iIdx > iNumPredefinedServers ) &&
+             ( ServerList[iIdx].GetRegistrationStamp() == Registration.second ) )
         {
             // remove this list entry
             vecRemovedHostAddr.Add ( ServerList[iIdx].HostAddr );
-            ServerList.removeAt ( iIdx );
-        }
-        else
-        {
-            // move to the next entry (only on else)
-            iIdx++;
+            RemoveServer ( iIdx );
         }
     }
 
-    locker.unlock();
-
     foreach ( const CHostAddress HostAddr, vecRemovedHostAddr )
     {
         tsConsoleStream << "Expired entry for " << HostAddr.toString() << endl;
@@ -346,39 +362,29 @@ void CServerListManager::CentralServerRegisterServer ( const CHostAddress&    In
 {
     if ( bIsCentralServer && bEnabled )
     {
+        // the lock also protects the console stream since the messages may
+        // be processed in different threads
+        QMutexLocker locker ( &Mutex );
+
         tsConsoleStream << "Requested to register entry for "
                         << InetAddr.toString() << " (" << LInetAddr.toString() << ")"
                         << ": " << ServerInfo.strName << endl;
 
-        QMutexLocker locker ( &Mutex );
-
-        const int iCurServerListSize = ServerList.size();
-
         // Check if server is already registered.
-        // The very first list entry must not be checked since
-        // this is per definition the central server (i.e., this server)
-        int iSelIdx = INVALID_INDEX; // initialize with an illegal value
-        for ( int iIdx = 1; iIdx < iCurServerListSize; iIdx++ )
-        {
-            if ( ServerList[iIdx].HostAddr == InetAddr )
-            {
-                // store entry index
-                iSelIdx = iIdx;
-
-                // entry found, leave for-loop
-                continue;
-            }
-        }
+        // The very first list entry is not in the index since this is per
+        // definition the central server (i.e., this server)
+        int iSelIdx = FindServer ( InetAddr );
 
         // if server is not yet registered, we have to create a new entry
         if ( iSelIdx == INVALID_INDEX )
         {
             // check for maximum allowed number of servers in the server list
-            if ( iCurServerListSize < MAX_NUM_SERVERS_IN_SERVER_LIST )
+            if ( ServerList.size() < MAX_NUM_SERVERS_IN_SERVER_LIST )
             {
                 // create a new server list entry and init with received data
-                ServerList.append ( CServerListEntry ( InetAddr, LInetAddr, ServerInfo ) );
-                iSelIdx = iCurServerListSize;
+                AddServer ( CServerListEntry ( InetAddr, LInetAddr, ServerInfo ) );
+                iSelIdx = ServerList.size() - 1;
+                QueueExpiry ( iSelIdx );
             }
         }
         else
@@ -386,6 +392,18 @@ void CServerListManager::CentralServerRegisterServer ( const CHostAddress&    In
             // do not update the information in the predefined servers
             if ( iSelIdx > iNumPredefinedServers )
             {
+                // most registrations are only refreshes of an unchanged entry
+                // which do not require a new server list message
+                if ( !( ServerList[iSelIdx].LHostAddr == LInetAddr ) ||
+                     ( ServerList[iSelIdx].strName          != ServerInfo.strName ) ||
+                     ( ServerList[iSelIdx].eCountry         != ServerInfo.eCountry ) ||
+                     ( ServerList[iSelIdx].strCity          != ServerInfo.strCity ) ||
+                     ( ServerList[iSelIdx].iMaxNumClients   != ServerInfo.iMaxNumClients ) ||
+                     ( ServerList[iSelIdx].bPermanentOnline != ServerInfo.bPermanentOnline ) )
+                {
+                    InvalidateServerListMes();
+                }
+
                 // update all data and call update registration function
                 ServerList[iSelIdx].LHostAddr        = LInetAddr;
                 ServerList[iSelIdx].strName          = ServerInfo.strName;
@@ -395,6 +413,7 @@ void CServerListManager::CentralServerRegisterServer ( const CHostAddress&    In
                 ServerList[iSelIdx].bPermanentOnline = ServerInfo.bPermanentOnline;
 
                 ServerList[iSelIdx].UpdateRegistration();
+                QueueExpiry ( iSelIdx );
             }
         }
 
@@ -408,85 +427,335 @@ void CServerListManager::CentralServerUnregisterServer ( const CHostAddress& Ine
 {
     if ( bIsCentralServer && bEnabled )
     {
-        tsConsoleStream << "Requested to unregister entry for "
-                        << InetAddr.toString() << endl;
-
         QMutexLocker locker ( &Mutex );
 
-        const int iCurServerListSize = ServerList.size();
+        tsConsoleStream << "Requested to unregister entry for "
+                        << InetAddr.toString() << endl;
 
         // Find the server to unregister in the list. The very first list entry
-        // must not be checked since this is per definition the central server
-        // (i.e., this server), also the predefined servers must not be checked.
-        for ( int iIdx = 1 + iNumPredefinedServers; iIdx < iCurServerListSize; iIdx++ )
+        // is not in the index since this is per definition the central server
+        // (i.e., this server), also the predefined servers must not be removed.
+        const int iIdx = FindServer ( InetAddr );
+
+        if ( iIdx > iNumPredefinedServers )
         {
-            if ( ServerList[iIdx].HostAddr == InetAddr )
-            {
-                // remove this list entry
-                ServerList.removeAt ( iIdx );
-
-                // entry found, leave for-loop (it is important to exit the
-                // for loop since when we remove an item from the server list,
-                // "iCurServerListSize" is not correct anymore and we could get
-                // a segmentation fault)
-                break;
-            }
+            // remove this list entry (its queued registration is skipped when
+            // it expires)
+            RemoveServer ( iIdx );
         }
     }
 }
 
 void CServerListManager::CentralServerQueryServerList ( const CHostAddress& InetAddr )
 {
-    QMutexLocker locker ( &Mutex );
+    CVector<uint8_t>    vecServerListMesCopy;
+    QList<CHostAddress> vecNatPunchServers;
 
-    if ( bIsCentralServer && bEnabled )
     {
+        // the list requests are processed by several threads in parallel, so
+        // the lock is only held for taking a copy of the message and for
+        // queueing the NAT requests, the messages are sent without it
+        QMutexLocker locker ( &Mutex );
+
+        if ( !( bIsCentralServer && bEnabled ) )
+        {
+            return;
+        }
+
         const int iCurServerListSize = ServerList.size();
 
-        // allocate memory for the entire list
-        CVector<CServerInfo> vecServerInfo ( iCurServerListSize );
+        UpdateServerListMes();
+        vecServerListMesCopy = vecServerListMes;
 
-        // copy the list (we have to copy it since the message requires
-        // a vector but the list is actually stored in a QList object and
-        // not in a vector object
-        for ( int iIdx = 0; iIdx < iCurServerListSize; iIdx++ )
+        // the very first list entry is this server (central server) per
+        // definition and is therefore skipped
+        for ( int iIdx = 1; iIdx < iCurServerListSize; iIdx++ )
         {
-            // copy list item
-            vecServerInfo[iIdx] = ServerList[iIdx];
-
-            if ( iIdx > 0 )
+            // check if the address of the client which is requesting the
+            // list is the same address as one server in the list -> in this
+            // case he has to connect to the local host address and port
+            // to allow for NAT.
+            if ( ServerList[iIdx].HostAddr.InetAddr == InetAddr.InetAddr )
             {
-                // check if the address of the client which is requesting the
-                // list is the same address as one server in the list -> in this
-                // case he has to connect to the local host address and port
-                // to allow for NAT.
-                if ( vecServerInfo[iIdx].HostAddr.InetAddr == InetAddr.InetAddr )
+                // for a predefined server:
+                // - LHostAddr and HostAddr are the same
+                // - no local port number is supplied
+                // otherwise, use the supplied details
+                if ( iIdx > iNumPredefinedServers )
                 {
-                    // for a predefined server:
-                    // - LHostAddr and HostAddr are the same
-                    // - no local port number is supplied
-                    // otherwise, use the supplied details
-                    if ( iIdx > iNumPredefinedServers )
-                    {
-                        vecServerInfo[iIdx].HostAddr = ServerList[iIdx].LHostAddr;
-                    }
+                    pConnLessProtocol->SetCLServerListMesAddress ( vecServerListMesCopy,
+                                                                   veciServerListMesAddrPos[iIdx],
+                                                                   ServerList[iIdx].LHostAddr );
                 }
-                else
+            }
+            else
+            {
+                // create "send empty message" for all registered servers
+                // (except of the very first list entry since this is this
+                // server (central server) per definition) and also it is
+                // not required to send this message, if the server is on
+                // the same computer
+                if ( QueueNatPunch ( ServerList[iIdx].HostAddr, InetAddr ) )
                 {
-                    // create "send empty message" for all registered servers
-                    // (except of the very first list entry since this is this
-                    // server (central server) per definition) and also it is
-                    // not required to send this message, if the server is on
-                    // the same computer
-                    pConnLessProtocol->CreateCLSendEmptyMesMes ( 
-                        vecServerInfo[iIdx].HostAddr,
-                        InetAddr );
+                    vecNatPunchServers.append ( ServerList[iIdx].HostAddr );
                 }
             }
         }
+    }
+
+    for ( int i = 0; i < vecNatPunchServers.size(); i++ )
+    {
+        pConnLessProtocol->CreateCLSendEmptyMesMes ( vecNatPunchServers[i], InetAddr );
+    }
+
+    // send the server list to the client
+    pConnLessProtocol->SendCLMessageFrame ( InetAddr, vecServerListMesCopy );
+}
+
+void CServerListManager::UpdateServerListMes()
+{
+    if ( bServerListMesValid )
+    {
+        return;
+    }
+
+    const int iCurServerListSize = ServerList.size();
+
+    // allocate memory for the entire list
+    CVector<CServerInfo> vecServerInfo ( iCurServerListSize );
+
+    // copy the list (we have to copy it since the message requires
+    // a vector but the list is actually stored in a QList object and
+    // not in a vector object
+    for ( int iIdx = 0; iIdx < iCurServerListSize; iIdx++ )
+    {
+        vecServerInfo[iIdx] = ServerList[iIdx];
+    }
+
+    pConnLessProtocol->GenCLServerListMesFrame ( vecServerListMes,
+                                                 veciServerListMesAddrPos,
+                                                 vecServerInfo );
+
+    bServerListMesValid = true;
+}
+
+bool CServerListManager::QueueNatPunch ( const CHostAddress& ServerAddr,
+                                         const CHostAddress& ClientAddr )
+{
+    const QPair<CHostAddress, CHostAddress> NatPunch ( ServerAddr, ClientAddr );
+    const qint64                            iCurTime = NatPunchClock.elapsed();
+
+    ExpireNatPunchTimes ( iCurTime );
+
+    // a client which requests the list again shortly after does not need a
+    // new request since the NAT of the server is still open for it
+    if ( NatPunchTime.contains ( NatPunch ) )
+    {
+        return false;
+    }
+
+    NatPunchTime.insert ( NatPunch, iCurTime );
+    NatPunchHistory.enqueue ( qMakePair ( NatPunch, iCurTime ) );
+
+    CNatPunchTarget& Target = NatPunchTargets[ServerAddr];
+
+    if ( iCurTime - Target.iIntervalStartTime >= SERVLIST_NAT_PUNCH_INTERVAL_MS )
+    {
+        Target.iIntervalStartTime = iCurTime;
+        Target.iNumSentInInterval = 0;
+    }
+
+    // the request is sent right away if the server has not got the maximum
+    // number of requests in the current interval
+    if ( Target.PendingClients.isEmpty() &&
+         ( Target.iNumSentInInterval < SERVLIST_NAT_PUNCH_MAX_PER_INTERVAL ) )
+    {
+        Target.iNumSentInInterval++;
+        return true;
+    }
+
+    // if the queue of the server is full, the oldest request is dropped since
+    // its client has most probably given up already
+    if ( Target.PendingClients.size() >= SERVLIST_NAT_PUNCH_MAX_QUEUE_LEN )
+    {
+        DropNatPunch ( ServerAddr, Target.PendingClients.dequeue() );
+    }
+
+    Target.PendingClients.enqueue ( qMakePair ( ClientAddr, iCurTime ) );
+
+    // the timer sends the waiting request (the timer is started by the event
+    // loop since the requests may be processed in other threads)
+    if ( !bNatPunchTimerActive )
+    {
+        bNatPunchTimerActive = true;
+        QMetaObject::invokeMethod ( &TimerNatPunch, "start" );
+    }
+
+    return false;
+}
+
+bool CServerListManager::SendNatPunches ( const CHostAddress& ServerAddr,
+                                          CNatPunchTarget&    Target,
+                                          const qint64        iCurTime )
+{
+    if ( iCurTime - Target.iIntervalStartTime >= SERVLIST_NAT_PUNCH_INTERVAL_MS )
+    {
+        Target.iIntervalStartTime = iCurTime;
+        Target.iNumSentInInterval = 0;
+    }
+
+    while ( !Target.PendingClients.isEmpty() &&
+            ( Target.iNumSentInInterval < SERVLIST_NAT_PUNCH_MAX_PER_INTERVAL ) )
+    {
+        const QPair<CHostAddress, qint64> Entry = Target.PendingClients.dequeue();
+
+        if ( iCurTime - Entry.second > SERVLIST_NAT_PUNCH_MAX_WAIT_MS )
+        {
+            DropNatPunch ( ServerAddr, Entry );
+            continue;
+        }
+
+        pConnLessProtocol->CreateCLSendEmptyMesMes ( ServerAddr, Entry.first );
+        Target.iNumSentInInterval++;
+    }
 
-        // send the server list to the client
-        pConnLessProtocol->CreateCLServerListMes ( InetAddr, vecServerInfo );
+    // returns true if requests are still waiting
+    return !Target.PendingClients.isEmpty();
+}
+
+void CServerListManager::DropNatPunch ( const CHostAddress&                ServerAddr,
+                                        const QPair<CHostAddress, qint64>& Entry )
+{
+    const QPair<CHostAddress, CHostAddress> NatPunch ( ServerAddr, Entry.first );
+
+    // the request was not sent, so a new request of the same client must not
+    // be skipped as a duplicate
+    if ( NatPunchTime.value ( NatPunch, -1 ) == Entry.second )
+    {
+        NatPunchTime.remove ( NatPunch );
+    }
+
+    iNumDroppedNatPunches++;
+}
+
+void CServerListManager::ExpireNatPunchTimes ( const qint64 iCurTime )
+{
+    // remove the expired times (a pair which was dropped and requested again
+    // in the meantime has a newer time which is kept)
+    while ( !NatPunchHistory.isEmpty() &&
+            ( iCurTime - NatPunchHistory.head().second >= SERVLIST_NAT_PUNCH_DEDUP_TIME_MS ) )
+    {
+        const QPair<QPair<CHostAddress, CHostAddress>, qint64> Entry = NatPunchHistory.dequeue();
+
+        if ( NatPunchTime.value ( Entry.first, -1 ) == Entry.second )
+        {
+            NatPunchTime.remove ( Entry.first );
+        }
+    }
+}
+
+void CServerListManager::OnTimerNatPunch()
+{
+    QMutexLocker locker ( &Mutex );
+
+    const qint64 iCurTime   = NatPunchClock.elapsed();
+    bool         bIsWaiting = false;
+
+    // send the waiting requests of each server within its limit, the servers
+    // without waiting requests are removed
+    QMutableHashIterator<CHostAddress, CNatPunchTarget> it ( NatPunchTargets );
+
+    while ( it.hasNext() )
+    {
+        it.next();
+
+        if ( SendNatPunches ( it.key(), it.value(), iCurTime ) )
+        {
+            bIsWaiting = true;
+        }
+        else if ( iCurTime - it.value().iIntervalStartTime >= SERVLIST_NAT_PUNCH_INTERVAL_MS )
+        {
+            it.remove();
+        }
+    }
+
+    if ( !bIsWaiting )
+    {
+        TimerNatPunch.stop();
+        bNatPunchTimerActive = false;
+    }
+}
+
+void CServerListManager::AddServer ( const CServerListEntry& NewEntry )
+{
+    ServerList.append ( NewEntry );
+    InvalidateServerListMes();
+
+    // if the same address is given twice, the first entry is used
+    if ( !ServerIndex.contains ( NewEntry.HostAddr ) )
+    {
+        ServerIndex.insert ( NewEntry.HostAddr, ServerList.size() - 1 );
+    }
+}
+
+void CServerListManager::RemoveServer ( const int iIdx )
+{
+    const int iLastIdx = ServerList.size() - 1;
+
+    ServerIndex.remove ( ServerList[iIdx].HostAddr );
+
+    // the waiting NAT punch requests to this server are not sent anymore
+    if ( NatPunchTargets.contains ( ServerList[iIdx].HostAddr ) )
+    {
+        const CNatPunchTarget Target = NatPunchTargets.take ( ServerList[iIdx].HostAddr );
+
+        for ( int i = 0; i < Target.PendingClients.size(); i++ )
+        {
+            DropNatPunch ( ServerList[iIdx].HostAddr, Target.PendingClients[i] );
+        }
+    }
+
+    // the order of the registered servers does not matter, therefore the last
+    // entry is moved to the free position so that no other entries have to be
+    // moved and re-indexed (the own server and the predefined servers at the
+    // beginning of the list are never removed)
+    if ( iIdx != iLastIdx )
+    {
+        ServerList[iIdx] = ServerList[iLastIdx];
+        ServerIndex.insert ( ServerList[iIdx].HostAddr, iIdx );
+    }
+
+    ServerList.removeLast();
+    InvalidateServerListMes();
+}
+
+void CServerListManager::QueueExpiry ( const int iIdx )
+{
+    ExpiryQueue.enqueue ( qMakePair ( ServerList[iIdx].HostAddr,
+                                      ServerList[iIdx].GetRegistrationStamp() ) );
+
+    if ( ExpiryQueue.size() > SERVLIST_MAX_EXPIRY_QUEUE_LEN )
+    {
+        // rebuild the queue with only the latest registration of each server
+        QList<QPair<qint64, CHostAddress> > vecRegistrations;
+
+        for ( int i = 1 + iNumPredefinedServers; i < ServerList.size(); i++ )
+        {
+            vecRegistrations.append ( qMakePair ( ServerList[i].GetRegistrationStamp(),
+                                                  ServerList[i].HostAddr ) );
+        }
+
+        std::sort ( vecRegistrations.begin(), vecRegistrations.end(),
+                    [] ( const QPair<qint64, CHostAddress>& A, const QPair<qint64, CHostAddress>& B )
+                    { return A.first < B.first; } );
+
+        ExpiryQueue.clear();
+
+        for ( int i = 0; i < vecRegistrations.size(); i++ )
+        {
+            ExpiryQueue.enqueue ( qMakePair ( vecRegistrations[i].second,
+                                              vecRegistrations[i].first ) );
+        }
     }
 }
 
@@ -62,6 +62,9 @@ private network.
 #include <QObject>
 #include <QLocale>
 #include <QList>
+#include <QHash>
+#include <QQueue>
+#include <QPair>
 #include <QElapsedTimer>
 #include <QMutex>
 #include "global.h"
@@ -69,6 +72,29 @@ private network.
 #include "protocol.h"
 
 
+/* Definitions ****************************************************************/
+// if the expiry queue gets longer than this (because of frequent registrations
+// of the same servers), the outdated registrations are removed from it
+#define SERVLIST_MAX_EXPIRY_QUEUE_LEN    ( 4 * MAX_NUM_SERVERS_IN_SERVER_LIST )
+
+// the requests to a registered server to send an empty message to a client
+// (for opening the NAT) are sent right away up to a limited number per
+// interval, further requests to this server are queued until the next
+// interval, a server is asked only once within the dedup time for the same
+// client
+#define SERVLIST_NAT_PUNCH_INTERVAL_MS       20
+#define SERVLIST_NAT_PUNCH_MAX_PER_INTERVAL  5 // per server, i.e. 250 messages per second
+#define SERVLIST_NAT_PUNCH_DEDUP_TIME_MS     15000
+
+// a request which waited longer than this time is useless since the client
+// has already given up pinging the server, the queue length of a server is
+// limited to the number of requests which can be sent in this time (if the
+// queue is full, the oldest request is dropped)
+#define SERVLIST_NAT_PUNCH_MAX_WAIT_MS       1000
+#define SERVLIST_NAT_PUNCH_MAX_QUEUE_LEN     ( SERVLIST_NAT_PUNCH_MAX_WAIT_MS / SERVLIST_NAT_PUNCH_INTERVAL_MS * \
+                                               SERVLIST_NAT_PUNCH_MAX_PER_INTERVAL )
+
+
 /* Classes ********************************************************************/
 class CServerListEntry : public CServerInfo
 {
@@ -111,11 +137,27 @@ public:
 
     void UpdateRegistration() { RegisterTime.start(); }
 
+    // time stamp of the registration which identifies it in the expiry queue
+    qint64 GetRegistrationStamp() const { return RegisterTime.msecsSinceReference(); }
+
 public:
     // time on which the entry was registered
     QElapsedTimer RegisterTime;
 };
 
+// NAT punch requests to one registered server: the number of requests which
+// were sent in the current interval and the queue of the waiting clients with
+// their queue time
+class CNatPunchTarget
+{
+public:
+    CNatPunchTarget() : iIntervalStartTime ( 0 ), iNumSentInInterval ( 0 ) {}
+
+    qint64                               iIntervalStartTime;
+    int                                  iNumSentInInterval;
+    QQueue<QPair<CHostAddress, qint64> > PendingClients;
+};
+
 class CServerListManager : public QObject
 {
     Q_OBJECT
@@ -155,41 +197,90 @@ public:
 
     // set server infos -> per definition the server info of this server is
     // stored in the first entry of the list, we assume here that the first
-    // entry is correctly created in the constructor of the class
+    // entry is correctly created in the constructor of the class (the list
+    // is also accessed by the threads processing the connection less
+    // messages, therefore the mutex is required)
     void SetServerName ( const QString& strNewName )
-        { ServerList[0].strName = strNewName; }
+        { QMutexLocker locker ( &Mutex ); ServerList[0].strName = strNewName; InvalidateServerListMes(); }
 
-    QString GetServerName() { return ServerList[0].strName; }
+    QString GetServerName() { QMutexLocker locker ( &Mutex ); return ServerList[0].strName; }
 
     void SetServerCity ( const QString& strNewCity )
-        { ServerList[0].strCity = strNewCity; }
+        { QMutexLocker locker ( &Mutex ); ServerList[0].strCity = strNewCity; InvalidateServerListMes(); }
 
-    QString GetServerCity() { return ServerList[0].strCity; }
+    QString GetServerCity() { QMutexLocker locker ( &Mutex ); return ServerList[0].strCity; }
 
     void SetServerCountry ( const QLocale::Country eNewCountry )
-        { ServerList[0].eCountry = eNewCountry; }
+        { QMutexLocker locker ( &Mutex ); ServerList[0].eCountry = eNewCountry; InvalidateServerListMes(); }
 
-    QLocale::Country GetServerCountry() { return ServerList[0].eCountry; }
+    QLocale::Country GetServerCountry() { QMutexLocker locker ( &Mutex ); return ServerList[0].eCountry; }
 
     ESvrRegStatus GetSvrRegStatus() { return eSvrRegStatus; }
 
+    int GetNumDroppedNatPunches() { QMutexLocker locker ( &Mutex ); return iNumDroppedNatPunches; }
+
     void StoreRegistrationResult ( ESvrRegResult eStatus );
 
 protected:
     void SlaveServerRegisterServer ( const bool bIsRegister );
     void SetSvrRegStatus ( ESvrRegStatus eNSvrRegStatus );
 
+    int  FindServer ( const CHostAddress& InetAddr ) const
+        { return ServerIndex.value ( InetAddr, INVALID_INDEX ); }
+
+    void AddServer ( const CServerListEntry& NewEntry );
+    void RemoveServer ( const int iIdx );
+    void QueueExpiry ( const int iIdx );
+
+    void InvalidateServerListMes() { bServerListMesValid = false; }
+
+    // returns true if the request must be sent right away by the caller
+    bool QueueNatPunch ( const CHostAddress& ServerAddr,
+                         const CHostAddress& ClientAddr );
+    bool SendNatPunches ( const CHostAddress& ServerAddr,
+                          CNatPunchTarget&    Target,
+                          const qint64        iCurTime );
+    void DropNatPunch ( const CHostAddress&                ServerAddr,
+                        const QPair<CHostAddress, qint64>& Entry );
+    void ExpireNatPunchTimes ( const qint64 iCurTime );
+    void UpdateServerListMes();
+
     QTimer                  TimerPollList;
     QTimer                  TimerRegistering;
     QTimer                  TimerPingServerInList;
     QTimer                  TimerPingCentralServer;
     QTimer                  TimerCLRegisterServerResp;
+    QTimer                  TimerNatPunch;
 
     QMutex                  Mutex;
     QTextStream&            tsConsoleStream;
 
     QList<CServerListEntry> ServerList;
 
+    // index of the server list entries by their address (the own server is
+    // not included) and queue of the registrations in the order in which they
+    // expire, an entry which was registered again in the meantime is skipped
+    // when its old registration is taken from the queue
+    QHash<CHostAddress, int>             ServerIndex;
+    QQueue<QPair<CHostAddress, qint64> > ExpiryQueue;
+
+    // the server list message is only generated again if the list has changed,
+    // the stored address positions are used to replace the address of a server
+    // which is behind the same NAT as the requesting client
+    CVector<uint8_t>        vecServerListMes;
+    CVector<int>            veciServerListMesAddrPos;
+    bool                    bServerListMesValid;
+
+    // NAT punch requests per registered server, the time of the latest
+    // request per pair (server address, client address) and the history for
+    // expiring these times, the timer only runs while requests are waiting
+    QHash<CHostAddress, CNatPunchTarget>                         NatPunchTargets;
+    QHash<QPair<CHostAddress, CHostAddress>, qint64>             NatPunchTime;
+    QQueue<QPair<QPair<CHostAddress, CHostAddress>, qint64> >    NatPunchHistory;
+    QElapsedTimer                                                NatPunchClock;
+    bool                                                         bNatPunchTimerActive;
+    int                                                          iNumDroppedNatPunches;
+
     QString                 strCentralServerAddress;
     int                     iNumPredefinedServers;
     bool                    bEnabled;
@@ -213,8 +304,10 @@ public slots:
     void OnTimerPingServerInList();
     void OnTimerPingCentralServer();
     void OnTimerCLRegisterServerResp();
+    void OnTimerNatPunch();
     void OnTimerRegistering() { SlaveServerRegisterServer ( true ); }
-    void OnTimerIsPermanent() { ServerList[0].bPermanentOnline = true; }
+    void OnTimerIsPermanent()
+        { QMutexLocker locker ( &Mutex ); ServerList[0].bPermanentOnline = true; InvalidateServerListMes(); }
 
 signals:
     void SvrRegStatusChanged();
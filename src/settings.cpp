@@ -267,6 +267,12 @@ void CSettings::Load()
             pClient->SetEnableOPUS64 ( bValue );
         }
 
+        // enable packet redundancy setting
+        if ( GetFlagIniSet ( IniXMLDocument, "client", "enableredundancy", bValue ) )
+        {
+            pClient->SetEnableRedundancy ( bValue );
+        }
+
         // GUI design
         if ( GetNumericIniSet ( IniXMLDocument, "client", "guidesign",
              0, 2 /* GD_SLIMFADER */, iValue ) )
@@ -575,6 +581,10 @@ void CSettings::Save()
         SetFlagIniSet ( IniXMLDocument, "client", "enableopussmall",
             pClient->GetEnableOPUS64() );
 
+        // enable packet redundancy setting
+        SetFlagIniSet ( IniXMLDocument, "client", "enableredundancy",
+            pClient->GetEnableRedundancy() );
+
         // GUI design
         SetNumericIniSet ( IniXMLDocument, "client", "guidesign",
             static_cast<int> ( pClient->GetGUIDesign() ) );
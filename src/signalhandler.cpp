@@ -147,6 +147,7 @@ CSignalUnix::CSignalUnix ( CSignalHandler* nPSignalHandler ) :
 
         setSignalHandled ( SIGUSR1, true );
         setSignalHandled ( SIGUSR2, true );
+        setSignalHandled ( SIGQUIT, true );
         setSignalHandled ( SIGINT, true );
         setSignalHandled ( SIGTERM, true );
     }
@@ -155,6 +156,7 @@ CSignalUnix::CSignalUnix ( CSignalHandler* nPSignalHandler ) :
 CSignalUnix::~CSignalUnix() {
     setSignalHandled ( SIGUSR1, false );
     setSignalHandled ( SIGUSR2, false );
+    setSignalHandled ( SIGQUIT, false );
     setSignalHandled ( SIGINT, false );
     setSignalHandled ( SIGTERM, false );
 }
@@ -0,0 +1,752 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#include "simulation.h"
+
+
+/* Implementation *************************************************************/
+CSimulation::CSimulation ( const bool   bNUseDoubleSystemFrameSize,
+                           QTextStream& tsNConsole ) :
+    tsConsole ( tsNConsole ),
+    Server    ( this, bNUseDoubleSystemFrameSize )
+{
+    iServerFrameSizeSamples = Server.GetServerFrameSizeSamples();
+
+    vecChanToClient.Init ( MAX_NUM_CHANNELS, INVALID_INDEX );
+}
+
+CSimulation::~CSimulation()
+{
+    for ( int i = 0; i < vecpClients.Size(); i++ )
+    {
+        CloseOutput ( vecpClients[i] );
+
+        if ( vecpClients[i]->InOpusEncoder != nullptr )
+        {
+            opus_custom_encoder_destroy ( vecpClients[i]->InOpusEncoder );
+            opus_custom_mode_destroy ( vecpClients[i]->InOpusMode );
+        }
+
+        delete vecpClients[i];
+    }
+}
+
+void CSimulation::Run ( const QString& strConfigFileName,
+                        const QString& strOutputDirName )
+{
+    if ( !ReadConfigFile ( strConfigFileName ) )
+    {
+        throw CGenErr ( "The simulation configuration file could not be read or "
+            "one of the client files is invalid." );
+    }
+
+    // the decoded mixes are only written if an output directory is given
+    if ( !strOutputDirName.isEmpty() )
+    {
+        const QDir OutputDir ( strOutputDirName );
+
+        if ( !OutputDir.mkpath ( "." ) )
+        {
+            throw CGenErr ( "The simulation output directory could not be created." );
+        }
+
+        for ( int i = 0; i < vecpClients.Size(); i++ )
+        {
+            OpenOutput ( vecpClients[i], OutputDir );
+        }
+    }
+
+    tsConsole << "- simulation of " << vecpClients.Size() << " clients with " <<
+        iServerFrameSizeSamples << " samples frame size" << endl;
+
+    const qint64  iTicksPerSec   = SYSTEM_SAMPLE_RATE_HZ / iServerFrameSizeSamples;
+    qint64        iTick          = 0;
+    bool          bClientsActive = true;
+    QElapsedTimer ElapsedTimer;
+
+    ElapsedTimer.start();
+
+    while ( bClientsActive )
+    {
+        // each client has its own encoder and random generator, therefore the
+        // packets of the clients can be created in parallel
+#ifdef USE_OMP
+# pragma omp parallel for
+#endif
+        for ( int i = 0; i < vecpClients.Size(); i++ )
+        {
+            SendPackets ( vecpClients[i], iTick );
+        }
+
+        // the server gets the arrived packets always in the same order
+        for ( int i = 0; i < vecpClients.Size(); i++ )
+        {
+            DeliverPackets ( vecpClients[i], iTick );
+        }
+
+        // the tick of the server timer
+        Server.OnTimer();
+
+        bClientsActive = false;
+
+        for ( int i = 0; i < vecpClients.Size(); i++ )
+        {
+            UpdateStatistics ( vecpClients[i] );
+
+            if ( !vecpClients[i]->bInputDone || !vecpClients[i]->mapInFlight.empty() )
+            {
+                bClientsActive = true;
+            }
+        }
+
+        iTick++;
+
+        if ( iTick % SIM_PROCESS_EVENTS_INTERVAL == 0 )
+        {
+            QCoreApplication::processEvents();
+        }
+
+        if ( iTick % ( SIM_PROGRESS_INTERVAL_SEC * iTicksPerSec ) == 0 )
+        {
+            tsConsole << "- simulated " << iTick / iTicksPerSec << " s in " <<
+                ElapsedTimer.elapsed() / 1000 << " s" << endl;
+        }
+    }
+
+    const qint64 iElapsedMs = std::max ( static_cast<qint64> ( 1 ), ElapsedTimer.elapsed() );
+
+    for ( int i = 0; i < vecpClients.Size(); i++ )
+    {
+        const CSimClient* pClient = vecpClients[i];
+
+        tsConsole << QString ( "  %1: sent %2, lost %3, server rec %4, underruns %5, "
+                               "overruns %6, jitbuf %7, mix %8" ).
+            arg ( pClient->strName ).
+            arg ( pClient->iNumSentPackets ).
+            arg ( pClient->iNumLostPackets ).
+            arg ( pClient->iChanRecPackets ).
+            arg ( pClient->iChanUnderruns ).
+            arg ( pClient->iChanOverruns ).
+            arg ( pClient->iChanJitBufFrames ).
+            arg ( pClient->iNumRecPackets ) << endl;
+    }
+
+    tsConsole << QString ( "- simulated %1 s in %2 s (%3 times real time)" ).
+        arg ( static_cast<double> ( iTick ) / iTicksPerSec, 0, 'f', 1 ).
+        arg ( iElapsedMs / 1000.0, 0, 'f', 1 ).
+        arg ( 1000.0 * iTick / iTicksPerSec / iElapsedMs, 0, 'f', 1 ) << endl;
+
+    for ( int i = 0; i < vecpClients.Size(); i++ )
+    {
+        CloseOutput ( vecpClients[i] );
+    }
+
+    if ( !strOutputDirName.isEmpty() )
+    {
+        WriteStatistics ( QDir ( strOutputDirName ).absoluteFilePath ( "statistics.json" ),
+                          iTick,
+                          iElapsedMs );
+    }
+}
+
+bool CSimulation::ReadConfigFile ( const QString& strConfigFileName )
+{
+    QFile ConfigFile ( strConfigFileName );
+
+    if ( !ConfigFile.open ( QIODevice::ReadOnly | QIODevice::Text ) )
+    {
+        return false;
+    }
+
+    // the client files are relative to the configuration file
+    const QDir   ConfigDir    = QFileInfo ( strConfigFileName ).absoluteDir();
+    const double dTicksPerSec = static_cast<double> ( SYSTEM_SAMPLE_RATE_HZ ) / iServerFrameSizeSamples;
+    QTextStream  in ( &ConfigFile );
+
+    while ( !in.atEnd() )
+    {
+        const QString strLine = in.readLine().trimmed();
+
+        if ( strLine.isEmpty() || strLine.startsWith ( "#" ) )
+        {
+            continue;
+        }
+
+        // name;file[;start (s)[;jitter (ms)[;loss (%)]]]
+        const QStringList slFields = strLine.split ( ";" );
+
+        if ( ( slFields.size() < 2 ) || ( vecpClients.Size() >= MAX_NUM_CHANNELS ) )
+        {
+            return false;
+        }
+
+        CSimClient* pClient = new CSimClient ( vecpClients.Size() );
+        vecpClients.Add ( pClient );
+
+        pClient->strName     = slFields[0].trimmed();
+        pClient->strFileName = ConfigDir.absoluteFilePath ( slFields[1].trimmed() );
+        pClient->Address     = CHostAddress ( QHostAddress ( QHostAddress::LocalHost ),
+                                              static_cast<quint16> ( SIM_CLIENT_BASE_PORT + pClient->iIndex ) );
+
+        if ( slFields.size() > 2 )
+        {
+            pClient->iStartTick = static_cast<qint64> ( slFields[2].toDouble() * dTicksPerSec + 0.5 );
+        }
+
+        if ( slFields.size() > 3 )
+        {
+            pClient->dJitterTicks = std::max ( 0.0, slFields[3].toDouble() ) * dTicksPerSec / 1000;
+        }
+
+        if ( slFields.size() > 4 )
+        {
+            pClient->dLossRate = std::max ( 0.0, std::min ( 100.0, slFields[4].toDouble() ) ) / 100;
+        }
+
+        if ( !OpenInput ( pClient ) )
+        {
+            tsConsole << "- invalid simulation input file: " << pClient->strFileName << endl;
+            return false;
+        }
+    }
+
+    return vecpClients.Size() > 0;
+}
+
+bool CSimulation::OpenInput ( CSimClient* pClient )
+{
+    pClient->InFile.setFileName ( pClient->strFileName );
+
+    if ( !pClient->InFile.open ( QIODevice::ReadOnly ) )
+    {
+        return false;
+    }
+
+    pClient->bIsPacketFile = pClient->strFileName.endsWith ( ".pkt", Qt::CaseInsensitive );
+
+    if ( pClient->bIsPacketFile )
+    {
+        return OpenPacketInput ( pClient );
+    }
+
+    return OpenWaveInput ( pClient );
+}
+
+bool CSimulation::OpenWaveInput ( CSimClient* pClient )
+{
+    QFile& InFile = pClient->InFile;
+
+    const QByteArray baHeader = InFile.read ( 12 );
+
+    if ( ( baHeader.size() < 12 ) ||
+         !baHeader.startsWith ( "RIFF" ) ||
+         ( baHeader.mid ( 8, 4 ) != "WAVE" ) )
+    {
+        return false;
+    }
+
+    // search for the format and data chunks, the samples are read frame by
+    // frame during the simulation
+    int iNumChannels = 0;
+
+    for ( ;; )
+    {
+        const QByteArray baChunk = InFile.read ( 8 );
+
+        if ( baChunk.size() < 8 )
+        {
+            return false;
+        }
+
+        const qint64 iChunkSize  = qFromLittleEndian<quint32> (
+            reinterpret_cast<const uchar*> ( baChunk.constData() + 4 ) );
+
+        const qint64 iChunkStart = InFile.pos();
+
+        if ( baChunk.startsWith ( "fmt " ) && ( iChunkSize >= 16 ) )
+        {
+            const QByteArray baFmt = InFile.read ( 16 );
+            const uchar*     pFmt  = reinterpret_cast<const uchar*> ( baFmt.constData() );
+
+            if ( baFmt.size() < 16 )
+            {
+                return false;
+            }
+
+            const int iFormat     = qFromLittleEndian<quint16> ( pFmt );
+            const int iSampleRate = static_cast<int> ( qFromLittleEndian<quint32> ( pFmt + 4 ) );
+            const int iBitsPerSam = qFromLittleEndian<quint16> ( pFmt + 14 );
+
+            iNumChannels = qFromLittleEndian<quint16> ( pFmt + 2 );
+
+            if ( ( iFormat != 1 /* PCM */ ) || ( iSampleRate != SYSTEM_SAMPLE_RATE_HZ ) ||
+                 ( iBitsPerSam != 16 ) || ( iNumChannels < 1 ) || ( iNumChannels > 2 ) )
+            {
+                return false;
+            }
+        }
+        else if ( baChunk.startsWith ( "data" ) && ( iNumChannels > 0 ) )
+        {
+            pClient->iInDataEnd = std::min ( iChunkStart + iChunkSize, InFile.size() );
+            break;
+        }
+
+        // chunks are word aligned
+        if ( !InFile.seek ( iChunkStart + iChunkSize + ( iChunkSize & 1 ) ) )
+        {
+            return false;
+        }
+    }
+
+    // the client uses the default settings (normal audio quality) with the
+    // frame size of the server
+    int iOpusError;
+
+    pClient->iNumAudioChannels = iNumChannels;
+
+    if ( iServerFrameSizeSamples == SYSTEM_FRAME_SIZE_SAMPLES )
+    {
+        pClient->eInComprType        = CT_OPUS64;
+        pClient->iInFrameSizeSamples = SYSTEM_FRAME_SIZE_SAMPLES;
+        pClient->iInNumCodedBytes    = ( iNumChannels == 1 ) ?
+            OPUS_NUM_BYTES_MONO_NORMAL_QUALITY : OPUS_NUM_BYTES_STEREO_NORMAL_QUALITY;
+    }
+    else
+    {
+        pClient->eInComprType        = CT_OPUS;
+        pClient->iInFrameSizeSamples = DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES;
+        pClient->iInNumCodedBytes    = ( iNumChannels == 1 ) ?
+            OPUS_NUM_BYTES_MONO_NORMAL_QUALITY_DBLE_FRAMESIZE : OPUS_NUM_BYTES_STEREO_NORMAL_QUALITY_DBLE_FRAMESIZE;
+    }
+
+    pClient->InOpusMode    = opus_custom_mode_create ( SYSTEM_SAMPLE_RATE_HZ,
+                                                       pClient->iInFrameSizeSamples,
+                                                       &iOpusError );
+
+    pClient->InOpusEncoder = opus_custom_encoder_create ( pClient->InOpusMode,
+                                                          iNumChannels,
+                                                          &iOpusError );
+
+    // same encoder settings as for the virtual clients of the load generator
+    opus_custom_encoder_ctl ( pClient->InOpusEncoder, OPUS_SET_VBR ( 0 ) );
+    opus_custom_encoder_ctl ( pClient->InOpusEncoder, OPUS_SET_COMPLEXITY ( 1 ) );
+
+    pClient->vecsInAudio.Init ( pClient->iInFrameSizeSamples * iNumChannels );
+    pClient->vecbyInRaw.resize ( 2 * pClient->iInFrameSizeSamples * iNumChannels );
+
+    return true;
+}
+
+bool CSimulation::OpenPacketInput ( CSimClient* pClient )
+{
+    QDataStream& in = pClient->InStream;
+
+    in.setDevice ( &pClient->InFile );
+    in.setByteOrder ( QDataStream::LittleEndian );
+
+    // the header written by the recorder
+    char    id[4];
+    quint8  iVersion;
+    quint8  iNumChannels;
+    quint16 iFrameSize;
+
+    in.readRawData ( id, 4 );
+    in >> iVersion >> iNumChannels >> iFrameSize;
+
+    if ( ( in.status() != QDataStream::Ok ) ||
+         ( memcmp ( id, JAM_RECORDER_PACKET_FILE_ID, 4 ) != 0 ) ||
+         ( iVersion != JAM_RECORDER_PACKET_FILE_VER ) ||
+         ( ( iNumChannels != 1 ) && ( iNumChannels != 2 ) ) ||
+         ( iFrameSize == 0 ) )
+    {
+        return false;
+    }
+
+    pClient->iNumAudioChannels = iNumChannels;
+    pClient->iInFileFrameSize  = iFrameSize;
+
+    // the start frame in the session is part of the file name:
+    // name-hostport-frame-numChannels[_n]
+    const QStringList slName =
+        QFileInfo ( pClient->strFileName ).fileName().split ( "." )[0].split ( "-" );
+
+    if ( slName.size() >= 4 )
+    {
+        pClient->iInFileStartFrame = slName[2].toLongLong();
+    }
+
+    ReadNextPacket ( pClient );
+
+    return true;
+}
+
+bool CSimulation::ReadNextPacket ( CSimClient* pClient )
+{
+    QDataStream& in = pClient->InStream;
+    quint32      iFrame;
+    quint8       iComprType;
+    quint16      iNumBytes;
+
+    // the packets which the recording server did not get are not sent
+    do
+    {
+        in >> iFrame >> iComprType >> iNumBytes;
+
+        if ( ( in.status() != QDataStream::Ok ) || ( iNumBytes > JAM_RECORDER_MAX_PACKET_BYTES ) )
+        {
+            pClient->bInputDone = true;
+            return false;
+        }
+
+        pClient->NextPacket.vecbyData.Init ( iNumBytes );
+
+        if ( ( iNumBytes > 0 ) &&
+             ( in.readRawData ( reinterpret_cast<char*> ( &pClient->NextPacket.vecbyData[0] ), iNumBytes ) != iNumBytes ) )
+        {
+            pClient->bInputDone = true;
+            return false;
+        }
+    }
+    while ( ( iNumBytes == 0 ) ||
+            ( ( iComprType != CT_OPUS ) && ( iComprType != CT_OPUS64 ) ) );
+
+    pClient->NextPacket.eComprType = static_cast<EAudComprType> ( iComprType );
+
+    // the frames of the recording server converted to ticks of the simulated
+    // server
+    pClient->iNextPacketTick = pClient->iStartTick +
+        ( pClient->iInFileStartFrame + iFrame ) * pClient->iInFileFrameSize / iServerFrameSizeSamples;
+
+    return true;
+}
+
+void CSimulation::OpenOutput ( CSimClient* pClient,
+                               const QDir& OutputDir )
+{
+    int iOpusError;
+
+    const QString strFileName = QString ( "%1-%2.wav" ).
+        arg ( pClient->iIndex ).
+        arg ( QString ( pClient->strName ).replace ( QRegExp ( "[^A-Za-z0-9_]" ), "_" ) );
+
+    pClient->pOutFile = new QFile ( OutputDir.absoluteFilePath ( strFileName ) );
+
+    if ( !pClient->pOutFile->open ( QIODevice::ReadWrite | QIODevice::Truncate ) )
+    {
+        tsConsole << "- could not write the simulation output file: " << pClient->pOutFile->fileName() << endl;
+
+        delete pClient->pOutFile;
+        pClient->pOutFile = nullptr;
+        return;
+    }
+
+    pClient->pOutStream = new recorder::CWaveStream ( pClient->pOutFile,
+                                                      static_cast<uint16_t> ( pClient->iNumAudioChannels ) );
+
+    // the server sends the mix with the codec of the client
+    pClient->OutOpusMode      = opus_custom_mode_create ( SYSTEM_SAMPLE_RATE_HZ,
+                                                          DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES,
+                                                          &iOpusError );
+
+    pClient->OutOpus64Mode    = opus_custom_mode_create ( SYSTEM_SAMPLE_RATE_HZ,
+                                                          SYSTEM_FRAME_SIZE_SAMPLES,
+                                                          &iOpusError );
+
+    pClient->OutOpusDecoder   = opus_custom_decoder_create ( pClient->OutOpusMode,
+                                                             pClient->iNumAudioChannels,
+                                                             &iOpusError );
+
+    pClient->OutOpus64Decoder = opus_custom_decoder_create ( pClient->OutOpus64Mode,
+                                                             pClient->iNumAudioChannels,
+                                                             &iOpusError );
+
+    pClient->vecsOutAudio.Init ( DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES * pClient->iNumAudioChannels );
+    pClient->vecbyOutRaw.resize ( 2 * DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES * pClient->iNumAudioChannels );
+}
+
+void CSimulation::CloseOutput ( CSimClient* pClient )
+{
+    if ( pClient->pOutFile == nullptr )
+    {
+        return;
+    }
+
+    pClient->pOutStream->finalise();
+    pClient->pOutFile->close();
+
+    delete pClient->pOutStream;
+    delete pClient->pOutFile;
+    pClient->pOutStream = nullptr;
+    pClient->pOutFile   = nullptr;
+
+    opus_custom_decoder_destroy ( pClient->OutOpusDecoder );
+    opus_custom_decoder_destroy ( pClient->OutOpus64Decoder );
+    opus_custom_mode_destroy ( pClient->OutOpusMode );
+    opus_custom_mode_destroy ( pClient->OutOpus64Mode );
+}
+
+void CSimulation::SendPackets ( CSimClient*  pClient,
+                                const qint64 iTick )
+{
+    if ( pClient->bInputDone || ( iTick < pClient->iStartTick ) )
+    {
+        return;
+    }
+
+    CVector<CSimPacket> vecPackets;
+
+    if ( pClient->bIsPacketFile )
+    {
+        // all packets which the recording server took in this tick
+        while ( !pClient->bInputDone && ( pClient->iNextPacketTick <= iTick ) )
+        {
+            vecPackets.Add ( pClient->NextPacket );
+            ReadNextPacket ( pClient );
+        }
+    }
+    else
+    {
+        // the codec of the client has the frame size of the server, i.e. one
+        // packet per tick
+        const int iNumBytes = pClient->vecbyInRaw.size();
+
+        if ( pClient->InFile.pos() + iNumBytes > pClient->iInDataEnd )
+        {
+            pClient->bInputDone = true;
+            return;
+        }
+
+        pClient->InFile.read ( pClient->vecbyInRaw.data(), iNumBytes );
+
+        const uchar* pRaw = reinterpret_cast<const uchar*> ( pClient->vecbyInRaw.constData() );
+
+        for ( int i = 0; i < pClient->vecsInAudio.Size(); i++ )
+        {
+            pClient->vecsInAudio[i] = qFromLittleEndian<qint16> ( pRaw + 2 * i );
+        }
+
+        CSimPacket Packet;
+
+        Packet.eComprType = pClient->eInComprType;
+        Packet.vecbyData.Init ( pClient->iInNumCodedBytes );
+
+        opus_custom_encode ( pClient->InOpusEncoder,
+                             &pClient->vecsInAudio[0],
+                             pClient->iInFrameSizeSamples,
+                             &Packet.vecbyData[0],
+                             pClient->iInNumCodedBytes );
+
+        vecPackets.Add ( Packet );
+    }
+
+    for ( int i = 0; i < vecPackets.Size(); i++ )
+    {
+        // two uniform random numbers in [0, 1) per packet, so the sequence of
+        // the generator does not depend on the results
+        const double dLossRand   = pClient->Rng() / 4294967296.0;
+        const double dJitterRand = pClient->Rng() / 4294967296.0;
+
+        pClient->iNumSentPackets++;
+
+        if ( dLossRand < pClient->dLossRate )
+        {
+            pClient->iNumLostPackets++;
+            continue;
+        }
+
+        const qint64 iArrivalTick = iTick + static_cast<qint64> ( dJitterRand * pClient->dJitterTicks + 0.5 );
+
+        pClient->mapInFlight.insert ( std::make_pair ( std::make_pair ( iArrivalTick, pClient->iNumSentPackets ),
+                                                       vecPackets[i] ) );
+    }
+}
+
+void CSimulation::DeliverPackets ( CSimClient*  pClient,
+                                   const qint64 iTick )
+{
+    while ( !pClient->mapInFlight.empty() && ( pClient->mapInFlight.begin()->first.first <= iTick ) )
+    {
+        const CSimPacket& Packet    = pClient->mapInFlight.begin()->second;
+        const int         iNumBytes = Packet.vecbyData.Size();
+        int               iCurChanID;
+
+        if ( Server.PutAudioData ( Packet.vecbyData, iNumBytes, pClient->Address, iCurChanID ) )
+        {
+            // new connection: the same as the socket does, the answers of the
+            // client to the requests of the server are given directly
+            Server.OnNewConnection ( iCurChanID, pClient->Address );
+
+            pClient->iChanID              = iCurChanID;
+            pClient->eChanComprType       = CT_NONE;
+            pClient->iChanNumBytes        = 0;
+            vecChanToClient[iCurChanID]   = pClient->iIndex;
+
+            CChannelCoreInfo ChanInfo;
+            ChanInfo.strName = pClient->strName;
+
+            Server.GetChannel ( iCurChanID ).OnChangeChanInfo ( ChanInfo );
+        }
+
+        if ( ( iCurChanID != INVALID_CHANNEL_ID ) &&
+             ( ( Packet.eComprType != pClient->eChanComprType ) || ( iNumBytes != pClient->iChanNumBytes ) ) )
+        {
+            Server.GetChannel ( iCurChanID ).OnNetTranspPropsReceived (
+                CNetworkTransportProps ( static_cast<uint32_t> ( iNumBytes ),
+                                         1, /* network frame size factor */
+                                         static_cast<uint32_t> ( pClient->iNumAudioChannels ),
+                                         SYSTEM_SAMPLE_RATE_HZ,
+                                         Packet.eComprType,
+                                         NF_NONE,
+                                         0 ) );
+
+            pClient->eChanComprType = Packet.eComprType;
+            pClient->iChanNumBytes  = iNumBytes;
+
+            // the packet did not fit to the previous properties
+            Server.PutAudioData ( Packet.vecbyData, iNumBytes, pClient->Address, iCurChanID );
+        }
+
+        pClient->mapInFlight.erase ( pClient->mapInFlight.begin() );
+    }
+}
+
+void CSimulation::UpdateStatistics ( CSimClient* pClient )
+{
+    if ( pClient->iChanID == INVALID_CHANNEL_ID )
+    {
+        return;
+    }
+
+    CChannel& Channel = Server.GetChannel ( pClient->iChanID );
+
+    if ( !Channel.IsConnected() || !( Channel.GetAddress() == pClient->Address ) )
+    {
+        return;
+    }
+
+    pClient->iChanRecPackets       = Channel.GetCounter ( CC_REC_PACKETS );
+    pClient->iChanRecoveredPackets = Channel.GetCounter ( CC_RECOVERED_PACKETS );
+    pClient->iChanUnderruns        = Channel.GetCounter ( CC_BUF_UNDERRUNS );
+    pClient->iChanOverruns         = Channel.GetCounter ( CC_BUF_OVERRUNS );
+    pClient->iChanJitBufFrames     = Channel.GetSockBufNumFrames();
+}
+
+void CSimulation::ReceiveMix ( const int               iChID,
+                               const CVector<uint8_t>& vecbyData,
+                               const int               iNumBytes )
+{
+    // note that this is called by the parallel threads of the server mix, the
+    // clients are only accessed by the thread of their channel
+    const int iClient = vecChanToClient[iChID];
+
+    if ( iClient == INVALID_INDEX )
+    {
+        return;
+    }
+
+    CSimClient* pClient = vecpClients[iClient];
+
+    pClient->iNumRecPackets++;
+
+    if ( pClient->pOutFile == nullptr )
+    {
+        return;
+    }
+
+    OpusCustomDecoder* CurOpusDecoder;
+    int                iFrameSizeSamples;
+
+    if ( Server.GetChannel ( iChID ).GetAudioCompressionType() == CT_OPUS64 )
+    {
+        CurOpusDecoder    = pClient->OutOpus64Decoder;
+        iFrameSizeSamples = SYSTEM_FRAME_SIZE_SAMPLES;
+    }
+    else
+    {
+        CurOpusDecoder    = pClient->OutOpusDecoder;
+        iFrameSizeSamples = DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES;
+    }
+
+    opus_custom_decode ( CurOpusDecoder,
+                         &vecbyData[0],
+                         iNumBytes,
+                         &pClient->vecsOutAudio[0],
+                         iFrameSizeSamples );
+
+    const int iNumSamples = iFrameSizeSamples * pClient->iNumAudioChannels;
+    char*     pRaw        = pClient->vecbyOutRaw.data();
+
+    for ( int i = 0; i < iNumSamples; i++ )
+    {
+        qToLittleEndian<qint16> ( pClient->vecsOutAudio[i], pRaw + 2 * i );
+    }
+
+    pClient->pOutFile->write ( pRaw, 2 * iNumSamples );
+}
+
+void CSimulation::WriteStatistics ( const QString& strFileName,
+                                    const qint64   iNumTicks,
+                                    const qint64   iElapsedMs )
+{
+    QFile StatisticsFile ( strFileName );
+
+    if ( !StatisticsFile.open ( QIODevice::WriteOnly ) )
+    {
+        tsConsole << "- could not write the simulation statistics: " << strFileName << endl;
+        return;
+    }
+
+    QJsonArray Clients;
+
+    for ( int i = 0; i < vecpClients.Size(); i++ )
+    {
+        const CSimClient* pClient = vecpClients[i];
+        QJsonObject       Client;
+
+        Client["name"]              = pClient->strName;
+        Client["file"]              = pClient->strFileName;
+        Client["sent_packets"]      = pClient->iNumSentPackets;
+        Client["lost_packets"]      = pClient->iNumLostPackets;
+        Client["rec_packets"]       = static_cast<qint64> ( pClient->iChanRecPackets );
+        Client["recovered_packets"] = static_cast<qint64> ( pClient->iChanRecoveredPackets );
+        Client["jitbuf_underruns"]  = static_cast<qint64> ( pClient->iChanUnderruns );
+        Client["jitbuf_overruns"]   = static_cast<qint64> ( pClient->iChanOverruns );
+        Client["jitbuf_frames"]     = pClient->iChanJitBufFrames;
+        Client["mix_packets"]       = pClient->iNumRecPackets;
+
+        Clients.append ( Client );
+    }
+
+    // the tick timing of the server is the processing time of the simulated
+    // ticks, i.e. without the waiting time of the real time timer
+    QJsonObject Statistics;
+
+    Statistics["frame_size_samples"] = iServerFrameSizeSamples;
+    Statistics["ticks"]              = iNumTicks;
+    Statistics["elapsed_ms"]         = iElapsedMs;
+    Statistics["clients"]            = Clients;
+    Statistics["timing"]             = CServerAdmin ( &Server ).GetTimingJson();
+
+    StatisticsFile.write ( QJsonDocument ( Statistics ).toJson() );
+}
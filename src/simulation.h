@@ -0,0 +1,257 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#pragma once
+
+#include <QCoreApplication>
+#include <QTextStream>
+#include <QElapsedTimer>
+#include <QString>
+#include <QStringList>
+#include <QRegExp>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDataStream>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QtEndian>
+#include <map>
+#include <random>
+#include <utility>
+#include <cstring>
+#ifdef USE_OPUS_SHARED_LIB
+# include "opus/opus_custom.h"
+#else
+# include "opus_custom.h"
+#endif
+#include "global.h"
+#include "channel.h"
+#include "server.h"
+#include "serveradmin.h"
+#include "client.h"
+#include "util.h"
+#include "recorder/cwavestream.h"
+#include "recorder/jamrecorder.h"
+
+
+/* Definitions ****************************************************************/
+// the queued Qt events (e.g. of the protocol) are processed after this number
+// of simulated ticks
+#define SIM_PROCESS_EVENTS_INTERVAL         1000
+
+// progress output interval in simulated seconds
+#define SIM_PROGRESS_INTERVAL_SEC           60
+
+// seed of the pseudo random network impairments, each client uses its own
+// generator so that the results do not depend on the processing order
+#define SIM_RANDOM_SEED                     1
+
+// first port of the (not used) addresses of the simulated clients
+#define SIM_CLIENT_BASE_PORT                30000
+
+
+/* Classes ********************************************************************/
+// Offline server simulation ---------------------------------------------------
+// Runs the real server processing (channels, jitter buffers, mixing and OPUS
+// coding) on a virtual clock as fast as possible. The clients are given in a
+// configuration file, each line has the format
+//   name;file[;start (s)[;jitter (ms)[;loss (%)]]]
+// where the file is a 16 bit, 48 kHz wave file (encoded with the default
+// client settings) or a packet file of a recording with --recordpackets (the
+// packets are sent in the ticks in which the server took them). The packets
+// get a uniformly distributed delay up to the given jitter and are lost with
+// the given probability. The mix received by each client is decoded to a wave
+// file in the output directory and the statistics are written to a JSON file.
+class CSimulation
+{
+public:
+    CSimulation ( const bool   bNUseDoubleSystemFrameSize,
+                  QTextStream& tsNConsole );
+
+    virtual ~CSimulation();
+
+    void Run ( const QString& strConfigFileName,
+               const QString& strOutputDirName );
+
+protected:
+    class CSimPacket
+    {
+    public:
+        EAudComprType    eComprType;
+        CVector<uint8_t> vecbyData;
+    };
+
+    // one simulated client with its input, network impairments, the decoder
+    // for the received mix and the statistics
+    class CSimClient
+    {
+    public:
+        CSimClient ( const int iNIndex ) :
+            iIndex                ( iNIndex ),
+            iNumAudioChannels     ( 1 ),
+            iStartTick            ( 0 ),
+            dJitterTicks          ( 0 ),
+            dLossRate             ( 0 ),
+            Rng                   ( SIM_RANDOM_SEED + iNIndex ),
+            bIsPacketFile         ( false ),
+            iInDataEnd            ( 0 ),
+            bInputDone            ( false ),
+            InOpusMode            ( nullptr ),
+            InOpusEncoder         ( nullptr ),
+            eInComprType          ( CT_NONE ),
+            iInFrameSizeSamples   ( 0 ),
+            iInNumCodedBytes      ( 0 ),
+            iInFileFrameSize      ( 0 ),
+            iInFileStartFrame     ( 0 ),
+            iNextPacketTick       ( 0 ),
+            iNumSentPackets       ( 0 ),
+            iChanID               ( INVALID_CHANNEL_ID ),
+            eChanComprType        ( CT_NONE ),
+            iChanNumBytes         ( 0 ),
+            pOutFile              ( nullptr ),
+            pOutStream            ( nullptr ),
+            OutOpusMode           ( nullptr ),
+            OutOpus64Mode         ( nullptr ),
+            OutOpusDecoder        ( nullptr ),
+            OutOpus64Decoder      ( nullptr ),
+            iNumRecPackets        ( 0 ),
+            iNumLostPackets       ( 0 ),
+            iChanRecPackets       ( 0 ),
+            iChanRecoveredPackets ( 0 ),
+            iChanUnderruns        ( 0 ),
+            iChanOverruns         ( 0 ),
+            iChanJitBufFrames     ( 0 ) {}
+
+        int                                           iIndex;
+        QString                                       strName;
+        QString                                       strFileName;
+        CHostAddress                                  Address;
+        int                                           iNumAudioChannels;
+        qint64                                        iStartTick;
+        double                                        dJitterTicks;
+        double                                        dLossRate;
+        std::mt19937                                  Rng;
+
+        // input: either a wave file which is encoded or a packet file
+        bool                                          bIsPacketFile;
+        QFile                                         InFile;
+        QDataStream                                   InStream;
+        qint64                                        iInDataEnd;
+        bool                                          bInputDone;
+        OpusCustomMode*                               InOpusMode;
+        OpusCustomEncoder*                            InOpusEncoder;
+        EAudComprType                                 eInComprType;
+        int                                           iInFrameSizeSamples;
+        int                                           iInNumCodedBytes;
+        CVector<int16_t>                              vecsInAudio;
+        QByteArray                                    vecbyInRaw;
+        int                                           iInFileFrameSize;
+        qint64                                        iInFileStartFrame;
+        qint64                                        iNextPacketTick;
+        CSimPacket                                    NextPacket;
+
+        // packets on their way to the server by arrival tick and send order
+        std::map<std::pair<qint64, qint64>, CSimPacket> mapInFlight;
+        qint64                                        iNumSentPackets;
+
+        // the server channel and its current network transport properties
+        int                                           iChanID;
+        EAudComprType                                 eChanComprType;
+        int                                           iChanNumBytes;
+
+        // output: the decoded mix of the server
+        QFile*                                        pOutFile;
+        recorder::CWaveStream*                        pOutStream;
+        OpusCustomMode*                               OutOpusMode;
+        OpusCustomMode*                               OutOpus64Mode;
+        OpusCustomDecoder*                            OutOpusDecoder;
+        OpusCustomDecoder*                            OutOpus64Decoder;
+        CVector<int16_t>                              vecsOutAudio;
+        QByteArray                                    vecbyOutRaw;
+        qint64                                        iNumRecPackets;
+
+        // statistics of the server channel (taken after each tick since the
+        // counters are gone when the channel disconnects)
+        qint64                                        iNumLostPackets;
+        uint32_t                                      iChanRecPackets;
+        uint32_t                                      iChanRecoveredPackets;
+        uint32_t                                      iChanUnderruns;
+        uint32_t                                      iChanOverruns;
+        int                                           iChanJitBufFrames;
+    };
+
+    // the server which sends the mixes and the protocol messages to the
+    // simulation instead of the network
+    class CSimServer : public CServer
+    {
+    public:
+        CSimServer ( CSimulation* pNSim,
+                     const bool   bNUseDoubleSystemFrameSize ) :
+            CServer ( MAX_NUM_CHANNELS, 0, "", 0 /* random port */,
+                      "", "", "", "", "", "", "", "", false, false,
+                      false, bNUseDoubleSystemFrameSize, LT_NO_LICENCE ),
+            pSim ( pNSim ) {}
+
+    protected:
+        virtual void SendProtMessage ( int, CVector<uint8_t> ) {}
+
+        virtual void SendAudioPacket ( const int               iChID,
+                                       const CVector<uint8_t>& vecbyData,
+                                       const int               iNumBytes )
+            { pSim->ReceiveMix ( iChID, vecbyData, iNumBytes ); }
+
+        CSimulation* pSim;
+    };
+
+    bool ReadConfigFile ( const QString& strConfigFileName );
+    bool OpenInput ( CSimClient* pClient );
+    bool OpenWaveInput ( CSimClient* pClient );
+    bool OpenPacketInput ( CSimClient* pClient );
+    bool ReadNextPacket ( CSimClient* pClient );
+    void OpenOutput ( CSimClient* pClient, const QDir& OutputDir );
+    void CloseOutput ( CSimClient* pClient );
+
+    void SendPackets ( CSimClient* pClient, const qint64 iTick );
+    void DeliverPackets ( CSimClient* pClient, const qint64 iTick );
+    void UpdateStatistics ( CSimClient* pClient );
+
+    // called by the server (possibly from parallel threads of the mix)
+    void ReceiveMix ( const int               iChID,
+                      const CVector<uint8_t>& vecbyData,
+                      const int               iNumBytes );
+
+    void WriteStatistics ( const QString& strFileName,
+                           const qint64   iNumTicks,
+                           const qint64   iElapsedMs );
+
+    QTextStream&          tsConsole;
+    CSimServer            Server;
+    int                   iServerFrameSizeSamples;
+    CVector<CSimClient*>  vecpClients;
+
+    // simulated client of each server channel
+    CVector<int>          vecChanToClient;
+};
@@ -127,8 +127,9 @@ void CSocket::Init ( const quint16 iPortNumber )
         QObject::connect ( this, &CSocket::ProtcolMessageReceived,
             pServer, &CServer::OnProtcolMessageReceived );
 
+        // the server distributes the connection less messages itself
         QObject::connect ( this, &CSocket::ProtcolCLMessageReceived,
-            pServer, &CServer::OnProtcolCLMessageReceived );
+            pServer, &CServer::OnProtcolCLMessageReceived, Qt::DirectConnection );
 
         QObject::connect ( this, static_cast<void (CSocket::*) ( int, CHostAddress )> ( &CSocket::NewConnection ),
             pServer, &CServer::OnNewConnection );
@@ -155,6 +156,15 @@ void CSocket::Close()
 
 CSocket::~CSocket()
 {
+    // the impairment thread must not use the socket anymore
+    CNetImpairment* pCurNetImpairment = pNetImpairment.load ( std::memory_order_acquire );
+
+    if ( pCurNetImpairment != nullptr )
+    {
+        pCurNetImpairment->Stop();
+        delete pCurNetImpairment;
+    }
+
     // cleanup the socket (on Windows the WSA cleanup must also be called)
 #ifdef _WIN32
     closesocket ( UdpSocket );
@@ -164,8 +174,45 @@ CSocket::~CSocket()
 #endif
 }
 
+void CSocket::EnableNetImpairment ( const CNetImpairmentParams& Params )
+{
+    CNetImpairment* pNewNetImpairment = new CNetImpairment ( this, Params );
+
+    pNewNetImpairment->start ( QThread::TimeCriticalPriority );
+    pNetImpairment.store ( pNewNetImpairment, std::memory_order_release );
+}
+
+void CSocket::ProcessImpairedDatagram ( const bool              bIsSend,
+                                        const CVector<uint8_t>& vecbyData,
+                                        const CHostAddress&     HostAddr )
+{
+    if ( bIsSend )
+    {
+        SendDatagram ( vecbyData, HostAddr );
+    }
+    else
+    {
+        ProcessDatagram ( vecbyData, vecbyData.Size(), HostAddr );
+    }
+}
+
 void CSocket::SendPacket ( const CVector<uint8_t>& vecbySendBuf,
                            const CHostAddress&     HostAddr )
+{
+    CNetImpairment* pCurNetImpairment = pNetImpairment.load ( std::memory_order_acquire );
+
+    if ( ( pCurNetImpairment != nullptr ) && pCurNetImpairment->IsActive ( true ) )
+    {
+        // the impairment sends the datagram after its delay (if it is not lost)
+        pCurNetImpairment->PutDatagram ( true, vecbySendBuf, vecbySendBuf.Size(), HostAddr );
+        return;
+    }
+
+    SendDatagram ( vecbySendBuf, HostAddr );
+}
+
+void CSocket::SendDatagram ( const CVector<uint8_t>& vecbySendBuf,
+                             const CHostAddress&     HostAddr )
 {
     QMutexLocker locker ( &Mutex );
 
@@ -242,14 +289,39 @@ void CSocket::OnDataReceived()
     RecHostAddr.InetAddr.setAddress ( ntohl ( SenderAddr.sin_addr.s_addr ) );
     RecHostAddr.iPort = ntohs ( SenderAddr.sin_port );
 
+    // optional capture of the received traffic (before any processing so that
+    // the replay contains the same datagrams)
+    CPacketCapture* pCurPacketCapture = pPacketCapture.load ( std::memory_order_acquire );
+
+    if ( pCurPacketCapture != nullptr )
+    {
+        pCurPacketCapture->PutPacket ( vecbyRecBuf, static_cast<int> ( iNumBytesRead ), RecHostAddr );
+    }
+
+    // optional emulation of network impairments, the datagram is processed by
+    // the impairment thread after its delay (if it is not lost)
+    CNetImpairment* pCurNetImpairment = pNetImpairment.load ( std::memory_order_acquire );
+
+    if ( ( pCurNetImpairment != nullptr ) && pCurNetImpairment->IsActive ( false ) )
+    {
+        pCurNetImpairment->PutDatagram ( false, vecbyRecBuf, static_cast<int> ( iNumBytesRead ), RecHostAddr );
+        return;
+    }
+
+    ProcessDatagram ( vecbyRecBuf, static_cast<int> ( iNumBytesRead ), RecHostAddr );
+}
 
+void CSocket::ProcessDatagram ( const CVector<uint8_t>& vecbyData,
+                                const int               iNumBytes,
+                                const CHostAddress&     HostAddr )
+{
     // check if this is a protocol message
     int              iRecCounter;
     int              iRecID;
     CVector<uint8_t> vecbyMesBodyData;
 
-    if ( !CProtocol::ParseMessageFrame ( vecbyRecBuf,
-                                         iNumBytesRead,
+    if ( !CProtocol::ParseMessageFrame ( vecbyData,
+                                         iNumBytes,
                                          vecbyMesBodyData,
                                          iRecCounter,
                                          iRecID ) )
@@ -260,14 +332,14 @@ void CSocket::OnDataReceived()
 
 // TODO a copy of the vector is used -> avoid malloc in real-time routine
 
-            emit ProtcolCLMessageReceived ( iRecID, vecbyMesBodyData, RecHostAddr );
+            emit ProtcolCLMessageReceived ( iRecID, vecbyMesBodyData, HostAddr );
         }
         else
         {
 
 // TODO a copy of the vector is used -> avoid malloc in real-time routine
 
-            emit ProtcolMessageReceived ( iRecCounter, iRecID, vecbyMesBodyData, RecHostAddr );
+            emit ProtcolMessageReceived ( iRecCounter, iRecID, vecbyMesBodyData, HostAddr );
         }
     }
     else
@@ -277,7 +349,7 @@ void CSocket::OnDataReceived()
         {
             // client:
 
-            switch ( pChannel->PutAudioData ( vecbyRecBuf, iNumBytesRead, RecHostAddr ) )
+            switch ( pChannel->PutAudioData ( vecbyData, iNumBytes, HostAddr ) )
             {
             case PS_AUDIO_ERR:
             case PS_GEN_ERROR:
@@ -291,7 +363,7 @@ void CSocket::OnDataReceived()
 
             case PS_AUDIO_INVALID:
                 // inform about received invalid packet by fireing an event
-                emit InvalidPacketReceived ( RecHostAddr );
+                emit InvalidPacketReceived ( HostAddr );
                 break;
 
             default:
@@ -305,10 +377,10 @@ void CSocket::OnDataReceived()
 
             int iCurChanID;
 
-            if ( pServer->PutAudioData ( vecbyRecBuf, iNumBytesRead, RecHostAddr, iCurChanID ) )
+            if ( pServer->PutAudioData ( vecbyData, iNumBytes, HostAddr, iCurChanID ) )
             {
                 // we have a new connection, emit a signal
-                emit NewConnection ( iCurChanID, RecHostAddr );
+                emit NewConnection ( iCurChanID, HostAddr );
 
                 // this was an audio packet, start server if it is in sleep mode
                 if ( !pServer->IsRunning() )
@@ -323,8 +395,120 @@ void CSocket::OnDataReceived()
             if ( iCurChanID == INVALID_CHANNEL_ID )
             {
                 // fire message for the state that no free channel is available
-                emit ServerFull ( RecHostAddr );
+                emit ServerFull ( HostAddr );
             }
         }
     }
 }
+
+
+/******************************************************************************\
+* Send pacer                                                                   *
+\******************************************************************************/
+CSendPacer::CSendPacer ( CSocket* pNSocket ) :
+    pSocket     ( pNSocket ),
+    bIsEnabled  ( false ),
+    bRun        ( true ),
+    iDelayUs    ( 0 ),
+    iReadIdx    ( 0 ),
+    iNumWaiting ( 0 )
+{
+    ElapsedTimer.start();
+}
+
+void CSendPacer::Enable()
+{
+    if ( !bIsEnabled )
+    {
+        bRun = true;
+        start ( QThread::TimeCriticalPriority );
+        bIsEnabled = true;
+    }
+}
+
+void CSendPacer::Stop()
+{
+    if ( bIsEnabled )
+    {
+        {
+            QMutexLocker locker ( &Mutex );
+
+            bRun = false;
+            WaitCondition.wakeOne();
+        }
+
+        wait();
+        bIsEnabled = false;
+    }
+}
+
+void CSendPacer::PutPacket ( const CVector<uint8_t>& vecbySendBuf,
+                             const CHostAddress&     HostAddr )
+{
+    QMutexLocker locker ( &Mutex );
+
+    if ( iNumWaiting >= SEND_PACER_NUM_SLOTS )
+    {
+        return;
+    }
+
+    const int iWriteIdx = ( iReadIdx + iNumWaiting ) % SEND_PACER_NUM_SLOTS;
+    const int iNumBytes = vecbySendBuf.Size();
+
+    if ( vecbySlotData[iWriteIdx].Size() != iNumBytes )
+    {
+        vecbySlotData[iWriteIdx].Init ( iNumBytes );
+    }
+
+    std::copy ( vecbySendBuf.begin(),
+                vecbySendBuf.end(),
+                vecbySlotData[iWriteIdx].begin() );
+
+    SlotHostAddr[iWriteIdx]   = HostAddr;
+    iSlotDueTimeNs[iWriteIdx] = ElapsedTimer.nsecsElapsed() +
+        static_cast<qint64> ( iDelayUs.load ( std::memory_order_relaxed ) ) * 1000;
+
+    iNumWaiting++;
+    WaitCondition.wakeOne();
+}
+
+void CSendPacer::run()
+{
+    Mutex.lock();
+
+    while ( bRun )
+    {
+        if ( iNumWaiting == 0 )
+        {
+            WaitCondition.wait ( &Mutex );
+            continue;
+        }
+
+        const qint64 iWaitNs = iSlotDueTimeNs[iReadIdx] - ElapsedTimer.nsecsElapsed();
+
+        if ( iWaitNs > SEND_PACER_SLEEP_THRESHOLD_NS )
+        {
+            WaitCondition.wait ( &Mutex, static_cast<unsigned long> ( iWaitNs / 1000000 - 1 ) );
+            continue;
+        }
+
+        if ( iWaitNs > 0 )
+        {
+            Mutex.unlock();
+            QThread::usleep ( static_cast<unsigned long> ( iWaitNs / 1000 ) );
+            Mutex.lock();
+            continue;
+        }
+
+        // the slot is not overwritten before it is released, so the packet
+        // can be sent without the lock
+        Mutex.unlock();
+        pSocket->SendPacket ( vecbySlotData[iReadIdx], SlotHostAddr[iReadIdx] );
+        Mutex.lock();
+
+        iReadIdx = ( iReadIdx + 1 ) % SEND_PACER_NUM_SLOTS;
+        iNumWaiting--;
+    }
+
+    Mutex.unlock();
+}
@@ -27,9 +27,14 @@
 #include <QObject>
 #include <QThread>
 #include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
 #include <vector>
+#include <atomic>
 #include "global.h"
 #include "protocol.h"
+#include "packetcapture.h"
+#include "netimpairment.h"
 #include "util.h"
 #ifndef _WIN32
 # include <netinet/in.h>
@@ -48,6 +53,14 @@ class CChannel; // forward declaration of CChannel
 // number of ports we try to bind until we give up
 #define NUM_SOCKET_PORTS_TO_TRY         50
 
+// number of audio packets which can wait in the send pacer (the delay is
+// shorter than a network frame, so only a few packets are waiting)
+#define SEND_PACER_NUM_SLOTS            16
+
+// below this waiting time the send pacer thread sleeps instead of waiting for
+// the condition since the wait has only a millisecond resolution
+#define SEND_PACER_SLEEP_THRESHOLD_NS   2000000
+
 
 /* Classes ********************************************************************/
 /* Base socket class -------------------------------------------------------- */
@@ -60,13 +73,17 @@ public:
               const quint16 iPortNumber )
         : pChannel ( pNewChannel ),
           bIsClient ( true ),
-          bJitterBufferOK ( true ) { Init ( iPortNumber ); }
+          bJitterBufferOK ( true ),
+          pPacketCapture ( nullptr ),
+          pNetImpairment ( nullptr ) { Init ( iPortNumber ); }
 
     CSocket ( CServer*      pNServP,
               const quint16 iPortNumber )
         : pServer ( pNServP ),
           bIsClient ( false ),
-          bJitterBufferOK ( true ) { Init ( iPortNumber ); }
+          bJitterBufferOK ( true ),
+          pPacketCapture ( nullptr ),
+          pNetImpairment ( nullptr ) { Init ( iPortNumber ); }
 
     virtual ~CSocket();
 
@@ -76,9 +93,31 @@ public:
     bool GetAndResetbJitterBufferOKFlag();
     void Close();
 
+    // all received datagrams are passed to the capture (may be set while the
+    // socket thread is running)
+    void SetPacketCapture ( CPacketCapture* pNPacketCapture )
+        { pPacketCapture.store ( pNPacketCapture, std::memory_order_release ); }
+
+    // emulation of network impairments for tests (may be enabled while the
+    // socket thread is running)
+    void EnableNetImpairment ( const CNetImpairmentParams& Params );
+
+    // called by the thread of the network impairment when the delay of a
+    // datagram has expired
+    void ProcessImpairedDatagram ( const bool              bIsSend,
+                                   const CVector<uint8_t>& vecbyData,
+                                   const CHostAddress&     HostAddr );
+
 protected:
     void Init ( const quint16 iPortNumber );
 
+    void SendDatagram ( const CVector<uint8_t>& vecbySendBuf,
+                        const CHostAddress&     HostAddr );
+
+    void ProcessDatagram ( const CVector<uint8_t>& vecbyData,
+                           const int               iNumBytes,
+                           const CHostAddress&     HostAddr );
+
 #ifdef _WIN32
     SOCKET           UdpSocket;
 #else
@@ -99,6 +138,9 @@ protected:
 
     bool             bJitterBufferOK;
 
+    std::atomic<CPacketCapture*> pPacketCapture;
+    std::atomic<CNetImpairment*> pNetImpairment;
+
 public slots:
     void OnDataReceived();
 
@@ -123,6 +165,51 @@ signals:
 };
 
 
+/* Send pacer -------------------------------------------------------------- */
+// Sends the audio packets with a constant delay after they were put by the
+// sound card thread. The client uses the delay to shift the arrival phase of
+// its packets at the server relative to the server mix tick.
+class CSendPacer : public QThread
+{
+public:
+    CSendPacer ( CSocket* pNSocket );
+
+    virtual ~CSendPacer() { Stop(); }
+
+    bool IsEnabled() const { return bIsEnabled; }
+
+    // starts the thread, may be called while packets are sent
+    void Enable();
+    void Stop();
+
+    void SetDelayUs ( const int iNDelayUs ) { iDelayUs.store ( iNDelayUs, std::memory_order_relaxed ); }
+    int  GetDelayUs() const { return iDelayUs.load ( std::memory_order_relaxed ); }
+
+    // a packet is dropped if all slots are in use
+    void PutPacket ( const CVector<uint8_t>& vecbySendBuf,
+                     const CHostAddress&     HostAddr );
+
+protected:
+    virtual void run();
+
+    CSocket*          pSocket;
+    std::atomic<bool> bIsEnabled;
+    bool              bRun;
+    std::atomic<int>  iDelayUs;
+    QMutex            Mutex;
+    QWaitCondition    WaitCondition;
+    QElapsedTimer     ElapsedTimer;
+
+    // ring of waiting packets, the slot vectors keep their size so that no
+    // memory is allocated as long as the packet size does not change
+    CVector<uint8_t>  vecbySlotData[SEND_PACER_NUM_SLOTS];
+    CHostAddress      SlotHostAddr[SEND_PACER_NUM_SLOTS];
+    qint64            iSlotDueTimeNs[SEND_PACER_NUM_SLOTS];
+    int               iReadIdx;
+    int               iNumWaiting;
+};
+
+
 /* Socket which runs in a separate high priority thread --------------------- */
 // The receive socket should be put in a high priority thread to ensure the GUI
 // does not effect the stability of the audio stream (e.g. if the GUI is on
@@ -135,14 +222,15 @@ class CHighPrioSocket : public QObject
 public:
     CHighPrioSocket ( CChannel*     pNewChannel,
                       const quint16 iPortNumber )
-        : Socket ( pNewChannel, iPortNumber ) { Init(); }
+        : Socket ( pNewChannel, iPortNumber ), SendPacer ( &Socket ) { Init(); }
 
     CHighPrioSocket ( CServer*      pNewServer,
                       const quint16 iPortNumber )
-        : Socket ( pNewServer, iPortNumber ) { Init(); }
+        : Socket ( pNewServer, iPortNumber ), SendPacer ( &Socket ) { Init(); }
 
     virtual ~CHighPrioSocket()
     {
+        SendPacer.Stop();
         NetworkWorkerThread.Stop();
     }
 
@@ -159,11 +247,41 @@ public:
         Socket.SendPacket ( vecbySendBuf, HostAddr );
     }
 
+    // the audio packets are delayed by the send pacer if it is enabled and
+    // the delay is not zero (the delay is less than the packet interval, so
+    // the packets are not reordered if the pacer is bypassed)
+    void SendAudioPacket ( const CVector<uint8_t>& vecbySendBuf,
+                           const CHostAddress&     HostAddr )
+    {
+        if ( SendPacer.IsEnabled() && ( SendPacer.GetDelayUs() > 0 ) )
+        {
+            SendPacer.PutPacket ( vecbySendBuf, HostAddr );
+        }
+        else
+        {
+            Socket.SendPacket ( vecbySendBuf, HostAddr );
+        }
+    }
+
+    void EnableSendPacer() { SendPacer.Enable(); }
+    void SetSendDelayUs ( const int iNDelayUs ) { SendPacer.SetDelayUs ( iNDelayUs ); }
+    int  GetSendDelayUs() const { return SendPacer.GetDelayUs(); }
+
     bool GetAndResetbJitterBufferOKFlag()
     {
         return Socket.GetAndResetbJitterBufferOKFlag();
     }
 
+    void SetPacketCapture ( CPacketCapture* pNPacketCapture )
+    {
+        Socket.SetPacketCapture ( pNPacketCapture );
+    }
+
+    void EnableNetImpairment ( const CNetImpairmentParams& Params )
+    {
+        Socket.EnableNetImpairment ( Params );
+    }
+
 protected:
     class CSocketThread : public QThread
     {
@@ -222,6 +340,7 @@ protected:
 
     CSocketThread NetworkWorkerThread;
     CSocket       Socket;
+    CSendPacer    SendPacer;
 
 signals:
     void InvalidPacketReceived ( CHostAddress RecHostAddr );
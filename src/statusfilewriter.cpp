@@ -0,0 +1,185 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#include "statusfilewriter.h"
+
+
+/* Implementation *************************************************************/
+CStatusFileWriter::CStatusFileWriter() :
+    pThread ( nullptr )
+{
+    TimerDebounce.setSingleShot ( true );
+    TimerDebounce.setInterval ( STATUS_FILE_DEBOUNCE_TIME_MS );
+
+
+    // Connections -------------------------------------------------------------
+    QObject::connect ( &TimerDebounce, &QTimer::timeout,
+        this, &CStatusFileWriter::OnTimerDebounce );
+}
+
+CStatusFileWriter::~CStatusFileWriter()
+{
+    if ( pThread != nullptr )
+    {
+        // a pending update is written and the timer is stopped in the writer
+        // thread before the thread is stopped (this does nothing if it was
+        // already done on quit)
+        QMetaObject::invokeMethod ( this,
+                                    "OnAboutToQuit",
+                                    Qt::BlockingQueuedConnection );
+
+        pThread->quit();
+        pThread->wait();
+        delete pThread;
+    }
+}
+
+void CStatusFileWriter::Init ( const QString& strNHTMLFileName,
+                               const QString& strNJSONFileName,
+                               const QString& strNServerNameWithPort )
+{
+    strHTMLFileName       = strNHTMLFileName;
+    strJSONFileName       = strNJSONFileName;
+    strServerNameWithPort = strNServerNameWithPort;
+
+    // the channel list is passed between threads
+    qRegisterMetaType<CVector<CChannelInfo> > ( "CVector<CChannelInfo>" );
+
+    // the final write must be finished before the application quits
+    QObject::connect ( QCoreApplication::instance(), &QCoreApplication::aboutToQuit,
+        this, &CStatusFileWriter::OnAboutToQuit, Qt::BlockingQueuedConnection );
+
+    // the timer is not a child object and must be moved explicitly
+    pThread = new QThread();
+    moveToThread ( pThread );
+    TimerDebounce.moveToThread ( pThread );
+    pThread->start();
+}
+
+void CStatusFileWriter::OnStatusChanged ( CVector<CChannelInfo> vecNChanInfo )
+{
+    // only the latest list is written, the previous one is not needed anymore
+    vecChanInfo = vecNChanInfo;
+
+    if ( !TimerDebounce.isActive() )
+    {
+        TimerDebounce.start();
+    }
+}
+
+void CStatusFileWriter::OnAboutToQuit()
+{
+    // write a pending update before the thread is stopped
+    if ( TimerDebounce.isActive() )
+    {
+        TimerDebounce.stop();
+        WriteFiles();
+    }
+}
+
+void CStatusFileWriter::WriteFiles()
+{
+    if ( !strHTMLFileName.isEmpty() )
+    {
+        WriteHTMLFile();
+    }
+
+    if ( !strJSONFileName.isEmpty() )
+    {
+        WriteJSONFile();
+    }
+}
+
+void CStatusFileWriter::WriteHTMLFile()
+{
+    // prepare file and stream
+    QSaveFile serverFileListFile ( strHTMLFileName );
+
+    if ( !serverFileListFile.open ( QIODevice::WriteOnly | QIODevice::Text ) )
+    {
+        return;
+    }
+
+    QTextStream streamFileOut ( &serverFileListFile );
+    streamFileOut << strServerNameWithPort << endl << "<ul>" << endl;
+
+    // depending on number of connected clients write list
+    if ( vecChanInfo.Size() == 0 )
+    {
+        // no clients are connected -> empty server
+        streamFileOut << "  No client connected" << endl;
+    }
+    else
+    {
+        // write entry for each connected client
+        for ( int i = 0; i < vecChanInfo.Size(); i++ )
+        {
+            streamFileOut << "  <li>" << vecChanInfo[i].strName << "</li>" << endl;
+        }
+    }
+
+    // finish list
+    streamFileOut << "</ul>" << endl;
+    streamFileOut.flush();
+
+    // replaces the old file by the new one
+    serverFileListFile.commit();
+}
+
+void CStatusFileWriter::WriteJSONFile()
+{
+    QSaveFile serverFileListFile ( strJSONFileName );
+
+    if ( !serverFileListFile.open ( QIODevice::WriteOnly ) )
+    {
+        return;
+    }
+
+    QJsonArray Clients;
+
+    for ( int i = 0; i < vecChanInfo.Size(); i++ )
+    {
+        QJsonObject Client;
+
+        Client["id"]         = vecChanInfo[i].iChanID;
+        Client["name"]       = vecChanInfo[i].strName;
+        Client["city"]       = vecChanInfo[i].strCity;
+        Client["country"]    = QLocale::countryToString ( vecChanInfo[i].eCountry );
+        Client["instrument"] = CInstPictures::GetName ( vecChanInfo[i].iInstrument );
+        Client["skill"]      = static_cast<int> ( vecChanInfo[i].eSkillLevel );
+
+        Clients.append ( Client );
+    }
+
+    QJsonObject Status;
+
+    Status["server"]      = strServerNameWithPort;
+    Status["num_clients"] = vecChanInfo.Size();
+    Status["clients"]     = Clients;
+
+    serverFileListFile.write ( QJsonDocument ( Status ).toJson() );
+
+    // replaces the old file by the new one
+    serverFileListFile.commit();
+}
@@ -0,0 +1,83 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2020
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QCoreApplication>
+#include "global.h"
+#include "util.h"
+
+
+/* Definitions ****************************************************************/
+// changes of the client list within this time are combined in one write
+#define STATUS_FILE_DEBOUNCE_TIME_MS        500
+
+
+/* Classes ********************************************************************/
+// Status file writer ----------------------------------------------------------
+// Writes the list of connected clients as HTML and/or JSON file in its own
+// thread. The files are written with a temporary file which is renamed at the
+// end so that a reader never sees a partially written file.
+class CStatusFileWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    CStatusFileWriter();
+    virtual ~CStatusFileWriter();
+
+    // must be called before the first status update, starts the thread
+    void Init ( const QString& strNHTMLFileName,
+                const QString& strNJSONFileName,
+                const QString& strNServerNameWithPort );
+
+    bool IsEnabled() const { return pThread != nullptr; }
+
+protected:
+    void WriteFiles();
+    void WriteHTMLFile();
+    void WriteJSONFile();
+
+    QThread*              pThread;
+    QTimer                TimerDebounce;
+
+    QString               strHTMLFileName;
+    QString               strJSONFileName;
+    QString               strServerNameWithPort;
+
+    CVector<CChannelInfo> vecChanInfo;
+
+public slots:
+    void OnStatusChanged ( CVector<CChannelInfo> vecNChanInfo );
+    void OnTimerDebounce() { WriteFiles(); }
+    void OnAboutToQuit();
+};
@@ -126,7 +126,7 @@ public slots:
         ESvrRegResult          eSvrRegResult;
 
         // generate random protocol message
-        switch ( GenRandomIntInRange ( 0, 34 ) )
+        switch ( GenRandomIntInRange ( 0, 35 ) )
         {
         case 0: // PROTMESSID_JITT_BUF_SIZE
             Protocol.CreateJitBufMes ( GenRandomIntInRange ( 0, 10 ) );
@@ -191,7 +191,7 @@ public slots:
             NetTrProps.iBlockSizeFact         = GenRandomIntInRange ( -2, 100 );
             NetTrProps.iNumAudioChannels      = GenRandomIntInRange ( -2, 10 );
             NetTrProps.iSampleRate            = GenRandomIntInRange ( -2, 10000 );
-            NetTrProps.iVersion               = GenRandomIntInRange ( -2, 10000 );
+            NetTrProps.iFlags                 = GenRandomIntInRange ( -2, 10000 );
 
             Protocol.CreateNetwTranspPropsMes ( NetTrProps );
             break;
@@ -331,6 +331,13 @@ public slots:
         case 34: // PROTMESSID_CLIENT_ID
             Protocol.CreateClientIDMes ( GenRandomIntInRange ( -2, 20 ) );
             break;
+
+        case 35: // PROTMESSID_CLM_TICK_PHASE
+            Protocol.CreateCLTickPhaseMes ( CurHostAddress,
+                                            GenRandomIntInRange ( 0, 10000 ),
+                                            GenRandomIntInRange ( 0, 10000 ),
+                                            GenRandomIntInRange ( 0, 10000 ) );
+            break;
         }
     }
 
@@ -1369,6 +1369,68 @@ QTextStream* ConsoleWriterFactory::get()
 }
 
 
+// Timing histogram ------------------------------------------------------------
+void CTimingHistogram::Reset()
+{
+    for ( int i = 0; i < TIMING_HIST_NUM_BUCKETS; i++ )
+    {
+        vecCounts[i].store ( 0, std::memory_order_relaxed );
+    }
+
+    iCount.store ( 0, std::memory_order_relaxed );
+    iMaxNs.store ( 0, std::memory_order_relaxed );
+}
+
+uint32_t CTimingHistogram::GetBucketValue ( const int iIndex )
+{
+    // inverse of GetBucketIndex(), returns the highest value of the bucket
+    if ( iIndex < TIMING_HIST_NUM_SUB_BUCKETS )
+    {
+        return static_cast<uint32_t> ( iIndex );
+    }
+
+    const int iShift = iIndex / TIMING_HIST_NUM_SUB_BUCKETS - 1;
+    const int iSub   = iIndex % TIMING_HIST_NUM_SUB_BUCKETS;
+
+    return static_cast<uint32_t> ( ( static_cast<uint64_t> ( TIMING_HIST_NUM_SUB_BUCKETS + iSub + 1 ) << iShift ) - 1 );
+}
+
+uint32_t CTimingHistogram::GetPercentileNs ( const double dPercentile ) const
+{
+    // the histogram may be updated while we are reading it, therefore we use
+    // the sum of the buckets as the total count instead of iCount
+    uint32_t vecSnapshot[TIMING_HIST_NUM_BUCKETS];
+    uint64_t iTotal = 0;
+
+    for ( int i = 0; i < TIMING_HIST_NUM_BUCKETS; i++ )
+    {
+        vecSnapshot[i] = vecCounts[i].load ( std::memory_order_relaxed );
+        iTotal        += vecSnapshot[i];
+    }
+
+    if ( iTotal == 0 )
+    {
+        return 0;
+    }
+
+    const uint64_t iTarget = static_cast<uint64_t> ( ceil ( dPercentile / 100 * iTotal ) );
+    uint64_t       iSum    = 0;
+
+    for ( int i = 0; i < TIMING_HIST_NUM_BUCKETS; i++ )
+    {
+        iSum += vecSnapshot[i];
+
+        if ( ( iSum >= iTarget ) && ( vecSnapshot[i] > 0 ) )
+        {
+            // the bucket value is an upper bound, the maximum is exact
+            return std::min ( GetBucketValue ( i ), GetMaxNs() );
+        }
+    }
+
+    return GetMaxNs();
+}
+
+
 /******************************************************************************\
 * Global Functions Implementation                                              *
 \******************************************************************************/
@@ -45,6 +45,7 @@
 #include <QElapsedTimer>
 #include <vector>
 #include <algorithm>
+#include <atomic>
 #include "global.h"
 using namespace std; // because of the library: "vector"
 #ifdef _WIN32
@@ -529,6 +530,25 @@ enum EAudComprType
 };
 
 
+// Network transport flags enum ------------------------------------------------
+enum ENetwFlags
+{
+    // used for protocol -> enum values must be fixed!
+    NF_NONE            = 0,
+    NF_WITH_REDUNDANCY = 1 // each audio packet carries a copy of the previous one
+};
+
+
+// Connected clients list delta type enum --------------------------------------
+enum EChanListDeltaType
+{
+    // used for protocol -> enum values must be fixed!
+    CD_REMOVE = 0,
+    CD_ADD = 1,
+    CD_UPDATE = 2
+};
+
+
 // Audio quality enum ----------------------------------------------------------
 enum EAudioQuality
 {
@@ -791,6 +811,12 @@ public:
     quint16      iPort;
 };
 
+// hash function so that the host address can be used as a key in a QHash
+inline uint qHash ( const CHostAddress& HostAddr, uint iSeed = 0 )
+{
+    return qHash ( HostAddr.InetAddr, iSeed ) ^ qHash ( HostAddr.iPort, iSeed );
+}
+
 
 // Instrument picture data base ------------------------------------------------
 // this is a pure static class
@@ -885,7 +911,7 @@ public:
         eSkillLevel ( NCorInf.eSkillLevel ) {}
 
     // compare operator
-    bool operator!= ( const CChannelCoreInfo& CompChanInfo )
+    bool operator!= ( const CChannelCoreInfo& CompChanInfo ) const
     {
         return ( ( CompChanInfo.strName     != strName ) ||
                  ( CompChanInfo.eCountry    != eCountry ) ||
@@ -948,6 +974,24 @@ public:
     quint32 iIpAddr;
 };
 
+class CChannelListDeltaEntry
+{
+public:
+    CChannelListDeltaEntry() :
+        eType ( CD_REMOVE ) {}
+
+    CChannelListDeltaEntry ( const EChanListDeltaType NeType,
+                             const CChannelInfo&      NChanInfo ) :
+        eType    ( NeType ),
+        ChanInfo ( NChanInfo ) {}
+
+    // kind of change of the channel
+    EChanListDeltaType eType;
+
+    // new channel infos (for a removed channel only the ID is used)
+    CChannelInfo       ChanInfo;
+};
+
 
 // Server info -----------------------------------------------------------------
 class CServerCoreInfo
@@ -1031,6 +1075,7 @@ public:
         iNumAudioChannels      ( 0 ),
         iSampleRate            ( 0 ),
         eAudioCodingType       ( CT_NONE ),
+        iFlags                 ( NF_NONE ),
         iAudioCodingArg        ( 0 ) {}
 
     CNetworkTransportProps ( const uint32_t      iNBNPS,
@@ -1038,14 +1083,14 @@ public:
                              const uint32_t      iNNACH,
                              const uint32_t      iNSR,
                              const EAudComprType eNACT,
-                             const uint32_t      iNVers,
+                             const uint32_t      iNFlags,
                              const int32_t       iNACA ) :
         iBaseNetworkPacketSize ( iNBNPS ),
         iBlockSizeFact         ( iNBSF ),
         iNumAudioChannels      ( iNNACH ),
         iSampleRate            ( iNSR ),
         eAudioCodingType       ( eNACT ),
-        iVersion               ( iNVers ),
+        iFlags                 ( iNFlags ),
         iAudioCodingArg        ( iNACA ) {}
 
     uint32_t      iBaseNetworkPacketSize;
@@ -1053,7 +1098,7 @@ public:
     uint32_t      iNumAudioChannels;
     uint32_t      iSampleRate;
     EAudComprType eAudioCodingType;
-    uint32_t      iVersion;
+    uint32_t      iFlags;
     int32_t       iAudioCodingArg;
 };
 
@@ -1316,6 +1361,72 @@ protected:
 };
 
 
+// Timing histogram ------------------------------------------------------------
+// Histogram of time durations with logarithmic bucket spacing (each power of
+// two range is split in a fixed number of linear sub buckets so that the
+// relative resolution is constant, similar to a HDR histogram). It is intended
+// to be updated in a real-time thread while another thread reads it: the
+// counters are atomic so that neither side has to take a lock.
+#define TIMING_HIST_SUB_BUCKET_BITS     3
+#define TIMING_HIST_NUM_SUB_BUCKETS     ( 1 << TIMING_HIST_SUB_BUCKET_BITS )
+#define TIMING_HIST_NUM_BUCKETS         ( ( 32 - TIMING_HIST_SUB_BUCKET_BITS + 1 ) * TIMING_HIST_NUM_SUB_BUCKETS )
+
+class CTimingHistogram
+{
+public:
+    CTimingHistogram() { Reset(); }
+
+    void Reset();
+
+    void Add ( const qint64 iDurationNs )
+    {
+        // clip to the range of the histogram
+        const uint32_t iValue = static_cast<uint32_t> (
+            std::max ( static_cast<qint64> ( 0 ), std::min ( iDurationNs, static_cast<qint64> ( 0xFFFFFFFF ) ) ) );
+
+        vecCounts[GetBucketIndex ( iValue )].fetch_add ( 1, std::memory_order_relaxed );
+        iCount.fetch_add ( 1, std::memory_order_relaxed );
+
+        // there is only one writer, therefore no compare and swap is needed
+        if ( iValue > iMaxNs.load ( std::memory_order_relaxed ) )
+        {
+            iMaxNs.store ( iValue, std::memory_order_relaxed );
+        }
+    }
+
+    uint32_t GetCount() const { return iCount.load ( std::memory_order_relaxed ); }
+    uint32_t GetMaxNs() const { return iMaxNs.load ( std::memory_order_relaxed ); }
+    uint32_t GetPercentileNs ( const double dPercentile ) const;
+
+protected:
+    static int GetBucketIndex ( const uint32_t iValue )
+    {
+        if ( iValue < TIMING_HIST_NUM_SUB_BUCKETS )
+        {
+            return static_cast<int> ( iValue );
+        }
+
+        // position of the most significant bit defines the power of two range
+        int iMSB = 0;
+        for ( uint32_t iTmp = iValue; iTmp > 1; iTmp >>= 1 )
+        {
+            iMSB++;
+        }
+
+        const int iShift = iMSB - TIMING_HIST_SUB_BUCKET_BITS;
+
+        return ( iShift + 1 ) * TIMING_HIST_NUM_SUB_BUCKETS +
+            static_cast<int> ( ( iValue >> iShift ) & ( TIMING_HIST_NUM_SUB_BUCKETS - 1 ) );
+    }
+
+    static uint32_t GetBucketValue ( const int iIndex );
+
+    std::atomic<uint32_t> vecCounts[TIMING_HIST_NUM_BUCKETS];
+    std::atomic<uint32_t> iCount;
+    std::atomic<uint32_t> iMaxNs;
+};
+
+
 /******************************************************************************\
 * Statistics                                                                   *
 \******************************************************************************/